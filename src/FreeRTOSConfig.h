@@ -12,9 +12,22 @@
 #define configRUN_FREERTOS_SECURE_ONLY          1
 #define configENABLE_FPU                        1
 
+/* Tickless idle (build with -DTICKLESS_IDLE=ON). The SMP kernel cannot
+ * suppress the tick, so this runs every task on core 0 with the
+ * single-core kernel: the idle task then stops SysTick and sleeps in WFI
+ * until the next timed wake-up, instead of waking every millisecond. The
+ * price is that the application tasks share core 0 with the CYW43 driver,
+ * lwIP and the scanner (priorities still favour the radio), core 1 stays
+ * parked, and the tick count is corrected after each sleep rather than
+ * counted. Worth it for the low-power profile, where the device idles
+ * minutes between scans. */
+#ifndef TICKLESS_IDLE_ENABLED
+#define TICKLESS_IDLE_ENABLED                   0
+#endif
+
 /* Scheduler Related */
 #define configUSE_PREEMPTION                    1
-#define configUSE_TICKLESS_IDLE                 1
+#define configUSE_TICKLESS_IDLE                 TICKLESS_IDLE_ENABLED
 #define configCPU_CLOCK_HZ                      150000000
 #define configTICK_RATE_HZ                      ((TickType_t)1000)
 #define configMAX_PRIORITIES                    32
@@ -37,10 +50,12 @@
 #define configSTACK_DEPTH_TYPE                  uint32_t
 #define configMESSAGE_BUFFER_LENGTH_TYPE        size_t
 
-/* Memory allocation */
-#define configSUPPORT_STATIC_ALLOCATION         0
+/* Memory allocation: application tasks, queues, mutexes and timers are
+ * static (kernel task memory comes from hooks in main.cpp). The heap only
+ * serves the CYW43 async context, lwIP and its mailboxes. */
+#define configSUPPORT_STATIC_ALLOCATION         1
 #define configSUPPORT_DYNAMIC_ALLOCATION        1
-#define configTOTAL_HEAP_SIZE                   (128 * 1024)
+#define configTOTAL_HEAP_SIZE                   (32 * 1024)
 #define configAPPLICATION_ALLOCATED_HEAP        0
 
 /* Hook functions */
@@ -50,11 +65,24 @@
 #define configUSE_MALLOC_FAILED_HOOK            0
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
-/* Run time and task stats */
-#define configGENERATE_RUN_TIME_STATS           0
-#define configUSE_TRACE_FACILITY                0
+/* Run time and task stats, for the sysmon report (build with -DSYSMON=ON) */
+#ifndef SYSMON_ENABLED
+#define SYSMON_ENABLED                          0
+#endif
+#define configGENERATE_RUN_TIME_STATS           SYSMON_ENABLED
+#define configUSE_TRACE_FACILITY                SYSMON_ENABLED
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
+#if SYSMON_ENABLED
+/* Microseconds from the always-running 64-bit timer; never wraps */
+#define configRUN_TIME_COUNTER_TYPE             uint64_t
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#ifndef __ASSEMBLER__
+#include "hardware/timer.h"
+#endif
+#define portGET_RUN_TIME_COUNTER_VALUE()        time_us_64()
+#endif
+
 /* Co-routines (not used) */
 #define configUSE_CO_ROUTINES                   0
 #define configMAX_CO_ROUTINE_PRIORITIES         1
@@ -68,11 +96,22 @@
 /* Interrupt nesting - RP2350 specific */
 #define configMAX_SYSCALL_INTERRUPT_PRIORITY    16
 
-/* SMP configuration (single core for now) */
+#if TICKLESS_IDLE_ENABLED
+/* Single core: every task runs on core 0 (see cores.hpp) */
 #define configNUMBER_OF_CORES                   1
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP   2
+#else
+/* SMP configuration: core 0 runs CYW43/lwIP and the scanner, core 1 the
+ * application tasks (see cores.hpp) */
+#define configNUMBER_OF_CORES                   2
 #define configTICK_CORE                         0
-#define configRUN_MULTIPLE_PRIORITIES           0
-#define configUSE_CORE_AFFINITY                 0
+#define configRUN_MULTIPLE_PRIORITIES           1
+#define configUSE_CORE_AFFINITY                 1
+#define configUSE_PASSIVE_IDLE_HOOK             0
+
+/* Timer service drives the LED through the CYW43, keep it with the driver */
+#define configTIMER_SERVICE_TASK_CORE_AFFINITY  (1 << 0)
+#endif
 
 /* RP2040/RP2350 SDK interop */
 #define configSUPPORT_PICO_SYNC_INTEROP         1
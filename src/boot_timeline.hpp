@@ -0,0 +1,107 @@
+/**
+ * @file boot_timeline.hpp
+ * @brief Timestamps of the boot phases, for time-to-first-scan.
+ *
+ * The CYW43 firmware download is the long pole of the boot, so it runs in
+ * its own task on the network core while the application core restores
+ * the scan log from flash. Each side marks the phases it passes; once the
+ * first scan is in, the timeline says where the time went.
+ */
+
+#ifndef BOOT_TIMELINE_HPP
+#define BOOT_TIMELINE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Boot milestones, roughly in the order they are reached.
+ */
+enum class BootPhase : uint8_t {
+    MAIN = 0,           ///< main() entered (boot ROM and C runtime done)
+    STDIO,              ///< stdio_init_all() returned
+    SCHEDULER,          ///< main_task running (the scheduler has started)
+    RADIO_START,        ///< CYW43 bring-up started
+    STORE_RESTORED,     ///< Scan log mounted and the last scan printed
+    RADIO_READY,        ///< CYW43 firmware loaded, station mode up
+    SCANNER_READY,      ///< Scanner task accepting requests
+    SERVICES,           ///< Telemetry, station and scheduler started
+    FIRST_SCAN,         ///< First scan result in hand
+    COUNT
+};
+
+inline constexpr std::size_t BOOT_PHASES = static_cast<std::size_t>(BootPhase::COUNT);
+
+[[nodiscard]] constexpr const char* boot_phase_name(BootPhase phase) noexcept {
+    switch (phase) {
+        case BootPhase::MAIN:           return "main";
+        case BootPhase::STDIO:          return "stdio";
+        case BootPhase::SCHEDULER:      return "scheduler";
+        case BootPhase::RADIO_START:    return "radio start";
+        case BootPhase::STORE_RESTORED: return "store restored";
+        case BootPhase::RADIO_READY:    return "radio ready";
+        case BootPhase::SCANNER_READY:  return "scanner ready";
+        case BootPhase::SERVICES:       return "services";
+        case BootPhase::FIRST_SCAN:     return "first scan";
+        default:                        return "???";
+    }
+}
+
+/**
+ * @brief Microsecond uptime at which each phase was first reached.
+ *
+ * Each phase is marked by one task, so slots need no lock: a word store
+ * is atomic, and readers only look once the last phase is in.
+ * The 32-bit timestamps cover the first 71 minutes of uptime.
+ */
+class BootTimeline {
+public:
+    /**
+     * @brief Record phase at now_us unless it was already reached.
+     * @return true if this call recorded it
+     */
+    bool mark(BootPhase phase, uint64_t now_us) noexcept {
+        if (!valid(phase) || at_[index(phase)] != 0) {
+            return false;
+        }
+        // 0 means "not reached", so a phase at the very first microsecond is 1
+        const uint64_t at = now_us == 0 ? 1 : now_us;
+        at_[index(phase)] = at > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(at);
+        return true;
+    }
+
+    [[nodiscard]] bool reached(BootPhase phase) const noexcept {
+        return at_us(phase) != 0;
+    }
+
+    /**
+     * @brief Uptime at phase, or 0 if not reached.
+     */
+    [[nodiscard]] uint32_t at_us(BootPhase phase) const noexcept {
+        return valid(phase) ? at_[index(phase)] : 0;
+    }
+
+    /**
+     * @brief Time from one phase to another, or 0 if either was not reached
+     *        or to came first.
+     */
+    [[nodiscard]] uint32_t between_us(BootPhase from, BootPhase to) const noexcept {
+        const uint32_t start = at_us(from);
+        const uint32_t end = at_us(to);
+        return (start != 0 && end > start) ? end - start : 0;
+    }
+
+private:
+    [[nodiscard]] static constexpr std::size_t index(BootPhase phase) noexcept {
+        return static_cast<std::size_t>(phase);
+    }
+
+    [[nodiscard]] static constexpr bool valid(BootPhase phase) noexcept {
+        return index(phase) < BOOT_PHASES;
+    }
+
+    std::array<uint32_t, BOOT_PHASES> at_{};
+};
+
+#endif // BOOT_TIMELINE_HPP
@@ -0,0 +1,423 @@
+/**
+ * @file console_format.hpp
+ * @brief Allocation-free rendering of AP rows for the console, as a table, CSV or JSON lines.
+ *
+ * Rows are rendered into a caller-owned ConsoleBuffer with hand-rolled
+ * integer and hex conversion, so a whole scan goes to stdio in one write
+ * instead of one printf (and one pass through every stdio driver's lock)
+ * per AP.
+ *
+ * TABLE is the human-readable layout. CSV and JSON_LINES put the record
+ * type first ("ap", "scan" or "location"), so a consumer can pick the data
+ * lines out of the rest of the console output:
+ *
+ *   type,marker,ssid,bssid,channel,rssi,auth,was
+ *   ap,+,Office,24:C9:A1:5C:27:98,6,-45,WPA2,
+ *   {"type":"ap","marker":"~","ssid":"Office","bssid":"24:C9:A1:5C:27:98","channel":6,"rssi":-45,"auth":"WPA2","was":-60}
+ */
+
+#ifndef CONSOLE_FORMAT_HPP
+#define CONSOLE_FORMAT_HPP
+
+#include "scan_msg.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Console output layout.
+ */
+enum class ConsoleFormat : uint8_t {
+    TABLE = 0,      ///< Aligned columns for people
+    CSV,            ///< RFC 4180 rows, header from append_csv_header()
+    JSON_LINES      ///< One JSON object per line
+};
+
+/// No previous RSSI to report for an AP row
+inline constexpr int32_t NO_PREVIOUS_RSSI = INT32_MIN;
+
+/**
+ * @brief Fixed-capacity text buffer with integer and hex formatting.
+ *
+ * Appends that do not fit set an overflow flag and are cut short; the row
+ * helpers below use mark()/rewind() so a row is written whole or not at all.
+ */
+template <std::size_t N>
+class ConsoleBuffer {
+public:
+    void put(char c) noexcept {
+        if (len_ < N) {
+            data_[len_++] = c;
+        } else {
+            overflow_ = true;
+        }
+    }
+
+    void put(const char* s) noexcept { put(s, std::strlen(s)); }
+
+    void put(const char* s, std::size_t n) noexcept {
+        const std::size_t fits = n <= N - len_ ? n : N - len_;
+        std::memcpy(data_.data() + len_, s, fits);
+        len_ += fits;
+        overflow_ = overflow_ || fits < n;
+    }
+
+    /**
+     * @brief Append s, padded with spaces on the right to width (like %-*s).
+     */
+    void put_left(const char* s, std::size_t width) noexcept {
+        const std::size_t n = std::strlen(s);
+        put(s, n);
+        pad(n, width);
+    }
+
+    /**
+     * @brief Append v in decimal, padded with spaces on the left to width (like %*u).
+     */
+    void put_uint(uint32_t v, std::size_t width = 0) noexcept {
+        std::array<char, 10> digits;
+        std::size_t n = 0;
+        do {
+            digits[n++] = static_cast<char>('0' + v % 10);
+            v /= 10;
+        } while (v != 0);
+        pad(n, width);
+        while (n > 0) {
+            put(digits[--n]);
+        }
+    }
+
+    /**
+     * @brief Append v in decimal, padded with spaces on the left to width (like %*d).
+     */
+    void put_int(int32_t v, std::size_t width = 0) noexcept {
+        const bool negative = v < 0;
+        const uint32_t magnitude = negative ? 0u - static_cast<uint32_t>(v)
+                                            : static_cast<uint32_t>(v);
+        std::size_t n = 0;
+        for (uint32_t rest = magnitude; n == 0 || rest != 0; rest /= 10) {
+            n++;
+        }
+        pad(n + (negative ? 1 : 0), width);
+        if (negative) {
+            put('-');
+        }
+        put_uint(magnitude);
+    }
+
+    /**
+     * @brief Append a BSSID as colon-separated upper-case hex.
+     */
+    void put_bssid(const std::array<uint8_t, BSSID_LEN>& bssid) noexcept {
+        constexpr char HEX[] = "0123456789ABCDEF";
+        for (std::size_t i = 0; i < BSSID_LEN; i++) {
+            if (i > 0) {
+                put(':');
+            }
+            put(HEX[bssid[i] >> 4]);
+            put(HEX[bssid[i] & 0x0F]);
+        }
+    }
+
+    /**
+     * @brief Insert n bytes of s at the front, e.g. a heading for rows already written.
+     * @return false, with nothing changed, if they do not fit
+     */
+    [[nodiscard]] bool prepend(const char* s, std::size_t n) noexcept {
+        if (n > N - len_) {
+            return false;
+        }
+        std::memmove(data_.data() + n, data_.data(), len_);
+        std::memcpy(data_.data(), s, n);
+        len_ += n;
+        return true;
+    }
+
+    [[nodiscard]] std::size_t mark() const noexcept { return len_; }
+
+    /**
+     * @brief Drop everything appended since mark and clear the overflow flag.
+     */
+    void rewind(std::size_t mark) noexcept {
+        len_ = mark;
+        overflow_ = false;
+    }
+
+    void clear() noexcept { rewind(0); }
+
+    [[nodiscard]] const char* data() const noexcept { return data_.data(); }
+    [[nodiscard]] std::size_t size() const noexcept { return len_; }
+    [[nodiscard]] bool empty() const noexcept { return len_ == 0; }
+    [[nodiscard]] bool overflowed() const noexcept { return overflow_; }
+
+private:
+    void pad(std::size_t n, std::size_t width) noexcept {
+        for (; n < width; n++) {
+            put(' ');
+        }
+    }
+
+    std::array<char, N> data_{};
+    std::size_t len_{0};
+    bool overflow_{false};
+};
+
+namespace console_detail {
+
+template <std::size_t N>
+void put_csv_field(ConsoleBuffer<N>& out, const char* s) noexcept {
+    const bool quote = std::strpbrk(s, ",\"\r\n") != nullptr || s[0] == ' ' ||
+                       (s[0] != '\0' && s[std::strlen(s) - 1] == ' ');
+    if (!quote) {
+        out.put(s);
+        return;
+    }
+    out.put('"');
+    for (; *s; s++) {
+        if (*s == '"') {
+            out.put('"');
+        }
+        out.put(*s);
+    }
+    out.put('"');
+}
+
+template <std::size_t N>
+void put_json_string(ConsoleBuffer<N>& out, const char* s) noexcept {
+    constexpr char HEX[] = "0123456789abcdef";
+    out.put('"');
+    for (; *s; s++) {
+        const auto c = static_cast<unsigned char>(*s);
+        if (c == '"' || c == '\\') {
+            out.put('\\');
+            out.put(static_cast<char>(c));
+        } else if (c < 0x20) {
+            out.put("\\u00", 4);
+            out.put(HEX[c >> 4]);
+            out.put(HEX[c & 0x0F]);
+        } else {
+            out.put(static_cast<char>(c));
+        }
+    }
+    out.put('"');
+}
+
+} // namespace console_detail
+
+/**
+ * @brief Append the CSV column names.
+ */
+template <std::size_t N>
+[[nodiscard]] bool append_csv_header(ConsoleBuffer<N>& out) noexcept {
+    const std::size_t start = out.mark();
+    out.put("type,marker,ssid,bssid,channel,rssi,auth,was\n");
+    if (out.overflowed()) {
+        out.rewind(start);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Append one AP row.
+ * @param marker One character saying why the AP is listed (e.g. ap_change_marker())
+ * @param previous_rssi Last reported RSSI, or NO_PREVIOUS_RSSI
+ * @return false, with nothing written, if the row does not fit
+ */
+template <std::size_t N>
+[[nodiscard]] bool append_ap(ConsoleBuffer<N>& out, ConsoleFormat format, char marker,
+                             const APInfo& ap, int32_t previous_rssi = NO_PREVIOUS_RSSI) noexcept {
+    const std::size_t start = out.mark();
+    const bool has_previous = previous_rssi != NO_PREVIOUS_RSSI;
+    const char* auth = auth_mode_to_string(ap.auth);
+    switch (format) {
+        case ConsoleFormat::TABLE:
+            // "  %c %-32s  %s  ch%2u  %4ddBm  %-9s %s\n"
+            out.put("  ", 2);
+            out.put(marker);
+            out.put(' ');
+            out.put_left(ap.ssid.data(), MAX_SSID_LEN);
+            out.put("  ", 2);
+            out.put_bssid(ap.bssid);
+            out.put("  ch", 4);
+            out.put_uint(ap.channel, 2);
+            out.put("  ", 2);
+            out.put_int(ap.rssi, 4);
+            out.put("dBm  ", 5);
+            out.put_left(auth, 9);
+            out.put(' ');
+            if (has_previous) {
+                out.put("(was ", 5);
+                out.put_int(previous_rssi);
+                out.put("dBm)", 4);
+            }
+            break;
+        case ConsoleFormat::CSV:
+            out.put("ap,", 3);
+            out.put(marker);
+            out.put(',');
+            console_detail::put_csv_field(out, ap.ssid.data());
+            out.put(',');
+            out.put_bssid(ap.bssid);
+            out.put(',');
+            out.put_uint(ap.channel);
+            out.put(',');
+            out.put_int(ap.rssi);
+            out.put(',');
+            out.put(auth);
+            out.put(',');
+            if (has_previous) {
+                out.put_int(previous_rssi);
+            }
+            break;
+        case ConsoleFormat::JSON_LINES:
+            out.put("{\"type\":\"ap\",\"marker\":\"");
+            // Markers are printable ASCII; guard the quote and backslash anyway
+            if (marker == '"' || marker == '\\') {
+                out.put('\\');
+            }
+            out.put(marker);
+            out.put("\",\"ssid\":");
+            console_detail::put_json_string(out, ap.ssid.data());
+            out.put(",\"bssid\":\"");
+            out.put_bssid(ap.bssid);
+            out.put("\",\"channel\":");
+            out.put_uint(ap.channel);
+            out.put(",\"rssi\":");
+            out.put_int(ap.rssi);
+            out.put(",\"auth\":\"");
+            out.put(auth);
+            out.put('"');
+            if (has_previous) {
+                out.put(",\"was\":");
+                out.put_int(previous_rssi);
+            }
+            out.put('}');
+            break;
+    }
+    out.put('\n');
+    if (out.overflowed()) {
+        out.rewind(start);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Append one row per AP in scan.
+ * @return APs written; fewer than scan.count if out filled up
+ */
+template <std::size_t N, std::size_t M>
+std::size_t append_scan(ConsoleBuffer<N>& out, ConsoleFormat format, char marker,
+                        const BasicScanResult<M>& scan) noexcept {
+    std::size_t written = 0;
+    while (written < scan.count && append_ap(out, format, marker, scan.networks[written])) {
+        written++;
+    }
+    return written;
+}
+
+/**
+ * @brief Append a scan summary line.
+ * @return false, with nothing written, if it does not fit
+ */
+template <std::size_t N>
+[[nodiscard]] bool append_scan_summary(ConsoleBuffer<N>& out, ConsoleFormat format,
+                                       std::size_t count, bool changed) noexcept {
+    const std::size_t start = out.mark();
+    const auto networks = static_cast<uint32_t>(count);
+    switch (format) {
+        case ConsoleFormat::TABLE:
+            out.put("--- Scan: ");
+            out.put_uint(networks);
+            out.put(" networks");
+            out.put(changed ? ", AP set changed ---" : " ---");
+            break;
+        case ConsoleFormat::CSV:
+            out.put("scan,");
+            out.put_uint(networks);
+            out.put(changed ? ",changed" : ",stable");
+            break;
+        case ConsoleFormat::JSON_LINES:
+            out.put("{\"type\":\"scan\",\"networks\":");
+            out.put_uint(networks);
+            out.put(changed ? ",\"changed\":true}" : ",\"changed\":false}");
+            break;
+    }
+    out.put('\n');
+    if (out.overflowed()) {
+        out.rewind(start);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Append a position estimate line.
+ * @param name Nearest reference location, or nullptr if none matched
+ * @param rms_q8 RMS RSSI distance to it, in 1/256 dB
+ * @param common APs the scan shared with it
+ * @return false, with nothing written, if it does not fit
+ */
+template <std::size_t N>
+[[nodiscard]] bool append_location(ConsoleBuffer<N>& out, ConsoleFormat format, const char* name,
+                                   uint32_t rms_q8, uint8_t common) noexcept {
+    const std::size_t start = out.mark();
+    // One decimal, rounded
+    const uint64_t tenths = (uint64_t{rms_q8} * 10 + 128) >> 8;
+    const auto put_db = [&] {
+        out.put_uint(static_cast<uint32_t>(tenths / 10));
+        out.put('.');
+        out.put(static_cast<char>('0' + tenths % 10));
+    };
+    switch (format) {
+        case ConsoleFormat::TABLE:
+            out.put("--- Location: ");
+            if (name) {
+                out.put(name);
+                out.put(" (");
+                put_db();
+                out.put(" dB RMS over ");
+                out.put_uint(common);
+                out.put(" APs) ---");
+            } else {
+                out.put("unknown ---");
+            }
+            break;
+        case ConsoleFormat::CSV:
+            out.put("location,");
+            if (name) {
+                console_detail::put_csv_field(out, name);
+                out.put(',');
+                put_db();
+            } else {
+                out.put(',');
+            }
+            out.put(',');
+            out.put_uint(name ? common : 0);
+            break;
+        case ConsoleFormat::JSON_LINES:
+            out.put("{\"type\":\"location\",\"name\":");
+            if (name) {
+                console_detail::put_json_string(out, name);
+                out.put(",\"rms_db\":");
+                put_db();
+                out.put(",\"common\":");
+                out.put_uint(common);
+            } else {
+                out.put("null");
+            }
+            out.put('}');
+            break;
+    }
+    out.put('\n');
+    if (out.overflowed()) {
+        out.rewind(start);
+        return false;
+    }
+    return true;
+}
+
+#endif // CONSOLE_FORMAT_HPP
@@ -0,0 +1,68 @@
+/**
+ * @file cores.hpp
+ * @brief Core assignment for tasks on the dual-core RP2350.
+ *
+ * Core 0 owns everything that talks to the radio: the CYW43 async
+ * context, the lwIP tcpip thread, the scanner task and the timer
+ * service (LED). Core 1 runs the application side: console, scan
+ * scheduler and log drain. Keeping the driver on one core avoids
+ * bouncing its lock between cores on every poll.
+ */
+
+#ifndef CORES_HPP
+#define CORES_HPP
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <array>
+#include <cstdint>
+
+/// Core running the CYW43 driver, lwIP and the scanner
+inline constexpr UBaseType_t NETWORK_CORE = 0;
+
+/// Core running application, console and logging tasks
+inline constexpr UBaseType_t APP_CORE = (configNUMBER_OF_CORES > 1) ? 1 : 0;
+
+/**
+ * @brief Stack and TCB for a statically allocated task.
+ * @tparam StackDepth Stack size in words
+ */
+template <uint32_t StackDepth>
+struct TaskMemory {
+    std::array<StackType_t, StackDepth> stack;
+    StaticTask_t tcb;
+};
+
+/**
+ * @brief xTaskCreateStatic() pinned to core (unpinned on single-core builds).
+ * @return Task handle; creation from static memory cannot fail
+ */
+template <uint32_t StackDepth>
+TaskHandle_t create_pinned_task(TaskFunction_t fn, const char* name, TaskMemory<StackDepth>& memory,
+                                void* params, UBaseType_t priority, UBaseType_t core) {
+#if configNUMBER_OF_CORES > 1 && configUSE_CORE_AFFINITY
+    return xTaskCreateStaticAffinitySet(fn, name, StackDepth, params, priority,
+                                        memory.stack.data(), &memory.tcb, 1u << core);
+#else
+    static_cast<void>(core);
+    return xTaskCreateStatic(fn, name, StackDepth, params, priority, memory.stack.data(),
+                             &memory.tcb);
+#endif
+}
+
+/**
+ * @brief Pin an already running task to core (no-op on single-core builds).
+ */
+inline void pin_task(TaskHandle_t task, UBaseType_t core) {
+#if configNUMBER_OF_CORES > 1 && configUSE_CORE_AFFINITY
+    if (task) {
+        vTaskCoreAffinitySet(task, 1u << core);
+    }
+#else
+    static_cast<void>(task);
+    static_cast<void>(core);
+#endif
+}
+
+#endif // CORES_HPP
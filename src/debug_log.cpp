@@ -0,0 +1,186 @@
+/**
+ * @file debug_log.cpp
+ * @brief Deferred log rings and the drain task that prints (or encodes) them.
+ */
+
+#include "debug_log.hpp"
+
+#if DEBUG_LOG_ENABLED && DEBUG_LOG_DEFERRED
+
+#include "cores.hpp"
+#include "log_ring.hpp"
+#include "pico/platform.h"
+
+#if DEBUG_LOG_BINARY
+#include "log_frame.hpp"
+#include "SEGGER_RTT.h"
+#endif
+
+namespace {
+
+constexpr uint32_t DRAIN_STACK_SIZE = 1024;
+constexpr UBaseType_t DRAIN_PRIORITY = tskIDLE_PRIORITY;
+
+// The drain task sleeps until a producer finds its ring empty and wakes it.
+// The timeout only bounds the delay if a wake-up is ever missed.
+constexpr uint32_t DRAIN_FALLBACK_MS = 1000;
+
+// Records each core can queue between drains (~40 bytes each)
+constexpr std::size_t LOG_RING_RECORDS = 64;
+
+using Ring = LogRing<dlog::Record, LOG_RING_RECORDS>;
+
+std::array<Ring, configNUMBER_OF_CORES> g_rings;
+
+TaskMemory<DRAIN_STACK_SIZE> g_drain_memory;
+TaskHandle_t g_drain_task = nullptr;
+
+#if DEBUG_LOG_BINARY
+
+// RTT up-channel for binary frames; channel 0 stays text stdio
+constexpr unsigned RTT_LOG_CHANNEL = 1;
+constexpr std::size_t RTT_LOG_BUFFER_SIZE = 2048;
+
+std::array<char, RTT_LOG_BUFFER_SIZE> g_rtt_log_buffer;
+
+static_assert(DBG_MAX_ARGS <= dlog_frame::MAX_ARGS);
+
+/**
+ * @brief Send one frame; RTT skips it whole if the host is not keeping up.
+ */
+void send_frame(uint32_t id, uint32_t tick, uint8_t core, const uint32_t* args,
+                std::size_t nargs) {
+    std::array<uint8_t, dlog_frame::MAX_FRAME> frame;
+    const std::size_t len = dlog_frame::encode(id, tick, core, args, nargs, frame.data());
+    SEGGER_RTT_Write(RTT_LOG_CHANNEL, frame.data(), static_cast<unsigned>(len));
+}
+
+/**
+ * @brief Encode one record; its ID is the call site's offset in .dlog, plus 1.
+ */
+void output_record(const dlog::Record& r) {
+    const auto site = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(r.fmt));
+    send_frame(site + 1, r.tick, r.core, r.args.data(), r.nargs);
+}
+
+void output_dropped(std::size_t core, uint32_t dropped) {
+    send_frame(dlog_frame::DROPPED_ID, xTaskGetTickCount(), static_cast<uint8_t>(core),
+               &dropped, 1);
+}
+
+#else
+
+constexpr const char* LEVEL_PREFIX[] = {"", "WARN: ", "ERROR: "};
+
+/**
+ * @brief Format one record the way the synchronous macros would.
+ */
+void output_record(const dlog::Record& r) {
+#if configNUMBER_OF_CORES > 1
+    printf("[%8lu] [c%u] [%s] %s", static_cast<unsigned long>(r.tick), r.core, r.tag,
+           LEVEL_PREFIX[static_cast<uint8_t>(r.level)]);
+#else
+    printf("[%8lu] [%s] %s", static_cast<unsigned long>(r.tick), r.tag,
+           LEVEL_PREFIX[static_cast<uint8_t>(r.level)]);
+#endif
+    // Every argument is a 32-bit word, which is what the AAPCS passes for
+    // each %d/%u/%x/%c/%s/%p conversion; unused trailing words are ignored
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+    printf(r.fmt, r.args[0], r.args[1], r.args[2], r.args[3], r.args[4], r.args[5]);
+#pragma GCC diagnostic pop
+    putchar('\n');
+}
+
+void output_dropped(std::size_t core, uint32_t dropped) {
+    printf("[%8lu] [Log] WARN: %lu messages dropped on core %u\n",
+           static_cast<unsigned long>(xTaskGetTickCount()),
+           static_cast<unsigned long>(dropped), static_cast<unsigned>(core));
+}
+
+static_assert(DBG_MAX_ARGS == 6, "output_record passes exactly six argument words");
+
+#endif // DEBUG_LOG_BINARY
+
+/**
+ * @brief Output everything queued on every core.
+ * @return Number of records output
+ */
+std::size_t drain() {
+    std::size_t printed = 0;
+    dlog::Record record;
+    for (std::size_t core = 0; core < g_rings.size(); core++) {
+        Ring& ring = g_rings[core];
+        if (const uint32_t dropped = ring.take_dropped(); dropped > 0) {
+            output_dropped(core, dropped);
+        }
+        while (ring.try_pop(record)) {
+            output_record(record);
+            printed++;
+        }
+    }
+    return printed;
+}
+
+/**
+ * @brief Drain task - prints queued records at idle priority.
+ */
+void drain_task(void* params) {
+    static_cast<void>(params);
+    while (true) {
+        drain();
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DRAIN_FALLBACK_MS));
+    }
+}
+
+/**
+ * @brief Wake the drain task (from a task or an ISR).
+ */
+void wake_drain() {
+    if (!g_drain_task || xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+        return;     // The drain task empties the rings when it first runs
+    }
+    if (portCHECK_IF_IN_ISR()) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(g_drain_task, &woken);
+        portYIELD_FROM_ISR(woken);
+    } else {
+        xTaskNotifyGive(g_drain_task);
+    }
+}
+
+} // anonymous namespace
+
+namespace dlog {
+
+void push(Record& record) {
+    record.core = static_cast<uint8_t>(configNUMBER_OF_CORES > 1 ? get_core_num() : 0);
+    // Only the record that makes a ring non-empty costs a kernel call
+    bool was_empty = false;
+    if (g_rings[record.core].try_push(record, was_empty) && was_empty) {
+        wake_drain();
+    }
+}
+
+[[nodiscard]] bool start() {
+    if (g_drain_task) {
+        return true;
+    }
+#if DEBUG_LOG_BINARY
+    SEGGER_RTT_ConfigUpBuffer(RTT_LOG_CHANNEL, "dlog", g_rtt_log_buffer.data(),
+                              g_rtt_log_buffer.size(), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+#endif
+    g_drain_task = create_pinned_task(drain_task, "log", g_drain_memory, nullptr,
+                                      DRAIN_PRIORITY, APP_CORE);
+    return g_drain_task != nullptr;
+}
+
+void flush() {
+    while (drain() > 0) {
+    }
+}
+
+} // namespace dlog
+
+#endif // DEBUG_LOG_ENABLED && DEBUG_LOG_DEFERRED
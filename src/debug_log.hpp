@@ -6,6 +6,24 @@
  * RTT provides real-time output through the debug probe without
  * requiring a serial connection.
  *
+ * By default logging is deferred: a macro only captures the tick, the
+ * tag and format pointers and up to DBG_MAX_ARGS raw arguments into a
+ * lock-free per-core ring (a few dozen cycles, never blocks), and a
+ * low-priority drain task formats and prints them. A slow UART therefore
+ * never stalls the caller. The drain task sleeps until a record lands in
+ * an empty ring; only that record pays for a task notification. Build
+ * with DEBUG_LOG_DEFERRED=0 to print synchronously instead.
+ *
+ * With DEBUG_LOG_BINARY=1 (implies deferred) the drain task sends compact
+ * binary frames (log_frame.hpp) to RTT channel 1 instead of text. Tag and
+ * format string of each call site are placed in the non-loaded .dlog
+ * ELF section, so they cost no flash and only their ID goes over the
+ * wire; `just rtt-log` decodes the frames against the ELF.
+ *
+ * Deferred arguments must be integers or pointers of at most 32 bits, and
+ * %s arguments must outlive the drain (string literals, task names), since
+ * only the pointer is stored.
+ *
  * Usage:
  *   DBG_INFO("WiFi", "Starting scan");
  *   DBG_INFO("WiFi", "Found %u networks", count);
@@ -24,7 +42,162 @@
 #define DEBUG_LOG_ENABLED 1
 #endif
 
-#if DEBUG_LOG_ENABLED
+// Defer formatting to the drain task (set to 0 to printf in the caller)
+#ifndef DEBUG_LOG_DEFERRED
+#define DEBUG_LOG_DEFERRED 1
+#endif
+
+// Send binary frames to RTT channel 1 instead of text (set to 1 to enable)
+#ifndef DEBUG_LOG_BINARY
+#define DEBUG_LOG_BINARY 0
+#endif
+
+#if DEBUG_LOG_BINARY && !DEBUG_LOG_DEFERRED
+#error "DEBUG_LOG_BINARY requires DEBUG_LOG_DEFERRED"
+#endif
+
+#if DEBUG_LOG_ENABLED && DEBUG_LOG_DEFERRED
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+/// Maximum arguments per deferred log message
+#define DBG_MAX_ARGS 6
+
+namespace dlog {
+
+/**
+ * @brief Message severity.
+ */
+enum class Level : uint8_t {
+    INFO = 0,
+    WARN,
+    ERROR
+};
+
+/**
+ * @brief Captured log call, formatted later by the drain task.
+ */
+struct Record {
+    uint32_t tick;                              ///< xTaskGetTickCount() at the call
+    const char* tag;                            ///< Module name (nullptr in binary mode)
+    const char* fmt;                            ///< printf format, or call site in binary mode
+    std::array<uint32_t, DBG_MAX_ARGS> args;    ///< Raw argument words
+    Level level;                                ///< Severity
+    uint8_t core;                               ///< Core the call ran on
+    uint8_t nargs;                              ///< Valid words in args
+};
+
+/**
+ * @brief Queue a record on the calling core's ring (drops it if full).
+ */
+void push(Record& record);
+
+/**
+ * @brief Start the drain task that prints queued records.
+ * @return true if the task was created
+ *
+ * May be called before the scheduler starts; records logged earlier are
+ * kept until the ring fills.
+ */
+[[nodiscard]] bool start();
+
+/**
+ * @brief Print every queued record from the calling context.
+ *
+ * For fatal paths (e.g. the stack overflow hook) where the drain task
+ * will never run again.
+ */
+void flush();
+
+/**
+ * @brief Convert one log argument to a raw 32-bit word.
+ */
+template <typename T>
+[[nodiscard]] inline uint32_t to_word(T value) noexcept {
+    if constexpr (std::is_pointer_v<T>) {
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(value));
+    } else if constexpr (std::is_enum_v<T>) {
+        return static_cast<uint32_t>(value);
+    } else {
+        static_assert(std::is_integral_v<T> && sizeof(T) <= sizeof(uint32_t),
+                      "deferred log arguments must be 32-bit integers or pointers");
+        return static_cast<uint32_t>(value);
+    }
+}
+
+/**
+ * @brief Capture a log call.
+ */
+template <typename... Args>
+inline void write(Level level, const char* tag, const char* fmt, Args... args) noexcept {
+    static_assert(sizeof...(Args) <= DBG_MAX_ARGS, "too many deferred log arguments");
+    Record record{xTaskGetTickCount(), tag, fmt, {to_word(args)...}, level, 0,
+                  static_cast<uint8_t>(sizeof...(Args))};
+    push(record);
+}
+
+} // namespace dlog
+
+#if DEBUG_LOG_BINARY
+
+#if !defined(__arm__)
+#error "DEBUG_LOG_BINARY relies on the ARM assembler comment character"
+#endif
+
+// Non-allocated section: the trailing '@' comments out the flags GCC
+// appends, so the strings stay in the ELF but are never loaded to flash.
+// Site addresses are offsets into the section (see tools/pico.py).
+#define DBG_SECTION ".dlog,\"\",%progbits @"
+
+/**
+ * @brief Per-call-site "<level><tag>\x1f<fmt>" record in the .dlog section.
+ */
+#define DBG_SITE(code, tag, fmt) \
+    ([]() noexcept -> const char* { \
+        __attribute__((section(DBG_SECTION), used)) \
+        static const char site[] = code tag "\x1f" fmt; \
+        return site; \
+    }())
+
+#define DBG_CAPTURE(level, code, tag, fmt, ...) \
+    ::dlog::write(level, nullptr, DBG_SITE(code, tag, fmt), ##__VA_ARGS__)
+
+#else
+
+#define DBG_CAPTURE(level, code, tag, fmt, ...) \
+    ::dlog::write(level, tag, fmt, ##__VA_ARGS__)
+
+#endif // DEBUG_LOG_BINARY
+
+// The unevaluated printf keeps compile-time format checking
+#define DBG_WRITE(level, code, tag, fmt, ...) \
+    (false ? static_cast<void>(printf(fmt, ##__VA_ARGS__)) \
+           : DBG_CAPTURE(level, code, tag, fmt, ##__VA_ARGS__))
+
+/**
+ * @brief Log an informational message.
+ * @param tag Module/component name (e.g., "WiFi", "Main")
+ * @param fmt printf-style format string
+ */
+#define DBG_INFO(tag, fmt, ...) DBG_WRITE(::dlog::Level::INFO, "I", tag, fmt, ##__VA_ARGS__)
+
+/**
+ * @brief Log an error message.
+ * @param tag Module/component name
+ * @param fmt printf-style format string
+ */
+#define DBG_ERROR(tag, fmt, ...) DBG_WRITE(::dlog::Level::ERROR, "E", tag, fmt, ##__VA_ARGS__)
+
+/**
+ * @brief Log a warning message.
+ * @param tag Module/component name
+ * @param fmt printf-style format string
+ */
+#define DBG_WARN(tag, fmt, ...) DBG_WRITE(::dlog::Level::WARN, "W", tag, fmt, ##__VA_ARGS__)
+
+#elif DEBUG_LOG_ENABLED
 
 /**
  * @brief Log an informational message.
@@ -61,4 +234,16 @@
 
 #endif // DEBUG_LOG_ENABLED
 
+#if !(DEBUG_LOG_ENABLED && DEBUG_LOG_DEFERRED)
+
+// Nothing is queued, so there is nothing to drain
+namespace dlog {
+
+[[nodiscard]] inline bool start() { return true; }
+inline void flush() {}
+
+} // namespace dlog
+
+#endif
+
 #endif // DEBUG_LOG_HPP
@@ -0,0 +1,291 @@
+/**
+ * @file fingerprint.hpp
+ * @brief Coarse indoor positioning: nearest reference fingerprint to a scan.
+ *
+ * A fingerprint is the strongest APs heard at one spot: BSSID and RSSI,
+ * sorted by BSSID. BSSIDs are packed into 48-bit integer keys, so sorting
+ * and comparing them costs one integer compare instead of a six-byte
+ * memcmp, and two fingerprints line up in a single linear merge.
+ *
+ * The distance between two fingerprints is the RMS RSSI difference over
+ * every AP either of them heard, in 1/256 dB. An AP only one side heard
+ * is compared against FINGERPRINT_MISSING_RSSI, so a strong AP missing
+ * from the scan weighs more than a weak one at the edge of range. All of
+ * it is integer arithmetic: about 32 steps per reference location, plus
+ * one integer square root for the best candidates.
+ *
+ * Reference locations are a constant table, typically generated from
+ * survey captures with `just fingerprints` and compiled in.
+ */
+
+#ifndef FINGERPRINT_HPP
+#define FINGERPRINT_HPP
+
+#include "scan_msg.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+/// APs kept per fingerprint (the strongest heard)
+inline constexpr std::size_t MAX_FINGERPRINT_APS = 16;
+
+/// RSSI assumed for an AP that one side of a comparison did not hear
+inline constexpr int8_t FINGERPRINT_MISSING_RSSI = -100;
+
+/// APs a reference must share with a scan to be a candidate at all
+inline constexpr uint8_t FINGERPRINT_MIN_COMMON = 2;
+
+/// Distance of fingerprints that could not be compared
+inline constexpr uint32_t NO_FINGERPRINT_DISTANCE = UINT32_MAX;
+
+/**
+ * @brief A BSSID as a 48-bit integer, most significant byte first.
+ *
+ * Keys sort in the same order as the BSSIDs' bytes.
+ */
+[[nodiscard]] constexpr uint64_t bssid_key(const std::array<uint8_t, BSSID_LEN>& bssid) noexcept {
+    uint64_t key = 0;
+    for (uint8_t byte : bssid) {
+        key = key << 8 | byte;
+    }
+    return key;
+}
+
+/**
+ * @brief Integer square root, rounded down.
+ */
+[[nodiscard]] constexpr uint32_t isqrt(uint32_t v) noexcept {
+    uint32_t root = 0;
+    for (uint32_t bit = 1u << 30; bit != 0; bit >>= 2) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+    }
+    return root;
+}
+
+/**
+ * @brief RSSI profile of one spot, sorted by BSSID key.
+ */
+struct Fingerprint {
+    std::array<uint64_t, MAX_FINGERPRINT_APS> bssid{};     ///< bssid_key(), ascending
+    std::array<int8_t, MAX_FINGERPRINT_APS> rssi{};        ///< dBm
+    uint8_t count{0};                                      ///< Valid entries
+
+    /**
+     * @brief Check that the keys are strictly ascending (a table built by hand may not be).
+     */
+    [[nodiscard]] constexpr bool valid() const noexcept {
+        if (count > MAX_FINGERPRINT_APS) {
+            return false;
+        }
+        for (std::size_t i = 1; i < count; i++) {
+            if (bssid[i - 1] >= bssid[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief Fingerprint of the strongest MAX_FINGERPRINT_APS APs in scan.
+ */
+template <std::size_t N>
+[[nodiscard]] Fingerprint fingerprint_of(const BasicScanResult<N>& scan) noexcept {
+    std::array<uint8_t, N> order{};
+    const std::size_t count = scan.count;
+    for (std::size_t i = 0; i < count; i++) {
+        order[i] = static_cast<uint8_t>(i);
+    }
+    const std::size_t kept = std::min(count, MAX_FINGERPRINT_APS);
+    if (kept < count) {
+        // Only the one-byte RSSI column is touched to rank
+        std::nth_element(order.begin(), order.begin() + kept, order.begin() + count,
+                         [&](uint8_t a, uint8_t b) {
+                             return scan.networks.rssi[a] > scan.networks.rssi[b];
+                         });
+    }
+
+    std::array<std::pair<uint64_t, int8_t>, MAX_FINGERPRINT_APS> entries{};
+    for (std::size_t i = 0; i < kept; i++) {
+        entries[i] = {bssid_key(scan.networks.bssid[order[i]]), scan.networks.rssi[order[i]]};
+    }
+    std::sort(entries.begin(), entries.begin() + kept);
+
+    Fingerprint print;
+    for (std::size_t i = 0; i < kept; i++) {
+        print.bssid[i] = entries[i].first;
+        print.rssi[i] = entries[i].second;
+    }
+    print.count = static_cast<uint8_t>(kept);
+    return print;
+}
+
+/**
+ * @brief How far apart two fingerprints are.
+ */
+struct FingerprintDistance {
+    uint32_t rms_q8{NO_FINGERPRINT_DISTANCE};   ///< RMS RSSI difference, 1/256 dB
+    uint8_t common{0};                          ///< APs both heard
+};
+
+namespace fingerprint_detail {
+
+[[nodiscard]] constexpr uint32_t squared(int32_t a, int32_t b) noexcept {
+    const int32_t d = a - b;
+    return static_cast<uint32_t>(d * d);
+}
+
+/**
+ * @brief Squared RSSI differences over the union of a and b, by linear merge.
+ * @param union_count Receives the number of distinct APs
+ */
+[[nodiscard]] constexpr uint32_t sum_squares(const Fingerprint& a, const Fingerprint& b,
+                                             uint32_t& union_count, uint8_t& common) noexcept {
+    uint32_t sum = 0;
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (i < a.count && j < b.count) {
+        if (a.bssid[i] == b.bssid[j]) {
+            sum += squared(a.rssi[i++], b.rssi[j++]);
+            common++;
+        } else if (a.bssid[i] < b.bssid[j]) {
+            sum += squared(a.rssi[i++], FINGERPRINT_MISSING_RSSI);
+        } else {
+            sum += squared(b.rssi[j++], FINGERPRINT_MISSING_RSSI);
+        }
+        union_count++;
+    }
+    for (; i < a.count; i++, union_count++) {
+        sum += squared(a.rssi[i], FINGERPRINT_MISSING_RSSI);
+    }
+    for (; j < b.count; j++, union_count++) {
+        sum += squared(b.rssi[j], FINGERPRINT_MISSING_RSSI);
+    }
+    return sum;
+}
+
+/**
+ * @brief Mean of sum over n in 1/65536 dB^2, so its square root is in 1/256 dB.
+ */
+[[nodiscard]] constexpr uint32_t mean_q16(uint32_t sum, uint32_t n) noexcept {
+    const uint64_t mean = (uint64_t{sum} << 16) / n;
+    return mean > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(mean);
+}
+
+} // namespace fingerprint_detail
+
+/**
+ * @brief RMS RSSI difference between a and b over every AP either heard.
+ */
+[[nodiscard]] constexpr FingerprintDistance fingerprint_distance(const Fingerprint& a,
+                                                                 const Fingerprint& b) noexcept {
+    FingerprintDistance distance;
+    uint32_t union_count = 0;
+    const uint32_t sum = fingerprint_detail::sum_squares(a, b, union_count, distance.common);
+    if (union_count > 0) {
+        distance.rms_q8 = isqrt(fingerprint_detail::mean_q16(sum, union_count));
+    }
+    return distance;
+}
+
+/**
+ * @brief A reference spot.
+ */
+struct FingerprintLocation {
+    const char* name;
+    Fingerprint print;
+};
+
+/**
+ * @brief Outcome of FingerprintDb::match().
+ */
+struct FingerprintMatch {
+    static constexpr std::size_t npos = SIZE_MAX;
+
+    std::size_t location{npos};                         ///< Index of the nearest location
+    FingerprintDistance distance{};                     ///< To the nearest location
+    uint32_t runner_up_q8{NO_FINGERPRINT_DISTANCE};     ///< RMS distance to the next nearest
+
+    [[nodiscard]] constexpr bool found() const noexcept { return location != npos; }
+};
+
+/**
+ * @brief Nearest-neighbour search over a constant table of reference locations.
+ */
+class FingerprintDb {
+public:
+    constexpr FingerprintDb() noexcept = default;
+
+    constexpr FingerprintDb(const FingerprintLocation* locations, std::size_t count) noexcept
+        : locations_(locations),
+          count_(locations ? count : 0) {}
+
+    [[nodiscard]] constexpr std::size_t size() const noexcept { return count_; }
+
+    [[nodiscard]] constexpr const FingerprintLocation& operator[](std::size_t i) const noexcept {
+        return locations_[i];
+    }
+
+    /**
+     * @brief Check every reference fingerprint is sorted and within bounds.
+     */
+    [[nodiscard]] constexpr bool valid() const noexcept {
+        return std::all_of(locations_, locations_ + count_, [](const FingerprintLocation& l) {
+            return l.print.valid();
+        });
+    }
+
+    /**
+     * @brief Nearest location to scan sharing at least min_common APs with it.
+     *
+     * Candidates are ranked by mean squared difference, so the square root
+     * is only taken for the two nearest. Ties go to the location sharing
+     * more APs.
+     */
+    [[nodiscard]] constexpr FingerprintMatch match(const Fingerprint& scan,
+                                                   uint8_t min_common = FINGERPRINT_MIN_COMMON)
+        const noexcept {
+        FingerprintMatch best;
+        uint32_t best_mean = NO_FINGERPRINT_DISTANCE;
+        uint32_t second_mean = NO_FINGERPRINT_DISTANCE;
+        for (std::size_t i = 0; i < count_; i++) {
+            uint32_t union_count = 0;
+            uint8_t common = 0;
+            const uint32_t sum =
+                fingerprint_detail::sum_squares(scan, locations_[i].print, union_count, common);
+            if (common < min_common || common == 0) {
+                continue;
+            }
+            const uint32_t mean = fingerprint_detail::mean_q16(sum, union_count);
+            if (mean < best_mean || (mean == best_mean && common > best.distance.common)) {
+                second_mean = best_mean;
+                best_mean = mean;
+                best.location = i;
+                best.distance.common = common;
+            } else if (mean < second_mean) {
+                second_mean = mean;
+            }
+        }
+        if (best.found()) {
+            best.distance.rms_q8 = isqrt(best_mean);
+        }
+        if (second_mean != NO_FINGERPRINT_DISTANCE) {
+            best.runner_up_q8 = isqrt(second_mean);
+        }
+        return best;
+    }
+
+private:
+    const FingerprintLocation* locations_{nullptr};
+    std::size_t count_{0};
+};
+
+#endif // FINGERPRINT_HPP
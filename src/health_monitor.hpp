@@ -0,0 +1,169 @@
+/**
+ * @file health_monitor.hpp
+ * @brief Deadlines of the supervised tasks, and the record a watchdog reboot leaves behind.
+ *
+ * A supervised task checks in with a budget: the longest it may take
+ * before it checks in again, or says it is idle (blocked waiting for
+ * work, so not expected to check in at all). A task that misses its
+ * deadline is stalled; one that hit a fault it cannot recover from, such
+ * as a radio that ignores a scan abort, marks itself failed. The
+ * supervisor feeds the hardware watchdog only while no task is either,
+ * so a wedged pipeline ends in a reset instead of a dead device.
+ *
+ * Before it stops feeding, the supervisor writes a RebootRecord to a
+ * watchdog scratch register, which survives the reset, so the next boot
+ * can say which task was to blame.
+ */
+
+#ifndef HEALTH_MONITOR_HPP
+#define HEALTH_MONITOR_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Supervised tasks.
+ */
+enum class Watched : uint8_t {
+    SCANNER = 0,    ///< Busy from a request batch to its delivery
+    SCHEDULER,      ///< Checks in once per scheduled scan
+    COUNT
+};
+
+inline constexpr std::size_t WATCHED_TASKS = static_cast<std::size_t>(Watched::COUNT);
+
+[[nodiscard]] constexpr const char* watched_name(Watched task) noexcept {
+    switch (task) {
+        case Watched::SCANNER:   return "scanner";
+        case Watched::SCHEDULER: return "scheduler";
+        default:                 return "???";
+    }
+}
+
+/**
+ * @brief Deadline of each supervised task.
+ *
+ * Not thread-safe: the supervisor guards it with a critical section.
+ */
+class HealthMonitor {
+public:
+    /**
+     * @brief task is alive, and checks in again or goes idle within budget_ms.
+     */
+    void check_in(Watched task, uint64_t now_us, uint32_t budget_ms) noexcept {
+        if (valid(task)) {
+            slot(task).deadline_us = now_us + uint64_t{budget_ms} * 1000;
+        }
+    }
+
+    /**
+     * @brief task is blocked waiting for work: no deadline until it checks in.
+     */
+    void idle(Watched task) noexcept {
+        if (valid(task)) {
+            slot(task).deadline_us = 0;
+        }
+    }
+
+    /**
+     * @brief task cannot recover on its own. Sticky: a later check-in does not clear it.
+     */
+    void fail(Watched task) noexcept {
+        if (valid(task)) {
+            slot(task).failed = true;
+        }
+    }
+
+    [[nodiscard]] bool failed(Watched task) const noexcept {
+        return valid(task) && slot(task).failed;
+    }
+
+    /**
+     * @brief First task that failed or is past its deadline, or Watched::COUNT if none.
+     */
+    [[nodiscard]] Watched unhealthy(uint64_t now_us) const noexcept {
+        for (std::size_t i = 0; i < WATCHED_TASKS; i++) {
+            const Slot& s = slots_[i];
+            if (s.failed || (s.deadline_us != 0 && now_us > s.deadline_us)) {
+                return static_cast<Watched>(i);
+            }
+        }
+        return Watched::COUNT;
+    }
+
+    [[nodiscard]] bool healthy(uint64_t now_us) const noexcept {
+        return unhealthy(now_us) == Watched::COUNT;
+    }
+
+private:
+    struct Slot {
+        uint64_t deadline_us{0};    ///< 0 while idle or never checked in
+        bool failed{false};
+    };
+
+    [[nodiscard]] static constexpr bool valid(Watched task) noexcept {
+        return static_cast<std::size_t>(task) < WATCHED_TASKS;
+    }
+
+    [[nodiscard]] Slot& slot(Watched task) noexcept {
+        return slots_[static_cast<std::size_t>(task)];
+    }
+
+    [[nodiscard]] const Slot& slot(Watched task) const noexcept {
+        return slots_[static_cast<std::size_t>(task)];
+    }
+
+    std::array<Slot, WATCHED_TASKS> slots_{};
+};
+
+/**
+ * @brief Why the supervisor let the watchdog reset the device.
+ */
+enum class RebootCause : uint8_t {
+    NONE = 0,       ///< Power-on, or a reset the supervisor did not cause
+    STALLED,        ///< A task missed its deadline
+    FAILED          ///< A task gave up (see HealthMonitor::fail())
+};
+
+[[nodiscard]] constexpr const char* reboot_cause_name(RebootCause cause) noexcept {
+    switch (cause) {
+        case RebootCause::NONE:    return "none";
+        case RebootCause::STALLED: return "stalled";
+        case RebootCause::FAILED:  return "failed";
+        default:                   return "???";
+    }
+}
+
+/**
+ * @brief What a supervised reboot leaves in a watchdog scratch register.
+ *
+ * Packed as magic (16 bits), cause (8 bits), task (8 bits), so a register
+ * holding anything else decodes as RebootCause::NONE.
+ */
+struct RebootRecord {
+    static constexpr uint32_t MAGIC = 0x5CA9;
+
+    RebootCause cause{RebootCause::NONE};
+    Watched task{Watched::COUNT};
+
+    [[nodiscard]] constexpr uint32_t encode() const noexcept {
+        return MAGIC << 16 | static_cast<uint32_t>(cause) << 8 | static_cast<uint32_t>(task);
+    }
+
+    [[nodiscard]] static constexpr RebootRecord decode(uint32_t word) noexcept {
+        const auto cause = static_cast<RebootCause>(word >> 8 & 0xFF);
+        const auto task = static_cast<Watched>(word & 0xFF);
+        if (word >> 16 != MAGIC || cause == RebootCause::NONE || cause > RebootCause::FAILED ||
+            task >= Watched::COUNT) {
+            return RebootRecord{};
+        }
+        return RebootRecord{cause, task};
+    }
+
+    [[nodiscard]] constexpr bool supervised() const noexcept {
+        return cause != RebootCause::NONE;
+    }
+};
+
+#endif // HEALTH_MONITOR_HPP
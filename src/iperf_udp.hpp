@@ -0,0 +1,112 @@
+/**
+ * @file iperf_udp.hpp
+ * @brief Receive-side accounting for an iperf2 UDP test.
+ *
+ * An iperf2 UDP client (`iperf -c <device> -u`) numbers its datagrams in
+ * the first four bytes (big-endian), counting up from 0, and ends the test
+ * with the same datagram bearing a negative number, sent a few times
+ * over. That is all the receiver needs for throughput, loss and
+ * reordering; the rest of the payload is ignored.
+ */
+
+#ifndef IPERF_UDP_HPP
+#define IPERF_UDP_HPP
+
+#include <cstdint>
+
+/// A gap this long between datagrams starts a new test
+inline constexpr uint64_t IPERF_UDP_IDLE_US = 2'000'000;
+
+/**
+ * @brief Outcome of one UDP test.
+ */
+struct IperfUdpReport {
+    uint32_t datagrams{0};      ///< Received, end marker excluded
+    uint64_t bytes{0};          ///< UDP payload bytes received
+    uint32_t lost{0};           ///< Never received
+    uint32_t out_of_order{0};   ///< Arrived after a later one
+    uint64_t duration_us{0};    ///< First to last datagram
+
+    /**
+     * @brief Received payload rate.
+     */
+    [[nodiscard]] uint32_t kbit_per_s() const noexcept {
+        return duration_us > 0 ? static_cast<uint32_t>(bytes * 8000 / duration_us) : 0;
+    }
+
+    /**
+     * @brief Lost datagrams per thousand sent.
+     */
+    [[nodiscard]] uint32_t loss_per_mille() const noexcept {
+        const uint64_t sent = static_cast<uint64_t>(datagrams) + lost;
+        return sent > 0 ? static_cast<uint32_t>(static_cast<uint64_t>(lost) * 1000 / sent) : 0;
+    }
+};
+
+/**
+ * @brief Tracks the datagrams of the test in progress.
+ */
+class IperfUdpTracker {
+public:
+    /**
+     * @brief Account for one datagram.
+     * @param id Datagram number (first payload word, host order)
+     * @param bytes UDP payload size
+     * @return true if this ended a test; report() then describes it
+     */
+    [[nodiscard]] bool on_datagram(int32_t id, uint32_t bytes, uint64_t now_us) noexcept {
+        if (active_ && now_us - last_us_ > IPERF_UDP_IDLE_US) {
+            // The client went away without an end marker
+            active_ = false;
+        }
+        if (id < 0) {
+            if (!active_) {
+                return false;   // Repeated end marker
+            }
+            active_ = false;
+            return true;
+        }
+
+        const uint32_t number = static_cast<uint32_t>(id);
+        if (!active_) {
+            active_ = true;
+            report_ = IperfUdpReport{};
+            start_us_ = now_us;
+            next_ = number;
+        }
+        if (number >= next_) {
+            report_.lost += number - next_;
+            next_ = number + 1;
+        } else {
+            // Counted as lost when the gap opened
+            report_.out_of_order++;
+            if (report_.lost > 0) {
+                report_.lost--;
+            }
+        }
+        report_.datagrams++;
+        report_.bytes += bytes;
+        last_us_ = now_us;
+        report_.duration_us = now_us - start_us_;
+        return false;
+    }
+
+    /**
+     * @brief The test in progress, or the last one to end.
+     */
+    [[nodiscard]] const IperfUdpReport& report() const noexcept { return report_; }
+
+    /**
+     * @brief Whether a test is in progress.
+     */
+    [[nodiscard]] bool active() const noexcept { return active_; }
+
+private:
+    IperfUdpReport report_{};
+    uint64_t start_us_{0};
+    uint64_t last_us_{0};
+    uint32_t next_{0};
+    bool active_{false};
+};
+
+#endif // IPERF_UDP_HPP
@@ -0,0 +1,214 @@
+/**
+ * @file known_networks.hpp
+ * @brief Cache of the APs the device returns to, for fast reconnect scans.
+ */
+
+#ifndef KNOWN_NETWORKS_HPP
+#define KNOWN_NETWORKS_HPP
+
+#include "scan_msg.hpp"
+#include "scan_request.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+/// Known APs cached
+inline constexpr std::size_t MAX_KNOWN_NETWORKS = 8;
+
+/**
+ * @brief A cached AP.
+ */
+struct KnownNetwork {
+    APInfo ap;                  ///< SSID, BSSID, channel and RSSI when last heard
+    uint32_t last_seen_ms{0};   ///< Uptime when last heard, 0 = not since boot
+};
+
+/**
+ * @brief Small set of known APs, keyed by BSSID.
+ *
+ * Entries are added explicitly (typically the AP just associated with),
+ * then kept current by refresh() from every scan. When the cache is full
+ * the entry heard least recently makes room.
+ *
+ * revision() changes only with what is worth persisting (the set of
+ * BSSIDs, and their SSID, channel and auth), not with RSSI or last-seen
+ * time, so a store can tell cheaply whether the cache needs writing.
+ */
+class KnownNetworks {
+public:
+    /**
+     * @brief Add ap, or update it if its BSSID is already known.
+     * @param now_ms Uptime, recorded as last seen
+     */
+    void remember(const APInfo& ap, uint32_t now_ms) noexcept {
+        std::size_t i = index_of(ap.bssid);
+        if (i == count_) {
+            if (count_ < entries_.size()) {
+                count_++;
+            } else {
+                i = least_recent();
+            }
+            revision_++;
+        } else if (differs(entries_[i].ap, ap)) {
+            revision_++;
+        }
+        entries_[i] = KnownNetwork{ap, now_ms};
+    }
+
+    /**
+     * @brief Drop bssid from the cache.
+     * @return false if it was not known
+     */
+    [[nodiscard]] bool forget(const std::array<uint8_t, BSSID_LEN>& bssid) noexcept {
+        const std::size_t i = index_of(bssid);
+        if (i == count_) {
+            return false;
+        }
+        entries_[i] = entries_[--count_];
+        revision_++;
+        return true;
+    }
+
+    /**
+     * @brief Update the known entries heard in scan.
+     * @param now_ms Uptime, recorded as last seen
+     * @return Number of known entries found in scan
+     */
+    template <std::size_t N>
+    std::size_t refresh(const BasicScanResult<N>& scan, uint32_t now_ms) noexcept {
+        std::size_t seen = 0;
+        for (std::size_t i = 0; i < count_; i++) {
+            const std::size_t j = scan.index_of(entries_[i].ap.bssid);
+            if (j == scan.npos) {
+                continue;
+            }
+            const APInfo ap = scan.networks[j];
+            if (differs(entries_[i].ap, ap)) {
+                revision_++;
+            }
+            entries_[i] = KnownNetwork{ap, now_ms};
+            seen++;
+        }
+        return seen;
+    }
+
+    /**
+     * @brief Targeted request that completes on the first known AP heard.
+     *
+     * Lists the MAX_TARGET_BSSIDS entries heard most recently (strongest
+     * first on a tie, so entries restored from flash rank by their last
+     * RSSI). No channel filter is set: an AP that moved channel is still
+     * found by the rest of the sweep.
+     */
+    [[nodiscard]] ScanRequest fast_request() const noexcept {
+        std::array<uint8_t, MAX_KNOWN_NETWORKS> order{};
+        for (std::size_t i = 0; i < count_; i++) {
+            order[i] = static_cast<uint8_t>(i);
+        }
+        std::sort(order.begin(), order.begin() + count_, [this](uint8_t a, uint8_t b) {
+            const KnownNetwork& x = entries_[a];
+            const KnownNetwork& y = entries_[b];
+            return x.last_seen_ms != y.last_seen_ms ? x.last_seen_ms > y.last_seen_ms
+                                                    : x.ap.rssi > y.ap.rssi;
+        });
+
+        ScanRequest request;
+        request.stop_on_match = true;
+        for (std::size_t i = 0; i < count_ && i < MAX_TARGET_BSSIDS; i++) {
+            [[maybe_unused]] const bool added = request.add_bssid(entries_[order[i]].ap.bssid.data());
+        }
+        return request;
+    }
+
+    /**
+     * @brief Entry for bssid, or nullptr if it is not known.
+     */
+    [[nodiscard]] const KnownNetwork* find(const std::array<uint8_t, BSSID_LEN>& bssid) const noexcept {
+        const std::size_t i = index_of(bssid);
+        return i < count_ ? &entries_[i] : nullptr;
+    }
+
+    /**
+     * @brief Best entry for joining ssid: heard most recently, strongest on a tie.
+     * @return nullptr if no entry has that SSID
+     */
+    [[nodiscard]] const KnownNetwork* best_for(const char* ssid) const noexcept {
+        const KnownNetwork* best = nullptr;
+        for (std::size_t i = 0; i < count_; i++) {
+            const KnownNetwork& entry = entries_[i];
+            if (std::strncmp(entry.ap.ssid.data(), ssid, entry.ap.ssid.size()) != 0) {
+                continue;
+            }
+            if (!best || entry.last_seen_ms > best->last_seen_ms ||
+                (entry.last_seen_ms == best->last_seen_ms && entry.ap.rssi > best->ap.rssi)) {
+                best = &entry;
+            }
+        }
+        return best;
+    }
+
+    /**
+     * @brief Copy the entries into a scan result, e.g. for ScanLog.
+     */
+    template <std::size_t N>
+    void export_to(BasicScanResult<N>& out) const noexcept {
+        static_assert(N >= MAX_KNOWN_NETWORKS, "result must hold every known network");
+        out.reset();
+        out.success = true;
+        for (std::size_t i = 0; i < count_; i++) {
+            [[maybe_unused]] const bool added = out.add(entries_[i].ap);
+        }
+    }
+
+    /**
+     * @brief Replace the cache with the APs in in (as not seen since boot).
+     */
+    template <std::size_t N>
+    void import_from(const BasicScanResult<N>& in) noexcept {
+        count_ = 0;
+        for (std::size_t i = 0; i < in.count && count_ < entries_.size(); i++) {
+            entries_[count_++] = KnownNetwork{in.networks[i], 0};
+        }
+        revision_++;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return count_; }
+    [[nodiscard]] bool empty() const noexcept { return count_ == 0; }
+    [[nodiscard]] const KnownNetwork& operator[](std::size_t i) const noexcept { return entries_[i]; }
+
+    /**
+     * @brief Counter bumped whenever a persisted field changes.
+     */
+    [[nodiscard]] uint32_t revision() const noexcept { return revision_; }
+
+private:
+    [[nodiscard]] std::size_t index_of(const std::array<uint8_t, BSSID_LEN>& bssid) const noexcept {
+        std::size_t i = 0;
+        while (i < count_ && entries_[i].ap.bssid != bssid) {
+            i++;
+        }
+        return i;
+    }
+
+    [[nodiscard]] std::size_t least_recent() const noexcept {
+        std::size_t oldest = 0;
+        for (std::size_t i = 1; i < count_; i++) {
+            if (entries_[i].last_seen_ms < entries_[oldest].last_seen_ms) {
+                oldest = i;
+            }
+        }
+        return oldest;
+    }
+
+    [[nodiscard]] static bool differs(const APInfo& a, const APInfo& b) noexcept {
+        return a.channel != b.channel || a.auth != b.auth || a.ssid != b.ssid;
+    }
+
+    std::array<KnownNetwork, MAX_KNOWN_NETWORKS> entries_{};
+    std::size_t count_{0};
+    uint32_t revision_{0};
+};
+
+#endif // KNOWN_NETWORKS_HPP
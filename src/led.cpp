@@ -4,55 +4,177 @@
  */
 
 #include "led.hpp"
+#include "led_pattern.hpp"
 #include "pico/cyw43_arch.h"
 #include "FreeRTOS.h"
+#include "semphr.h"
 #include "timers.h"
 
+#include <algorithm>
+
+// GPIO of an optional external status LED driven by PIO (-1 for none)
+#ifndef LED_EXTERNAL_PIN
+#define LED_EXTERNAL_PIN -1
+#endif
+
+#if LED_EXTERNAL_PIN >= 0
+#include "hardware/pio.h"
+#include "led_pattern.pio.h"
+#endif
+
 namespace {
 
+constexpr bool HAS_EXTERNAL_LED = LED_EXTERNAL_PIN >= 0;
+
+// Every CYW43 LED write is a gSPI transaction shared with the scan, so
+// the onboard LED never toggles faster than this
+constexpr uint32_t CYW43_MIN_BLINK_MS = 250;
+
+// Placeholder period; start_blink() sets the real one
+constexpr TickType_t DEFAULT_BLINK_PERIOD = pdMS_TO_TICKS(CYW43_MIN_BLINK_MS);
+
+// Serializes LED state and the blink timer between tasks on both cores
+// and the timer service. Until init() runs, callers are assumed to be
+// single-threaded.
+SemaphoreHandle_t led_mutex = nullptr;
+StaticSemaphore_t led_mutex_control;
+
+// Created once by init() and only ever restarted or stopped
 TimerHandle_t blink_timer = nullptr;
+StaticTimer_t blink_timer_control;
+
 bool led_state = false;
+bool blinking = false;
+
+#if LED_EXTERNAL_PIN >= 0
+PIO pattern_pio = nullptr;
+uint pattern_sm = 0;
+uint pattern_offset = 0;
+#endif
 
+bool lock(TickType_t wait = portMAX_DELAY) {
+    return !led_mutex || xSemaphoreTake(led_mutex, wait) == pdTRUE;
+}
+
+void unlock() {
+    if (led_mutex) {
+        xSemaphoreGive(led_mutex);
+    }
+}
+
+/**
+ * @brief Set the onboard (CYW43) LED, skipping writes that change nothing.
+ * @note Caller must hold led_mutex.
+ */
 void set_led(bool state) {
+    if (state == led_state) {
+        return;
+    }
     led_state = state;
     cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, state);
 }
 
+/**
+ * @brief Claim a PIO state machine for the external LED and start it dark.
+ */
+bool init_external() {
+#if LED_EXTERNAL_PIN >= 0
+    if (!pio_claim_free_sm_and_add_program_for_gpio_range(&led_pattern_program, &pattern_pio,
+                                                          &pattern_sm, &pattern_offset,
+                                                          LED_EXTERNAL_PIN, 1, true)) {
+        pattern_pio = nullptr;
+        return false;
+    }
+    led_pattern_program_init(pattern_pio, pattern_sm, pattern_offset, LED_EXTERNAL_PIN,
+                             PATTERN_SLOT_MS);
+#endif
+    return true;
+}
+
+/**
+ * @brief Loop bits on the external LED (no-op without one).
+ * @note Caller must hold led_mutex.
+ */
+void show_external(uint32_t bits) {
+#if LED_EXTERNAL_PIN >= 0
+    if (pattern_pio) {
+        led_pattern_program_show(pattern_pio, pattern_sm, pattern_offset, bits);
+    }
+#else
+    static_cast<void>(bits);
+#endif
+}
+
 void blink_tick(TimerHandle_t) {
-    set_led(!led_state);
+    // Skip a toggle rather than stall the timer service behind another task.
+    // A tick already queued when blinking stopped must not turn the LED off.
+    if (lock(0)) {
+        if (blinking) {
+            set_led(!led_state);
+        }
+        unlock();
+    }
 }
 
 } // anonymous namespace
 
 namespace led {
 
+[[nodiscard]] bool init() {
+    if (!led_mutex) {
+        led_mutex = xSemaphoreCreateMutexStatic(&led_mutex_control);
+        blink_timer = xTimerCreateStatic("led", DEFAULT_BLINK_PERIOD, pdTRUE, nullptr,
+                                         blink_tick, &blink_timer_control);
+        if (!init_external()) {
+            return false;
+        }
+    }
+    return led_mutex && blink_timer;
+}
+
 void on() {
+    lock();
     set_led(true);
+    show_external(heartbeat_bits());
+    unlock();
 }
 
 void off() {
+    lock();
     set_led(false);
+    show_external(0);
+    unlock();
 }
 
 void start_blink(uint32_t interval_ms) {
-    if (blink_timer) {
-        xTimerStop(blink_timer, 0);
-        xTimerDelete(blink_timer, 0);
-    }
-    blink_timer = xTimerCreate("led", pdMS_TO_TICKS(interval_ms), pdTRUE, nullptr, blink_tick);
-    if (blink_timer) {
+    lock();
+    show_external(blink_bits(interval_ms));
+    // With a hardware-driven LED showing activity the onboard one stays solid
+    if (!HAS_EXTERNAL_LED && blink_timer) {
+        blinking = true;
         set_led(true);
-        xTimerStart(blink_timer, 0);
+        // Changing the period also (re)starts the timer
+        xTimerChangePeriod(blink_timer,
+                           pdMS_TO_TICKS(std::max(interval_ms, CYW43_MIN_BLINK_MS)), 0);
     }
+    unlock();
 }
 
 void stop_blink() {
-    if (blink_timer) {
+    lock();
+    if (blinking) {
         xTimerStop(blink_timer, 0);
-        xTimerDelete(blink_timer, 0);
-        blink_timer = nullptr;
+        blinking = false;
     }
     set_led(true);  // Return to solid on
+    show_external(heartbeat_bits());
+    unlock();
+}
+
+void show_code(uint8_t count) {
+    lock();
+    show_external(flash_code_bits(count));
+    unlock();
 }
 
 } // namespace led
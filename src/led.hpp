@@ -3,7 +3,15 @@
  * @brief LED control for Pico W onboard LED.
  *
  * The Pico W's LED is connected through the CYW43 WiFi chip,
- * requiring cyw43_arch functions rather than direct GPIO.
+ * requiring cyw43_arch functions rather than direct GPIO. Each change is
+ * a transaction on the gSPI bus the scan also uses, so onboard blinking
+ * is limited to 250 ms per state and redundant writes are skipped.
+ *
+ * Building with -DLED_EXTERNAL_PIN=<gpio> adds a status LED on that pin,
+ * driven by a PIO state machine that loops a pattern (led_pattern.hpp)
+ * without any CPU or timer involvement. It shows a heartbeat where the
+ * onboard LED is solid on, blinks during scans in place of the onboard
+ * LED, and can show status codes.
  */
 
 #ifndef LED_HPP
@@ -13,6 +21,16 @@
 
 namespace led {
 
+/**
+ * @brief Create the LED lock and blink timer (statically allocated), and
+ *        claim a PIO state machine for the external LED if there is one.
+ * @return false if no PIO state machine was free
+ *
+ * Call before tasks that use the LED start; the lock makes the other
+ * functions safe from any task or core.
+ */
+[[nodiscard]] bool init();
+
 /**
  * @brief Turn LED on (solid).
  */
@@ -34,6 +52,15 @@ void start_blink(uint32_t interval_ms = 50);
  */
 void stop_blink();
 
+/**
+ * @brief Repeat count flashes followed by a pause on the external LED.
+ * @param count 1..MAX_FLASH_CODE
+ *
+ * Works before WiFi is up, so it can report init failures. No-op without
+ * an external LED.
+ */
+void show_code(uint8_t count);
+
 } // namespace led
 
 #endif // LED_HPP
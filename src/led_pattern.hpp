@@ -0,0 +1,76 @@
+/**
+ * @file led_pattern.hpp
+ * @brief LED patterns encoded as 32-slot on/off bit masks.
+ *
+ * The external status LED is driven by a PIO state machine that loops
+ * over one 32-bit word forever, shifting out a bit every PATTERN_SLOT_MS
+ * (led_pattern.pio), so a pattern costs the CPU nothing once loaded.
+ * Bit i is slot i, LSB first.
+ */
+
+#ifndef LED_PATTERN_HPP
+#define LED_PATTERN_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+/// Duration of one pattern slot
+inline constexpr uint32_t PATTERN_SLOT_MS = 50;
+
+/// Slots per pattern cycle (one 32-bit word, 1.6 s)
+inline constexpr std::size_t PATTERN_SLOTS = 32;
+
+/// Longest status code that still leaves a visible pause before it repeats
+inline constexpr uint8_t MAX_FLASH_CODE = 6;
+
+/**
+ * @brief Pattern that blinks with a 50% duty cycle.
+ * @param interval_ms Time the LED stays in each state
+ *
+ * The interval is rounded down to a power of two slots between 50 and
+ * 800 ms, so the blink stays even across the end of the cycle.
+ */
+[[nodiscard]] constexpr uint32_t blink_bits(uint32_t interval_ms) noexcept {
+    const uint32_t slots = std::max<uint32_t>(interval_ms / PATTERN_SLOT_MS, 1);
+    const uint32_t half = std::min<uint32_t>(std::bit_floor(slots), PATTERN_SLOTS / 2);
+    uint32_t bits = 0;
+    for (uint32_t i = 0; i < PATTERN_SLOTS; i++) {
+        if ((i / half) % 2 == 0) {
+            bits |= 1u << i;
+        }
+    }
+    return bits;
+}
+
+/**
+ * @brief Double pulse ("lub-dub") then a long pause, once per cycle.
+ */
+[[nodiscard]] constexpr uint32_t heartbeat_bits() noexcept {
+    // 100 ms on, 100 ms off, 100 ms on, 1.3 s off
+    return 0b0011'0011u;
+}
+
+/**
+ * @brief Status code: count flashes then a pause, once per cycle.
+ * @param count 1..MAX_FLASH_CODE (clamped)
+ */
+[[nodiscard]] constexpr uint32_t flash_code_bits(uint8_t count) noexcept {
+    count = std::clamp<uint8_t>(count, 1, MAX_FLASH_CODE);
+    uint32_t bits = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        bits |= 0b0011u << (4 * i);   // 100 ms on, 100 ms off
+    }
+    return bits;
+}
+
+/**
+ * @brief LED level a pattern shows t_ms after its cycle started.
+ */
+[[nodiscard]] constexpr bool pattern_level(uint32_t bits, uint32_t t_ms) noexcept {
+    const uint32_t slot = (t_ms / PATTERN_SLOT_MS) % PATTERN_SLOTS;
+    return (bits >> slot) & 1u;
+}
+
+#endif // LED_PATTERN_HPP
@@ -0,0 +1,112 @@
+/**
+ * @file log_frame.hpp
+ * @brief Compact binary encoding of deferred log records.
+ *
+ * A frame carries only a format-string ID, the tick and the raw argument
+ * words; the host rebuilds the text from the firmware ELF (see
+ * tools/pico.py rtt-log). Layout before framing:
+ *
+ *   header   1 byte   bits 0-2 argument count, bits 3-4 core, bits 5-7 version
+ *   id       varint   format site ID + 1 (0 = "records dropped", one argument)
+ *   tick     varint   xTaskGetTickCount() at the call
+ *   args     varint   one per argument, raw 32-bit words
+ *
+ * Varints are unsigned LEB128. The payload is COBS-encoded and terminated
+ * by a zero byte, so a reader that connects mid-stream resynchronizes at
+ * the next frame.
+ */
+
+#ifndef LOG_FRAME_HPP
+#define LOG_FRAME_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace dlog_frame {
+
+/// Format version in the header's top bits
+inline constexpr uint8_t VERSION = 1;
+
+/// Most argument words a frame can carry
+inline constexpr std::size_t MAX_ARGS = 7;
+
+/// Wire ID reserved for the dropped-records notice
+inline constexpr uint32_t DROPPED_ID = 0;
+
+/// Longest unsigned LEB128 encoding of a 32-bit value
+inline constexpr std::size_t MAX_VARINT = 5;
+
+/// Longest payload before COBS
+inline constexpr std::size_t MAX_PAYLOAD = 1 + (2 + MAX_ARGS) * MAX_VARINT;
+
+/// Longest encoded frame: COBS adds one byte per 254, plus the delimiter
+inline constexpr std::size_t MAX_FRAME = MAX_PAYLOAD + 1 + 1;
+
+/**
+ * @brief Append v as unsigned LEB128.
+ * @return Bytes written
+ */
+[[nodiscard]] constexpr std::size_t put_varint(uint8_t* out, uint32_t v) noexcept {
+    std::size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = static_cast<uint8_t>(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = static_cast<uint8_t>(v);
+    return n;
+}
+
+/**
+ * @brief COBS-encode len bytes of in into out and append the zero delimiter.
+ * @return Bytes written (at most len + len / 254 + 2)
+ */
+[[nodiscard]] constexpr std::size_t cobs_encode(const uint8_t* in, std::size_t len,
+                                                uint8_t* out) noexcept {
+    std::size_t code_pos = 0;
+    std::size_t n = 1;
+    uint8_t code = 1;
+    for (std::size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code_pos] = code;
+            code_pos = n++;
+            code = 1;
+            continue;
+        }
+        out[n++] = in[i];
+        if (++code == 0xFF) {
+            out[code_pos] = code;
+            code_pos = n++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    out[n++] = 0;
+    return n;
+}
+
+/**
+ * @brief Encode one log record as a delimited frame.
+ * @param id Wire ID (site ID + 1, or DROPPED_ID)
+ * @param nargs Number of words in args (at most MAX_ARGS)
+ * @param out Buffer of at least MAX_FRAME bytes
+ * @return Frame length including the delimiter
+ */
+[[nodiscard]] constexpr std::size_t encode(uint32_t id, uint32_t tick, uint8_t core,
+                                           const uint32_t* args, std::size_t nargs,
+                                           uint8_t* out) noexcept {
+    std::array<uint8_t, MAX_PAYLOAD> payload{};
+    nargs = nargs < MAX_ARGS ? nargs : MAX_ARGS;
+    std::size_t n = 0;
+    payload[n++] = static_cast<uint8_t>(nargs | (core & 0x03) << 3 | VERSION << 5);
+    n += put_varint(&payload[n], id);
+    n += put_varint(&payload[n], tick);
+    for (std::size_t i = 0; i < nargs; i++) {
+        n += put_varint(&payload[n], args[i]);
+    }
+    return cobs_encode(payload.data(), n, out);
+}
+
+} // namespace dlog_frame
+
+#endif // LOG_FRAME_HPP
@@ -0,0 +1,138 @@
+/**
+ * @file log_ring.hpp
+ * @brief Bounded lock-free multi-producer ring buffer for deferred logging.
+ */
+
+#ifndef LOG_RING_HPP
+#define LOG_RING_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+/**
+ * @brief Fixed-size MPMC queue of trivially copyable records.
+ *
+ * Each slot carries a sequence number that tells producers and consumers
+ * whose turn it is (D. Vyukov's bounded queue), so pushing is one
+ * compare-and-swap plus a copy and never blocks. That makes it safe from
+ * any task or ISR, with no critical section on the logging path. When the
+ * ring is full, new records are dropped and counted rather than
+ * overwriting ones the consumer has not seen.
+ *
+ * Needs lock-free 32-bit atomics (LDREX/STREX on Cortex-M33).
+ *
+ * @tparam T Record type
+ * @tparam N Capacity, a power of two
+ */
+template <typename T, std::size_t N>
+class LogRing {
+    static_assert(std::has_single_bit(N), "capacity must be a power of two");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+public:
+    LogRing() noexcept {
+        for (uint32_t i = 0; i < N; i++) {
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    /**
+     * @brief Append a record.
+     * @return false if the ring was full (the record is dropped and counted)
+     */
+    bool try_push(const T& record) noexcept {
+        bool was_empty = false;
+        return try_push(record, was_empty);
+    }
+
+    /**
+     * @brief Append a record and report whether the consumer had caught up.
+     * @param[out] was_empty true if every earlier record had been taken
+     * @return false if the ring was full (the record is dropped and counted)
+     *
+     * Lets a producer wake a sleeping consumer only on the transition from
+     * empty to non-empty, instead of on every record.
+     */
+    bool try_push(const T& record, bool& was_empty) noexcept {
+        was_empty = false;
+        uint32_t pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[pos & MASK];
+            const uint32_t seq = slot.seq.load(std::memory_order_acquire);
+            const auto lag = static_cast<int32_t>(seq - pos);
+            if (lag == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.record = record;
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+                    was_empty = static_cast<int32_t>(tail - pos) >= 0;
+                    return true;
+                }
+            } else if (lag < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Remove the oldest record.
+     * @return false if the ring is empty or the oldest record is still being written
+     */
+    bool try_pop(T& record) noexcept {
+        uint32_t pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[pos & MASK];
+            const uint32_t seq = slot.seq.load(std::memory_order_acquire);
+            const auto lag = static_cast<int32_t>(seq - (pos + 1));
+            if (lag == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    record = slot.record;
+                    slot.seq.store(pos + N, std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Take and reset the number of records dropped since the last call.
+     */
+    uint32_t take_dropped() noexcept {
+        return dropped_.exchange(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Capacity in records.
+     */
+    [[nodiscard]] static constexpr std::size_t capacity() noexcept {
+        return N;
+    }
+
+private:
+    static constexpr uint32_t MASK = N - 1;
+
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        T record;
+    };
+
+    std::array<Slot, N> slots_{};
+    std::atomic<uint32_t> head_{0};
+    std::atomic<uint32_t> tail_{0};
+    std::atomic<uint32_t> dropped_{0};
+};
+
+#endif // LOG_RING_HPP
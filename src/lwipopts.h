@@ -25,13 +25,46 @@
 #define TCPIP_THREAD_STACKSIZE          1024
 #define TCPIP_THREAD_PRIO               (configMAX_PRIORITIES - 2)
 
+/*
+ * Memory profiles, selected with -DLWIP_PROFILE=<name> (src/CMakeLists.txt).
+ * Each pool pbuf holds one full-size frame (about 1.5 KB); build with
+ * -DNET_PERF=ON to measure a profile (net_perf.hpp).
+ *
+ *   low-memory       8 pool pbufs, 2-segment TCP windows   (~15 KB)
+ *   balanced        24 pool pbufs, 8-segment TCP windows   (~42 KB)
+ *   high-throughput 48 pool pbufs, 16-segment TCP windows  (~110 KB)
+ */
+#define LWIP_PROFILE_LOW_MEMORY         1
+#define LWIP_PROFILE_BALANCED           2
+#define LWIP_PROFILE_HIGH_THROUGHPUT    3
+
+#ifndef LWIP_PROFILE
+#define LWIP_PROFILE                    LWIP_PROFILE_BALANCED
+#endif
+
+#if LWIP_PROFILE == LWIP_PROFILE_LOW_MEMORY
+#define MEM_SIZE                        2000
+#define PBUF_POOL_SIZE                  8
+#define TCP_WND_SEGMENTS                2
+#define MEMP_NUM_TCP_SEG                8
+#elif LWIP_PROFILE == LWIP_PROFILE_BALANCED
+#define MEM_SIZE                        4000
+#define PBUF_POOL_SIZE                  24
+#define TCP_WND_SEGMENTS                8
+#define MEMP_NUM_TCP_SEG                32
+#elif LWIP_PROFILE == LWIP_PROFILE_HIGH_THROUGHPUT
+#define MEM_SIZE                        32000
+#define PBUF_POOL_SIZE                  48
+#define TCP_WND_SEGMENTS                16
+#define MEMP_NUM_TCP_SEG                64
+#else
+#error "Unknown LWIP_PROFILE"
+#endif
+
 /* Memory configuration */
 #define MEM_LIBC_MALLOC                 0
 #define MEM_ALIGNMENT                   4
-#define MEM_SIZE                        4000
-#define MEMP_NUM_TCP_SEG                32
 #define MEMP_NUM_ARP_QUEUE              10
-#define PBUF_POOL_SIZE                  24
 
 /* Core protocols */
 #define LWIP_ARP                        1
@@ -45,9 +78,9 @@
 #define LWIP_DHCP                       1
 
 /* TCP tuning */
-#define TCP_WND                         (8 * TCP_MSS)
+#define TCP_WND                         (TCP_WND_SEGMENTS * TCP_MSS)
 #define TCP_MSS                         1460
-#define TCP_SND_BUF                     (8 * TCP_MSS)
+#define TCP_SND_BUF                     (TCP_WND_SEGMENTS * TCP_MSS)
 #define TCP_SND_QUEUELEN                ((4 * (TCP_SND_BUF) + (TCP_MSS - 1)) / (TCP_MSS))
 #define LWIP_TCP_KEEPALIVE              1
 
@@ -57,6 +90,9 @@
 #define LWIP_NETIF_HOSTNAME             1
 #define LWIP_NETIF_TX_SINGLE_PBUF       1
 
+/* Static telemetry datagrams are sent as custom pbufs (telemetry.cpp) */
+#define LWIP_SUPPORT_CUSTOM_PBUF        1
+
 /* No netconn/socket API needed */
 #define LWIP_NETCONN                    0
 
@@ -67,11 +103,20 @@
 /* Checksum */
 #define LWIP_CHKSUM_ALGORITHM           3
 
-/* Statistics (disabled for size) */
-#define MEM_STATS                       0
-#define SYS_STATS                       0
-#define MEMP_STATS                      0
-#define LINK_STATS                      0
+/* Statistics: on in non-release and throughput-test builds (net_stats.hpp) */
+#if !defined(NDEBUG) || NET_PERF_ENABLED
+#define LWIP_STATS                      1
+#define LWIP_STATS_LARGE                1
+#define MEM_STATS                       1
+#define MEMP_STATS                      1
+#define SYS_STATS                       1
+#define LINK_STATS                      1
+#define IP_STATS                        1
+#define TCP_STATS                       1
+#define UDP_STATS                       1
+#else
+#define LWIP_STATS                      0
+#endif
 
 /* Debug (disabled for release) */
 #define LWIP_DEBUG                      0
@@ -3,60 +3,231 @@
  * @brief Pico 2 W WiFi Scanner - FreeRTOS application.
  *
  * Architecture:
- *   - Main task: Periodically requests scans and displays results
+ *   - WiFi init task: Loads the CYW43 firmware and starts the scanner at
+ *     boot, then exits
+ *   - Main task: Restores the scan log while the radio comes up, then
+ *     starts the remaining services and exits
+ *   - Scan scheduler task: Requests scans on an adaptive interval, displays
+ *     changes (added, removed, RSSI moved) since the previous scan
  *   - Scanner task: Waits for requests, performs scans, returns results
+ *   - Scan store task: Persists changed scans to flash, restored at boot
+ *   - Telemetry task: Batches changed scans into UDP datagrams (optional)
+ *   - Station task: Stays associated with a configured network (optional)
+ *   - Net perf task: Logs iperf2 throughput test results (optional)
+ *   - Each scheduled scan is matched against reference fingerprints for a
+ *     position estimate (optional)
+ *   - Supervisor task: Feeds the hardware watchdog while the scanner and
+ *     scheduler keep their deadlines (optional)
  *   - LED blinks during active scans
  */
 
+#include <array>
 #include <cstdio>
 #include "pico/stdlib.h"
 #include "FreeRTOS.h"
 #include "task.h"
 
 #include "scan_msg.hpp"
+#include "console_format.hpp"
+#include "power_profile.hpp"
+#include "boot_timeline.hpp"
+#include "fingerprint.hpp"
 #include "wifi_scanner.hpp"
 #include "led.hpp"
 #include "debug_log.hpp"
+#include "cores.hpp"
+#include "sysmon.hpp"
+#include "supervisor.hpp"
+#include "scan_store.hpp"
+#include "telemetry.hpp"
+#include "station.hpp"
+#include "net_perf.hpp"
+
+// Console layout for AP rows (set with -DCONSOLE_FORMAT=table|csv|json)
+#ifndef CONSOLE_FORMAT
+#define CONSOLE_FORMAT ConsoleFormat::TABLE
+#endif
+
+// Scan power profile (set with -DSCAN_POWER_PROFILE=performance|balanced|low-power|auto)
+#ifndef SCAN_POWER_PROFILE
+#define SCAN_POWER_PROFILE PowerProfile::BALANCED
+#endif
+#ifndef SCAN_POWER_PROFILE_AUTO
+#define SCAN_POWER_PROFILE_AUTO 0
+#endif
+
+// Reference location table from `just fingerprints` (set with -DFINGERPRINT_DB=<file>)
+#ifndef FINGERPRINT_ENABLED
+#define FINGERPRINT_ENABLED 0
+#endif
 
 namespace {
 
-constexpr uint32_t MAIN_STACK_SIZE = 2048;
+// Both boot tasks delete themselves, so their stacks are sized to what they
+// use (each logs its high-water mark on exit) rather than generously.
+// main_task holds one ScanResult (~1 KB) at a time on its stack, in
+// restore_scans() or find_known_networks() (kept out of line so the two
+// frames are never merged), on top of printf.
+constexpr uint32_t MAIN_STACK_SIZE = 1280;
 constexpr UBaseType_t MAIN_PRIORITY = tskIDLE_PRIORITY + 1;
-constexpr uint32_t SCAN_INTERVAL_MS = 20000;
+
+TaskMemory<MAIN_STACK_SIZE> g_main_memory;
+
+// CYW43 bring-up runs on the network core, in parallel with main_task
+constexpr uint32_t WIFI_INIT_STACK_SIZE = 1024;
+constexpr UBaseType_t WIFI_INIT_PRIORITY = tskIDLE_PRIORITY + 2;
+
+TaskMemory<WIFI_INIT_STACK_SIZE> g_wifi_init_memory;
+
+// wifi_init_task reports its outcome on this notification index of main_task
+constexpr UBaseType_t RADIO_NOTIFY_INDEX = 0;
 
 /**
- * @brief Print a single AP to console.
+ * @brief Outcome of wifi_init_task, as its notification value.
  */
-void print_ap(const APInfo& ap) {
-    char bssid_str[18];
-    ap.format_bssid(bssid_str, sizeof(bssid_str));
+enum RadioOutcome : uint32_t {
+    RADIO_UP = 1,
+    RADIO_INIT_FAILED,
+    RADIO_SCANNER_FAILED
+};
+
+// Written by wifi_init_task before it notifies main_task
+PowerProfile g_power_profile = PowerProfile::BALANCED;
+
+// Boot phase timestamps, reported with the first scan
+BootTimeline g_boot;
+
+// Flash codes shown on the external status LED when startup halts
+constexpr uint8_t HALT_CODE_WIFI_INIT = 2;
+constexpr uint8_t HALT_CODE_SCANNER = 3;
+constexpr uint8_t HALT_CODE_SCHEDULER = 4;
+
+// Kernel task memory handed out by the vApplicationGet*TaskMemory() hooks
+TaskMemory<configMINIMAL_STACK_SIZE> g_idle_memory;
+#if configNUMBER_OF_CORES > 1
+std::array<TaskMemory<configMINIMAL_STACK_SIZE>, configNUMBER_OF_CORES - 1> g_passive_idle_memory;
+#endif
+TaskMemory<configTIMER_TASK_STACK_DEPTH> g_timer_memory;
+
+// Scan every 20 s while the environment changes, backing off to 5 min when stable
+constexpr ScheduleConfig SCAN_SCHEDULE{
+    .min_interval_ms = 20000,
+    .max_interval_ms = 300000,
+    .backoff_percent = 200,
+    .change_tolerance = 1,
+    .min_overlap_percent = 75,
+};
+
+// AP rows are rendered here and written to stdio in one call per batch.
+// Used by the main task until the scan scheduler starts, then only by the
+// scheduler task (its listeners).
+constexpr std::size_t CONSOLE_BUFFER_SIZE = 4096;
+ConsoleBuffer<CONSOLE_BUFFER_SIZE> g_console;
+
+#if FINGERPRINT_ENABLED
+constexpr FingerprintLocation FINGERPRINT_LOCATIONS[] = {
+#include FINGERPRINT_DB_FILE
+};
+constexpr FingerprintDb FINGERPRINTS{FINGERPRINT_LOCATIONS, std::size(FINGERPRINT_LOCATIONS)};
+static_assert(FINGERPRINTS.valid(), "Fingerprint table must be sorted by BSSID");
+#endif
 
-    printf("  %-32s  %s  ch%2u  %4ddBm  %s\n",
-           ap.ssid.data(),
-           bssid_str,
-           ap.channel,
-           ap.rssi,
-           auth_mode_to_string(ap.auth));
+/**
+ * @brief Write out the buffered rows in one pass through the stdio drivers.
+ */
+void flush_console() {
+    if (!g_console.empty()) {
+        stdio_put_string(g_console.data(), static_cast<int>(g_console.size()), false, true);
+        g_console.clear();
+    }
 }
 
 /**
- * @brief Print scan results to console.
+ * @brief Buffer a single AP row, prefixed with marker, flushing first if the buffer is full.
  */
-void print_results(const ScanResult& result) {
-    if (!result.success) {
-        printf("Scan failed (error: %d)\n\n", static_cast<int>(result.error_code));
-        return;
+void print_ap(char marker, const APInfo& ap, int32_t previous_rssi = NO_PREVIOUS_RSSI) {
+    if (!append_ap(g_console, CONSOLE_FORMAT, marker, ap, previous_rssi)) {
+        flush_console();
+        [[maybe_unused]] const bool added =
+            append_ap(g_console, CONSOLE_FORMAT, marker, ap, previous_rssi);
     }
+}
 
-    printf("\n");
-    printf("  %-32s  %-17s  %3s  %7s  %s\n", "SSID", "BSSID", "CH", "RSSI", "AUTH");
-    printf("  %s\n", "--------------------------------------------------------------------------------");
+/**
+ * @brief Append the reference location nearest to scan (if any is configured) to out.
+ */
+template <std::size_t N>
+void locate(const ScanResult& scan, ConsoleBuffer<N>& out) {
+#if FINGERPRINT_ENABLED
+    const FingerprintMatch match = FINGERPRINTS.match(fingerprint_of(scan));
+    const char* name = match.found() ? FINGERPRINTS[match.location].name : nullptr;
+    if (name) {
+        DBG_INFO("Locate", "%s, %lu/256 dB RMS over %u APs, next nearest %lu/256 dB", name,
+                 static_cast<unsigned long>(match.distance.rms_q8), match.distance.common,
+                 static_cast<unsigned long>(match.runner_up_q8));
+    } else {
+        DBG_INFO("Locate", "No reference location shares %u APs with the scan",
+                 FINGERPRINT_MIN_COMMON);
+    }
+    [[maybe_unused]] const bool added = append_location(out, CONSOLE_FORMAT, name,
+                                                        match.distance.rms_q8,
+                                                        match.distance.common);
+#else
+    static_cast<void>(scan);
+    static_cast<void>(out);
+#endif
+}
 
-    for (uint16_t i = 0; i < result.count; i++) {
-        print_ap(result.networks[i]);
+/**
+ * @brief Log where the boot time went, once the first scan is in.
+ */
+void report_boot() {
+    for (std::size_t i = 0; i < BOOT_PHASES; i++) {
+        const auto phase = static_cast<BootPhase>(i);
+        if (g_boot.reached(phase)) {
+            DBG_INFO("Boot", "%s at %lu us", boot_phase_name(phase),
+                     static_cast<unsigned long>(g_boot.at_us(phase)));
+        }
     }
+    printf("Boot: radio up in %lu ms, first scan at %lu ms\n",
+           static_cast<unsigned long>(
+               g_boot.between_us(BootPhase::RADIO_START, BootPhase::RADIO_READY) / 1000),
+           static_cast<unsigned long>(g_boot.at_us(BootPhase::FIRST_SCAN) / 1000));
+}
 
-    printf("\n  Found %u networks\n\n", result.count);
+/**
+ * @brief Mark the first scan result of the boot, reporting the timeline the first time.
+ */
+void mark_first_scan() {
+    if (g_boot.mark(BootPhase::FIRST_SCAN, time_us_64())) {
+        report_boot();
+    }
+}
+
+/**
+ * @brief Scan scheduler listener: print a one-line summary, then the changes buffered for it.
+ */
+void on_scan(const ScanResult& result, bool changed, void* ctx) {
+    static_cast<void>(ctx);
+    DBG_INFO("Main", "Scan complete: %u networks found", result.count);
+    mark_first_scan();
+    ConsoleBuffer<128> summary;
+    [[maybe_unused]] const bool added =
+        append_scan_summary(summary, CONSOLE_FORMAT, result.count, changed);
+    locate(result, summary);
+    if (!g_console.prepend(summary.data(), summary.size())) {
+        stdio_put_string(summary.data(), static_cast<int>(summary.size()), false, true);
+    }
+    flush_console();
+}
+
+/**
+ * @brief Delta listener: buffer each added, removed or changed AP for on_scan().
+ */
+void on_delta(const APEvent& event, void* ctx) {
+    static_cast<void>(ctx);
+    print_ap(ap_change_marker(event.change), event.ap,
+             event.change == APChange::RSSI_CHANGED ? event.previous_rssi : NO_PREVIOUS_RSSI);
 }
 
 /**
@@ -71,23 +242,120 @@ void print_banner() {
 }
 
 /**
- * @brief Initialize WiFi subsystem.
- * @return true on success
+ * @brief Say so if this boot is the supervisor's recovery from a hung task.
  */
-bool init_wifi() {
+void print_recovery() {
+    const supervisor::BootRecovery recovery = supervisor::boot_recovery();
+    if (!recovery.record.supervised()) {
+        return;
+    }
+    DBG_WARN("Main", "Watchdog reset: %s %s", watched_name(recovery.record.task),
+             reboot_cause_name(recovery.record.cause));
+    printf("Recovered from a watchdog reset (%s %s), %lu since power-on\n\n",
+           watched_name(recovery.record.task), reboot_cause_name(recovery.record.cause),
+           static_cast<unsigned long>(recovery.watchdog_resets));
+}
+
+/**
+ * @brief Power profile for this boot: the configured one, or by power source.
+ */
+PowerProfile choose_power_profile() {
+#if SCAN_POWER_PROFILE_AUTO
+    return auto_power_profile(wifi::on_battery());
+#else
+    return SCAN_POWER_PROFILE;
+#endif
+}
+
+/**
+ * @brief WiFi init task - CYW43 firmware download, power profile and scanner task.
+ * @param params main_task's handle, notified with a RadioOutcome
+ */
+void wifi_init_task(void* params) {
+    const auto main_handle = static_cast<TaskHandle_t>(params);
+
+    g_boot.mark(BootPhase::RADIO_START, time_us_64());
     DBG_INFO("Main", "WiFi init starting");
-    printf("Initializing WiFi...\n");
+    uint32_t outcome = RADIO_UP;
     if (!wifi::init()) {
         DBG_ERROR("Main", "WiFi init failed");
-        printf("ERROR: WiFi init failed!\n");
-        return false;
+        outcome = RADIO_INIT_FAILED;
+    } else {
+        g_boot.mark(BootPhase::RADIO_READY, time_us_64());
+        g_power_profile = choose_power_profile();
+        if (!wifi::set_power_profile(g_power_profile)) {
+            DBG_WARN("Main", "Radio power settings incomplete");
+        }
+        DBG_INFO("Main", "Starting scanner task");
+        if (wifi::start_scanner_task()) {
+            g_boot.mark(BootPhase::SCANNER_READY, time_us_64());
+        } else {
+            DBG_ERROR("Main", "Failed to start scanner task");
+            outcome = RADIO_SCANNER_FAILED;
+        }
     }
-    DBG_INFO("Main", "WiFi init complete");
-    printf("WiFi initialized.\n\n");
+    DBG_INFO("Main", "WiFi init done, %lu stack words unused",
+             static_cast<unsigned long>(uxTaskGetStackHighWaterMark(nullptr)));
+    xTaskNotifyIndexed(main_handle, RADIO_NOTIFY_INDEX, outcome, eSetValueWithOverwrite);
+    vTaskDelete(nullptr);
+}
 
-    // LED solid on when idle
-    led::on();
-    return true;
+/**
+ * @brief Wait for wifi_init_task.
+ * @return Its RadioOutcome
+ */
+uint32_t wait_for_radio() {
+    uint32_t outcome = 0;
+    xTaskNotifyWaitIndexed(RADIO_NOTIFY_INDEX, 0, UINT32_MAX, &outcome, portMAX_DELAY);
+    return outcome;
+}
+
+/**
+ * @brief Mount the scan log and print the APs saved by the previous run.
+ */
+[[gnu::noinline]] void restore_scans() {
+    if (!scan_store::start()) {
+        DBG_ERROR("Main", "Failed to start scan store");
+        return;
+    }
+    // On the stack: released once the restore is printed
+    ScanResult restored;
+    uint32_t sequence = 0;
+    if (!scan_store::load_latest(restored, &sequence)) {
+        return;
+    }
+    printf("Restored %u APs from flash (record %lu):\n", restored.count,
+           static_cast<unsigned long>(sequence));
+    for (std::size_t i = 0; i < restored.count; i++) {
+        print_ap('*', restored.networks[i]);
+    }
+    flush_console();
+    printf("\n");
+}
+
+/**
+ * @brief Look for a known AP with a fast reconnect scan and print what answered.
+ */
+[[gnu::noinline]] void find_known_networks() {
+    const KnownNetworks known = wifi::known_networks();
+    if (known.empty()) {
+        return;
+    }
+    printf("Looking for %u known networks...\n", static_cast<unsigned>(known.size()));
+    // On the stack: released once the answers are printed
+    ScanResult found;
+    const uint64_t start_us = time_us_64();
+    if (!wifi::scan_known(&found)) {
+        printf("No known network in range.\n\n");
+        return;
+    }
+    mark_first_scan();
+    printf("Found after %lu ms:\n", static_cast<unsigned long>((time_us_64() - start_us) / 1000));
+    for (std::size_t i = 0; i < found.count; i++) {
+        print_ap('=', found.networks[i]);
+    }
+    flush_console();
+    printf("\n");
 }
 
 /**
@@ -96,39 +364,77 @@ bool init_wifi() {
 void main_task(void* params) {
     static_cast<void>(params);
 
+    g_boot.mark(BootPhase::SCHEDULER, time_us_64());
     DBG_INFO("Main", "main_task started");
     print_banner();
-
-    if (!init_wifi()) {
-        DBG_ERROR("Main", "Halting due to WiFi init failure");
-        while (true) { vTaskDelay(pdMS_TO_TICKS(1000)); }
+    print_recovery();
+    if (CONSOLE_FORMAT == ConsoleFormat::CSV) {
+        [[maybe_unused]] const bool added = append_csv_header(g_console);
+        flush_console();
     }
 
-    DBG_INFO("Main", "Starting scanner task");
-    if (!wifi::start_scanner_task()) {
-        DBG_ERROR("Main", "Failed to start scanner task");
-        printf("ERROR: Failed to start scanner task!\n");
-        while (true) { vTaskDelay(pdMS_TO_TICKS(1000)); }
+    // Flash only, so it overlaps the CYW43 firmware download. Before the
+    // scheduler, so the store sees the initial AP set as changes
+    restore_scans();
+    g_boot.mark(BootPhase::STORE_RESTORED, time_us_64());
+
+    printf("Initializing WiFi...\n");
+    switch (wait_for_radio()) {
+        case RADIO_UP:
+            break;
+        case RADIO_SCANNER_FAILED:
+            DBG_ERROR("Main", "Halting, scanner task not started");
+            printf("ERROR: Failed to start scanner task!\n");
+            led::show_code(HALT_CODE_SCANNER);
+            while (true) { vTaskDelay(pdMS_TO_TICKS(1000)); }
+        default:
+            DBG_ERROR("Main", "Halting due to WiFi init failure");
+            printf("ERROR: WiFi init failed!\n");
+            led::show_code(HALT_CODE_WIFI_INIT);
+            while (true) { vTaskDelay(pdMS_TO_TICKS(1000)); }
     }
-    DBG_INFO("Main", "Scanner task started");
+    printf("WiFi initialized.\n\n");
+    // LED solid on when idle
+    led::on();
 
-    printf("Scanning every %u seconds...\n", SCAN_INTERVAL_MS / 1000);
+    printf("Power profile: %s\n", power_profile_name(g_power_profile));
+    const ScheduleConfig schedule =
+        apply_power_settings(SCAN_SCHEDULE, power_settings(g_power_profile));
 
-    ScanResult result;
-    while (true) {
-        DBG_INFO("Main", "Requesting scan");
-        printf("--- Starting scan ---\n");
+    find_known_networks();
 
-        if (wifi::request_scan(&result)) {
-            DBG_INFO("Main", "Scan complete: %u networks found", result.count);
-            print_results(result);
-        } else {
-            DBG_WARN("Main", "Scan timeout");
-            printf("Scan timeout!\n\n");
-        }
+    if (!telemetry::start()) {
+        DBG_ERROR("Main", "Failed to start telemetry");
+    }
+    // After the restore, so the join can use the cached BSSID and channel
+    if (!station::start()) {
+        DBG_ERROR("Main", "Failed to start station task");
+    }
+    if (!net_perf::start()) {
+        DBG_ERROR("Main", "Failed to start throughput test");
+    }
 
-        vTaskDelay(pdMS_TO_TICKS(SCAN_INTERVAL_MS));
+    // Subscribe first so the initial AP set is printed as additions
+    if (!wifi::subscribe_deltas(on_delta)) {
+        DBG_ERROR("Main", "Failed to subscribe to scan deltas");
+    }
+    if (!wifi::start_scan_scheduler(schedule, on_scan)) {
+        DBG_ERROR("Main", "Failed to start scan scheduler");
+        printf("ERROR: Failed to start scan scheduler!\n");
+        led::show_code(HALT_CODE_SCHEDULER);
+        while (true) { vTaskDelay(pdMS_TO_TICKS(1000)); }
     }
+    g_boot.mark(BootPhase::SERVICES, time_us_64());
+
+    printf("Scanning every %lu-%lu seconds (adaptive, %s)...\n",
+           static_cast<unsigned long>(schedule.min_interval_ms / 1000),
+           static_cast<unsigned long>(schedule.max_interval_ms / 1000),
+           schedule.mode == ScanMode::PASSIVE ? "passive" : "active");
+
+    DBG_INFO("Main", "main_task done, %lu stack words unused",
+             static_cast<unsigned long>(uxTaskGetStackHighWaterMark(nullptr)));
+    // Scheduler and scanner tasks take it from here
+    vTaskDelete(nullptr);
 }
 
 } // anonymous namespace
@@ -136,22 +442,69 @@ void main_task(void* params) {
 extern "C" void vApplicationStackOverflowHook(TaskHandle_t xTask, char* pcTaskName) {
     (void)xTask;
     DBG_ERROR("RTOS", "Stack overflow in task: %s", pcTaskName);
+    // The drain task will never run again; print what led up to this
+    dlog::flush();
     printf("STACK OVERFLOW: %s\n", pcTaskName);
     while (true) { tight_loop_contents(); }
 }
 
+extern "C" void vApplicationGetIdleTaskMemory(StaticTask_t** tcb, StackType_t** stack,
+                                              configSTACK_DEPTH_TYPE* stack_depth) {
+    *tcb = &g_idle_memory.tcb;
+    *stack = g_idle_memory.stack.data();
+    *stack_depth = g_idle_memory.stack.size();
+}
+
+#if configNUMBER_OF_CORES > 1
+extern "C" void vApplicationGetPassiveIdleTaskMemory(StaticTask_t** tcb, StackType_t** stack,
+                                                     configSTACK_DEPTH_TYPE* stack_depth,
+                                                     BaseType_t index) {
+    TaskMemory<configMINIMAL_STACK_SIZE>& memory = g_passive_idle_memory[index];
+    *tcb = &memory.tcb;
+    *stack = memory.stack.data();
+    *stack_depth = memory.stack.size();
+}
+#endif
+
+extern "C" void vApplicationGetTimerTaskMemory(StaticTask_t** tcb, StackType_t** stack,
+                                               configSTACK_DEPTH_TYPE* stack_depth) {
+    *tcb = &g_timer_memory.tcb;
+    *stack = g_timer_memory.stack.data();
+    *stack_depth = g_timer_memory.stack.size();
+}
+
 int main() {
+    g_boot.mark(BootPhase::MAIN, time_us_64());
     stdio_init_all();
+    g_boot.mark(BootPhase::STDIO, time_us_64());
+
+    if (!dlog::start()) {
+        printf("ERROR: Failed to start log drain task!\n");
+    }
+    if (!led::init()) {
+        printf("ERROR: Failed to initialize LEDs!\n");
+    }
+    if (!sysmon::start()) {
+        printf("ERROR: Failed to start sysmon task!\n");
+    }
+    if (!supervisor::start()) {
+        printf("ERROR: Failed to start supervisor task!\n");
+    }
 
     DBG_INFO("Main", "Firmware starting");
-    DBG_INFO("Main", "Creating main_task");
-    xTaskCreate(main_task, "main", MAIN_STACK_SIZE, nullptr, MAIN_PRIORITY, nullptr);
+    DBG_INFO("Main", "Creating main_task and wifi_init");
+    TaskHandle_t main_handle = create_pinned_task(main_task, "main", g_main_memory, nullptr,
+                                                  MAIN_PRIORITY, APP_CORE);
+    // Starts the firmware download as soon as the scheduler runs
+    create_pinned_task(wifi_init_task, "wifi_init", g_wifi_init_memory, main_handle,
+                       WIFI_INIT_PRIORITY, NETWORK_CORE);
 
     DBG_INFO("Main", "Starting FreeRTOS scheduler");
     vTaskStartScheduler();
 
     // Should never reach here
     DBG_ERROR("Main", "Scheduler exited unexpectedly");
+    dlog::flush();
     while (true) { tight_loop_contents(); }
     return 0;
 }
@@ -0,0 +1,171 @@
+/**
+ * @file net_perf.cpp
+ * @brief Throughput test: lwiperf TCP server, iperf2 UDP receiver, result logging.
+ */
+
+#include "net_perf.hpp"
+
+#if NET_PERF_ENABLED
+
+#include "iperf_udp.hpp"
+#include "net_stats.hpp"
+#include "cores.hpp"
+#include "debug_log.hpp"
+
+#include "pico/cyw43_arch.h"
+#include "pico/time.h"
+#include "lwip/apps/lwiperf.h"
+#include "lwip/def.h"
+#include "lwip/pbuf.h"
+#include "lwip/udp.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+namespace {
+
+static_assert(net_perf::PERF_PORT == LWIPERF_TCP_PORT_DEFAULT, "TCP and UDP share the port");
+
+constexpr uint32_t NET_PERF_STACK_SIZE = 1024;
+constexpr UBaseType_t NET_PERF_PRIORITY = tskIDLE_PRIORITY + 1;
+
+constexpr uint32_t PERF_EVENT_TCP = 1u << 0;    ///< A TCP test ended
+constexpr uint32_t PERF_EVENT_UDP = 1u << 1;    ///< A UDP test ended
+
+/**
+ * @brief Result handed over by lwiperf.
+ */
+struct TcpReport {
+    lwiperf_report_type type;
+    uint32_t bytes;
+    uint32_t ms;
+    uint32_t kbit_per_s;
+};
+
+// Written in the lwIP thread, read by the task under the lwIP lock
+TcpReport g_tcp_report{};
+IperfUdpTracker g_udp_tracker;
+IperfUdpReport g_udp_report{};
+
+udp_pcb* g_udp_pcb = nullptr;
+void* g_tcp_server = nullptr;
+
+TaskMemory<NET_PERF_STACK_SIZE> g_net_perf_memory;
+TaskHandle_t g_net_perf_task = nullptr;
+
+/**
+ * @brief lwiperf report callback (lwIP thread).
+ */
+void on_tcp_report(void* arg, enum lwiperf_report_type type, const ip_addr_t* local_addr,
+                   u16_t local_port, const ip_addr_t* remote_addr, u16_t remote_port,
+                   u32_t bytes, u32_t ms, u32_t kbit_per_s) {
+    static_cast<void>(arg);
+    static_cast<void>(local_addr);
+    static_cast<void>(local_port);
+    static_cast<void>(remote_addr);
+    static_cast<void>(remote_port);
+    g_tcp_report = TcpReport{type, bytes, ms, kbit_per_s};
+    xTaskNotify(g_net_perf_task, PERF_EVENT_TCP, eSetBits);
+}
+
+/**
+ * @brief UDP receive callback (lwIP thread): count the datagram and drop it.
+ */
+void on_udp_recv(void* arg, udp_pcb* pcb, pbuf* p, const ip_addr_t* addr, u16_t port) {
+    static_cast<void>(arg);
+    static_cast<void>(pcb);
+    static_cast<void>(addr);
+    static_cast<void>(port);
+
+    uint32_t id = 0;
+    if (pbuf_copy_partial(p, &id, sizeof(id), 0) == sizeof(id) &&
+        g_udp_tracker.on_datagram(static_cast<int32_t>(lwip_ntohl(id)), p->tot_len,
+                                  time_us_64())) {
+        g_udp_report = g_udp_tracker.report();
+        xTaskNotify(g_net_perf_task, PERF_EVENT_UDP, eSetBits);
+    }
+    pbuf_free(p);
+}
+
+const char* tcp_outcome(lwiperf_report_type type) {
+    switch (type) {
+        case LWIPERF_TCP_DONE_SERVER: return "receive";
+        case LWIPERF_TCP_DONE_CLIENT: return "send";
+        case LWIPERF_TCP_ABORTED_REMOTE: return "aborted by client";
+        default: return "aborted";
+    }
+}
+
+/**
+ * @brief Net perf task - logs each finished test with the lwIP counters.
+ */
+void net_perf_task(void* params) {
+    static_cast<void>(params);
+
+    NetCounters baseline = net_stats::sample();
+    while (true) {
+        uint32_t events = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &events, portMAX_DELAY);
+
+        cyw43_arch_lwip_begin();
+        const TcpReport tcp = g_tcp_report;
+        const IperfUdpReport udp = g_udp_report;
+        cyw43_arch_lwip_end();
+
+        if (events & PERF_EVENT_TCP) {
+            DBG_INFO("Perf", "TCP %s: %lu kbit/s, %lu bytes in %lu ms", tcp_outcome(tcp.type),
+                     static_cast<unsigned long>(tcp.kbit_per_s),
+                     static_cast<unsigned long>(tcp.bytes),
+                     static_cast<unsigned long>(tcp.ms));
+        }
+        if (events & PERF_EVENT_UDP) {
+            const uint32_t loss = udp.loss_per_mille();
+            DBG_INFO("Perf", "UDP receive: %lu kbit/s, %lu datagrams in %lu ms",
+                     static_cast<unsigned long>(udp.kbit_per_s()),
+                     static_cast<unsigned long>(udp.datagrams),
+                     static_cast<unsigned long>(udp.duration_us / 1000));
+            DBG_INFO("Perf", "UDP receive: %lu lost (%lu.%lu%%), %lu out of order",
+                     static_cast<unsigned long>(udp.lost),
+                     static_cast<unsigned long>(loss / 10), static_cast<unsigned long>(loss % 10),
+                     static_cast<unsigned long>(udp.out_of_order));
+        }
+
+        const NetCounters now = net_stats::sample();
+        net_stats::log("Since last test", now.since(baseline));
+        baseline = now;
+    }
+}
+
+} // anonymous namespace
+
+namespace net_perf {
+
+[[nodiscard]] bool start() {
+    if (g_net_perf_task) {
+        return false;
+    }
+    g_net_perf_task = create_pinned_task(net_perf_task, "net_perf", g_net_perf_memory, nullptr,
+                                         NET_PERF_PRIORITY, APP_CORE);
+    if (!g_net_perf_task) {
+        return false;
+    }
+
+    cyw43_arch_lwip_begin();
+    g_tcp_server = lwiperf_start_tcp_server_default(on_tcp_report, nullptr);
+    g_udp_pcb = udp_new();
+    const bool udp_ok = g_udp_pcb && udp_bind(g_udp_pcb, IP_ADDR_ANY, PERF_PORT) == ERR_OK;
+    if (udp_ok) {
+        udp_recv(g_udp_pcb, on_udp_recv, nullptr);
+    }
+    cyw43_arch_lwip_end();
+
+    if (!g_tcp_server || !udp_ok) {
+        DBG_ERROR("Perf", "Failed to listen on port %u", static_cast<unsigned>(PERF_PORT));
+        return false;
+    }
+    DBG_INFO("Perf", "iperf2 TCP and UDP on port %u", static_cast<unsigned>(PERF_PORT));
+    return true;
+}
+
+} // namespace net_perf
+
+#endif // NET_PERF_ENABLED
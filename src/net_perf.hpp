@@ -0,0 +1,48 @@
+/**
+ * @file net_perf.hpp
+ * @brief iperf2-compatible throughput test endpoints, for choosing an lwIP profile.
+ *
+ * Build with -DNET_PERF=ON (with -DWIFI_SSID, so there is a link to
+ * test). The device then answers iperf2 clients on PERF_PORT:
+ *
+ *   iperf -c <device> -t 10         TCP receive (lwIP's lwiperf server)
+ *   iperf -c <device> -t 10 -r      then TCP send, back to the client
+ *   iperf -c <device> -u -b 20M     UDP receive, with loss and reordering
+ *
+ * A net_perf task on the application core logs each result together
+ * with the lwIP pool, heap and drop counters since the previous result
+ * (net_stats.hpp), so a profile that runs out of pbufs shows it. The
+ * UDP client waits in vain for a server report and warns about it; the
+ * device's log has the numbers.
+ */
+
+#ifndef NET_PERF_HPP
+#define NET_PERF_HPP
+
+#include <cstdint>
+
+namespace net_perf {
+
+/// iperf2's default port, for TCP and UDP
+inline constexpr uint16_t PERF_PORT = 5001;
+
+#if NET_PERF_ENABLED
+
+/**
+ * @brief Start listening for tests and start the reporting task.
+ * @return false if the task or a listener could not be created
+ *
+ * Call after wifi::init().
+ */
+[[nodiscard]] bool start();
+
+#else
+
+// Throughput test compiled out
+[[nodiscard]] inline bool start() { return true; }
+
+#endif // NET_PERF_ENABLED
+
+} // namespace net_perf
+
+#endif // NET_PERF_HPP
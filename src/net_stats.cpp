@@ -0,0 +1,67 @@
+/**
+ * @file net_stats.cpp
+ * @brief Reads the lwIP statistics counters.
+ */
+
+#include "net_stats.hpp"
+#include "debug_log.hpp"
+
+#include "pico/cyw43_arch.h"
+#include "lwip/memp.h"
+#include "lwip/stats.h"
+
+namespace net_stats {
+
+[[nodiscard]] NetCounters sample() {
+    NetCounters counters;
+#if LWIP_STATS
+    cyw43_arch_lwip_begin();
+#if MEMP_STATS
+    counters.pbuf_pool_err = lwip_stats.memp[MEMP_PBUF_POOL]->err;
+    counters.pbuf_pool_max = lwip_stats.memp[MEMP_PBUF_POOL]->max;
+    counters.tcp_seg_err = lwip_stats.memp[MEMP_TCP_SEG]->err;
+#endif
+#if MEM_STATS
+    counters.mem_err = lwip_stats.mem.err;
+    counters.mem_max = lwip_stats.mem.max;
+#endif
+#if LINK_STATS
+    counters.link_recv = lwip_stats.link.recv;
+    counters.link_xmit = lwip_stats.link.xmit;
+    counters.link_drop = lwip_stats.link.drop;
+#endif
+#if TCP_STATS
+    counters.tcp_drop = lwip_stats.tcp.drop;
+#endif
+#if UDP_STATS
+    counters.udp_drop = lwip_stats.udp.drop;
+#endif
+    cyw43_arch_lwip_end();
+#endif // LWIP_STATS
+    return counters;
+}
+
+void log(const char* label, const NetCounters& counters) {
+#if LWIP_STATS
+    DBG_INFO("Net", "%s: pbuf pool %lu err, max %lu of %u", label,
+             static_cast<unsigned long>(counters.pbuf_pool_err),
+             static_cast<unsigned long>(counters.pbuf_pool_max),
+             static_cast<unsigned>(PBUF_POOL_SIZE));
+    DBG_INFO("Net", "%s: tcp seg %lu err; heap %lu err, max %lu of %u", label,
+             static_cast<unsigned long>(counters.tcp_seg_err),
+             static_cast<unsigned long>(counters.mem_err),
+             static_cast<unsigned long>(counters.mem_max),
+             static_cast<unsigned>(MEM_SIZE));
+    DBG_INFO("Net", "%s: link %lu rx, %lu tx, %lu drop; tcp %lu drop; udp %lu drop", label,
+             static_cast<unsigned long>(counters.link_recv),
+             static_cast<unsigned long>(counters.link_xmit),
+             static_cast<unsigned long>(counters.link_drop),
+             static_cast<unsigned long>(counters.tcp_drop),
+             static_cast<unsigned long>(counters.udp_drop));
+#else
+    static_cast<void>(label);
+    static_cast<void>(counters);
+#endif
+}
+
+} // namespace net_stats
@@ -0,0 +1,65 @@
+/**
+ * @file net_stats.hpp
+ * @brief lwIP drop and pool counters, for sizing the memory profile (lwipopts.h).
+ *
+ * The counters exist in builds with lwIP statistics (non-release builds,
+ * and -DNET_PERF=ON). A pool or heap error means an allocation failed: a
+ * frame received while the pbuf pool is exhausted is dropped before lwIP
+ * sees it, which only shows up in the PBUF_POOL error count.
+ */
+
+#ifndef NET_STATS_HPP
+#define NET_STATS_HPP
+
+#include <cstdint>
+
+/**
+ * @brief Snapshot of the lwIP counters worth watching.
+ */
+struct NetCounters {
+    uint32_t pbuf_pool_err{0};    ///< Failed PBUF_POOL allocations (receive drops)
+    uint32_t pbuf_pool_max{0};    ///< Most pool pbufs in use at once
+    uint32_t tcp_seg_err{0};      ///< Failed TCP segment allocations
+    uint32_t mem_err{0};          ///< Failed heap (PBUF_RAM) allocations
+    uint32_t mem_max{0};          ///< Most heap bytes in use at once
+    uint32_t link_recv{0};        ///< Frames received
+    uint32_t link_xmit{0};        ///< Frames sent
+    uint32_t link_drop{0};        ///< Frames dropped by the link layer
+    uint32_t tcp_drop{0};         ///< TCP segments dropped
+    uint32_t udp_drop{0};         ///< UDP datagrams dropped
+
+    /**
+     * @brief Counts since earlier; high-water marks stay the peaks since boot.
+     */
+    [[nodiscard]] NetCounters since(const NetCounters& earlier) const noexcept {
+        NetCounters delta = *this;
+        delta.pbuf_pool_err -= earlier.pbuf_pool_err;
+        delta.tcp_seg_err -= earlier.tcp_seg_err;
+        delta.mem_err -= earlier.mem_err;
+        delta.link_recv -= earlier.link_recv;
+        delta.link_xmit -= earlier.link_xmit;
+        delta.link_drop -= earlier.link_drop;
+        delta.tcp_drop -= earlier.tcp_drop;
+        delta.udp_drop -= earlier.udp_drop;
+        return delta;
+    }
+};
+
+namespace net_stats {
+
+/**
+ * @brief Read the counters (takes the lwIP lock); all zero without lwIP statistics.
+ */
+[[nodiscard]] NetCounters sample();
+
+/**
+ * @brief Log counters over the debug log, prefixed with what they cover.
+ * @param label String literal (the deferred log keeps only the pointer)
+ *
+ * Logs nothing without lwIP statistics.
+ */
+void log(const char* label, const NetCounters& counters);
+
+} // namespace net_stats
+
+#endif // NET_STATS_HPP
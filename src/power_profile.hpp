@@ -0,0 +1,116 @@
+/**
+ * @file power_profile.hpp
+ * @brief Scan power profiles: CYW43 power management, scan mode and cadence.
+ *
+ * The radio dominates a battery node's energy budget, and how often it
+ * scans is the biggest knob. A profile sets:
+ *
+ *   - the CYW43 power-save mode used while associated (none, PM2 with a
+ *     200 ms sleep return, or PM1: sleep between every beacon);
+ *   - whether the firmware may power the radio down while idle and not
+ *     associated (the "mpc" setting), so it sleeps between scheduled scans;
+ *   - active or passive scheduled scans, and the passive dwell per channel
+ *     (long enough to hear one 102.4 ms beacon interval);
+ *   - a scale for the scheduler's intervals.
+ *
+ * Radio-on time per scan (ScanStats::radio_on) is the energy proxy to
+ * compare profiles with: the CYW43439 draws roughly the same current
+ * whenever its receiver is on, so energy per scan follows radio time.
+ */
+
+#ifndef POWER_PROFILE_HPP
+#define POWER_PROFILE_HPP
+
+#include "scan_request.hpp"
+#include "scan_schedule.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * @brief Scan power profile.
+ */
+enum class PowerProfile : uint8_t {
+    PERFORMANCE = 0,    ///< Radio always ready, lowest latency, frequent scans
+    BALANCED,           ///< Driver defaults: PM2 while associated, active scans
+    ULTRA_LOW_POWER     ///< PM1, passive scans, long intervals (battery)
+};
+
+/**
+ * @brief CYW43 power-save mode while associated (CYW43_*_PM in the driver).
+ */
+enum class RadioPowerSave : uint8_t {
+    NONE = 0,       ///< Never sleep (CYW43_NONE_PM)
+    PERFORMANCE,    ///< PM2, back to sleep 200 ms after traffic (CYW43_PERFORMANCE_PM)
+    AGGRESSIVE      ///< PM1, sleep between beacons (CYW43_AGGRESSIVE_PM)
+};
+
+/**
+ * @brief Everything a profile sets.
+ */
+struct PowerSettings {
+    RadioPowerSave power_save;
+    bool idle_radio_off;            ///< Let the firmware power the radio down between scans
+    ScanMode scan_mode;             ///< Mode of scheduled scans
+    uint32_t passive_dwell_ms;      ///< Per-channel listen time of passive scans
+    uint16_t interval_percent;      ///< Scale for the schedule's intervals (100 = as configured)
+};
+
+[[nodiscard]] constexpr PowerSettings power_settings(PowerProfile profile) noexcept {
+    switch (profile) {
+        case PowerProfile::PERFORMANCE:
+            return {RadioPowerSave::NONE, false, ScanMode::ACTIVE, 110, 50};
+        case PowerProfile::ULTRA_LOW_POWER:
+            return {RadioPowerSave::AGGRESSIVE, true, ScanMode::PASSIVE, 120, 300};
+        case PowerProfile::BALANCED:
+        default:
+            return {RadioPowerSave::PERFORMANCE, true, ScanMode::ACTIVE, 110, 100};
+    }
+}
+
+[[nodiscard]] constexpr const char* power_profile_name(PowerProfile profile) noexcept {
+    switch (profile) {
+        case PowerProfile::PERFORMANCE:     return "performance";
+        case PowerProfile::BALANCED:        return "balanced";
+        case PowerProfile::ULTRA_LOW_POWER: return "ultra-low-power";
+        default:                            return "???";
+    }
+}
+
+/**
+ * @brief Profile for builds that pick one at boot: ultra-low-power on battery, else balanced.
+ */
+[[nodiscard]] constexpr PowerProfile auto_power_profile(bool on_battery) noexcept {
+    return on_battery ? PowerProfile::ULTRA_LOW_POWER : PowerProfile::BALANCED;
+}
+
+/**
+ * @brief config with its intervals scaled and its scan mode set for settings.
+ */
+[[nodiscard]] constexpr ScheduleConfig apply_power_settings(ScheduleConfig config,
+                                                            const PowerSettings& settings) noexcept {
+    const auto scale = [&](uint32_t ms) {
+        const uint64_t scaled = uint64_t{ms} * settings.interval_percent / 100;
+        return static_cast<uint32_t>(std::min<uint64_t>(scaled, UINT32_MAX));
+    };
+    config.min_interval_ms = scale(config.min_interval_ms);
+    config.max_interval_ms = scale(config.max_interval_ms);
+    config.mode = settings.scan_mode;
+    return config;
+}
+
+/**
+ * @brief Share of time the radio spent scanning, in parts per thousand.
+ * @param radio_on_us Radio time over the period (ScanStats::radio_on total)
+ * @param period_us Length of the period
+ */
+[[nodiscard]] constexpr uint32_t radio_duty_per_mille(uint64_t radio_on_us,
+                                                      uint64_t period_us) noexcept {
+    if (period_us == 0) {
+        return 0;
+    }
+    const uint64_t duty = radio_on_us * 1000 / period_us;
+    return static_cast<uint32_t>(std::min<uint64_t>(duty, 1000));
+}
+
+#endif // POWER_PROFILE_HPP
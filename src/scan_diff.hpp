@@ -0,0 +1,197 @@
+/**
+ * @file scan_diff.hpp
+ * @brief Incremental diff of successive scan results, keyed by BSSID.
+ */
+
+#ifndef SCAN_DIFF_HPP
+#define SCAN_DIFF_HPP
+
+#include "scan_msg.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * @brief Kind of change reported by BasicScanDiff.
+ */
+enum class APChange : uint8_t {
+    ADDED = 0,      ///< BSSID seen for the first time (or again after removal)
+    REMOVED,        ///< BSSID missing from enough consecutive scans
+    RSSI_CHANGED    ///< Signal moved by at least the RSSI threshold
+};
+
+/**
+ * @brief Convert APChange to a one-character marker (+, -, ~).
+ */
+[[nodiscard]] constexpr char ap_change_marker(APChange change) noexcept {
+    switch (change) {
+        case APChange::ADDED:           return '+';
+        case APChange::REMOVED:         return '-';
+        case APChange::RSSI_CHANGED:    return '~';
+    }
+    return '?';
+}
+
+/**
+ * @brief A single change between two scans.
+ */
+struct APEvent {
+    APChange change;        ///< What happened
+    APInfo ap;              ///< Current view of the AP (last known one for REMOVED)
+    int8_t previous_rssi;   ///< Last reported RSSI (RSSI_CHANGED only)
+};
+
+/**
+ * @brief Hysteresis thresholds for BasicScanDiff.
+ */
+struct DiffConfig {
+    uint8_t rssi_threshold_db{6};   ///< Minimum move from the last reported RSSI
+    uint8_t missed_scans{2};        ///< Consecutive scans an AP must miss to be removed
+};
+
+/**
+ * @brief Turns successive scans into added/removed/RSSI-changed events.
+ *
+ * Both directions have hysteresis, so an AP at the edge of range does not
+ * flap. RSSI is compared against the value last reported, not the last
+ * one seen, so slow drift is reported once it adds up to the threshold
+ * while noise around a level is not. An AP is removed only after it has
+ * been missing from missed_scans scans in a row.
+ *
+ * Up to N BSSIDs are tracked, including ones currently missing. When a
+ * new AP needs room, the one missing longest is removed early.
+ *
+ * @tparam N Tracked BSSIDs
+ */
+template <std::size_t N>
+class BasicScanDiff {
+public:
+    BasicScanDiff() noexcept : BasicScanDiff(DiffConfig{}) {}
+
+    explicit BasicScanDiff(const DiffConfig& config) noexcept
+        : config_(config) {
+        if (config_.missed_scans == 0) {
+            config_.missed_scans = 1;
+        }
+    }
+
+    /**
+     * @brief Compare scan with the tracked state and report the differences.
+     * @param sink Called as sink(const APEvent&) for every change
+     * @return Number of events reported
+     *
+     * Failed scans are ignored, so a radio error never looks like every
+     * AP disappearing.
+     */
+    template <std::size_t M, typename Sink>
+    std::size_t update(const BasicScanResult<M>& scan, Sink&& sink) {
+        if (!scan.success) {
+            return 0;
+        }
+
+        std::size_t events = 0;
+        std::array<bool, M> seen{};
+
+        for (std::size_t j = 0; j < count_;) {
+            const std::size_t i = scan.index_of(known_.bssid[j]);
+            if (i == BasicScanResult<M>::npos) {
+                if (++missed_[j] >= config_.missed_scans) {
+                    sink(APEvent{APChange::REMOVED, known_[j], 0});
+                    events++;
+                    erase(j);
+                    continue;
+                }
+            } else {
+                seen[i] = true;
+                missed_[j] = 0;
+                const int8_t previous = known_.rssi[j];
+                const int8_t current = scan.networks.rssi[i];
+                // Refresh SSID/channel/auth silently, RSSI only past the threshold
+                known_.set(j, scan.networks[i]);
+                if (std::abs(current - previous) >= config_.rssi_threshold_db) {
+                    sink(APEvent{APChange::RSSI_CHANGED, scan.networks[i], previous});
+                    events++;
+                } else {
+                    known_.rssi[j] = previous;
+                }
+            }
+            j++;
+        }
+
+        for (std::size_t i = 0; i < scan.count; i++) {
+            if (seen[i]) {
+                continue;
+            }
+            if (count_ == N) {
+                if (!evict_missing(sink)) {
+                    break;
+                }
+                events++;
+            }
+            known_.set(count_, scan.networks[i]);
+            missed_[count_] = 0;
+            count_++;
+            sink(APEvent{APChange::ADDED, scan.networks[i], 0});
+            events++;
+        }
+        return events;
+    }
+
+    /**
+     * @brief Number of BSSIDs tracked (present or recently missing).
+     */
+    [[nodiscard]] std::size_t tracked() const noexcept {
+        return count_;
+    }
+
+    /**
+     * @brief Forget everything; the next scan reports every AP as added.
+     */
+    void reset() noexcept {
+        count_ = 0;
+        known_.clear();
+    }
+
+private:
+    /**
+     * @brief Remove entry j by moving the last entry into its place.
+     */
+    void erase(std::size_t j) noexcept {
+        const std::size_t last = --count_;
+        known_.move_entry(last, j);
+        missed_[j] = missed_[last];
+    }
+
+    /**
+     * @brief Remove the entry missing for longest to make room.
+     * @return false if every tracked AP is present in this scan
+     */
+    template <typename Sink>
+    bool evict_missing(Sink&& sink) {
+        std::size_t victim = N;
+        uint8_t longest = 0;
+        for (std::size_t j = 0; j < count_; j++) {
+            if (missed_[j] > longest) {
+                longest = missed_[j];
+                victim = j;
+            }
+        }
+        if (victim == N) {
+            return false;
+        }
+        sink(APEvent{APChange::REMOVED, known_[victim], 0});
+        erase(victim);
+        return true;
+    }
+
+    DiffConfig config_;
+    APTable<N> known_{};                ///< Tracked APs, RSSI as last reported
+    std::array<uint8_t, N> missed_{};   ///< Consecutive scans each AP was missing from
+    std::size_t count_{0};
+};
+
+/// Diff sized for default-capacity scan results
+using ScanDiff = BasicScanDiff<MAX_SCAN_RESULTS>;
+
+#endif // SCAN_DIFF_HPP
@@ -0,0 +1,113 @@
+/**
+ * @file scan_exchange.hpp
+ * @brief Double-buffered hand-off of scan results from one writer to many readers.
+ */
+
+#ifndef SCAN_EXCHANGE_HPP
+#define SCAN_EXCHANGE_HPP
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @brief Ping-pong buffer pair with reader counts and a generation counter.
+ *
+ * The writer fills the back buffer while readers hold leases on the front
+ * one, then publish() swaps them. A buffer is only handed back to the
+ * writer once its last reader has released it, so readers never see a
+ * partially written result and never need to copy one.
+ *
+ * Not synchronized: every call must be made under the owner's lock (a
+ * critical section on target). Reader counts are small, so leases should
+ * be short-lived; a lease held across the next publish() keeps the writer
+ * from reusing that buffer.
+ *
+ * @tparam T Buffer type
+ */
+template <typename T>
+class PingPong {
+public:
+    /// Slot returned by acquire() when nothing has been published yet
+    static constexpr uint8_t NO_SLOT = 0xFF;
+
+    /**
+     * @brief Back buffer for the writer, or nullptr while readers still hold it.
+     */
+    [[nodiscard]] T* back() noexcept {
+        const uint8_t slot = static_cast<uint8_t>(front_ ^ 1u);
+        return readers_[slot] == 0 ? &buffers_[slot] : nullptr;
+    }
+
+    /**
+     * @brief Make the back buffer the new front and bump the generation.
+     * @note Only call after back() returned non-null for this fill.
+     */
+    void publish() noexcept {
+        front_ ^= 1u;
+        // Skip 0, which means "never published"
+        if (++generation_ == 0) {
+            ++generation_;
+        }
+        generations_[front_] = generation_;
+    }
+
+    /**
+     * @brief Take a read lease on the front buffer.
+     * @return Slot to pass to get() and release(), or NO_SLOT if nothing published
+     */
+    [[nodiscard]] uint8_t acquire() noexcept {
+        if (generation_ == 0 || readers_[front_] == UINT8_MAX) {
+            return NO_SLOT;
+        }
+        readers_[front_]++;
+        return front_;
+    }
+
+    /**
+     * @brief Drop a read lease.
+     * @return true if this freed the back buffer (the writer may be waiting for it)
+     */
+    bool release(uint8_t slot) noexcept {
+        if (slot > 1 || readers_[slot] == 0) {
+            return false;
+        }
+        return --readers_[slot] == 0 && slot != front_;
+    }
+
+    /**
+     * @brief Buffer behind a leased slot.
+     */
+    [[nodiscard]] const T& get(uint8_t slot) const noexcept {
+        return buffers_[slot & 1u];
+    }
+
+    /**
+     * @brief Generation the buffer in slot was published with.
+     */
+    [[nodiscard]] uint32_t generation(uint8_t slot) const noexcept {
+        return generations_[slot & 1u];
+    }
+
+    /**
+     * @brief Generation of the front buffer (0 before the first publish).
+     */
+    [[nodiscard]] uint32_t generation() const noexcept {
+        return generation_;
+    }
+
+    /**
+     * @brief Number of leases held on slot.
+     */
+    [[nodiscard]] uint8_t readers(uint8_t slot) const noexcept {
+        return readers_[slot & 1u];
+    }
+
+private:
+    std::array<T, 2> buffers_{};
+    std::array<uint32_t, 2> generations_{};
+    std::array<uint8_t, 2> readers_{};
+    uint32_t generation_{0};
+    uint8_t front_{0};
+};
+
+#endif // SCAN_EXCHANGE_HPP
@@ -0,0 +1,403 @@
+/**
+ * @file scan_log.hpp
+ * @brief Append-only ring of compact scan records in a reserved flash region.
+ *
+ * The region is a ring of erase sectors written strictly in order: records
+ * are appended page-aligned to the current sector, and when the next one
+ * does not fit the following sector is erased and writing continues there.
+ * Every sector is therefore erased once per trip around the ring (sector
+ * level wear levelling), and the log always holds the records of the last
+ * sectors - 1 sectors or more.
+ *
+ * Nothing is kept in RAM between boots: mount() finds the newest record by
+ * sequence number. A record torn by a reset mid-write fails its CRC and
+ * ends its sector; writing resumes in the next one.
+ *
+ * Flash access goes through the Flash template parameter:
+ *
+ *   static constexpr std::size_t SECTOR_SIZE, PAGE_SIZE;
+ *   std::size_t sectors() const;
+ *   void read(std::size_t offset, uint8_t* out, std::size_t len);
+ *   bool erase_sector(std::size_t sector);
+ *   bool program(std::size_t offset, const uint8_t* data, std::size_t len);  // whole pages
+ */
+
+#ifndef SCAN_LOG_HPP
+#define SCAN_LOG_HPP
+
+#include "scan_msg.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+/**
+ * @brief CRC-32 (IEEE 802.3, reflected) of len bytes, continuing from crc.
+ */
+[[nodiscard]] constexpr uint32_t crc32(const uint8_t* data, std::size_t len,
+                                       uint32_t crc = 0) noexcept {
+    crc = ~crc;
+    for (std::size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * @brief On-flash record header; the payload follows it directly.
+ */
+struct ScanLogHeader {
+    uint32_t magic;     ///< SCAN_LOG_MAGIC (erased flash reads 0xFFFFFFFF)
+    uint32_t sequence;  ///< Increases by one per record, across reboots
+    uint16_t length;    ///< Payload bytes
+    uint8_t count;      ///< APs in the payload
+    uint8_t version;    ///< SCAN_LOG_VERSION
+    uint32_t crc;       ///< crc32() of the header up to this field, then the payload
+};
+static_assert(sizeof(ScanLogHeader) == 16);
+
+inline constexpr uint32_t SCAN_LOG_MAGIC = 0x4C4E4353;  // "SCNL"
+inline constexpr uint8_t SCAN_LOG_VERSION = 1;
+
+/// Encoded AP: BSSID, RSSI, channel/auth byte, SSID length, SSID
+inline constexpr std::size_t SCAN_LOG_AP_FIXED = BSSID_LEN + 3;
+inline constexpr std::size_t SCAN_LOG_MAX_PAYLOAD = MAX_SCAN_RESULTS * (SCAN_LOG_AP_FIXED + MAX_SSID_LEN);
+
+/**
+ * @brief Scan ring log over a Flash backend (see file comment).
+ */
+template <typename Flash>
+class ScanLog {
+public:
+    static constexpr std::size_t SECTOR_SIZE = Flash::SECTOR_SIZE;
+    static constexpr std::size_t PAGE_SIZE = Flash::PAGE_SIZE;
+
+    /// Flash taken by the largest record
+    static constexpr std::size_t MAX_RECORD =
+        (sizeof(ScanLogHeader) + SCAN_LOG_MAX_PAYLOAD + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+
+    static_assert(MAX_RECORD <= SECTOR_SIZE, "a record must fit in one sector");
+    static_assert(SECTOR_SIZE % PAGE_SIZE == 0);
+
+    explicit ScanLog(Flash& flash) noexcept : flash_(flash) {}
+
+    ScanLog(const ScanLog&) = delete;
+    ScanLog& operator=(const ScanLog&) = delete;
+
+    /**
+     * @brief Find the newest record and the write position.
+     *
+     * Reads every record header once; call before anything else.
+     */
+    void mount() noexcept {
+        has_latest_ = false;
+        bool head_torn = false;
+        std::size_t head_end = 0;
+        for (std::size_t s = 0; s < flash_.sectors(); s++) {
+            const SectorInfo info = scan_sector(s, nullptr);
+            if (info.records > 0 && (!has_latest_ || newer(info.last_sequence, latest_sequence_))) {
+                has_latest_ = true;
+                latest_sequence_ = info.last_sequence;
+                latest_offset_ = s * SECTOR_SIZE + info.last_offset;
+                write_sector_ = s;
+                head_end = info.end;
+                head_torn = info.torn;
+            }
+        }
+        if (!has_latest_) {
+            write_sector_ = 0;
+            write_offset_ = 0;
+            next_sequence_ = 1;
+            return;
+        }
+        // Never append after a torn record: its pages may be half programmed
+        write_offset_ = head_torn ? SECTOR_SIZE : head_end;
+        next_sequence_ = latest_sequence_ + 1;
+    }
+
+    /**
+     * @brief Check if the log holds no record.
+     */
+    [[nodiscard]] bool empty() const noexcept {
+        return !has_latest_;
+    }
+
+    /**
+     * @brief Sequence number of the newest record (0 if empty).
+     */
+    [[nodiscard]] uint32_t latest_sequence() const noexcept {
+        return has_latest_ ? latest_sequence_ : 0;
+    }
+
+    /**
+     * @brief Sectors erased since mount().
+     */
+    [[nodiscard]] uint32_t erases() const noexcept {
+        return erases_;
+    }
+
+    /**
+     * @brief Encode scan into the write buffer without touching flash.
+     * @return false for a failed scan
+     *
+     * Lets the caller drop its hold on scan before the (slow) commit().
+     */
+    template <std::size_t N>
+    [[nodiscard]] bool prepare(const BasicScanResult<N>& scan) noexcept {
+        static_assert(N <= MAX_SCAN_RESULTS, "record payload is sized for MAX_SCAN_RESULTS");
+        if (!scan.success) {
+            return false;
+        }
+        std::size_t len = 0;
+        uint8_t* out = buffer_.data() + sizeof(ScanLogHeader);
+        for (std::size_t i = 0; i < scan.count; i++) {
+            const std::string_view ssid = scan.networks.ssid(i);
+            std::memcpy(out + len, scan.networks.bssid[i].data(), BSSID_LEN);
+            len += BSSID_LEN;
+            out[len++] = static_cast<uint8_t>(scan.networks.rssi[i]);
+            out[len++] = scan.networks.chan_auth[i];
+            out[len++] = static_cast<uint8_t>(ssid.size());
+            std::memcpy(out + len, ssid.data(), ssid.size());
+            len += ssid.size();
+        }
+        prepared_ = ScanLogHeader{SCAN_LOG_MAGIC, 0, static_cast<uint16_t>(len),
+                                  static_cast<uint8_t>(scan.count), SCAN_LOG_VERSION, 0};
+        has_prepared_ = true;
+        return true;
+    }
+
+    /**
+     * @brief Write the prepared record, erasing the next sector first if needed.
+     * @return false if nothing was prepared or the flash reported an error
+     *
+     * Programs one page per Flash::program() call, so a backend that has to
+     * pause the other core does so for one page at a time.
+     */
+    [[nodiscard]] bool commit() noexcept {
+        if (!has_prepared_) {
+            return false;
+        }
+        const std::size_t total = round_up(sizeof(ScanLogHeader) + prepared_.length);
+        if (write_offset_ + total > SECTOR_SIZE) {
+            write_sector_ = (write_sector_ + 1) % flash_.sectors();
+            write_offset_ = 0;
+        }
+        if (write_offset_ == 0) {
+            if (!flash_.erase_sector(write_sector_)) {
+                return false;
+            }
+            erases_++;
+        }
+
+        prepared_.sequence = next_sequence_;
+        prepared_.crc = record_crc(prepared_, buffer_.data() + sizeof(ScanLogHeader));
+        std::memcpy(buffer_.data(), &prepared_, sizeof(prepared_));
+        // Erased flash is 0xFF; padding it with 0xFF leaves those bytes untouched
+        std::memset(buffer_.data() + sizeof(ScanLogHeader) + prepared_.length, 0xFF,
+                    total - sizeof(ScanLogHeader) - prepared_.length);
+
+        const std::size_t base = write_sector_ * SECTOR_SIZE + write_offset_;
+        for (std::size_t page = 0; page < total; page += PAGE_SIZE) {
+            if (!flash_.program(base + page, buffer_.data() + page, PAGE_SIZE)) {
+                // The pages written so far are a torn record; start over in a fresh sector
+                write_offset_ = SECTOR_SIZE;
+                return false;
+            }
+        }
+
+        has_prepared_ = false;
+        has_latest_ = true;
+        latest_sequence_ = next_sequence_++;
+        latest_offset_ = base;
+        write_offset_ += total;
+        return true;
+    }
+
+    /**
+     * @brief Encode and write scan in one go.
+     */
+    template <std::size_t N>
+    [[nodiscard]] bool append(const BasicScanResult<N>& scan) noexcept {
+        return prepare(scan) && commit();
+    }
+
+    /**
+     * @brief Decode the newest record into out.
+     * @return false if the log is empty or the record no longer verifies
+     */
+    template <std::size_t N>
+    [[nodiscard]] bool load_latest(BasicScanResult<N>& out) noexcept {
+        return has_latest_ && read_record(latest_offset_, out) != nullptr;
+    }
+
+    /**
+     * @brief Decode up to max records, newest first.
+     * @param scratch Buffer each record is decoded into
+     * @param visit Called as visit(const BasicScanResult<N>&, uint32_t sequence);
+     *        return false to stop
+     * @return Records visited
+     */
+    template <std::size_t N, typename Visit>
+    std::size_t for_each_recent(std::size_t max, BasicScanResult<N>& scratch, Visit&& visit) noexcept {
+        if (!has_latest_) {
+            return 0;
+        }
+        std::size_t visited = 0;
+        uint32_t previous = latest_sequence_ + 1;
+        std::size_t sector = latest_offset_ / SECTOR_SIZE;
+        for (std::size_t pass = 0; pass < flash_.sectors() && visited < max; pass++) {
+            std::array<uint16_t, SECTOR_SIZE / PAGE_SIZE> offsets{};
+            const SectorInfo info = scan_sector(sector, &offsets);
+            for (std::size_t r = info.records; r-- > 0 && visited < max;) {
+                const std::size_t offset = sector * SECTOR_SIZE + offsets[r];
+                const ScanLogHeader* header = read_record(offset, scratch);
+                // Stop at anything not strictly older (e.g. records written after
+                // the newest one was found, or left over from a previous ring)
+                if (!header || !newer(previous, header->sequence)) {
+                    return visited;
+                }
+                previous = header->sequence;
+                visited++;
+                if (!visit(static_cast<const BasicScanResult<N>&>(scratch), header->sequence)) {
+                    return visited;
+                }
+            }
+            sector = (sector + flash_.sectors() - 1) % flash_.sectors();
+        }
+        return visited;
+    }
+
+private:
+    struct SectorInfo {
+        std::size_t records{0};         ///< Valid records from the start of the sector
+        uint32_t last_sequence{0};
+        std::size_t last_offset{0};     ///< Offset of the last valid record in the sector
+        std::size_t end{0};             ///< Offset just past it
+        bool torn{false};               ///< A header was found that does not verify
+    };
+
+    [[nodiscard]] static constexpr std::size_t round_up(std::size_t bytes) noexcept {
+        return (bytes + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+    }
+
+    /// a is newer than b, allowing for wrap-around
+    [[nodiscard]] static constexpr bool newer(uint32_t a, uint32_t b) noexcept {
+        return static_cast<int32_t>(a - b) > 0;
+    }
+
+    [[nodiscard]] static uint32_t record_crc(const ScanLogHeader& header, const uint8_t* payload) noexcept {
+        const uint32_t crc = crc32(reinterpret_cast<const uint8_t*>(&header),
+                                   offsetof(ScanLogHeader, crc));
+        return crc32(payload, header.length, crc);
+    }
+
+    /**
+     * @brief Read and verify the record at offset into buffer_.
+     * @return Header copy in buffer_, or nullptr if there is no valid record
+     */
+    const ScanLogHeader* verify(std::size_t offset, std::size_t sector_end) noexcept {
+        ScanLogHeader header;
+        flash_.read(offset, reinterpret_cast<uint8_t*>(&header), sizeof(header));
+        if (header.magic != SCAN_LOG_MAGIC || header.version != SCAN_LOG_VERSION ||
+            header.length > SCAN_LOG_MAX_PAYLOAD ||
+            offset + round_up(sizeof(header) + header.length) > sector_end) {
+            return nullptr;
+        }
+        uint8_t* payload = buffer_.data() + sizeof(ScanLogHeader);
+        flash_.read(offset + sizeof(header), payload, header.length);
+        if (record_crc(header, payload) != header.crc) {
+            return nullptr;
+        }
+        std::memcpy(buffer_.data(), &header, sizeof(header));
+        has_prepared_ = false;  // buffer_ is shared with prepare()
+        return reinterpret_cast<const ScanLogHeader*>(buffer_.data());
+    }
+
+    /**
+     * @brief Walk the records of sector from its start.
+     * @param offsets Receives the offset of each valid record, or nullptr
+     */
+    SectorInfo scan_sector(std::size_t sector,
+                           std::array<uint16_t, SECTOR_SIZE / PAGE_SIZE>* offsets) noexcept {
+        SectorInfo info;
+        const std::size_t base = sector * SECTOR_SIZE;
+        std::size_t offset = 0;
+        while (offset + sizeof(ScanLogHeader) <= SECTOR_SIZE) {
+            uint32_t magic = 0;
+            flash_.read(base + offset, reinterpret_cast<uint8_t*>(&magic), sizeof(magic));
+            if (magic != SCAN_LOG_MAGIC) {
+                break;
+            }
+            const ScanLogHeader* header = verify(base + offset, base + SECTOR_SIZE);
+            if (!header) {
+                info.torn = true;
+                break;
+            }
+            if (offsets) {
+                (*offsets)[info.records] = static_cast<uint16_t>(offset);
+            }
+            info.records++;
+            info.last_sequence = header->sequence;
+            info.last_offset = offset;
+            offset += round_up(sizeof(ScanLogHeader) + header->length);
+            info.end = offset;
+        }
+        return info;
+    }
+
+    /**
+     * @brief Decode the record at offset.
+     * @return Its header, or nullptr if it does not verify or decode
+     */
+    template <std::size_t N>
+    const ScanLogHeader* read_record(std::size_t offset, BasicScanResult<N>& out) noexcept {
+        const std::size_t sector_end = (offset / SECTOR_SIZE + 1) * SECTOR_SIZE;
+        const ScanLogHeader* header = verify(offset, sector_end);
+        if (!header) {
+            return nullptr;
+        }
+        out.reset();
+        const uint8_t* in = buffer_.data() + sizeof(ScanLogHeader);
+        std::size_t pos = 0;
+        for (std::size_t i = 0; i < header->count; i++) {
+            if (pos + SCAN_LOG_AP_FIXED > header->length) {
+                return nullptr;
+            }
+            APInfo ap;
+            std::memcpy(ap.bssid.data(), in + pos, BSSID_LEN);
+            pos += BSSID_LEN;
+            ap.rssi = static_cast<int8_t>(in[pos++]);
+            const uint8_t chan_auth = in[pos++];
+            ap.channel = chan_auth & 0x0F;
+            ap.auth = static_cast<AuthMode>(chan_auth >> 4);
+            const uint8_t ssid_len = in[pos++];
+            if (ssid_len > MAX_SSID_LEN || pos + ssid_len > header->length) {
+                return nullptr;
+            }
+            std::memcpy(ap.ssid.data(), in + pos, ssid_len);
+            pos += ssid_len;
+            [[maybe_unused]] const bool added = out.add(ap);
+        }
+        out.success = true;
+        return header;
+    }
+
+    Flash& flash_;
+    alignas(ScanLogHeader) std::array<uint8_t, MAX_RECORD> buffer_{};  ///< Record being written or read
+    ScanLogHeader prepared_{};
+    bool has_prepared_{false};
+    bool has_latest_{false};
+    uint32_t latest_sequence_{0};
+    std::size_t latest_offset_{0};              ///< Byte offset of the newest record
+    uint32_t next_sequence_{1};
+    std::size_t write_sector_{0};
+    std::size_t write_offset_{0};               ///< Next free byte in write_sector_
+    uint32_t erases_{0};
+};
+
+#endif // SCAN_LOG_HPP
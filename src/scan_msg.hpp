@@ -6,10 +6,15 @@
 #ifndef SCAN_MSG_HPP
 #define SCAN_MSG_HPP
 
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <optional>
+#include <string_view>
+#include <type_traits>
 
 /// Maximum SSID length per 802.11 spec
 inline constexpr std::size_t MAX_SSID_LEN = 32;
@@ -17,8 +22,11 @@ inline constexpr std::size_t MAX_SSID_LEN = 32;
 /// BSSID (MAC address) length
 inline constexpr std::size_t BSSID_LEN = 6;
 
-/// Maximum APs to store per scan
-inline constexpr std::size_t MAX_SCAN_RESULTS = 32;
+/// Maximum APs to store per scan (default ScanResult capacity)
+#ifndef WIFI_MAX_SCAN_RESULTS
+#define WIFI_MAX_SCAN_RESULTS 32
+#endif
+inline constexpr std::size_t MAX_SCAN_RESULTS = WIFI_MAX_SCAN_RESULTS;
 
 /**
  * @brief Authentication mode of discovered AP.
@@ -65,6 +73,14 @@ enum class AuthMode : uint8_t {
     return AuthMode::UNKNOWN;
 }
 
+/**
+ * @brief How repeated reports of the same BSSID combine their RSSI.
+ */
+enum class RssiMerge : uint8_t {
+    MAX = 0,    ///< Keep the strongest report
+    MEAN        ///< Average all reports
+};
+
 /**
  * @brief Data for a single AP scan result.
  */
@@ -82,48 +98,395 @@ struct APInfo {
      */
     void format_bssid(char* out, std::size_t out_len) const noexcept {
         if (out && out_len >= 18) {
-            std::snprintf(out, out_len, "%02X:%02X:%02X:%02X:%02X:%02X",
-                          bssid[0], bssid[1], bssid[2], bssid[3], bssid[4], bssid[5]);
+            constexpr char HEX[] = "0123456789ABCDEF";
+            for (std::size_t i = 0; i < BSSID_LEN; i++) {
+                out[i * 3] = HEX[bssid[i] >> 4];
+                out[i * 3 + 1] = HEX[bssid[i] & 0x0F];
+                out[i * 3 + 2] = ':';
+            }
+            out[17] = '\0';
+        }
+    }
+};
+
+/**
+ * @brief Hash a BSSID for the result index (FNV-1a).
+ */
+[[nodiscard]] constexpr uint32_t bssid_hash(const std::array<uint8_t, BSSID_LEN>& bssid) noexcept {
+    uint32_t h = 2166136261u;
+    for (uint8_t b : bssid) {
+        h = (h ^ b) * 16777619u;
+    }
+    return h;
+}
+
+/// SSID bytes set aside per entry in an APTable's shared pool
+#ifndef WIFI_SSID_POOL_BYTES_PER_AP
+#define WIFI_SSID_POOL_BYTES_PER_AP 16
+#endif
+inline constexpr std::size_t SSID_POOL_BYTES_PER_AP = WIFI_SSID_POOL_BYTES_PER_AP;
+
+/**
+ * @brief Struct-of-arrays AP storage for BasicScanResult.
+ *
+ * RSSI and the packed channel/auth byte live in their own columns, so
+ * ranking by signal strength touches N bytes rather than N APInfo
+ * records. Indexing decodes an entry into an APInfo by value.
+ *
+ * SSIDs share one byte pool, SSID_POOL_BYTES_PER_AP per entry, and each
+ * entry keeps an offset and a length into it: most SSIDs are far shorter
+ * than 32 bytes, and hidden networks take none. A new SSID no longer than
+ * the entry's old one is written in its place; a longer one is appended,
+ * compacting the pool first if the end is reached. If a full table's
+ * SSIDs average more than SSID_POOL_BYTES_PER_AP bytes, the SSIDs that do
+ * not fit are truncated to the space left. At the default 32 entries the
+ * table is 866 bytes, against 1408 for an array of APInfo.
+ *
+ * Channel takes the low nibble of chan_auth (2.4 GHz channels 1-14; out of
+ * range channels are stored as 0), auth the high nibble.
+ */
+template <std::size_t N>
+struct APTable {
+    static_assert(N <= 256, "entries are ordered through uint8_t indices");
+
+    /// Pool bytes (never less than one full-length SSID)
+    static constexpr std::size_t SSID_POOL_SIZE = std::max(N * SSID_POOL_BYTES_PER_AP, MAX_SSID_LEN);
+    static_assert(SSID_POOL_SIZE <= UINT16_MAX, "pool offsets are 16-bit");
+
+    /// Offset into the pool: one byte when the pool is small enough
+    using PoolOffset = std::conditional_t<(SSID_POOL_SIZE <= 256), uint8_t, uint16_t>;
+
+    std::array<char, SSID_POOL_SIZE> ssid_pool{};        ///< Cold: SSID bytes, no terminators
+    std::array<PoolOffset, N> ssid_offset{};             ///< Cold: start of each SSID in the pool
+    std::array<uint8_t, N> ssid_len{};                   ///< Cold: SSID length (0 = hidden or unused)
+    std::array<std::array<uint8_t, BSSID_LEN>, N> bssid{};  ///< Cold: MAC addresses
+    std::array<int8_t, N> rssi{};                        ///< Hot: signal strength in dBm
+    std::array<uint8_t, N> chan_auth{};                  ///< Hot: channel | auth << 4
+    uint16_t ssid_pool_used{0};                          ///< Pool bytes up to the last SSID
+
+    /**
+     * @brief Decode entry i.
+     */
+    [[nodiscard]] APInfo operator[](std::size_t i) const noexcept {
+        APInfo ap;
+        const std::string_view name = ssid(i);
+        std::memcpy(ap.ssid.data(), name.data(), name.size());
+        ap.bssid = bssid[i];
+        ap.rssi = rssi[i];
+        ap.channel = channel(i);
+        ap.auth = auth(i);
+        return ap;
+    }
+
+    /**
+     * @brief Encode ap into entry i (RSSI saturates to int8_t).
+     */
+    void set(std::size_t i, const APInfo& ap) noexcept {
+        const auto len = static_cast<std::size_t>(
+            std::find(ap.ssid.begin(), ap.ssid.begin() + MAX_SSID_LEN, '\0') - ap.ssid.begin());
+        set_ssid(i, ap.ssid.data(), len);
+        bssid[i] = ap.bssid;
+        rssi[i] = clamp_rssi(ap.rssi);
+        const uint8_t ch = (ap.channel <= 0x0F) ? ap.channel : 0;
+        chan_auth[i] = static_cast<uint8_t>(ch | (static_cast<uint8_t>(ap.auth) << 4));
+    }
+
+    /**
+     * @brief SSID of entry i (not terminated).
+     */
+    [[nodiscard]] std::string_view ssid(std::size_t i) const noexcept {
+        return {ssid_pool.data() + ssid_offset[i], ssid_len[i]};
+    }
+
+    /**
+     * @brief Move entry from into entry to, leaving from unused.
+     */
+    void move_entry(std::size_t from, std::size_t to) noexcept {
+        ssid_offset[to] = ssid_offset[from];
+        ssid_len[to] = ssid_len[from];
+        ssid_len[from] = 0;
+        bssid[to] = bssid[from];
+        rssi[to] = rssi[from];
+        chan_auth[to] = chan_auth[from];
+    }
+
+    /**
+     * @brief Mark every entry unused and empty the pool.
+     */
+    void clear() noexcept {
+        ssid_len.fill(0);
+        ssid_pool_used = 0;
+    }
+
+    [[nodiscard]] uint8_t channel(std::size_t i) const noexcept {
+        return chan_auth[i] & 0x0F;
+    }
+
+    [[nodiscard]] AuthMode auth(std::size_t i) const noexcept {
+        return static_cast<AuthMode>(chan_auth[i] >> 4);
+    }
+
+    [[nodiscard]] static constexpr int8_t clamp_rssi(int16_t rssi) noexcept {
+        return static_cast<int8_t>(std::clamp<int16_t>(rssi, INT8_MIN, INT8_MAX));
+    }
+
+private:
+    void set_ssid(std::size_t i, const char* chars, std::size_t len) noexcept {
+        if (len <= ssid_len[i]) {
+            // Fits where the old one was
+            std::memcpy(ssid_pool.data() + ssid_offset[i], chars, len);
+            ssid_len[i] = static_cast<uint8_t>(len);
+            return;
+        }
+        ssid_len[i] = 0;
+        if (ssid_pool_used + len > SSID_POOL_SIZE) {
+            compact_ssids();
+        }
+        len = std::min(len, SSID_POOL_SIZE - ssid_pool_used);
+        ssid_offset[i] = static_cast<PoolOffset>(len > 0 ? ssid_pool_used : 0);
+        std::memcpy(ssid_pool.data() + ssid_offset[i], chars, len);
+        ssid_len[i] = static_cast<uint8_t>(len);
+        ssid_pool_used = static_cast<uint16_t>(ssid_pool_used + len);
+    }
+
+    /// Close the gaps left by replaced SSIDs, keeping the SSIDs in pool order
+    void compact_ssids() noexcept {
+        std::array<uint8_t, N> order{};
+        std::size_t live = 0;
+        for (std::size_t i = 0; i < N; i++) {
+            if (ssid_len[i] != 0) {
+                order[live++] = static_cast<uint8_t>(i);
+            }
+        }
+        std::sort(order.begin(), order.begin() + live, [this](uint8_t a, uint8_t b) {
+            return ssid_offset[a] < ssid_offset[b];
+        });
+        std::size_t used = 0;
+        for (std::size_t k = 0; k < live; k++) {
+            const std::size_t i = order[k];
+            std::memmove(ssid_pool.data() + used, ssid_pool.data() + ssid_offset[i], ssid_len[i]);
+            ssid_offset[i] = static_cast<PoolOffset>(used);
+            used += ssid_len[i];
         }
+        ssid_pool_used = static_cast<uint16_t>(used);
     }
 };
 
 /**
- * @brief Result of a WiFi scan operation.
+ * @brief What add() does with a new AP when the table is full.
  */
-struct ScanResult {
+enum class FullPolicy : uint8_t {
+    DROP_NEW = 0,       ///< Keep the first APs seen, drop later ones
+    KEEP_STRONGEST      ///< Keep the strongest APs seen (top-K by RSSI)
+};
+
+/**
+ * @brief Result of a WiFi scan operation, holding up to N APs.
+ *
+ * APs are unique by BSSID. The radio reports an AP once per beacon or
+ * probe response it hears, so add() merges repeats into the existing
+ * entry through an open-addressed index, keeping the per-callback cost O(1).
+ *
+ * With FullPolicy::KEEP_STRONGEST a stronger newcomer replaces the
+ * weakest entry. The weakest is found by scanning the one-byte RSSI
+ * column, which for tables this size is cheaper in both RAM and cycles
+ * than maintaining a heap on every merge.
+ *
+ * rejected counts reports that were left out, not APs: an AP left out is
+ * rejected again at each beacon the radio hears from it, so in dense
+ * places it runs well ahead of the number of APs missing from the table.
+ * A newcomer swapped in for the weakest entry is not rejected; the swap
+ * counts in replaced instead.
+ *
+ * Capacity is a template parameter so memory-constrained builds can pick
+ * a smaller table; ScanResult uses MAX_SCAN_RESULTS.
+ */
+template <std::size_t N>
+struct BasicScanResult {
+    static_assert(N > 0 && N < 255, "index entries are stored as uint8_t");
+
+    /// Capacity
+    static constexpr std::size_t CAPACITY = N;
+
+    /// Open-addressed BSSID index slots (power of two, load factor <= 50%)
+    static constexpr std::size_t INDEX_SLOTS = std::bit_ceil(2 * N);
+
+    /// index_of() result for an absent BSSID
+    static constexpr std::size_t npos = N;
+
     bool success{false};                              ///< true if scan completed without error
     int32_t error_code{0};                            ///< Error code if !success
     uint16_t count{0};                                ///< Number of APs found
-    std::array<APInfo, MAX_SCAN_RESULTS> networks{};  ///< Discovered networks
+    uint16_t rejected{0};                             ///< Reports left out of a full table, repeats included
+    uint16_t replaced{0};                             ///< Entries displaced by a stronger newcomer
+    RssiMerge merge{RssiMerge::MAX};                  ///< RSSI policy for repeated BSSIDs
+    FullPolicy policy{FullPolicy::DROP_NEW};          ///< Overflow policy
+    APTable<N> networks{};                            ///< Discovered networks
+    std::array<uint8_t, N> samples{};                 ///< Reports merged into each entry (saturates)
+    std::array<int16_t, N> rssi_sum{};                ///< Sum of merged RSSI reports
+    std::array<uint8_t, INDEX_SLOTS> index{};         ///< BSSID slots holding entry + 1, 0 = empty
 
     /**
-     * @brief Reset result for a new scan.
+     * @brief Reset result for a new scan (keeps the merge and full policies).
      */
     void reset() noexcept {
         success = false;
         error_code = 0;
         count = 0;
+        rejected = 0;
+        replaced = 0;
+        networks.clear();
+        index.fill(0);
     }
 
     /**
-     * @brief Add an AP to the results.
-     * @return true if added, false if at capacity
+     * @brief Add an AP to the results, merging it if its BSSID is known.
+     * @return true if added, merged or swapped in for a weaker AP;
+     *         false if left out because the table is full
      */
     [[nodiscard]] bool add(const APInfo& ap) noexcept {
-        if (count < MAX_SCAN_RESULTS) {
-            networks[count++] = ap;
+        const std::size_t slot = probe(ap.bssid);
+        if (index[slot] != 0) {
+            const std::size_t i = index[slot] - 1u;
+            merge_rssi(i, ap.rssi);
+            return true;
+        }
+        if (count < N) {
+            store(count, ap);
+            index[slot] = static_cast<uint8_t>(++count);
             return true;
         }
+        if (policy == FullPolicy::KEEP_STRONGEST && replace_weakest(ap)) {
+            replaced++;
+            return true;
+        }
+        rejected++;
         return false;
     }
 
+    /**
+     * @brief Append entry i of another result, keeping its merge statistics.
+     * @return false if the BSSID is already present or the table is full
+     */
+    template <std::size_t M>
+    [[nodiscard]] bool copy_entry(const BasicScanResult<M>& other, std::size_t i) noexcept {
+        const std::size_t slot = probe(other.networks.bssid[i]);
+        if (index[slot] != 0 || count >= N) {
+            return false;
+        }
+        store(count, other.networks[i]);
+        samples[count] = other.samples[i];
+        rssi_sum[count] = other.rssi_sum[i];
+        index[slot] = static_cast<uint8_t>(++count);
+        return true;
+    }
+
+    /**
+     * @brief Find the entry index of a BSSID.
+     * @return Entry index, or npos if not present
+     */
+    [[nodiscard]] std::size_t index_of(const std::array<uint8_t, BSSID_LEN>& bssid) const noexcept {
+        const std::size_t slot = probe(bssid);
+        return index[slot] != 0 ? index[slot] - 1u : npos;
+    }
+
+    /**
+     * @brief Look up an AP by BSSID.
+     */
+    [[nodiscard]] std::optional<APInfo> find(const std::array<uint8_t, BSSID_LEN>& bssid) const noexcept {
+        const std::size_t i = index_of(bssid);
+        return i != npos ? std::optional<APInfo>{networks[i]} : std::nullopt;
+    }
+
+    /**
+     * @brief Entry indices ordered strongest first (first count are valid).
+     *
+     * Reads only the RSSI column.
+     */
+    [[nodiscard]] std::array<uint8_t, N> by_rssi() const noexcept {
+        std::array<uint8_t, N> order{};
+        for (std::size_t i = 0; i < count; i++) {
+            order[i] = static_cast<uint8_t>(i);
+        }
+        std::stable_sort(order.begin(), order.begin() + count, [this](uint8_t a, uint8_t b) {
+            return networks.rssi[a] > networks.rssi[b];
+        });
+        return order;
+    }
+
     /**
      * @brief Check if results are at capacity.
      */
     [[nodiscard]] bool is_full() const noexcept {
-        return count >= MAX_SCAN_RESULTS;
+        return count >= N;
+    }
+
+private:
+    static constexpr std::size_t SLOT_MASK = INDEX_SLOTS - 1;
+
+    static std::size_t home_slot(const std::array<uint8_t, BSSID_LEN>& bssid) noexcept {
+        return bssid_hash(bssid) & SLOT_MASK;
+    }
+
+    /// Slot holding bssid, or the empty slot where it would be inserted
+    std::size_t probe(const std::array<uint8_t, BSSID_LEN>& bssid) const noexcept {
+        std::size_t slot = home_slot(bssid);
+        while (index[slot] != 0 && networks.bssid[index[slot] - 1u] != bssid) {
+            slot = (slot + 1) & SLOT_MASK;
+        }
+        return slot;
+    }
+
+    /// Remove a slot, shifting later probe-chain members back (no tombstones)
+    void erase_slot(std::size_t hole) noexcept {
+        std::size_t j = hole;
+        while (true) {
+            j = (j + 1) & SLOT_MASK;
+            if (index[j] == 0) break;
+            const std::size_t k = home_slot(networks.bssid[index[j] - 1u]);
+            // Entry at j stays put if its home lies cyclically in (hole, j]
+            const bool stays = (hole < j) ? (hole < k && k <= j) : (hole < k || k <= j);
+            if (!stays) {
+                index[hole] = index[j];
+                hole = j;
+            }
+        }
+        index[hole] = 0;
+    }
+
+    void store(std::size_t i, const APInfo& ap) noexcept {
+        networks.set(i, ap);
+        samples[i] = 1;
+        rssi_sum[i] = networks.rssi[i];
+    }
+
+    void merge_rssi(std::size_t i, int16_t rssi) noexcept {
+        const int8_t value = APTable<N>::clamp_rssi(rssi);
+        if (samples[i] < UINT8_MAX) {
+            samples[i]++;
+            rssi_sum[i] = static_cast<int16_t>(rssi_sum[i] + value);
+        }
+        if (merge == RssiMerge::MEAN) {
+            networks.rssi[i] = static_cast<int8_t>(rssi_sum[i] / samples[i]);
+        } else if (value > networks.rssi[i]) {
+            networks.rssi[i] = value;
+        }
+    }
+
+    bool replace_weakest(const APInfo& ap) noexcept {
+        const auto weakest = std::min_element(networks.rssi.begin(), networks.rssi.begin() + count);
+        const auto victim = static_cast<std::size_t>(weakest - networks.rssi.begin());
+        if (APTable<N>::clamp_rssi(ap.rssi) <= *weakest) {
+            return false;
+        }
+        erase_slot(probe(networks.bssid[victim]));
+        store(victim, ap);
+        index[probe(ap.bssid)] = static_cast<uint8_t>(victim + 1);
+        return true;
     }
 };
 
+/// Default-capacity scan result used by the scanner API
+using ScanResult = BasicScanResult<MAX_SCAN_RESULTS>;
+
 #endif // SCAN_MSG_HPP
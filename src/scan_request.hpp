@@ -0,0 +1,141 @@
+/**
+ * @file scan_request.hpp
+ * @brief Scan parameters and target filters for WiFi scan requests.
+ */
+
+#ifndef SCAN_REQUEST_HPP
+#define SCAN_REQUEST_HPP
+
+#include "scan_msg.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+/// Maximum BSSIDs a single targeted request may list
+inline constexpr std::size_t MAX_TARGET_BSSIDS = 4;
+
+/// Highest 2.4 GHz channel (CYW43439 is single-band)
+inline constexpr uint8_t MAX_WIFI_CHANNEL = 14;
+
+/**
+ * @brief Radio probing mode.
+ */
+enum class ScanMode : uint8_t {
+    ACTIVE = 0,     ///< Send probe requests on each channel
+    PASSIVE         ///< Listen for beacons only
+};
+
+/**
+ * @brief What to scan for and when to stop.
+ *
+ * A default-constructed request is a full active all-channel scan. The
+ * SSID and mode go to the radio; BSSID and channel filters are applied to
+ * each result as it arrives, because the CYW43 driver overwrites those
+ * scan option fields.
+ */
+struct ScanRequest {
+    std::array<char, MAX_SSID_LEN + 1> ssid{};                              ///< Target SSID, empty for any
+    std::array<std::array<uint8_t, BSSID_LEN>, MAX_TARGET_BSSIDS> bssids{};  ///< Target BSSIDs
+    uint8_t bssid_count{0};                                                 ///< Valid entries in bssids
+    uint16_t channel_mask{0};                                               ///< Bit n = channel n, 0 for all
+    ScanMode mode{ScanMode::ACTIVE};                                        ///< Active or passive probing
+    bool stop_on_match{false};                                              ///< Complete on first match
+
+    /**
+     * @brief Set the target SSID (truncated to MAX_SSID_LEN).
+     */
+    void set_ssid(const char* name) noexcept {
+        ssid.fill('\0');
+        if (name) {
+            std::strncpy(ssid.data(), name, MAX_SSID_LEN);
+        }
+    }
+
+    /**
+     * @brief Add a target BSSID.
+     * @return false if MAX_TARGET_BSSIDS are already set
+     */
+    [[nodiscard]] bool add_bssid(const uint8_t* bssid) noexcept {
+        if (!bssid || bssid_count >= MAX_TARGET_BSSIDS) return false;
+        std::memcpy(bssids[bssid_count++].data(), bssid, BSSID_LEN);
+        return true;
+    }
+
+    /**
+     * @brief Restrict results to channel (may be called repeatedly).
+     * @return false if channel is outside 1..MAX_WIFI_CHANNEL
+     */
+    [[nodiscard]] bool add_channel(uint8_t channel) noexcept {
+        if (channel == 0 || channel > MAX_WIFI_CHANNEL) return false;
+        channel_mask = static_cast<uint16_t>(channel_mask | (1u << channel));
+        return true;
+    }
+
+    /**
+     * @brief Check if a target SSID is set.
+     */
+    [[nodiscard]] bool has_ssid() const noexcept {
+        return ssid[0] != '\0';
+    }
+
+    /**
+     * @brief Check if any filter is set.
+     */
+    [[nodiscard]] bool is_targeted() const noexcept {
+        return has_ssid() || bssid_count > 0 || channel_mask != 0;
+    }
+
+    /**
+     * @brief Check if an AP passes every filter in this request.
+     */
+    [[nodiscard]] bool matches(const APInfo& ap) const noexcept {
+        if (channel_mask != 0 && (ap.channel > MAX_WIFI_CHANNEL ||
+                                  (channel_mask & (1u << ap.channel)) == 0)) {
+            return false;
+        }
+        if (has_ssid() && std::strcmp(ssid.data(), ap.ssid.data()) != 0) {
+            return false;
+        }
+        if (bssid_count == 0) return true;
+        for (uint8_t i = 0; i < bssid_count; i++) {
+            if (std::memcmp(bssids[i].data(), ap.bssid.data(), BSSID_LEN) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Check if a radio scan run for this request also serves other.
+     *
+     * Only the SSID limits what the radio reports; everything else is
+     * filtered per request afterwards.
+     */
+    [[nodiscard]] bool covers(const ScanRequest& other) const noexcept {
+        return !has_ssid() || std::strcmp(ssid.data(), other.ssid.data()) == 0;
+    }
+};
+
+/**
+ * @brief Copy the APs of in that match filter into out.
+ *
+ * Status fields are copied unchanged.
+ */
+template <std::size_t N, std::size_t M>
+void copy_matching(const BasicScanResult<N>& in, const ScanRequest& filter,
+                   BasicScanResult<M>& out) noexcept {
+    out.reset();
+    out.success = in.success;
+    out.error_code = in.error_code;
+    out.rejected = in.rejected;
+    out.replaced = in.replaced;
+    out.merge = in.merge;
+    for (uint16_t i = 0; i < in.count; i++) {
+        if (filter.matches(in.networks[i])) {
+            [[maybe_unused]] const bool copied = out.copy_entry(in, i);
+        }
+    }
+}
+
+#endif // SCAN_REQUEST_HPP
@@ -0,0 +1,137 @@
+/**
+ * @file scan_schedule.hpp
+ * @brief Adaptive interval policy for periodic background scans.
+ */
+
+#ifndef SCAN_SCHEDULE_HPP
+#define SCAN_SCHEDULE_HPP
+
+#include "scan_diff.hpp"
+#include "scan_msg.hpp"
+#include "scan_request.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+/**
+ * @brief Tuning for AdaptiveSchedule.
+ */
+struct ScheduleConfig {
+    uint32_t min_interval_ms{10000};    ///< Interval right after the AP set changed
+    uint32_t max_interval_ms{300000};   ///< Ceiling reached in a stable environment
+    uint8_t backoff_percent{200};       ///< Interval growth per stable scan (200 = doubling)
+    uint8_t change_tolerance{1};        ///< APs that may come and go without counting as a change
+    uint8_t min_overlap_percent{75};    ///< Share of the combined AP set that must persist to count as stable
+    DiffConfig diff{};                  ///< Hysteresis for delta subscribers
+    ScanMode mode{ScanMode::ACTIVE};    ///< Radio mode of the scheduled scans
+};
+
+/**
+ * @brief Scan interval that backs off while the AP set is stable.
+ *
+ * Each completed scan is compared with the previous one by BSSID only,
+ * since RSSI fluctuates from scan to scan. A scan counts as stable if at
+ * most change_tolerance APs appeared or vanished, or if the BSSIDs seen
+ * in both scans make up at least min_overlap_percent of those seen in
+ * either. The first rule covers small AP sets, where one AP is a large
+ * share; the second covers a full table, where a few weak APs at the edge
+ * of range swap in and out on every scan. While stable, the interval grows
+ * by backoff_percent up to max_interval_ms. A bigger change snaps it back
+ * to min_interval_ms. A min_overlap_percent of 100 leaves only the
+ * change_tolerance rule.
+ */
+class AdaptiveSchedule {
+public:
+    AdaptiveSchedule() noexcept : AdaptiveSchedule(ScheduleConfig{}) {}
+
+    explicit AdaptiveSchedule(const ScheduleConfig& config) noexcept
+        : config_(config),
+          interval_ms_(config.min_interval_ms) {
+        config_.max_interval_ms = std::max(config_.max_interval_ms, config_.min_interval_ms);
+        config_.backoff_percent = std::max<uint8_t>(config_.backoff_percent, 100);
+        config_.min_overlap_percent = std::min<uint8_t>(config_.min_overlap_percent, 100);
+    }
+
+    /**
+     * @brief Interval to wait before the next scan.
+     */
+    [[nodiscard]] uint32_t interval_ms() const noexcept {
+        return interval_ms_;
+    }
+
+    /**
+     * @brief Number of consecutive stable scans.
+     */
+    [[nodiscard]] uint32_t stable_scans() const noexcept {
+        return stable_scans_;
+    }
+
+    /**
+     * @brief Feed a completed scan and adapt the interval.
+     * @return true if the AP set changed since the previous scan
+     *
+     * Failed scans leave the interval and the reference AP set unchanged.
+     */
+    bool update(const ScanResult& result) noexcept {
+        if (!result.success) {
+            return false;
+        }
+
+        std::array<uint32_t, MAX_SCAN_RESULTS> current{};
+        const std::size_t count = result.count;
+        for (std::size_t i = 0; i < count; i++) {
+            current[i] = bssid_hash(result.networks.bssid[i]);
+        }
+        std::sort(current.begin(), current.begin() + count);
+
+        const bool changed = !has_reference_ || !similar(current, count);
+        previous_ = current;
+        previous_count_ = count;
+        has_reference_ = true;
+
+        if (changed) {
+            interval_ms_ = config_.min_interval_ms;
+            stable_scans_ = 0;
+        } else {
+            const uint64_t grown = uint64_t{interval_ms_} * config_.backoff_percent / 100;
+            interval_ms_ = static_cast<uint32_t>(
+                std::min<uint64_t>(grown, config_.max_interval_ms));
+            stable_scans_++;
+        }
+        return changed;
+    }
+
+private:
+    /**
+     * @brief Whether current is close enough to previous_ (both sorted) to count as stable.
+     */
+    [[nodiscard]] bool similar(const std::array<uint32_t, MAX_SCAN_RESULTS>& current,
+                               std::size_t count) const noexcept {
+        std::size_t i = 0;
+        std::size_t j = 0;
+        std::size_t shared = 0;
+        while (i < count && j < previous_count_) {
+            if (current[i] == previous_[j]) {
+                i++;
+                j++;
+                shared++;
+            } else {
+                current[i] < previous_[j] ? i++ : j++;
+            }
+        }
+        const std::size_t either = count + previous_count_ - shared;
+        const std::size_t diff = either - shared;
+        return diff <= config_.change_tolerance ||
+               shared * 100 >= either * config_.min_overlap_percent;
+    }
+
+    ScheduleConfig config_;
+    uint32_t interval_ms_;
+    uint32_t stable_scans_{0};
+    std::array<uint32_t, MAX_SCAN_RESULTS> previous_{};   ///< Sorted BSSID hashes of the last scan
+    std::size_t previous_count_{0};
+    bool has_reference_{false};
+};
+
+#endif // SCAN_SCHEDULE_HPP
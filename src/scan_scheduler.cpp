@@ -0,0 +1,155 @@
+/**
+ * @file scan_scheduler.cpp
+ * @brief Periodic background scans on an adaptive fixed-rate cadence, with
+ *        delta reporting.
+ */
+
+#include "wifi_scanner.hpp"
+#include "cores.hpp"
+#include "debug_log.hpp"
+#include "supervisor.hpp"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <array>
+
+namespace {
+
+constexpr uint32_t SCHEDULER_STACK_SIZE = 2048;
+constexpr UBaseType_t SCHEDULER_PRIORITY = tskIDLE_PRIORITY + 1;
+
+// Supervisor budget of one scheduled scan on top of the sleep before it:
+// the request's 30 s timeout, then the listeners
+constexpr uint32_t SCHEDULED_SCAN_BUDGET_MS = 60000;
+
+/**
+ * @brief Registered delta listener.
+ */
+struct DeltaSubscriber {
+    wifi::DeltaListener listener;
+    void* ctx;
+};
+
+using SubscriberList = std::array<DeltaSubscriber, wifi::MAX_DELTA_SUBSCRIBERS>;
+
+/**
+ * @brief State of the (single) scheduler task.
+ */
+struct Scheduler {
+    AdaptiveSchedule schedule;
+    ScanMode mode;
+    ScanDiff diff;
+    wifi::ScanListener listener;
+    void* ctx;
+};
+
+Scheduler g_scheduler{};
+TaskMemory<SCHEDULER_STACK_SIZE> g_scheduler_memory;
+TaskHandle_t g_scheduler_task = nullptr;
+
+// Delta subscribers, guarded by a critical section (registered from any task)
+SubscriberList g_subscribers{};
+std::size_t g_subscriber_count = 0;
+
+/**
+ * @brief Run the diff for scan and fan the events out to every subscriber.
+ */
+void publish_deltas(const ScanResult& scan) {
+    taskENTER_CRITICAL();
+    const SubscriberList subscribers = g_subscribers;
+    const std::size_t count = g_subscriber_count;
+    taskEXIT_CRITICAL();
+
+    const std::size_t events = g_scheduler.diff.update(scan, [&](const APEvent& event) {
+        for (std::size_t i = 0; i < count; i++) {
+            subscribers[i].listener(event, subscribers[i].ctx);
+        }
+    });
+    if (events > 0) {
+        DBG_INFO("Sched", "%u AP changes, %u tracked", static_cast<unsigned>(events),
+                 static_cast<unsigned>(g_scheduler.diff.tracked()));
+    }
+}
+
+/**
+ * @brief Scheduler task - scans, reports, then sleeps until the next slot.
+ */
+void scheduler_task(void* params) {
+    static_cast<void>(params);
+
+    DBG_INFO("Sched", "Scan scheduler started");
+    TickType_t last_wake = xTaskGetTickCount();
+    wifi::ScanLease scan;
+    supervisor::check_in(Watched::SCHEDULER, SCHEDULED_SCAN_BUDGET_MS);
+    while (true) {
+        if (wifi::request_scan(scan, g_scheduler.mode)) {
+            const bool changed = g_scheduler.schedule.update(*scan);
+            DBG_INFO("Sched", "Scan %lu: %u APs, %s, next in %lu ms",
+                     static_cast<unsigned long>(scan.generation()), scan->count,
+                     changed ? "changed" : "stable",
+                     static_cast<unsigned long>(g_scheduler.schedule.interval_ms()));
+            // Deltas first, so the listener can close a batch of them
+            publish_deltas(*scan);
+            if (g_scheduler.listener) {
+                g_scheduler.listener(*scan, changed, g_scheduler.ctx);
+            }
+        } else {
+            DBG_WARN("Sched", "Scheduled scan failed, retrying in %lu ms",
+                     static_cast<unsigned long>(g_scheduler.schedule.interval_ms()));
+        }
+        // Don't hold the scanner's buffer while asleep
+        scan.release();
+
+        const uint32_t interval_ms = g_scheduler.schedule.interval_ms();
+        supervisor::check_in(Watched::SCHEDULER, interval_ms + SCHEDULED_SCAN_BUDGET_MS);
+        const TickType_t period = pdMS_TO_TICKS(interval_ms);
+        if (xTaskDelayUntil(&last_wake, period) == pdFALSE) {
+            // Scan and listener overran the period: restart the cadence from
+            // now rather than firing back-to-back scans to catch up
+            last_wake = xTaskGetTickCount();
+        }
+    }
+}
+
+} // anonymous namespace
+
+namespace wifi {
+
+[[nodiscard]] bool start_scan_scheduler(const ScheduleConfig& config, ScanListener listener,
+                                        void* ctx) {
+    if (g_scheduler_task) {
+        return false;
+    }
+    g_scheduler = Scheduler{AdaptiveSchedule{config}, config.mode, ScanDiff{config.diff},
+                            listener, ctx};
+
+    DBG_INFO("Sched", "Creating scheduler task (interval %lu..%lu ms, %s scans)",
+             static_cast<unsigned long>(config.min_interval_ms),
+             static_cast<unsigned long>(config.max_interval_ms),
+             config.mode == ScanMode::PASSIVE ? "passive" : "active");
+    g_scheduler_task = create_pinned_task(
+        scheduler_task,
+        "scan_sched",
+        g_scheduler_memory,
+        nullptr,
+        SCHEDULER_PRIORITY,
+        APP_CORE
+    );
+    return g_scheduler_task != nullptr;
+}
+
+[[nodiscard]] bool subscribe_deltas(DeltaListener listener, void* ctx) {
+    if (!listener) {
+        return false;
+    }
+    taskENTER_CRITICAL();
+    const bool added = g_subscriber_count < g_subscribers.size();
+    if (added) {
+        g_subscribers[g_subscriber_count++] = DeltaSubscriber{listener, ctx};
+    }
+    taskEXIT_CRITICAL();
+    return added;
+}
+
+} // namespace wifi
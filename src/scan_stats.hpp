@@ -0,0 +1,142 @@
+/**
+ * @file scan_stats.hpp
+ * @brief Latency histograms and counters for the scan pipeline.
+ */
+
+#ifndef SCAN_STATS_HPP
+#define SCAN_STATS_HPP
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Fixed-bucket histogram of durations in microseconds.
+ *
+ * Buckets are powers of two: bucket 0 holds durations under 1024 us,
+ * bucket k holds [2^(9+k), 2^(10+k)) us, and the last bucket holds
+ * everything from about 16.8 s up. That spans a sub-millisecond handoff to
+ * a scan that nearly hits the 30 s request timeout, within a factor of two,
+ * in a few dozen bytes. Recording costs one bit scan and no division.
+ */
+class LatencyHistogram {
+public:
+    static constexpr std::size_t BUCKETS = 16;
+
+    /**
+     * @brief Bucket a duration falls in.
+     */
+    [[nodiscard]] static constexpr std::size_t bucket_of(uint32_t us) noexcept {
+        const auto bucket = static_cast<std::size_t>(std::bit_width(us >> 10));
+        return bucket < BUCKETS ? bucket : BUCKETS - 1;
+    }
+
+    /**
+     * @brief Exclusive upper edge of bucket, in microseconds (UINT32_MAX for the last).
+     */
+    [[nodiscard]] static constexpr uint32_t bucket_limit_us(std::size_t bucket) noexcept {
+        return bucket + 1 < BUCKETS ? 1u << (10 + bucket) : UINT32_MAX;
+    }
+
+    void record(uint32_t us) noexcept {
+        counts_[bucket_of(us)]++;
+        if (count_ == 0 || us < min_us_) {
+            min_us_ = us;
+        }
+        if (us > max_us_) {
+            max_us_ = us;
+        }
+        count_++;
+        total_us_ += us;
+    }
+
+    /**
+     * @brief Upper bound on the given percentile, in microseconds.
+     * @param percent 0..100
+     * @return Edge of the bucket the percentile falls in, capped at max_us()
+     *         (0 if nothing was recorded)
+     */
+    [[nodiscard]] uint32_t percentile_us(uint32_t percent) const noexcept {
+        if (count_ == 0) {
+            return 0;
+        }
+        const uint64_t rank = (static_cast<uint64_t>(count_) * percent + 99) / 100;
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < BUCKETS; i++) {
+            seen += counts_[i];
+            if (seen >= rank && seen > 0) {
+                const uint32_t limit = bucket_limit_us(i);
+                return limit < max_us_ ? limit : max_us_;
+            }
+        }
+        return max_us_;
+    }
+
+    [[nodiscard]] uint32_t count() const noexcept { return count_; }
+    [[nodiscard]] uint32_t min_us() const noexcept { return min_us_; }
+    [[nodiscard]] uint32_t max_us() const noexcept { return max_us_; }
+
+    [[nodiscard]] uint32_t mean_us() const noexcept {
+        return count_ ? static_cast<uint32_t>(total_us_ / count_) : 0;
+    }
+
+    /**
+     * @brief Sum of every recorded duration.
+     */
+    [[nodiscard]] uint64_t total_us() const noexcept { return total_us_; }
+
+    /**
+     * @brief Samples in bucket.
+     */
+    [[nodiscard]] uint32_t bucket_count(std::size_t bucket) const noexcept {
+        return bucket < BUCKETS ? counts_[bucket] : 0;
+    }
+
+private:
+    std::array<uint32_t, BUCKETS> counts_{};
+    uint64_t total_us_{0};
+    uint32_t count_{0};
+    uint32_t min_us_{0};
+    uint32_t max_us_{0};
+};
+
+/**
+ * @brief Microseconds from start to end, saturating (0 if end is earlier).
+ */
+[[nodiscard]] constexpr uint32_t elapsed_us(uint64_t start, uint64_t end) noexcept {
+    if (end <= start) {
+        return 0;
+    }
+    const uint64_t us = end - start;
+    return us > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(us);
+}
+
+/**
+ * @brief Timing of every phase a scan request goes through.
+ *
+ *   enqueued -> scan started -> first AP -> scan complete -> caller woken
+ *
+ * queue_wait, first_ap and radio are recorded by the scanner task;
+ * handoff and end_to_end by the caller once it has its result, so they
+ * include the time it took the caller to be scheduled. radio_on is
+ * recorded when the radio goes idle: a scan ended early by a match keeps
+ * sweeping, and the radio's energy use with it.
+ */
+struct ScanStats {
+    LatencyHistogram queue_wait;    ///< Request enqueued to its scan starting (per request)
+    LatencyHistogram first_ap;      ///< Scan start to the first AP callback (per scan)
+    LatencyHistogram radio;         ///< Scan start to scan complete or early match (per scan)
+    LatencyHistogram radio_on;      ///< Scan start to the radio going idle (per scan)
+    LatencyHistogram handoff;       ///< Scan complete to the caller running again (per request)
+    LatencyHistogram end_to_end;    ///< Request call to return, queueing included (per request)
+    uint32_t scans{0};              ///< Radio scans that completed
+    uint32_t failed_scans{0};       ///< Scans that could not start or timed out
+    uint32_t aborted_scans{0};      ///< Hung scans the radio gave up when told to abort
+    uint32_t wedged_scans{0};       ///< Hung scans the radio kept running despite the abort
+    uint32_t requests{0};           ///< Requests delivered to their caller
+    uint32_t timeouts{0};           ///< Requests whose caller gave up waiting
+    uint32_t aps_heard{0};          ///< AP callbacks from the radio, duplicates included
+};
+
+#endif // SCAN_STATS_HPP
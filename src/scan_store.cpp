@@ -0,0 +1,286 @@
+/**
+ * @file scan_store.cpp
+ * @brief Flash backend for ScanLog and the batched writer task.
+ *
+ * The reserved region holds two rings: the known-network cache in its
+ * first KNOWN_LOG_SECTORS sectors, full scans in the rest.
+ */
+
+#include "scan_store.hpp"
+#include "scan_log.hpp"
+#include "wifi_scanner.hpp"
+#include "cores.hpp"
+#include "debug_log.hpp"
+
+#include "hardware/flash.h"
+#include "pico/flash.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include <cstring>
+
+extern "C" char __flash_binary_end;
+
+namespace {
+
+constexpr uint32_t STORE_STACK_SIZE = 1024;
+constexpr UBaseType_t STORE_PRIORITY = tskIDLE_PRIORITY + 1;
+
+// Minimum time between writes; changes in between are batched
+constexpr uint32_t STORE_MIN_INTERVAL_MS = 60000;
+
+// Write an unchanged AP set at least this often, to keep RSSI fresh
+constexpr uint32_t STORE_REFRESH_INTERVAL_MS = 30 * 60 * 1000;
+
+// Longest a flash operation waits for the other core to be parked
+constexpr uint32_t FLASH_SAFE_TIMEOUT_MS = 100;
+
+// Reserved region at the very end of flash
+constexpr std::size_t REGION_SECTORS = 16;
+constexpr std::size_t REGION_OFFSET = PICO_FLASH_SIZE_BYTES - REGION_SECTORS * FLASH_SECTOR_SIZE;
+
+// Known-network ring at the start of the region; a record is two pages
+constexpr std::size_t KNOWN_LOG_SECTORS = 2;
+
+// Notification bits for the writer task
+constexpr uint32_t STORE_EVENT_SCAN = 1u << 0;     ///< The AP set changed
+constexpr uint32_t STORE_EVENT_KNOWN = 1u << 1;    ///< save_known() was called
+
+/**
+ * @brief ScanLog backend for part of the reserved region of the on-board QSPI flash.
+ */
+struct RegionFlash {
+    static constexpr std::size_t SECTOR_SIZE = FLASH_SECTOR_SIZE;
+    static constexpr std::size_t PAGE_SIZE = FLASH_PAGE_SIZE;
+
+    std::size_t base;           ///< Flash offset of the first sector
+    std::size_t sector_count;   ///< Sectors in the ring
+
+    std::size_t sectors() const {
+        return sector_count;
+    }
+
+    void read(std::size_t offset, uint8_t* out, std::size_t len) {
+        // flash_range_erase/program flush the XIP cache, so mapped reads are current
+        std::memcpy(out, reinterpret_cast<const uint8_t*>(XIP_BASE + base + offset), len);
+    }
+
+    bool erase_sector(std::size_t sector) {
+        std::size_t offset = base + sector * SECTOR_SIZE;
+        return flash_safe_execute(do_erase, &offset, FLASH_SAFE_TIMEOUT_MS) == PICO_OK;
+    }
+
+    bool program(std::size_t offset, const uint8_t* data, std::size_t len) {
+        Program op{base + offset, data, len};
+        return flash_safe_execute(do_program, &op, FLASH_SAFE_TIMEOUT_MS) == PICO_OK;
+    }
+
+private:
+    struct Program {
+        std::size_t offset;
+        const uint8_t* data;
+        std::size_t len;
+    };
+
+    // Run with XIP disabled and the other core parked
+    static void do_erase(void* param) {
+        flash_range_erase(*static_cast<const std::size_t*>(param), SECTOR_SIZE);
+    }
+
+    static void do_program(void* param) {
+        const auto* op = static_cast<const Program*>(param);
+        flash_range_program(op->offset, op->data, op->len);
+    }
+};
+
+RegionFlash g_known_flash{REGION_OFFSET, KNOWN_LOG_SECTORS};
+RegionFlash g_flash{REGION_OFFSET + KNOWN_LOG_SECTORS * FLASH_SECTOR_SIZE,
+                    REGION_SECTORS - KNOWN_LOG_SECTORS};
+ScanLog<RegionFlash> g_known_log{g_known_flash};
+ScanLog<RegionFlash> g_log{g_flash};
+
+// Known-network cache revision last written (or restored)
+uint32_t g_known_revision = 0;
+
+// Guards both logs (their buffers are shared by reads and writes)
+SemaphoreHandle_t g_log_mutex = nullptr;
+StaticSemaphore_t g_log_mutex_control;
+
+TaskMemory<STORE_STACK_SIZE> g_store_memory;
+TaskHandle_t g_store_task = nullptr;
+
+/**
+ * @brief Delta listener: the AP set changed, a write is due.
+ */
+void on_delta(const APEvent& event, void* ctx) {
+    static_cast<void>(event);
+    static_cast<void>(ctx);
+    xTaskNotify(g_store_task, STORE_EVENT_SCAN, eSetBits);
+}
+
+/**
+ * @brief Write the known-network cache if it changed since the last write.
+ */
+void write_known() {
+    const KnownNetworks known = wifi::known_networks();
+    if (known.revision() == g_known_revision) {
+        return;
+    }
+    // Static: the writer is the only user
+    static BasicScanResult<MAX_KNOWN_NETWORKS> record;
+    known.export_to(record);
+
+    xSemaphoreTake(g_log_mutex, portMAX_DELAY);
+    const bool written = g_known_log.prepare(record) && g_known_log.commit();
+    xSemaphoreGive(g_log_mutex);
+
+    if (!written) {
+        DBG_ERROR("Store", "Failed to write known networks to flash");
+        return;
+    }
+    g_known_revision = known.revision();
+    DBG_INFO("Store", "Saved %u known networks", static_cast<unsigned>(known.size()));
+}
+
+/**
+ * @brief Write the latest full scan to the log.
+ * @return false if there was nothing new to write or the write failed
+ */
+bool write_latest(uint32_t& last_generation) {
+    wifi::ScanLease scan = wifi::latest_scan();
+    if (!scan || scan.generation() == last_generation) {
+        return false;
+    }
+
+    xSemaphoreTake(g_log_mutex, portMAX_DELAY);
+    // Encode from the lease, then give the scanner its buffer back before
+    // the slow part
+    const bool prepared = g_log.prepare(*scan);
+    const uint32_t generation = scan.generation();
+    const uint16_t count = scan->count;
+    scan.release();
+    const bool written = prepared && g_log.commit();
+    const uint32_t sequence = g_log.latest_sequence();
+    xSemaphoreGive(g_log_mutex);
+
+    if (!written) {
+        DBG_ERROR("Store", "Failed to write scan %lu to flash",
+                  static_cast<unsigned long>(generation));
+        return false;
+    }
+    last_generation = generation;
+    DBG_INFO("Store", "Saved scan %lu as record %lu (%u APs)",
+             static_cast<unsigned long>(generation), static_cast<unsigned long>(sequence), count);
+    return true;
+}
+
+/**
+ * @brief Writer task - persists the latest full scan after changes.
+ *
+ * Woken by delta events, which the scheduler delivers right after a scan,
+ * so flash is written while the radio is idle. Changes that arrive within
+ * STORE_MIN_INTERVAL_MS of the previous write are batched into one write
+ * of the newest scan at the end of that interval. The known-network cache
+ * is small and rarely changes, so it is checked on every wakeup and
+ * written straight away.
+ */
+void store_task(void* params) {
+    static_cast<void>(params);
+
+    uint32_t last_generation = 0;
+    bool pending = false;
+    TickType_t last_write = xTaskGetTickCount() - pdMS_TO_TICKS(STORE_MIN_INTERVAL_MS);
+    while (true) {
+        const TickType_t wait = pdMS_TO_TICKS(pending ? STORE_MIN_INTERVAL_MS
+                                                      : STORE_REFRESH_INTERVAL_MS);
+        uint32_t events = 0;
+        const bool notified = xTaskNotifyWait(0, UINT32_MAX, &events, wait) == pdTRUE;
+        write_known();
+        if (notified) {
+            const bool changed = (events & STORE_EVENT_SCAN) != 0;
+            pending = pending || changed;
+            if (!changed ||
+                xTaskGetTickCount() - last_write < pdMS_TO_TICKS(STORE_MIN_INTERVAL_MS)) {
+                continue;
+            }
+        }
+        // Timed out: write the batched change, or refresh an unchanged AP set
+        if (write_latest(last_generation)) {
+            last_write = xTaskGetTickCount();
+        }
+        pending = false;
+    }
+}
+
+/**
+ * @brief Mount the known-network log and hand its newest record to the scanner.
+ */
+void restore_known() {
+    g_known_log.mount();
+    static BasicScanResult<MAX_KNOWN_NETWORKS> record;
+    if (!g_known_log.load_latest(record)) {
+        return;
+    }
+    KnownNetworks known;
+    known.import_from(record);
+    wifi::set_known_networks(known);
+    g_known_revision = known.revision();
+    DBG_INFO("Store", "Restored %u known networks", static_cast<unsigned>(known.size()));
+}
+
+} // anonymous namespace
+
+namespace scan_store {
+
+[[nodiscard]] bool start() {
+    if (g_store_task) {
+        return false;
+    }
+    const auto image_end = reinterpret_cast<uintptr_t>(&__flash_binary_end) - XIP_BASE;
+    if (image_end > REGION_OFFSET) {
+        DBG_ERROR("Store", "Firmware image overlaps the scan log region");
+        return false;
+    }
+
+    g_log_mutex = xSemaphoreCreateMutexStatic(&g_log_mutex_control);
+    restore_known();
+    g_log.mount();
+    if (g_log.empty()) {
+        DBG_INFO("Store", "No stored scans");
+    } else {
+        DBG_INFO("Store", "Scan log mounted, newest record %lu",
+                 static_cast<unsigned long>(g_log.latest_sequence()));
+    }
+
+    g_store_task = create_pinned_task(store_task, "scan_store", g_store_memory, nullptr,
+                                      STORE_PRIORITY, APP_CORE);
+    if (!g_store_task) {
+        return false;
+    }
+    if (!wifi::subscribe_deltas(on_delta)) {
+        DBG_ERROR("Store", "No delta subscriber slot, scans will only be refreshed");
+    }
+    return true;
+}
+
+[[nodiscard]] bool load_latest(ScanResult& out, uint32_t* sequence) {
+    if (!g_log_mutex) {
+        return false;
+    }
+    xSemaphoreTake(g_log_mutex, portMAX_DELAY);
+    const bool loaded = g_log.load_latest(out);
+    if (sequence) {
+        *sequence = g_log.latest_sequence();
+    }
+    xSemaphoreGive(g_log_mutex);
+    return loaded;
+}
+
+void save_known() {
+    if (g_store_task) {
+        xTaskNotify(g_store_task, STORE_EVENT_KNOWN, eSetBits);
+    }
+}
+
+} // namespace scan_store
@@ -0,0 +1,53 @@
+/**
+ * @file scan_store.hpp
+ * @brief Scan results persisted to flash, for a warm AP cache after reboot.
+ *
+ * The last 64 KB of flash hold two ScanLog rings (scan_log.hpp): 8 KB for
+ * the scanner's known-network cache, the rest for full scans. A
+ * low-priority writer task on the application core writes the latest full
+ * scan when the scan scheduler reports changes, at most once a minute
+ * (changes in between are batched into one write), and refreshes an
+ * unchanged AP set every half hour. The known-network cache is written
+ * whenever it changes in a way worth keeping (see KnownNetworks::revision()).
+ *
+ * Flash is programmed through flash_safe_execute(), one page (about
+ * 0.5 ms) or one sector erase (up to about 50 ms, every few records) at a
+ * time, which briefly parks the other core. Change-triggered writes start
+ * right after a scan, while the radio is idle until the next one.
+ */
+
+#ifndef SCAN_STORE_HPP
+#define SCAN_STORE_HPP
+
+#include "scan_msg.hpp"
+
+#include <cstdint>
+
+namespace scan_store {
+
+/**
+ * @brief Mount the flash logs, restore the known-network cache and start the writer task.
+ * @return false if the region overlaps the firmware image or the task could not start
+ *
+ * Call once, before start_scan_scheduler(), so the first scan is saved.
+ */
+[[nodiscard]] bool start();
+
+/**
+ * @brief Write the known-network cache now instead of at the next scan.
+ *
+ * Call after wifi::remember_network() or wifi::forget_network(). Returns
+ * immediately; the writer task does the write.
+ */
+void save_known();
+
+/**
+ * @brief Decode the newest stored scan.
+ * @param sequence Receives the record's sequence number, or nullptr
+ * @return false if nothing is stored (first boot, or start() not called)
+ */
+[[nodiscard]] bool load_latest(ScanResult& out, uint32_t* sequence = nullptr);
+
+} // namespace scan_store
+
+#endif // SCAN_STORE_HPP
@@ -0,0 +1,82 @@
+/**
+ * @file scan_trace.cpp
+ * @brief Scan callback capture: trace frames written to RTT channel 2.
+ */
+
+#include "scan_trace.hpp"
+
+#if SCAN_TRACE_ENABLED
+
+#include "trace_frame.hpp"
+#include "SEGGER_RTT.h"
+
+#include <array>
+
+namespace {
+
+// RTT up-channel for trace frames; 0 is text stdio, 1 binary debug logs
+constexpr unsigned RTT_TRACE_CHANNEL = 2;
+
+// About two scans of a busy site (~50 bytes per callback)
+constexpr std::size_t RTT_TRACE_BUFFER_SIZE = 8192;
+
+std::array<char, RTT_TRACE_BUFFER_SIZE> g_rtt_trace_buffer;
+
+// Only touched under the CYW43 lock
+uint8_t g_sequence = 0;
+uint64_t g_start_us = 0;
+bool g_tracing = false;
+
+/**
+ * @brief Send one frame; RTT skips it whole if the host is not keeping up.
+ */
+void send(const std::array<uint8_t, trace_frame::MAX_FRAME>& frame, std::size_t len) {
+    SEGGER_RTT_Write(RTT_TRACE_CHANNEL, frame.data(), static_cast<unsigned>(len));
+    // Counted even when skipped, so the gap shows on the host
+    g_sequence++;
+}
+
+} // anonymous namespace
+
+namespace scan_trace {
+
+void start() {
+    SEGGER_RTT_ConfigUpBuffer(RTT_TRACE_CHANNEL, "scantrace", g_rtt_trace_buffer.data(),
+                              g_rtt_trace_buffer.size(), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+}
+
+void scan_started(uint64_t start_us, bool passive, bool directed) {
+    const uint8_t flags = (passive ? trace_frame::FLAG_PASSIVE : 0) |
+                          (directed ? trace_frame::FLAG_DIRECTED : 0);
+    std::array<uint8_t, trace_frame::MAX_FRAME> frame;
+    send(frame, trace_frame::encode_start(g_sequence, flags, static_cast<uint32_t>(start_us),
+                                          frame.data()));
+    g_start_us = start_us;
+    g_tracing = true;
+}
+
+void ap_heard(const cyw43_ev_scan_result_t& result, uint64_t now_us) {
+    if (!g_tracing) {
+        return;
+    }
+    const trace_frame::TracedAp ap{static_cast<uint32_t>(now_us - g_start_us), result.bssid,
+                                   static_cast<int8_t>(result.rssi),
+                                   static_cast<uint8_t>(result.channel), result.auth_mode,
+                                   result.ssid, result.ssid_len};
+    std::array<uint8_t, trace_frame::MAX_FRAME> frame;
+    send(frame, trace_frame::encode_ap(g_sequence, ap, frame.data()));
+}
+
+void scan_done(uint64_t now_us) {
+    if (!g_tracing) {
+        return;
+    }
+    std::array<uint8_t, trace_frame::MAX_FRAME> frame;
+    send(frame, trace_frame::encode_end(g_sequence, static_cast<uint32_t>(now_us - g_start_us),
+                                        frame.data()));
+    g_tracing = false;
+}
+
+} // namespace scan_trace
+
+#endif // SCAN_TRACE_ENABLED
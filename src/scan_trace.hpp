@@ -0,0 +1,61 @@
+/**
+ * @file scan_trace.hpp
+ * @brief Capture of raw scan callbacks over RTT, for replay in the host simulator.
+ *
+ * Enable with -DSCAN_TRACE=ON. Every scan the scanner starts is recorded
+ * (trace_frame.hpp): its start, every callback the driver makes with its
+ * microsecond offset, and its completion, before any deduplication or
+ * filtering. Frames go to RTT channel 2, which only the network core
+ * writes; `just trace FILE` turns them into a trace test/sim replays.
+ *
+ * The hooks run in the scan callback and the driver poll, under the CYW43
+ * lock, so each is one encode into a stack buffer and one RTT write. When
+ * the host is not reading fast enough RTT skips whole frames, and the
+ * frame sequence number tells the tool which scans are incomplete.
+ */
+
+#ifndef SCAN_TRACE_HPP
+#define SCAN_TRACE_HPP
+
+#include "pico/cyw43_arch.h"
+
+#include <cstdint>
+
+namespace scan_trace {
+
+#if SCAN_TRACE_ENABLED
+
+/**
+ * @brief Set up the RTT channel. Call before the scanner starts.
+ */
+void start();
+
+/**
+ * @brief Record a scan the radio accepted.
+ * @param start_us time_us_64() when cyw43_wifi_scan() was called
+ */
+void scan_started(uint64_t start_us, bool passive, bool directed);
+
+/**
+ * @brief Record one callback of the current scan.
+ */
+void ap_heard(const cyw43_ev_scan_result_t& result, uint64_t now_us);
+
+/**
+ * @brief Record the current scan's completion.
+ */
+void scan_done(uint64_t now_us);
+
+#else
+
+// Capture disabled
+inline void start() {}
+inline void scan_started(uint64_t, bool, bool) {}
+inline void ap_heard(const cyw43_ev_scan_result_t&, uint64_t) {}
+inline void scan_done(uint64_t) {}
+
+#endif // SCAN_TRACE_ENABLED
+
+} // namespace scan_trace
+
+#endif // SCAN_TRACE_HPP
@@ -0,0 +1,181 @@
+/**
+ * @file station.cpp
+ * @brief Link task: fast join from the known-network cache, rejoin with backoff.
+ */
+
+#include "station.hpp"
+
+#ifdef WIFI_SSID
+
+#include "wifi_scanner.hpp"
+#include "scan_store.hpp"
+#include "cores.hpp"
+#include "debug_log.hpp"
+
+#include "pico/cyw43_arch.h"
+#include "pico/time.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#ifndef WIFI_PASSWORD
+#define WIFI_PASSWORD ""
+#endif
+
+namespace {
+
+constexpr uint32_t STATION_STACK_SIZE = 1024;
+constexpr UBaseType_t STATION_PRIORITY = tskIDLE_PRIORITY + 1;
+
+constexpr uint32_t JOIN_POLL_MS = 100;
+constexpr uint32_t LINK_POLL_MS = 1000;
+
+// Broadcom WLC ioctl, encoded for cyw43_ioctl() as cmd << 1 | set
+constexpr uint32_t WLC_GET_CHANNEL = 29 << 1;
+
+TaskMemory<STATION_STACK_SIZE> g_station_memory;
+TaskHandle_t g_station_task = nullptr;
+
+bool has_password() {
+    return WIFI_PASSWORD[0] != '\0';
+}
+
+int link_status() {
+    return cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+}
+
+/**
+ * @brief Start a join and wait for an IP address.
+ * @param bssid AP to join, or nullptr for any AP with the SSID
+ * @param channel Channel of bssid, or CYW43_CHANNEL_NONE
+ */
+bool try_join(const uint8_t* bssid, uint32_t channel) {
+    const uint32_t auth = has_password() ? CYW43_AUTH_WPA2_AES_PSK : CYW43_AUTH_OPEN;
+    // The cyw43_wifi_* calls take the driver lock themselves
+    const int err = cyw43_wifi_join(&cyw43_state, std::strlen(WIFI_SSID),
+                                    reinterpret_cast<const uint8_t*>(WIFI_SSID),
+                                    std::strlen(WIFI_PASSWORD),
+                                    reinterpret_cast<const uint8_t*>(WIFI_PASSWORD),
+                                    auth, bssid, channel);
+    if (err != 0) {
+        DBG_WARN("Sta", "cyw43_wifi_join failed: %d", err);
+        return false;
+    }
+
+    int status = CYW43_LINK_JOIN;
+    for (uint32_t waited = 0; waited < station::JOIN_TIMEOUT_MS; waited += JOIN_POLL_MS) {
+        status = link_status();
+        if (status == CYW43_LINK_UP || status < 0) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(JOIN_POLL_MS));
+    }
+    if (status == CYW43_LINK_UP) {
+        return true;
+    }
+    DBG_WARN("Sta", "Join failed (link status %d)", status);
+    cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+    return false;
+}
+
+/**
+ * @brief The AP now associated with, as a known-network entry.
+ */
+APInfo associated_ap() {
+    APInfo ap;
+    std::strncpy(ap.ssid.data(), WIFI_SSID, MAX_SSID_LEN);
+    ap.auth = has_password() ? AuthMode::WPA2_PSK : AuthMode::OPEN;
+
+    int32_t rssi = 0;
+    std::array<uint8_t, 3 * sizeof(uint32_t)> channel_info{};
+    cyw43_wifi_get_bssid(&cyw43_state, ap.bssid.data());
+    cyw43_wifi_get_rssi(&cyw43_state, &rssi);
+    cyw43_ioctl(&cyw43_state, WLC_GET_CHANNEL, channel_info.size(), channel_info.data(),
+                CYW43_ITF_STA);
+
+    // channel_info_t: hw_channel, target_channel, scan_channel
+    uint32_t channel = 0;
+    std::memcpy(&channel, channel_info.data(), sizeof(channel));
+    ap.rssi = static_cast<int16_t>(rssi);
+    ap.channel = static_cast<uint8_t>(channel);
+    return ap;
+}
+
+/**
+ * @brief Join, trying the cached AP for the SSID first.
+ */
+bool join() {
+    const uint64_t start_us = time_us_64();
+    const KnownNetworks known = wifi::known_networks();
+    const KnownNetwork* cached = known.best_for(WIFI_SSID);
+
+    bool joined = false;
+    if (cached) {
+        DBG_INFO("Sta", "Joining %s on ch%u (cached)", WIFI_SSID, cached->ap.channel);
+        joined = try_join(cached->ap.bssid.data(), cached->ap.channel);
+    }
+    if (!joined) {
+        DBG_INFO("Sta", "Joining %s", WIFI_SSID);
+        joined = try_join(nullptr, CYW43_CHANNEL_NONE);
+    }
+    if (!joined) {
+        return false;
+    }
+
+    const APInfo ap = associated_ap();
+    DBG_INFO("Sta", "Connected to %s (ch%u, %d dBm) in %lu ms", WIFI_SSID, ap.channel, ap.rssi,
+             static_cast<unsigned long>((time_us_64() - start_us) / 1000));
+    // The bytes themselves, not a formatted string: the record outlives this frame
+    DBG_INFO("Sta", "Joined BSSID %02x:%02x:%02x:%02x:%02x:%02x", ap.bssid[0], ap.bssid[1],
+             ap.bssid[2], ap.bssid[3], ap.bssid[4], ap.bssid[5]);
+    wifi::remember_network(ap);
+    scan_store::save_known();
+    return true;
+}
+
+/**
+ * @brief Link task - keeps the station associated.
+ */
+void station_task(void* params) {
+    static_cast<void>(params);
+
+    uint32_t retry_ms = station::RETRY_MIN_MS;
+    while (true) {
+        if (!join()) {
+            DBG_WARN("Sta", "Retrying in %lu ms", static_cast<unsigned long>(retry_ms));
+            vTaskDelay(pdMS_TO_TICKS(retry_ms));
+            retry_ms = std::min(retry_ms * 2, station::RETRY_MAX_MS);
+            continue;
+        }
+        retry_ms = station::RETRY_MIN_MS;
+
+        while (link_status() == CYW43_LINK_UP) {
+            vTaskDelay(pdMS_TO_TICKS(LINK_POLL_MS));
+        }
+        DBG_WARN("Sta", "Link lost (status %d), rejoining", link_status());
+    }
+}
+
+} // anonymous namespace
+
+namespace station {
+
+[[nodiscard]] bool start() {
+    if (g_station_task) {
+        return false;
+    }
+    g_station_task = create_pinned_task(station_task, "station", g_station_memory, nullptr,
+                                        STATION_PRIORITY, APP_CORE);
+    return g_station_task != nullptr;
+}
+
+[[nodiscard]] bool connected() {
+    return link_status() == CYW43_LINK_UP;
+}
+
+} // namespace station
+
+#endif // WIFI_SSID
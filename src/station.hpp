@@ -0,0 +1,64 @@
+/**
+ * @file station.hpp
+ * @brief Stay associated with one network while the scanner keeps scanning.
+ *
+ * Configure with -DWIFI_SSID=<network> (and -DWIFI_PASSWORD=<passphrase>,
+ * empty for an open network). A link task on the application core joins
+ * the network, then watches the link and rejoins with exponential backoff
+ * when it drops.
+ *
+ * A join goes straight to the BSSID and channel recorded in the
+ * known-network cache for the SSID, when there is one, so the firmware
+ * skips its own search scan; it falls back to a join by SSID alone. The
+ * AP joined is remembered in the cache (and saved to flash), so the next
+ * boot or rejoin takes the fast path.
+ *
+ * Scans keep running while associated: the firmware visits one channel at
+ * a time and returns to the AP's channel between them (see
+ * wifi::init()), so lwIP traffic is delayed by one short dwell rather
+ * than stopped for the whole sweep.
+ */
+
+#ifndef STATION_HPP
+#define STATION_HPP
+
+#include <cstdint>
+
+namespace station {
+
+/// First retry delay after a failed join
+inline constexpr uint32_t RETRY_MIN_MS = 1000;
+
+/// Longest retry delay, reached by doubling
+inline constexpr uint32_t RETRY_MAX_MS = 60000;
+
+/// Longest a join may take, IP address included
+inline constexpr uint32_t JOIN_TIMEOUT_MS = 15000;
+
+#ifdef WIFI_SSID
+
+/**
+ * @brief Start the link task.
+ * @return false if the task could not start
+ *
+ * Call after wifi::init() and scan_store::start(), so the cache holds the
+ * APs saved by earlier boots.
+ */
+[[nodiscard]] bool start();
+
+/**
+ * @brief Whether the station has a link and an IP address.
+ */
+[[nodiscard]] bool connected();
+
+#else
+
+// No network configured: scan only
+[[nodiscard]] inline bool start() { return true; }
+[[nodiscard]] inline bool connected() { return false; }
+
+#endif // WIFI_SSID
+
+} // namespace station
+
+#endif // STATION_HPP
@@ -0,0 +1,133 @@
+/**
+ * @file supervisor.cpp
+ * @brief Supervisor task: feeds the hardware watchdog while every supervised task is healthy.
+ */
+
+#include "supervisor.hpp"
+
+#if WATCHDOG_ENABLED
+
+#include "cores.hpp"
+#include "debug_log.hpp"
+
+#include "hardware/watchdog.h"
+#include "pico/time.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+namespace {
+
+constexpr uint32_t SUPERVISOR_STACK_SIZE = 512;
+// Lowest application priority: a task spinning on the core starves the
+// feed too, and the watchdog catches that as well
+constexpr UBaseType_t SUPERVISOR_PRIORITY = tskIDLE_PRIORITY + 1;
+
+constexpr uint32_t FEED_INTERVAL_MS = 1000;
+static_assert(FEED_INTERVAL_MS * 2 <= supervisor::WATCHDOG_TIMEOUT_MS);
+
+// Scratch registers 0-3 are free; the SDK uses 4-7 for watchdog_reboot()
+constexpr uint32_t RECORD_SCRATCH = 0;
+constexpr uint32_t COUNT_SCRATCH = 1;
+
+TaskMemory<SUPERVISOR_STACK_SIZE> g_supervisor_memory;
+TaskHandle_t g_supervisor_task = nullptr;
+
+// Written by the supervised tasks, read by the supervisor; guarded by a
+// critical section (64-bit deadlines are not written atomically)
+HealthMonitor g_monitor;
+
+// Read once by start(), before the scheduler runs
+supervisor::BootRecovery g_boot_recovery;
+
+/**
+ * @brief Leave the reason for the coming reset where the next boot finds it.
+ */
+void record_reboot(RebootCause cause, Watched task) {
+    watchdog_hw->scratch[RECORD_SCRATCH] = RebootRecord{cause, task}.encode();
+    watchdog_hw->scratch[COUNT_SCRATCH] = g_boot_recovery.watchdog_resets + 1;
+}
+
+/**
+ * @brief Supervisor task - feeds the watchdog until a supervised task is unhealthy.
+ */
+void supervisor_task(void* params) {
+    static_cast<void>(params);
+
+    TickType_t last_wake = xTaskGetTickCount();
+    while (true) {
+        taskENTER_CRITICAL();
+        const Watched culprit = g_monitor.unhealthy(time_us_64());
+        const bool failed = g_monitor.failed(culprit);
+        taskEXIT_CRITICAL();
+
+        if (culprit == Watched::COUNT) {
+            watchdog_update();
+            xTaskDelayUntil(&last_wake, pdMS_TO_TICKS(FEED_INTERVAL_MS));
+            continue;
+        }
+
+        const RebootCause cause = failed ? RebootCause::FAILED : RebootCause::STALLED;
+        record_reboot(cause, culprit);
+        DBG_ERROR("Supervisor", "%s %s, watchdog reset in %lu ms", watched_name(culprit),
+                  failed ? "gave up" : "missed its deadline",
+                  static_cast<unsigned long>(supervisor::WATCHDOG_TIMEOUT_MS));
+        dlog::flush();
+        // Stop feeding; the watchdog takes it from here
+        while (true) { vTaskDelay(portMAX_DELAY); }
+    }
+}
+
+} // anonymous namespace
+
+namespace supervisor {
+
+[[nodiscard]] bool start() {
+    if (g_supervisor_task) {
+        return false;
+    }
+
+    // Scratch registers survive a watchdog reset but not a power-on
+    if (watchdog_enable_caused_reboot()) {
+        g_boot_recovery.record = RebootRecord::decode(watchdog_hw->scratch[RECORD_SCRATCH]);
+        g_boot_recovery.watchdog_resets = watchdog_hw->scratch[COUNT_SCRATCH];
+    }
+    if (!g_boot_recovery.record.supervised()) {
+        g_boot_recovery.watchdog_resets = 0;
+    }
+    watchdog_hw->scratch[RECORD_SCRATCH] = 0;
+    watchdog_hw->scratch[COUNT_SCRATCH] = g_boot_recovery.watchdog_resets;
+
+    DBG_INFO("Supervisor", "Watchdog armed (%lu ms)",
+             static_cast<unsigned long>(WATCHDOG_TIMEOUT_MS));
+    watchdog_enable(WATCHDOG_TIMEOUT_MS, true);
+    g_supervisor_task = create_pinned_task(supervisor_task, "supervisor", g_supervisor_memory,
+                                           nullptr, SUPERVISOR_PRIORITY, APP_CORE);
+    return g_supervisor_task != nullptr;
+}
+
+void check_in(Watched task, uint32_t budget_ms) {
+    const uint64_t now = time_us_64();
+    taskENTER_CRITICAL();
+    g_monitor.check_in(task, now, budget_ms);
+    taskEXIT_CRITICAL();
+}
+
+void idle(Watched task) {
+    taskENTER_CRITICAL();
+    g_monitor.idle(task);
+    taskEXIT_CRITICAL();
+}
+
+void fail(Watched task) {
+    taskENTER_CRITICAL();
+    g_monitor.fail(task);
+    taskEXIT_CRITICAL();
+}
+
+[[nodiscard]] BootRecovery boot_recovery() {
+    return g_boot_recovery;
+}
+
+} // namespace supervisor
+
+#endif // WATCHDOG_ENABLED
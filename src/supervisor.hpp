@@ -0,0 +1,74 @@
+/**
+ * @file supervisor.hpp
+ * @brief Hardware watchdog, fed only while the supervised tasks are healthy.
+ *
+ * Build with -DWATCHDOG=ON (the default). The supervisor task feeds the
+ * RP2350 watchdog once a second, as long as every task in Watched has
+ * checked in within its budget and none has failed (health_monitor.hpp).
+ * When one has, it logs the culprit, leaves a RebootRecord in watchdog
+ * scratch register 0 and stops feeding: the watchdog resets the chip,
+ * radio included, WATCHDOG_TIMEOUT_MS later. Scratch register 1 counts
+ * these resets until the next power-on.
+ *
+ * The watchdog pauses while a debugger halts the cores.
+ */
+
+#ifndef SUPERVISOR_HPP
+#define SUPERVISOR_HPP
+
+#include "health_monitor.hpp"
+
+#include <cstdint>
+
+namespace supervisor {
+
+/// Hardware watchdog period: a stall is caught between this and this plus one feed interval
+inline constexpr uint32_t WATCHDOG_TIMEOUT_MS = 8000;
+
+/**
+ * @brief How the previous run ended, read at start().
+ */
+struct BootRecovery {
+    RebootRecord record{};          ///< Cause if this boot follows a supervised reset
+    uint32_t watchdog_resets{0};    ///< Supervised resets since power-on
+};
+
+#if WATCHDOG_ENABLED
+
+/**
+ * @brief Read the previous run's reboot record, arm the watchdog and start the supervisor task.
+ * @return true if the task was created
+ */
+[[nodiscard]] bool start();
+
+/**
+ * @brief The calling task is alive, and checks in again or goes idle within budget_ms.
+ */
+void check_in(Watched task, uint32_t budget_ms);
+
+/**
+ * @brief The calling task is about to block waiting for work.
+ */
+void idle(Watched task);
+
+/**
+ * @brief The calling task cannot recover on its own: reset the device.
+ */
+void fail(Watched task);
+
+[[nodiscard]] BootRecovery boot_recovery();
+
+#else
+
+// No watchdog: stalls and failures are only logged by the tasks themselves
+[[nodiscard]] inline bool start() { return true; }
+inline void check_in(Watched, uint32_t) {}
+inline void idle(Watched) {}
+inline void fail(Watched) {}
+[[nodiscard]] inline BootRecovery boot_recovery() { return {}; }
+
+#endif // WATCHDOG_ENABLED
+
+} // namespace supervisor
+
+#endif // SUPERVISOR_HPP
@@ -0,0 +1,155 @@
+/**
+ * @file sysmon.cpp
+ * @brief Sysmon task: per-task CPU and stack usage, heap watermarks.
+ */
+
+#include "sysmon.hpp"
+
+#if SYSMON_ENABLED
+
+#include "cores.hpp"
+#include "debug_log.hpp"
+#include "task_stats.hpp"
+#include "net_stats.hpp"
+#include "wifi_scanner.hpp"
+#include "supervisor.hpp"
+
+#include "pico/time.h"
+#include "task.h"
+
+#include <array>
+
+namespace {
+
+constexpr uint32_t SYSMON_STACK_SIZE = 1024;
+constexpr UBaseType_t SYSMON_PRIORITY = tskIDLE_PRIORITY + 1;
+
+// Tasks listed per report; the rest are counted but not shown
+constexpr std::size_t MAX_TASKS = 16;
+
+TaskMemory<SYSMON_STACK_SIZE> g_sysmon_memory;
+TaskHandle_t g_sysmon_task = nullptr;
+
+std::array<TaskStatus_t, MAX_TASKS> g_status;
+RunTimeDelta<MAX_TASKS> g_run_time;
+configRUN_TIME_COUNTER_TYPE g_last_total = 0;
+
+// Radio-on total and time at the previous report, for the radio's duty cycle
+uint64_t g_last_radio_on_us = 0;
+uint64_t g_last_report_us = 0;
+
+/**
+ * @brief Cores a task may run on, as a bit mask.
+ */
+UBaseType_t affinity(const TaskStatus_t& status) {
+#if configNUMBER_OF_CORES > 1 && configUSE_CORE_AFFINITY
+    return status.uxCoreAffinityMask;
+#else
+    static_cast<void>(status);
+    return 1;
+#endif
+}
+
+/**
+ * @brief Log the scan pipeline's latency summary (see wifi::get_stats()).
+ */
+void report_scans() {
+    const ScanStats stats = wifi::get_stats();
+    DBG_INFO("Sysmon", "Scans %lu ok, %lu failed, %lu requests, %lu timed out, %lu APs heard",
+             static_cast<unsigned long>(stats.scans),
+             static_cast<unsigned long>(stats.failed_scans),
+             static_cast<unsigned long>(stats.requests),
+             static_cast<unsigned long>(stats.timeouts),
+             static_cast<unsigned long>(stats.aps_heard));
+    DBG_INFO("Sysmon", "Scan p95 us: queue %lu, first AP %lu, radio %lu, handoff %lu, total %lu",
+             static_cast<unsigned long>(stats.queue_wait.percentile_us(95)),
+             static_cast<unsigned long>(stats.first_ap.percentile_us(95)),
+             static_cast<unsigned long>(stats.radio.percentile_us(95)),
+             static_cast<unsigned long>(stats.handoff.percentile_us(95)),
+             static_cast<unsigned long>(stats.end_to_end.percentile_us(95)));
+
+    // Energy proxy: the receiver draws about the same whenever it is on
+    const uint64_t now = time_us_64();
+    const uint64_t radio_on_us = stats.radio_on.total_us();
+    // A reset_stats() since the last report restarts the total from zero
+    const uint64_t last_radio_on_us = radio_on_us >= g_last_radio_on_us ? g_last_radio_on_us : 0;
+    DBG_INFO("Sysmon", "Radio on %lu us per scan (p95 %lu), duty %lu/1000 since last report",
+             static_cast<unsigned long>(stats.radio_on.mean_us()),
+             static_cast<unsigned long>(stats.radio_on.percentile_us(95)),
+             static_cast<unsigned long>(radio_duty_per_mille(radio_on_us - last_radio_on_us,
+                                                             now - g_last_report_us)));
+    g_last_radio_on_us = radio_on_us;
+    g_last_report_us = now;
+
+    DBG_INFO("Sysmon", "Hung scans: %lu aborted, %lu wedged; %lu watchdog resets since power-on",
+             static_cast<unsigned long>(stats.aborted_scans),
+             static_cast<unsigned long>(stats.wedged_scans),
+             static_cast<unsigned long>(supervisor::boot_recovery().watchdog_resets));
+}
+
+/**
+ * @brief Log one report.
+ */
+void report() {
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    const UBaseType_t tasks = uxTaskGetNumberOfTasks();
+    const UBaseType_t listed = uxTaskGetSystemState(g_status.data(), g_status.size(), &total);
+
+    // Every core contributes a full interval of run time (idle tasks included)
+    const uint64_t capacity = static_cast<uint64_t>(total - g_last_total) * configNUMBER_OF_CORES;
+    g_last_total = total;
+    g_run_time.begin();
+
+    DBG_INFO("Sysmon", "%lu tasks, heap %u free, %u min ever",
+             static_cast<unsigned long>(tasks),
+             static_cast<unsigned>(xPortGetFreeHeapSize()),
+             static_cast<unsigned>(xPortGetMinimumEverFreeHeapSize()));
+    if (listed == 0) {
+        DBG_WARN("Sysmon", "More than %u tasks, per-task stats skipped",
+                 static_cast<unsigned>(MAX_TASKS));
+        return;
+    }
+    for (UBaseType_t i = 0; i < listed; i++) {
+        const TaskStatus_t& status = g_status[i];
+        const uint32_t cpu = per_mille(
+            g_run_time.sample(status.xTaskNumber, status.ulRunTimeCounter), capacity);
+        // Task names live in the TCB, which outlives the drain unless the task is deleted
+        DBG_INFO("Sysmon", "%-16s cpu %3lu.%lu%% stack min %4lu words, cores 0x%lx",
+                 status.pcTaskName,
+                 static_cast<unsigned long>(cpu / 10), static_cast<unsigned long>(cpu % 10),
+                 static_cast<unsigned long>(status.usStackHighWaterMark),
+                 static_cast<unsigned long>(affinity(status)));
+    }
+}
+
+/**
+ * @brief Sysmon task - reports every interval_ms.
+ */
+void sysmon_task(void* params) {
+    const TickType_t period = pdMS_TO_TICKS(reinterpret_cast<uintptr_t>(params));
+    TickType_t last_wake = xTaskGetTickCount();
+    while (true) {
+        xTaskDelayUntil(&last_wake, period);
+        report();
+        report_scans();
+        net_stats::log("Since boot", net_stats::sample());
+    }
+}
+
+} // anonymous namespace
+
+namespace sysmon {
+
+[[nodiscard]] bool start(uint32_t interval_ms) {
+    if (interval_ms == 0 || g_sysmon_task) {
+        return false;
+    }
+    g_sysmon_task = create_pinned_task(
+        sysmon_task, "sysmon", g_sysmon_memory,
+        reinterpret_cast<void*>(static_cast<uintptr_t>(interval_ms)), SYSMON_PRIORITY, APP_CORE);
+    return g_sysmon_task != nullptr;
+}
+
+} // namespace sysmon
+
+#endif // SYSMON_ENABLED
@@ -0,0 +1,44 @@
+/**
+ * @file sysmon.hpp
+ * @brief Periodic CPU, stack and heap report over the debug log.
+ *
+ * Build with -DSYSMON=ON: that turns on FreeRTOS run-time stats, counted
+ * in microseconds by the RP2350 64-bit timer, and the trace facility. Each
+ * report logs one line per task (CPU share over the last interval, stack
+ * high-water mark, core affinity) and the heap's current and minimum-ever
+ * free bytes, which is what MAIN_STACK_SIZE, SCANNER_STACK_SIZE and
+ * configTOTAL_HEAP_SIZE should be sized from. It ends with the 95th
+ * percentile of each scan phase from wifi::get_stats() and, in builds with
+ * lwIP statistics, the lwIP pool and drop counters (net_stats.hpp).
+ */
+
+#ifndef SYSMON_HPP
+#define SYSMON_HPP
+
+#include "FreeRTOS.h"
+
+#include <cstdint>
+
+namespace sysmon {
+
+/// Default time between reports
+inline constexpr uint32_t DEFAULT_INTERVAL_MS = 10000;
+
+#if SYSMON_ENABLED
+
+/**
+ * @brief Start the sysmon task.
+ * @return true if the task was created
+ */
+[[nodiscard]] bool start(uint32_t interval_ms = DEFAULT_INTERVAL_MS);
+
+#else
+
+// Stats are compiled out
+[[nodiscard]] inline bool start(uint32_t = DEFAULT_INTERVAL_MS) { return true; }
+
+#endif // SYSMON_ENABLED
+
+} // namespace sysmon
+
+#endif // SYSMON_HPP
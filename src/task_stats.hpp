@@ -0,0 +1,83 @@
+/**
+ * @file task_stats.hpp
+ * @brief Per-interval CPU accounting from FreeRTOS run-time counters.
+ */
+
+#ifndef TASK_STATS_HPP
+#define TASK_STATS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Share of whole in tenths of a percent, capped at 100%.
+ */
+[[nodiscard]] constexpr uint32_t per_mille(uint64_t part, uint64_t whole) noexcept {
+    if (whole == 0) {
+        return 0;
+    }
+    const uint64_t share = part * 1000 / whole;
+    return share > 1000 ? 1000 : static_cast<uint32_t>(share);
+}
+
+/**
+ * @brief Remembers each task's run-time counter so reports show the last
+ *        interval rather than the average since boot.
+ *
+ * Tasks are keyed by their FreeRTOS task number. A slot is reused once its
+ * task has been absent from a whole report (it was deleted), so tasks
+ * that come and go do not exhaust the table. A task that finds no slot is
+ * reported against its lifetime counter.
+ *
+ * @tparam N Tasks tracked
+ */
+template <std::size_t N>
+class RunTimeDelta {
+public:
+    /**
+     * @brief Start a new report; call once before the report's samples.
+     */
+    void begin() noexcept {
+        report_++;
+    }
+
+    /**
+     * @brief Run time task id accumulated since the previous report.
+     * @param counter Task's current (monotonic) run-time counter
+     */
+    [[nodiscard]] uint64_t sample(uint32_t id, uint64_t counter) noexcept {
+        std::size_t slot = N;
+        for (std::size_t i = 0; i < N; i++) {
+            if (last_report_[i] != 0 && ids_[i] == id) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot == N) {
+            for (std::size_t i = 0; i < N; i++) {
+                if (last_report_[i] == 0 || last_report_[i] + 1 < report_) {
+                    slot = i;
+                    ids_[i] = id;
+                    counters_[i] = 0;
+                    break;
+                }
+            }
+        }
+        if (slot == N) {
+            return counter;
+        }
+        const uint64_t delta = counter - counters_[slot];
+        counters_[slot] = counter;
+        last_report_[slot] = report_;
+        return delta;
+    }
+
+private:
+    std::array<uint32_t, N> ids_{};
+    std::array<uint64_t, N> counters_{};
+    std::array<uint32_t, N> last_report_{};    ///< Report each slot was last sampled in (0 = free)
+    uint32_t report_{0};
+};
+
+#endif // TASK_STATS_HPP
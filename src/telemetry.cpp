@@ -0,0 +1,235 @@
+/**
+ * @file telemetry.cpp
+ * @brief Telemetry task: batches scans into datagrams sent from static pbufs.
+ */
+
+#include "telemetry.hpp"
+
+#ifdef TELEMETRY_HOST
+
+#include "telemetry_frame.hpp"
+#include "wifi_scanner.hpp"
+#include "cores.hpp"
+#include "debug_log.hpp"
+
+#include "pico/cyw43_arch.h"
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+#include "lwip/udp.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <array>
+#include <atomic>
+
+#ifndef TELEMETRY_PORT
+#define TELEMETRY_PORT telemetry::DEFAULT_PORT
+#endif
+
+namespace {
+
+constexpr uint32_t TELEMETRY_STACK_SIZE = 1024;
+constexpr UBaseType_t TELEMETRY_PRIORITY = tskIDLE_PRIORITY + 1;
+
+// Largest UDP payload that fits a 1500-byte MTU unfragmented
+constexpr std::size_t MAX_PAYLOAD = 1500 - 20 - 8;
+
+// Space pbuf_alloced_custom() leaves in front of the payload for the
+// UDP, IP and link headers, which lwIP then prepends in place
+constexpr std::size_t HEADROOM = LWIP_MEM_ALIGN_SIZE(static_cast<std::size_t>(PBUF_TRANSPORT));
+
+/**
+ * @brief Static datagram buffer, sent as a custom pbuf.
+ *
+ * pbuf_add_header() will not move a payload below the end of its pbuf
+ * struct, so the storage must follow the struct in memory.
+ */
+struct Datagram {
+    pbuf_custom custom;
+    alignas(MEM_ALIGNMENT) std::array<uint8_t, HEADROOM + MAX_PAYLOAD> storage;
+    std::atomic<bool> in_flight;    ///< Held by lwIP (e.g. queued for ARP)
+};
+
+// Two buffers, so a batch can be filled while lwIP still holds the last one
+std::array<Datagram, 2> g_datagrams{};
+Datagram* g_open = nullptr;
+TickType_t g_opened_at = 0;
+
+TelemetryWriter g_writer;
+std::array<uint8_t, BSSID_LEN> g_device{};
+uint32_t g_sequence = 0;
+uint32_t g_dropped = 0;
+
+// Guarded by the lwIP lock (cyw43_arch_lwip_begin/end)
+udp_pcb* g_pcb = nullptr;
+ip_addr_t g_collector;
+
+TaskMemory<TELEMETRY_STACK_SIZE> g_telemetry_memory;
+TaskHandle_t g_telemetry_task = nullptr;
+
+/**
+ * @brief pbuf free hook: lwIP is done with the datagram.
+ *
+ * Runs wherever the last reference is dropped (this task or the lwIP thread).
+ */
+void datagram_free(pbuf* p) {
+    for (Datagram& datagram : g_datagrams) {
+        if (&datagram.custom.pbuf == p) {
+            datagram.in_flight.store(false);
+        }
+    }
+}
+
+/**
+ * @brief Delta listener: a scan with changes was published.
+ */
+void on_delta(const APEvent& event, void* ctx) {
+    static_cast<void>(event);
+    static_cast<void>(ctx);
+    xTaskNotifyGive(g_telemetry_task);
+}
+
+/**
+ * @brief Start a datagram in a buffer lwIP has released.
+ * @return false if both buffers are still in flight
+ */
+bool open_datagram() {
+    if (g_open) {
+        return true;
+    }
+    for (Datagram& datagram : g_datagrams) {
+        if (!datagram.in_flight.load()) {
+            g_open = &datagram;
+            g_opened_at = xTaskGetTickCount();
+            g_writer.begin(datagram.storage.data() + HEADROOM, MAX_PAYLOAD, g_device, g_sequence);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Send the open datagram, if it holds any scan.
+ */
+void flush() {
+    if (!g_open || g_writer.scans() == 0) {
+        return;
+    }
+    Datagram& datagram = *g_open;
+    g_open = nullptr;
+
+    if (cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) != CYW43_LINK_UP) {
+        g_dropped += g_writer.scans();
+        return;
+    }
+
+    datagram.in_flight.store(true);
+    datagram.custom.custom_free_function = datagram_free;
+    cyw43_arch_lwip_begin();
+    pbuf* p = pbuf_alloced_custom(PBUF_TRANSPORT, static_cast<u16_t>(g_writer.size()), PBUF_RAM,
+                                  &datagram.custom, datagram.storage.data(),
+                                  static_cast<u16_t>(datagram.storage.size()));
+    const err_t err = udp_sendto(g_pcb, p, &g_collector, TELEMETRY_PORT);
+    // Drops our reference; datagram_free() runs once lwIP has dropped its own
+    pbuf_free(p);
+    cyw43_arch_lwip_end();
+
+    if (err != ERR_OK) {
+        DBG_WARN("Telem", "udp_sendto failed: %d", err);
+        g_dropped += g_writer.scans();
+        return;
+    }
+    DBG_INFO("Telem", "Sent datagram %lu: %u scans, %u bytes",
+             static_cast<unsigned long>(g_sequence), static_cast<unsigned>(g_writer.scans()),
+             static_cast<unsigned>(g_writer.size()));
+    g_sequence++;
+}
+
+/**
+ * @brief Add the newest full scan to the open datagram, flushing it first if full.
+ */
+void add_latest(uint32_t& last_generation) {
+    wifi::ScanLease scan = wifi::latest_scan();
+    if (!scan || scan.generation() == last_generation) {
+        return;
+    }
+    last_generation = scan.generation();
+    const uint32_t uptime_s = to_ms_since_boot(get_absolute_time()) / 1000;
+
+    if (open_datagram() && g_writer.add(*scan, scan.generation(), uptime_s)) {
+        return;
+    }
+    flush();
+    if (!open_datagram() || !g_writer.add(*scan, scan.generation(), uptime_s)) {
+        g_dropped++;
+        DBG_WARN("Telem", "Scan %lu dropped (%lu so far)",
+                 static_cast<unsigned long>(scan.generation()),
+                 static_cast<unsigned long>(g_dropped));
+    }
+}
+
+/**
+ * @brief Telemetry task - batches changed scans and sends full batches.
+ *
+ * A partial batch is sent once its first scan is FLUSH_INTERVAL_MS old;
+ * waking then also picks up the newest scan if it brought no changes.
+ */
+void telemetry_task(void* params) {
+    static_cast<void>(params);
+
+    const TickType_t flush_interval = pdMS_TO_TICKS(telemetry::FLUSH_INTERVAL_MS);
+    uint32_t last_generation = 0;
+    while (true) {
+        TickType_t wait = flush_interval;
+        if (g_open && g_writer.scans() > 0) {
+            const TickType_t age = xTaskGetTickCount() - g_opened_at;
+            wait = age < flush_interval ? flush_interval - age : 0;
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        add_latest(last_generation);
+        if (g_open && (g_writer.scans() >= telemetry::TELEMETRY_BATCH_SCANS ||
+                       xTaskGetTickCount() - g_opened_at >= flush_interval)) {
+            flush();
+        }
+    }
+}
+
+} // anonymous namespace
+
+namespace telemetry {
+
+[[nodiscard]] bool start() {
+    if (g_telemetry_task) {
+        return false;
+    }
+    if (!ipaddr_aton(TELEMETRY_HOST, &g_collector)) {
+        DBG_ERROR("Telem", "Invalid collector address %s", TELEMETRY_HOST);
+        return false;
+    }
+    cyw43_arch_lwip_begin();
+    g_pcb = udp_new_ip_type(IPADDR_TYPE_V4);
+    cyw43_arch_lwip_end();
+    if (!g_pcb) {
+        DBG_ERROR("Telem", "Failed to create UDP pcb");
+        return false;
+    }
+    cyw43_wifi_get_mac(&cyw43_state, CYW43_ITF_STA, g_device.data());
+
+    DBG_INFO("Telem", "Sending scans to %s:%u", TELEMETRY_HOST,
+             static_cast<unsigned>(TELEMETRY_PORT));
+    g_telemetry_task = create_pinned_task(telemetry_task, "telemetry", g_telemetry_memory,
+                                          nullptr, TELEMETRY_PRIORITY, APP_CORE);
+    if (!g_telemetry_task) {
+        return false;
+    }
+    if (!wifi::subscribe_deltas(on_delta)) {
+        DBG_WARN("Telem", "No delta subscriber slot, sending every %lu ms only",
+                 static_cast<unsigned long>(FLUSH_INTERVAL_MS));
+    }
+    return true;
+}
+
+} // namespace telemetry
+
+#endif // TELEMETRY_HOST
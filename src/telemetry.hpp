@@ -0,0 +1,55 @@
+/**
+ * @file telemetry.hpp
+ * @brief Scan telemetry streamed to a collector over UDP.
+ *
+ * Configure with -DTELEMETRY_HOST=<IPv4 address> (and optionally
+ * -DTELEMETRY_PORT=<port>). A telemetry task on the application core
+ * takes each scan the scheduler reports changes for, plus the newest one
+ * at every flush interval, and batches up to TELEMETRY_BATCH_SCANS of
+ * them into one datagram (telemetry_frame.hpp).
+ *
+ * Datagrams are encoded straight into one of two static buffers that are
+ * handed to lwIP's raw UDP API as custom pbufs, with headroom for the
+ * UDP, IP and link headers, so nothing is allocated or copied on the way
+ * to the driver. A buffer is reused only once lwIP has released it.
+ *
+ * Nothing is sent while the station interface has no link; batches
+ * completed meanwhile are dropped.
+ */
+
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <cstdint>
+
+namespace telemetry {
+
+/// Default collector port
+inline constexpr uint16_t DEFAULT_PORT = 5530;
+
+/// Most scans batched into one datagram
+inline constexpr uint32_t TELEMETRY_BATCH_SCANS = 4;
+
+/// Longest a scan waits in a partial batch
+inline constexpr uint32_t FLUSH_INTERVAL_MS = 5 * 60 * 1000;
+
+#ifdef TELEMETRY_HOST
+
+/**
+ * @brief Start the telemetry task.
+ * @return false if TELEMETRY_HOST is not a valid address or the task could not start
+ *
+ * Call after wifi::init() and before start_scan_scheduler().
+ */
+[[nodiscard]] bool start();
+
+#else
+
+// No collector configured
+[[nodiscard]] inline bool start() { return true; }
+
+#endif // TELEMETRY_HOST
+
+} // namespace telemetry
+
+#endif // TELEMETRY_HPP
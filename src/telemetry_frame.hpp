@@ -0,0 +1,155 @@
+/**
+ * @file telemetry_frame.hpp
+ * @brief Compact binary encoding of scan batches for UDP telemetry.
+ *
+ * One datagram carries one or more scans from one device:
+ *
+ *   version   1 byte   TELEMETRY_VERSION
+ *   device    6 bytes  STA MAC address
+ *   sequence  varint   datagram counter (a gap means datagrams were lost)
+ *   then per scan, until the end of the datagram:
+ *     generation  varint   scan generation (wifi::ScanLease::generation())
+ *     uptime      varint   seconds since boot when the scan was batched
+ *     count       1 byte   APs that follow
+ *     per AP:
+ *       bssid      6 bytes
+ *       rssi       1 byte   dBm, signed
+ *       chan_auth  1 byte   channel | auth << 4 (as APTable)
+ *       ssid       1 byte length + bytes, only on the BSSID's first
+ *                  appearance in the datagram
+ *
+ * Varints are unsigned LEB128 (log_frame.hpp). An AP costs 8 bytes in
+ * every scan after the first, so a datagram of several scans of the same
+ * neighbourhood is about 8 bytes per AP per scan. Every datagram is
+ * self-contained: a receiver tracks the BSSIDs seen in it, not across
+ * datagrams, so losing one loses nothing else.
+ *
+ * tools/pico.py telemetry decodes the datagrams.
+ */
+
+#ifndef TELEMETRY_FRAME_HPP
+#define TELEMETRY_FRAME_HPP
+
+#include "scan_msg.hpp"
+#include "log_frame.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+/// Format version in the first byte of every datagram
+inline constexpr uint8_t TELEMETRY_VERSION = 1;
+
+/// Distinct BSSIDs a datagram can carry SSIDs for
+inline constexpr std::size_t TELEMETRY_MAX_BSSIDS = 96;
+
+/// Datagram header: version, device, longest sequence varint
+inline constexpr std::size_t TELEMETRY_HEADER_MAX = 1 + BSSID_LEN + dlog_frame::MAX_VARINT;
+
+/// Encoded AP without its SSID
+inline constexpr std::size_t TELEMETRY_AP_FIXED = BSSID_LEN + 2;
+
+/**
+ * @brief Appends scans to a datagram in a caller-provided buffer.
+ *
+ * The buffer can be the payload of a network buffer, so nothing is copied
+ * between encoding and sending.
+ */
+class TelemetryWriter {
+public:
+    /**
+     * @brief Start a datagram.
+     * @param out Buffer of capacity bytes (at least TELEMETRY_HEADER_MAX)
+     */
+    void begin(uint8_t* out, std::size_t capacity, const std::array<uint8_t, BSSID_LEN>& device,
+               uint32_t sequence) noexcept {
+        out_ = out;
+        capacity_ = capacity;
+        bssid_count_ = 0;
+        scans_ = 0;
+        len_ = 0;
+        out_[len_++] = TELEMETRY_VERSION;
+        std::memcpy(out_ + len_, device.data(), BSSID_LEN);
+        len_ += BSSID_LEN;
+        len_ += dlog_frame::put_varint(out_ + len_, sequence);
+    }
+
+    /**
+     * @brief Append a scan if the rest of the datagram can hold it.
+     * @return false, with nothing written, if it does not fit
+     *
+     * A scan too large for even an empty datagram never fits; the caller
+     * is expected to drop it.
+     */
+    template <std::size_t N>
+    [[nodiscard]] bool add(const BasicScanResult<N>& scan, uint32_t generation,
+                           uint32_t uptime_s) noexcept {
+        static_assert(N <= UINT8_MAX, "AP count is one byte");
+        std::size_t need = 2 * dlog_frame::MAX_VARINT + 1;
+        std::size_t new_bssids = 0;
+        for (std::size_t i = 0; i < scan.count; i++) {
+            need += TELEMETRY_AP_FIXED;
+            if (!seen(scan.networks.bssid[i], bssid_count_)) {
+                need += 1 + scan.networks.ssid_len[i];
+                new_bssids++;
+            }
+        }
+        if (len_ + need > capacity_ || bssid_count_ + new_bssids > bssids_.size()) {
+            return false;
+        }
+
+        const std::size_t known = bssid_count_;
+        len_ += dlog_frame::put_varint(out_ + len_, generation);
+        len_ += dlog_frame::put_varint(out_ + len_, uptime_s);
+        out_[len_++] = static_cast<uint8_t>(scan.count);
+        for (std::size_t i = 0; i < scan.count; i++) {
+            const std::array<uint8_t, BSSID_LEN>& bssid = scan.networks.bssid[i];
+            std::memcpy(out_ + len_, bssid.data(), BSSID_LEN);
+            len_ += BSSID_LEN;
+            out_[len_++] = static_cast<uint8_t>(scan.networks.rssi[i]);
+            out_[len_++] = scan.networks.chan_auth[i];
+            // A scan holds each BSSID once, so only earlier scans need checking
+            if (!seen(bssid, known)) {
+                const std::string_view ssid = scan.networks.ssid(i);
+                out_[len_++] = static_cast<uint8_t>(ssid.size());
+                std::memcpy(out_ + len_, ssid.data(), ssid.size());
+                len_ += ssid.size();
+                bssids_[bssid_count_++] = bssid;
+            }
+        }
+        scans_++;
+        return true;
+    }
+
+    /**
+     * @brief Bytes written so far, header included.
+     */
+    [[nodiscard]] std::size_t size() const noexcept { return len_; }
+
+    /**
+     * @brief Scans in the datagram.
+     */
+    [[nodiscard]] std::size_t scans() const noexcept { return scans_; }
+
+private:
+    [[nodiscard]] bool seen(const std::array<uint8_t, BSSID_LEN>& bssid,
+                            std::size_t count) const noexcept {
+        for (std::size_t i = 0; i < count; i++) {
+            if (bssids_[i] == bssid) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint8_t* out_{nullptr};
+    std::size_t capacity_{0};
+    std::size_t len_{0};
+    std::size_t scans_{0};
+    std::array<std::array<uint8_t, BSSID_LEN>, TELEMETRY_MAX_BSSIDS> bssids_{};
+    std::size_t bssid_count_{0};
+};
+
+#endif // TELEMETRY_FRAME_HPP
@@ -0,0 +1,137 @@
+/**
+ * @file trace_frame.hpp
+ * @brief Compact binary encoding of raw scan callbacks for trace capture.
+ *
+ * A captured scan is a start frame, one frame per callback, then an end
+ * frame. Layout before framing:
+ *
+ *   header    1 byte   bits 0-3 kind, bits 5-7 version
+ *   sequence  1 byte   frame counter, modulo 256 (a gap means frames were skipped)
+ *   then by kind:
+ *     START  flags   1 byte   bit 0 passive, bit 1 directed (SSID) scan
+ *            uptime  varint   time_us_64() at cyw43_wifi_scan(), low 32 bits
+ *     AP     offset  varint   microseconds since the scan started
+ *            bssid   6 bytes
+ *            rssi    1 byte   dBm, signed
+ *            channel 1 byte
+ *            auth    1 byte   CYW43 auth bitmask, as reported
+ *            ssid    1 byte length + bytes (0 for a hidden network)
+ *     END    duration varint  microseconds from start to scan complete
+ *
+ * Varints are unsigned LEB128 and frames are COBS-encoded and zero
+ * terminated, as log_frame.hpp. Callbacks are recorded before any
+ * filtering, duplicates and hidden networks included.
+ *
+ * tools/pico.py trace rebuilds the scans as the simulator's text traces
+ * (test/sim/sim_cyw43.hpp).
+ */
+
+#ifndef TRACE_FRAME_HPP
+#define TRACE_FRAME_HPP
+
+#include "log_frame.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace trace_frame {
+
+/// Format version in the header's top bits
+inline constexpr uint8_t VERSION = 1;
+
+/// Frame kinds, in the header's low bits
+inline constexpr uint8_t KIND_START = 1;
+inline constexpr uint8_t KIND_AP = 2;
+inline constexpr uint8_t KIND_END = 3;
+
+/// START flags
+inline constexpr uint8_t FLAG_PASSIVE = 0x01;
+inline constexpr uint8_t FLAG_DIRECTED = 0x02;
+
+/// Longest SSID a frame carries (the 802.11 limit)
+inline constexpr std::size_t MAX_SSID = 32;
+
+/// Longest payload (an AP frame) before COBS
+inline constexpr std::size_t MAX_PAYLOAD = 2 + dlog_frame::MAX_VARINT + 6 + 3 + 1 + MAX_SSID;
+
+/// Longest encoded frame: COBS adds one byte per 254, plus the delimiter
+inline constexpr std::size_t MAX_FRAME = MAX_PAYLOAD + 1 + 1;
+
+/**
+ * @brief One raw scan callback, as the radio reported it.
+ */
+struct TracedAp {
+    uint32_t offset_us;         ///< Since the scan started
+    const uint8_t* bssid;       ///< 6 bytes
+    int8_t rssi;
+    uint8_t channel;
+    uint8_t auth;               ///< CYW43 auth bitmask
+    const uint8_t* ssid;
+    std::size_t ssid_len;       ///< Truncated to MAX_SSID
+};
+
+namespace detail {
+
+[[nodiscard]] constexpr std::size_t header(uint8_t* payload, uint8_t kind,
+                                           uint8_t sequence) noexcept {
+    payload[0] = static_cast<uint8_t>(kind | VERSION << 5);
+    payload[1] = sequence;
+    return 2;
+}
+
+} // namespace detail
+
+/**
+ * @brief Encode a scan start frame.
+ * @param out Buffer of at least MAX_FRAME bytes
+ * @return Frame length including the delimiter
+ */
+[[nodiscard]] inline std::size_t encode_start(uint8_t sequence, uint8_t flags, uint32_t uptime_us,
+                                              uint8_t* out) noexcept {
+    std::array<uint8_t, MAX_PAYLOAD> payload{};
+    std::size_t n = detail::header(payload.data(), KIND_START, sequence);
+    payload[n++] = flags;
+    n += dlog_frame::put_varint(&payload[n], uptime_us);
+    return dlog_frame::cobs_encode(payload.data(), n, out);
+}
+
+/**
+ * @brief Encode one callback.
+ * @param out Buffer of at least MAX_FRAME bytes
+ * @return Frame length including the delimiter
+ */
+[[nodiscard]] inline std::size_t encode_ap(uint8_t sequence, const TracedAp& ap,
+                                           uint8_t* out) noexcept {
+    std::array<uint8_t, MAX_PAYLOAD> payload{};
+    std::size_t n = detail::header(payload.data(), KIND_AP, sequence);
+    n += dlog_frame::put_varint(&payload[n], ap.offset_us);
+    std::memcpy(&payload[n], ap.bssid, 6);
+    n += 6;
+    payload[n++] = static_cast<uint8_t>(ap.rssi);
+    payload[n++] = ap.channel;
+    payload[n++] = ap.auth;
+    const std::size_t ssid_len = ap.ssid_len < MAX_SSID ? ap.ssid_len : MAX_SSID;
+    payload[n++] = static_cast<uint8_t>(ssid_len);
+    std::memcpy(&payload[n], ap.ssid, ssid_len);
+    n += ssid_len;
+    return dlog_frame::cobs_encode(payload.data(), n, out);
+}
+
+/**
+ * @brief Encode a scan end frame.
+ * @param out Buffer of at least MAX_FRAME bytes
+ * @return Frame length including the delimiter
+ */
+[[nodiscard]] inline std::size_t encode_end(uint8_t sequence, uint32_t duration_us,
+                                            uint8_t* out) noexcept {
+    std::array<uint8_t, MAX_PAYLOAD> payload{};
+    std::size_t n = detail::header(payload.data(), KIND_END, sequence);
+    n += dlog_frame::put_varint(&payload[n], duration_us);
+    return dlog_frame::cobs_encode(payload.data(), n, out);
+}
+
+} // namespace trace_frame
+
+#endif // TRACE_FRAME_HPP
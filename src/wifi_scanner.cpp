@@ -1,36 +1,326 @@
 /**
  * @file wifi_scanner.cpp
- * @brief WiFi scanning implementation with synchronous request-response.
+ * @brief WiFi scanning implementation with a coalescing request queue.
  */
 
 #include "wifi_scanner.hpp"
+#include "scan_exchange.hpp"
+#include "cores.hpp"
 #include "led.hpp"
 #include "debug_log.hpp"
+#include "scan_trace.hpp"
+#include "supervisor.hpp"
 
 #include "pico/cyw43_arch.h"
+#include "pico/time.h"
 #include "FreeRTOS.h"
 #include "task.h"
 #include "semphr.h"
+#include "queue.h"
+#include "message_buffer.h"
 
 #include <algorithm>
+#include <array>
 #include <cstring>
 
+// Backstop in case the scan-complete event is never observed (driver hang).
+// The simulator shortens it to exercise the recovery quickly
+#ifndef WIFI_SCAN_COMPLETE_TIMEOUT_MS
+#define WIFI_SCAN_COMPLETE_TIMEOUT_MS 15000
+#endif
+
 namespace {
 
 constexpr uint32_t SCANNER_STACK_SIZE = 2048;
 constexpr UBaseType_t SCANNER_PRIORITY = tskIDLE_PRIORITY + 2;
 constexpr uint32_t LED_BLINK_INTERVAL_MS = 50;
-constexpr uint32_t SCAN_POLL_INTERVAL_MS = 50;
 
-// Synchronization primitives for request-response pattern.
-// Note: For this single-caller example, direct calls to do_scan() would suffice.
-// However, semaphores provide the foundation for safely adding concurrent
-// scan requesters (e.g., a command task, network trigger) without races.
-SemaphoreHandle_t g_request_sem = nullptr;
-SemaphoreHandle_t g_complete_sem = nullptr;
+constexpr uint32_t SCAN_COMPLETE_TIMEOUT_MS = WIFI_SCAN_COMPLETE_TIMEOUT_MS;
+
+// How long a hung scan has to end once aborted before the radio counts as wedged
+constexpr uint32_t SCAN_ABORT_TIMEOUT_MS = 1000;
+
+// Task notification slot used for scan events on the scanner task. Index 0
+// is left free for kernel objects (stream buffers) that notify the default index.
+constexpr UBaseType_t SCAN_EVENT_NOTIFY_INDEX = 1;
+
+// Scan event bits
+constexpr uint32_t SCAN_EVENT_DONE = 1u << 0;      ///< Radio finished the scan
+constexpr uint32_t SCAN_EVENT_MATCHED = 1u << 1;   ///< Every live request is satisfied
+constexpr uint32_t SCAN_EVENT_RELEASED = 1u << 2;  ///< Last lease on the back buffer dropped
+
+// Task notification slot on the *requesting* task that carries the ticket
+// of its completed request.
+constexpr UBaseType_t REQUEST_DONE_NOTIFY_INDEX = 2;
+
+// Pending requests the queue can hold, and how many may be coalesced
+// onto a single radio scan.
+constexpr UBaseType_t REQUEST_QUEUE_LENGTH = 8;
+constexpr std::size_t MAX_COALESCED_REQUESTS = 8;
+
+// APs a streaming request can buffer before the callback starts dropping
+constexpr std::size_t STREAM_BUFFER_APS = 8;
+constexpr std::size_t STREAM_BUFFER_SIZE = STREAM_BUFFER_APS * (sizeof(APInfo) + sizeof(size_t));
+
+// How long delivery waits for a slow stream consumer to make room
+constexpr uint32_t STREAM_END_TIMEOUT_MS = 100;
+
+// How long a scan waits for readers to release the buffer it will fill
+constexpr uint32_t LEASE_WAIT_TIMEOUT_MS = 1000;
+
+// Longest the scanner may take from a request batch to its delivery before
+// the supervisor treats it as stalled: waiting out the previous scan and
+// running this one, each up to its abort, the lease wait, and the streams
+constexpr uint32_t SCANNER_BUSY_BUDGET_MS =
+    2 * (SCAN_COMPLETE_TIMEOUT_MS + SCAN_ABORT_TIMEOUT_MS) + LEASE_WAIT_TIMEOUT_MS +
+    MAX_COALESCED_REQUESTS * STREAM_END_TIMEOUT_MS + 1000;
+
+// cyw43_wifi_scan_options_t::scan_type values
+constexpr int8_t CYW43_SCAN_TYPE_ACTIVE = 0;
+constexpr int8_t CYW43_SCAN_TYPE_PASSIVE = 1;
+
+// While associated, the firmware scans one channel at a time and returns
+// to the AP's channel between them. Short off-channel slices with long
+// home time keep traffic flowing during a scan, at the cost of a longer
+// sweep (about 13 x 120 ms on 2.4 GHz)
+constexpr uint32_t ASSOC_SCAN_DWELL_MS = 20;    ///< Active dwell per channel while associated
+constexpr uint32_t ASSOC_SCAN_HOME_MS = 100;    ///< Time back on the AP's channel between channels
+
+// Broadcom WLC ioctls, encoded for cyw43_ioctl() as cmd << 1 | set
+constexpr uint32_t WLC_SET_SCAN = (50 << 1) | 1;
+constexpr uint32_t WLC_SET_SCAN_CHANNEL_TIME = (185 << 1) | 1;
+constexpr uint32_t WLC_SET_SCAN_HOME_TIME = (189 << 1) | 1;
+constexpr uint32_t WLC_SET_SCAN_PASSIVE_TIME = (258 << 1) | 1;
+constexpr uint32_t WLC_SET_VAR = (263 << 1) | 1;
+
+/**
+ * @brief Scan request descriptor passed through the request queue.
+ */
+struct PendingRequest {
+    uint32_t ticket;                ///< Unique request id, echoed back on completion
+    ScanRequest params;             ///< Filters and radio mode (copied, caller may return early)
+    ScanResult* result;             ///< Caller buffer (nullptr for streams), written under g_delivery_mutex
+    MessageBufferHandle_t stream;   ///< Per-AP stream for scan_async(), or nullptr
+    wifi::ScanLease* lease;         ///< Caller lease for a full scan, written under g_delivery_mutex
+    uint64_t* scan_end_us;          ///< Caller's copy of ScanTiming::end_us, written under g_delivery_mutex
+    uint64_t enqueued_us;           ///< time_us_64() when the request was queued
+    TaskHandle_t waiter;            ///< Task notified at REQUEST_DONE_NOTIFY_INDEX
+};
+
+using RequestBatch = std::array<PendingRequest, MAX_COALESCED_REQUESTS>;
+
+/**
+ * @brief Request attached to the scan in progress, as seen by the callback.
+ */
+struct LiveRequest {
+    const ScanRequest* params;      ///< Points into the scanner's batch
+    MessageBufferHandle_t stream;   ///< Stream to feed, or nullptr
+    bool satisfied;                 ///< Matched with stop_on_match, or consumer detached
+};
+
+/**
+ * @brief Phase timestamps of one radio scan (time_us_64(), 0 = did not happen).
+ */
+struct ScanTiming {
+    uint64_t start_us;      ///< cyw43_wifi_scan() called
+    uint64_t first_ap_us;   ///< First AP callback
+    uint64_t end_us;        ///< Radio finished, or every request matched
+    uint32_t aps_heard;     ///< AP callbacks, duplicates included
+};
+
+/**
+ * @brief Final message on a stream, distinguished from APInfo by its size.
+ */
+struct StreamEnd {
+    bool success;
+    int32_t error_code;
+};
+static_assert(sizeof(StreamEnd) != sizeof(APInfo));
+
+/**
+ * @brief Receive buffer large enough for either stream message type.
+ */
+union StreamMessage {
+    APInfo ap{};
+    StreamEnd end;
+};
+
+QueueHandle_t g_request_queue = nullptr;
+StaticQueue_t g_request_queue_control;
+std::array<uint8_t, REQUEST_QUEUE_LENGTH * sizeof(PendingRequest)> g_request_queue_storage;
+
+// Serializes result delivery against request cancellation, so a caller
+// that timed out can be sure its buffer is never written afterwards.
+SemaphoreHandle_t g_delivery_mutex = nullptr;
+StaticSemaphore_t g_delivery_mutex_control;
+
+// Tickets of requests whose callers gave up waiting. Every abandoned ticket
+// is either still queued or in the current batch, which bounds the size.
+std::array<uint32_t, REQUEST_QUEUE_LENGTH + MAX_COALESCED_REQUESTS> g_abandoned{};
+std::size_t g_abandoned_count = 0;
+
+uint32_t g_next_ticket = 0;
+
+// Scanner-owned result buffers. The scanner fills the back one without a
+// lock; swapping and lease counts are guarded by a critical section.
+PingPong<ScanResult> g_results;
+
+// Result handed out when no scan could be run
+BasicScanResult<1> g_scan_failure;
+
+// Pipeline latency and counters, guarded by a critical section (updated
+// by the scanner and by callers on either core)
+ScanStats g_stats{};
+
+// Known APs, refreshed by every published full scan. Guarded by a
+// critical section.
+KnownNetworks g_known;
+
+// Requests attached to the scan in progress. Guarded by the CYW43 thread
+// lock, which scan_result_callback runs under.
+std::array<LiveRequest, MAX_COALESCED_REQUESTS> g_live{};
+std::size_t g_live_count = 0;
+bool g_match_signaled = false;
+
+// Scanner task handle, target of scan event notifications
+TaskMemory<SCANNER_STACK_SIZE> g_scanner_memory;
+TaskHandle_t g_scanner_task = nullptr;
+
+// Original driver poll function, wrapped by scan_aware_poll()
+void (*g_driver_poll)() = nullptr;
 
-// Shared scan result pointer (safe: written before request_sem, read after)
-ScanResult* g_result_ptr = nullptr;
+// Set while a scan started by do_scan() has not yet been seen to finish.
+// Only touched with the CYW43 thread lock held.
+bool g_scan_in_flight = false;
+
+// Timing of the scan in progress. Only touched with the CYW43 thread lock held.
+ScanTiming g_timing{};
+
+/**
+ * @brief Driver poll wrapper that signals the scanner when a scan finishes.
+ *
+ * CYW43 does not invoke the result callback for the scan-complete event; it
+ * only clears its internal scan state while processing events. Wrapping
+ * cyw43_poll observes that transition in the async context task right after
+ * the event is handled, so the scanner task can block on a notification
+ * instead of polling cyw43_wifi_scan_active().
+ */
+void scan_aware_poll() {
+    g_driver_poll();
+    if (g_scan_in_flight && !cyw43_wifi_scan_active(&cyw43_state)) {
+        g_scan_in_flight = false;
+        const uint64_t now = time_us_64();
+        if (g_timing.end_us == 0) {
+            g_timing.end_us = now;
+        }
+        taskENTER_CRITICAL();
+        g_stats.radio_on.record(elapsed_us(g_timing.start_us, now));
+        taskEXIT_CRITICAL();
+        scan_trace::scan_done(now);
+        xTaskNotifyIndexed(g_scanner_task, SCAN_EVENT_NOTIFY_INDEX, SCAN_EVENT_DONE, eSetBits);
+    }
+}
+
+/**
+ * @brief Install scan_aware_poll() in front of the driver poll function.
+ * @return false if the driver is not up (no poll function registered)
+ */
+bool install_poll_hook() {
+    cyw43_thread_enter();
+    if (cyw43_poll != scan_aware_poll && cyw43_poll != nullptr) {
+        g_driver_poll = cyw43_poll;
+        cyw43_poll = scan_aware_poll;
+    }
+    const bool installed = (cyw43_poll == scan_aware_poll);
+    cyw43_thread_exit();
+    return installed;
+}
+
+/**
+ * @brief Set a 32-bit firmware parameter on the STA interface.
+ */
+bool set_wlc_u32(uint32_t cmd, uint32_t value) {
+    // Little-endian on the wire, as on the host
+    std::array<uint8_t, sizeof(value)> buf{};
+    std::memcpy(buf.data(), &value, sizeof(value));
+    return cyw43_ioctl(&cyw43_state, cmd, buf.size(), buf.data(), CYW43_ITF_STA) == 0;
+}
+
+/**
+ * @brief Set a 32-bit firmware variable ("iovar") on the STA interface.
+ * @param name Variable name, at most 15 characters
+ */
+bool set_wlc_var_u32(const char* name, uint32_t value) {
+    // Name and its terminator, then the value
+    std::array<uint8_t, 16 + sizeof(value)> buf{};
+    const std::size_t name_len = std::strlen(name) + 1;
+    std::memcpy(buf.data(), name, name_len);
+    std::memcpy(buf.data() + name_len, &value, sizeof(value));
+    return cyw43_ioctl(&cyw43_state, WLC_SET_VAR, name_len + sizeof(value), buf.data(),
+                       CYW43_ITF_STA) == 0;
+}
+
+/**
+ * @brief Ask the firmware to abandon the scan in progress.
+ *
+ * The Broadcom idiom: a WLC_SCAN whose channel list is the one channel
+ * -1. The firmware ends the escan with an abort status, which the driver
+ * handles like any other scan completion, so scan_aware_poll() sees it.
+ */
+bool request_scan_abort() {
+    // wl_scan_params: SSID (length, 32 bytes), BSSID, BSS type, scan type,
+    // probe count and three dwell times, channel count, channel list
+    std::array<uint8_t, 66> params{};
+    std::fill_n(params.begin() + 36, 6, 0xFF);  // Broadcast BSSID
+    params[42] = 2;                             // Any BSS type
+    std::fill_n(params.begin() + 44, 16, 0xFF); // Probes and dwells: -1, firmware defaults
+    params[60] = 1;                             // One channel...
+    params[64] = 0xFF;                          // ...numbered -1: abort
+    params[65] = 0xFF;
+    return cyw43_ioctl(&cyw43_state, WLC_SET_SCAN, params.size(), params.data(),
+                       CYW43_ITF_STA) == 0;
+}
+
+/**
+ * @brief Driver power-management value for a RadioPowerSave mode.
+ */
+uint32_t driver_pm(RadioPowerSave mode) {
+    switch (mode) {
+        case RadioPowerSave::NONE:       return CYW43_NONE_PM;
+        case RadioPowerSave::AGGRESSIVE: return CYW43_AGGRESSIVE_PM;
+        case RadioPowerSave::PERFORMANCE:
+        default:                         return CYW43_PERFORMANCE_PM;
+    }
+}
+
+/**
+ * @brief Slice scans made while associated into short off-channel dwells.
+ *
+ * do_scan() leaves dwell and home times at the firmware defaults, which
+ * these replace. They have no effect on scans while not associated.
+ */
+void configure_associated_scans() {
+    if (!set_wlc_u32(WLC_SET_SCAN_CHANNEL_TIME, ASSOC_SCAN_DWELL_MS) ||
+        !set_wlc_u32(WLC_SET_SCAN_HOME_TIME, ASSOC_SCAN_HOME_MS)) {
+        DBG_WARN("WiFi", "Could not set associated scan timing, using firmware defaults");
+        return;
+    }
+    DBG_INFO("WiFi", "Associated scans: %lu ms per channel, %lu ms home",
+             static_cast<unsigned long>(ASSOC_SCAN_DWELL_MS),
+             static_cast<unsigned long>(ASSOC_SCAN_HOME_MS));
+}
+
+/**
+ * @brief Pin one of the driver's worker tasks to the network core.
+ */
+void pin_driver_task(const char* name) {
+    TaskHandle_t task = xTaskGetHandle(name);
+    if (!task) {
+        DBG_WARN("WiFi", "Driver task %s not found, left unpinned", name);
+        return;
+    }
+    pin_task(task, NETWORK_CORE);
+}
 
 /**
  * @brief Callback invoked by CYW43 for each AP found during scan.
@@ -38,8 +328,15 @@ ScanResult* g_result_ptr = nullptr;
 int scan_result_callback(void* env, const cyw43_ev_scan_result_t* result) {
     if (!result) return 0;
 
+    const uint64_t now = time_us_64();
+    scan_trace::ap_heard(*result, now);
+    g_timing.aps_heard++;
+    if (g_timing.first_ap_us == 0) {
+        g_timing.first_ap_us = now;
+    }
+
     auto* scan_result = static_cast<ScanResult*>(env);
-    if (!scan_result || scan_result->is_full()) return 0;
+    if (!scan_result || g_match_signaled) return 0;
 
     APInfo ap;
 
@@ -57,14 +354,120 @@ int scan_result_callback(void* env, const cyw43_ev_scan_result_t* result) {
     ap.channel = result->channel;
     ap.auth = auth_mode_from_cyw43(result->auth_mode);
 
-    [[maybe_unused]] const bool added = scan_result->add(ap);
+    bool wanted = false;
+    bool all_satisfied = true;
+    for (std::size_t i = 0; i < g_live_count; i++) {
+        LiveRequest& live = g_live[i];
+        if (!live.satisfied && live.params->matches(ap)) {
+            wanted = true;
+            // Never block here: a full stream drops the AP rather than stall the driver
+            if (live.stream) {
+                xMessageBufferSend(live.stream, &ap, sizeof(ap), 0);
+            }
+            live.satisfied = live.params->stop_on_match;
+        }
+        all_satisfied = all_satisfied && live.satisfied;
+    }
+
+    if (wanted) {
+        [[maybe_unused]] const bool added = scan_result->add(ap);
+    }
+    if (all_satisfied && g_live_count > 0) {
+        g_match_signaled = true;
+        g_timing.end_us = now;
+        xTaskNotifyIndexed(g_scanner_task, SCAN_EVENT_NOTIFY_INDEX, SCAN_EVENT_MATCHED, eSetBits);
+    }
+    return 0;
+}
+
+/**
+ * @brief Wait for any of the scan events in mask.
+ * @return Events received (0 on timeout)
+ */
+uint32_t wait_scan_event(uint32_t mask, uint32_t timeout_ms) {
+    TimeOut_t timeout;
+    TickType_t remaining = pdMS_TO_TICKS(timeout_ms);
+    vTaskSetTimeOutState(&timeout);
+    do {
+        uint32_t events = 0;
+        xTaskNotifyWaitIndexed(SCAN_EVENT_NOTIFY_INDEX, 0, mask, &events, remaining);
+        if (events & mask) {
+            return events & mask;
+        }
+    } while (xTaskCheckForTimeOut(&timeout, &remaining) == pdFALSE);
     return 0;
 }
 
+/**
+ * @brief Abort a scan that outlived SCAN_COMPLETE_TIMEOUT_MS.
+ *
+ * A radio that ignores the abort as well is wedged: only a reset brings
+ * it back, so the scanner reports itself failed to the supervisor.
+ *
+ * @return false if the radio is still scanning SCAN_ABORT_TIMEOUT_MS later
+ */
+bool abort_hung_scan() {
+    DBG_WARN("WiFi", "Scan hung, aborting");
+    if (!request_scan_abort()) {
+        DBG_ERROR("WiFi", "Scan abort ioctl failed");
+    }
+    [[maybe_unused]] const uint32_t events =
+        wait_scan_event(SCAN_EVENT_DONE, SCAN_ABORT_TIMEOUT_MS);
+
+    cyw43_thread_enter();
+    const bool still_active = cyw43_wifi_scan_active(&cyw43_state);
+    g_scan_in_flight = still_active;
+    cyw43_thread_exit();
+
+    taskENTER_CRITICAL();
+    if (still_active) {
+        g_stats.wedged_scans++;
+    } else {
+        g_stats.aborted_scans++;
+    }
+    taskEXIT_CRITICAL();
+
+    if (still_active) {
+        DBG_ERROR("WiFi", "Radio still scanning %lu ms after the abort, wedged",
+                  static_cast<unsigned long>(SCAN_ABORT_TIMEOUT_MS));
+        supervisor::fail(Watched::SCANNER);
+        return false;
+    }
+    DBG_INFO("WiFi", "Hung scan aborted%s", events ? "" : " (no completion event)");
+    return true;
+}
+
+/**
+ * @brief Wait for a radio scan that outlived its requests to finish.
+ *
+ * A scan ended early by stop_on_match keeps running in the radio, and
+ * CYW43 refuses to start another until it completes.
+ *
+ * @return false if the radio is still busy after SCAN_COMPLETE_TIMEOUT_MS
+ *         and an abort
+ */
+bool wait_radio_idle() {
+    cyw43_thread_enter();
+    const bool in_flight = g_scan_in_flight;
+    cyw43_thread_exit();
+
+    if (in_flight && wait_scan_event(SCAN_EVENT_DONE, SCAN_COMPLETE_TIMEOUT_MS) == 0) {
+        cyw43_thread_enter();
+        const bool still_active = cyw43_wifi_scan_active(&cyw43_state);
+        g_scan_in_flight = still_active;
+        cyw43_thread_exit();
+        return !still_active || abort_hung_scan();
+    }
+    return true;
+}
+
 /**
  * @brief Perform a single WiFi scan.
+ * @param radio SSID and mode passed to the radio
+ * @param timing Receives the scan's phase timestamps
+ * @return true if the scan was ended early because every request matched
  */
-void do_scan(ScanResult* result) {
+bool do_scan(ScanResult* result, const ScanRequest& radio, ScanTiming& timing) {
     DBG_INFO("WiFi", "Scan starting");
     result->reset();
 
@@ -72,42 +475,490 @@ void do_scan(ScanResult* result) {
 
     // Use brace initialization instead of memset
     cyw43_wifi_scan_options_t scan_options{};
+    if (radio.has_ssid()) {
+        scan_options.ssid_len = static_cast<uint32_t>(std::strlen(radio.ssid.data()));
+        std::memcpy(scan_options.ssid, radio.ssid.data(), scan_options.ssid_len);
+    }
+    scan_options.scan_type = (radio.mode == ScanMode::PASSIVE)
+        ? CYW43_SCAN_TYPE_PASSIVE : CYW43_SCAN_TYPE_ACTIVE;
 
+    // Drop any stale events left over from a previous scan
+    xTaskNotifyStateClearIndexed(nullptr, SCAN_EVENT_NOTIFY_INDEX);
+    ulTaskNotifyValueClearIndexed(nullptr, SCAN_EVENT_NOTIFY_INDEX, UINT32_MAX);
+
+    // Arm the completion flag under the driver lock so the poll hook cannot
+    // observe "not active" between arming and the scan actually starting
+    cyw43_thread_enter();
+    g_scan_in_flight = true;
+    g_timing = ScanTiming{time_us_64(), 0, 0, 0};
     int err = cyw43_wifi_scan(&cyw43_state, &scan_options, result, scan_result_callback);
+    if (err != 0) {
+        g_scan_in_flight = false;
+    } else {
+        scan_trace::scan_started(g_timing.start_us, radio.mode == ScanMode::PASSIVE,
+                                 radio.has_ssid());
+    }
+    cyw43_thread_exit();
+
     if (err != 0) {
         DBG_ERROR("WiFi", "cyw43_wifi_scan failed: %d", err);
         led::stop_blink();
         result->error_code = err;
-        return;
+        timing = ScanTiming{};
+        return false;
     }
 
-    DBG_INFO("WiFi", "Scan initiated, polling for completion");
-    while (cyw43_wifi_scan_active(&cyw43_state)) {
-        vTaskDelay(pdMS_TO_TICKS(SCAN_POLL_INTERVAL_MS));
+    DBG_INFO("WiFi", "Scan initiated, waiting for completion event");
+    const uint32_t events = wait_scan_event(SCAN_EVENT_DONE | SCAN_EVENT_MATCHED,
+                                            SCAN_COMPLETE_TIMEOUT_MS);
+
+    cyw43_thread_enter();
+    const bool still_active = cyw43_wifi_scan_active(&cyw43_state);
+    if (!still_active) {
+        g_scan_in_flight = false;
     }
+    timing = g_timing;
+    cyw43_thread_exit();
 
     led::stop_blink();
+    const bool matched = (events & SCAN_EVENT_MATCHED) != 0;
+    if (events == 0 && still_active) {
+        DBG_ERROR("WiFi", "Scan did not complete within %lu ms",
+                  static_cast<unsigned long>(SCAN_COMPLETE_TIMEOUT_MS));
+        // Its requests fail either way; the abort frees the radio for the next one
+        [[maybe_unused]] const bool aborted = abort_hung_scan();
+        result->error_code = PICO_ERROR_TIMEOUT;
+        return false;
+    }
+    if (events == 0) {
+        DBG_WARN("WiFi", "Scan completed without completion event");
+    }
+    if (timing.end_us == 0) {
+        timing.end_us = time_us_64();
+    }
+
     result->success = true;
-    DBG_INFO("WiFi", "Scan finished: %u APs found", result->count);
+    DBG_INFO("WiFi", "Scan finished%s: %u APs found, %u replaced, %u reports rejected",
+             (matched && still_active) ? " early" : "", result->count, result->replaced,
+             result->rejected);
+    return matched && still_active;
+}
+
+/**
+ * @brief Allocate a request ticket (never 0, so 0 can mean "none").
+ */
+uint32_t next_ticket() {
+    taskENTER_CRITICAL();
+    if (++g_next_ticket == 0) {
+        ++g_next_ticket;
+    }
+    const uint32_t ticket = g_next_ticket;
+    taskEXIT_CRITICAL();
+    return ticket;
+}
+
+/**
+ * @brief Remove ticket from the abandoned set.
+ * @return true if the ticket had been abandoned by its caller
+ * @note Caller must hold g_delivery_mutex.
+ */
+bool take_abandoned(uint32_t ticket) {
+    for (std::size_t i = 0; i < g_abandoned_count; i++) {
+        if (g_abandoned[i] == ticket) {
+            g_abandoned[i] = g_abandoned[--g_abandoned_count];
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Remove requests whose callers gave up from the batch.
+ *
+ * An abandoned stream lived on its caller's stack and is already freed,
+ * so it must go before the batch is attached to the callback.
+ *
+ * @return New batch size
+ * @note Caller must hold g_delivery_mutex.
+ */
+std::size_t drop_abandoned(RequestBatch& batch, std::size_t count) {
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        if (!take_abandoned(batch[i].ticket)) {
+            batch[kept++] = batch[i];
+        }
+    }
+    return kept;
+}
+
+/**
+ * @brief Move queued requests into the batch without blocking, dropping abandoned ones.
+ * @return New batch size
+ */
+std::size_t drain_requests(RequestBatch& batch, std::size_t count) {
+    while (count < batch.size() && xQueueReceive(g_request_queue, &batch[count], 0) == pdTRUE) {
+        count++;
+    }
+    xSemaphoreTake(g_delivery_mutex, portMAX_DELAY);
+    count = drop_abandoned(batch, count);
+    xSemaphoreGive(g_delivery_mutex);
+    return count;
+}
+
+/**
+ * @brief Choose radio parameters serving every request in the batch.
+ *
+ * Requests that disagree on the SSID widen the scan to all SSIDs; passive
+ * mode is used only if every request asks for it.
+ */
+ScanRequest radio_params(const RequestBatch& batch, std::size_t count) {
+    ScanRequest radio;
+    radio.ssid = batch[0].params.ssid;
+    radio.mode = batch[0].params.mode;
+    for (std::size_t i = 1; i < count; i++) {
+        if (!radio.covers(batch[i].params)) {
+            radio.ssid.fill('\0');
+        }
+        if (batch[i].params.mode != radio.mode) {
+            radio.mode = ScanMode::ACTIVE;
+        }
+    }
+    return radio;
+}
+
+/**
+ * @brief Attach the batch to scan_result_callback.
+ *
+ * Requests abandoned since they were drained are dropped first, under
+ * g_delivery_mutex, so a caller cancelling now either finds its request
+ * dropped or attached (and detaches it before freeing its stream).
+ *
+ * @return New batch size
+ */
+std::size_t attach_requests(RequestBatch& batch, std::size_t count) {
+    xSemaphoreTake(g_delivery_mutex, portMAX_DELAY);
+    count = drop_abandoned(batch, count);
+    cyw43_thread_enter();
+    for (std::size_t i = 0; i < count; i++) {
+        g_live[i] = LiveRequest{&batch[i].params, batch[i].stream, false};
+    }
+    g_live_count = count;
+    g_match_signaled = false;
+    cyw43_thread_exit();
+    xSemaphoreGive(g_delivery_mutex);
+    return count;
+}
+
+/**
+ * @brief Stop feeding requests from scan_result_callback.
+ * @param stream Stream to detach, or nullptr to detach everything
+ */
+void detach_requests(MessageBufferHandle_t stream) {
+    cyw43_thread_enter();
+    if (!stream) {
+        g_live_count = 0;
+    }
+    for (std::size_t i = 0; i < g_live_count; i++) {
+        if (g_live[i].stream == stream) {
+            g_live[i].stream = nullptr;
+            g_live[i].satisfied = true;
+        }
+    }
+    cyw43_thread_exit();
+}
+
+/**
+ * @brief Check if the batch needs every AP the radio reports.
+ *
+ * Only then is the scan buffer a complete picture that later requests and
+ * lease holders can be served from.
+ */
+bool wants_full_scan(const RequestBatch& batch, std::size_t count) {
+    return std::any_of(batch.begin(), batch.begin() + count, [](const PendingRequest& req) {
+        return !req.params.is_targeted() && !req.params.stop_on_match;
+    });
+}
+
+/**
+ * @brief Claim the back result buffer, waiting briefly for readers to let go.
+ * @return Buffer to fill, or nullptr if it is still leased after LEASE_WAIT_TIMEOUT_MS
+ */
+ScanResult* claim_back_buffer() {
+    while (true) {
+        taskENTER_CRITICAL();
+        ScanResult* back = g_results.back();
+        taskEXIT_CRITICAL();
+        if (back) {
+            return back;
+        }
+        // Readers only ever lease the front buffer, so every wakeup means
+        // progress and this loop ends
+        if (wait_scan_event(SCAN_EVENT_RELEASED, LEASE_WAIT_TIMEOUT_MS) == 0) {
+            taskENTER_CRITICAL();
+            back = g_results.back();
+            taskEXIT_CRITICAL();
+            return back;
+        }
+    }
+}
+
+/**
+ * @brief Uptime in milliseconds, as recorded in the known-network cache.
+ */
+uint32_t uptime_ms() {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+/**
+ * @brief Update the known-network cache from the APs in scan.
+ */
+void refresh_known(const ScanResult& scan) {
+    const uint32_t now = uptime_ms();
+    taskENTER_CRITICAL();
+    g_known.refresh(scan, now);
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Make the filled back buffer the one latest_scan() hands out.
+ */
+void publish_results() {
+    taskENTER_CRITICAL();
+    g_results.publish();
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Add a finished scan attempt to g_stats.
+ * @param live Requests the scan was started for
+ * @param timing Phase timestamps (start_us 0 if the scan never started)
+ */
+void record_scan(const RequestBatch& batch, std::size_t live, const ScanTiming& timing,
+                 bool success) {
+    taskENTER_CRITICAL();
+    if (timing.start_us != 0) {
+        for (std::size_t i = 0; i < live; i++) {
+            g_stats.queue_wait.record(elapsed_us(batch[i].enqueued_us, timing.start_us));
+        }
+        if (timing.first_ap_us != 0) {
+            g_stats.first_ap.record(elapsed_us(timing.start_us, timing.first_ap_us));
+        }
+        g_stats.aps_heard += timing.aps_heard;
+    }
+    if (success) {
+        g_stats.radio.record(elapsed_us(timing.start_us, timing.end_us));
+        g_stats.scans++;
+    } else {
+        g_stats.failed_scans++;
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Add a request the caller received to g_stats.
+ * @param start_us When the caller made the request
+ * @param scan_end_us When its scan completed (0 for streams, whose caller
+ *        consumes APs during the scan)
+ */
+void record_delivery(uint64_t start_us, uint64_t scan_end_us) {
+    const uint64_t now = time_us_64();
+    taskENTER_CRITICAL();
+    g_stats.requests++;
+    g_stats.end_to_end.record(elapsed_us(start_us, now));
+    if (scan_end_us != 0) {
+        g_stats.handoff.record(elapsed_us(scan_end_us, now));
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Count a request whose caller gave up waiting.
+ */
+void record_timeout() {
+    taskENTER_CRITICAL();
+    g_stats.timeouts++;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Complete every live request in the batch and wake its caller.
+ *
+ * Result requests get the matching part of the scan buffer; streams get a
+ * StreamEnd; lease requests get a lease on the published result. Requests
+ * queued after the scan started are carried to the front of the batch for
+ * the next scan when they could not be served by this one: streams (they
+ * missed the live APs), and anything when the scan was not a full one.
+ *
+ * @param live Number of requests that were attached when the scan started
+ * @param full Scan reported every AP (see wants_full_scan())
+ * @param published scan was published and can be leased
+ * @param end_us When the scan completed, passed on to callers for the handoff time
+ * @return Number of requests carried over to the next scan
+ */
+template <std::size_t N>
+std::size_t deliver(RequestBatch& batch, std::size_t live, std::size_t count,
+                    const BasicScanResult<N>& scan, bool full, bool published, uint64_t end_us) {
+    std::size_t carried = 0;
+    xSemaphoreTake(g_delivery_mutex, portMAX_DELAY);
+    for (std::size_t i = 0; i < count; i++) {
+        const PendingRequest req = batch[i];
+        if (take_abandoned(req.ticket)) {
+            continue;
+        }
+        if (i >= live && (req.stream || !full)) {
+            batch[carried++] = req;
+            continue;
+        }
+        if (req.stream) {
+            const StreamEnd end{scan.success, scan.error_code};
+            if (xMessageBufferSend(req.stream, &end, sizeof(end),
+                                   pdMS_TO_TICKS(STREAM_END_TIMEOUT_MS)) != sizeof(end)) {
+                DBG_WARN("WiFi", "Stream consumer too slow, end of scan not sent");
+            }
+        } else if (req.lease) {
+            if (published) {
+                *req.lease = wifi::latest_scan();
+            }
+        } else {
+            copy_matching(scan, req.params, *req.result);
+        }
+        if (req.scan_end_us) {
+            *req.scan_end_us = end_us;
+        }
+        xTaskNotifyIndexed(req.waiter, REQUEST_DONE_NOTIFY_INDEX, req.ticket,
+                           eSetValueWithOverwrite);
+    }
+    xSemaphoreGive(g_delivery_mutex);
+    return carried;
+}
+
+/**
+ * @brief Wait for the completion notification carrying ticket.
+ *
+ * Notifications for other tickets are stale (from a request that finished
+ * after its own wait gave up) and are discarded.
+ */
+bool wait_for_ticket(uint32_t ticket, TimeOut_t* timeout, TickType_t* remaining) {
+    uint32_t value = 0;
+    do {
+        if (xTaskNotifyWaitIndexed(REQUEST_DONE_NOTIFY_INDEX, 0, UINT32_MAX,
+                                   &value, *remaining) == pdTRUE && value == ticket) {
+            return true;
+        }
+    } while (xTaskCheckForTimeOut(timeout, remaining) == pdFALSE);
+    return false;
+}
+
+/**
+ * @brief Withdraw a request whose caller is done waiting.
+ *
+ * Either the scanner completed it before we took the mutex, or the ticket
+ * is marked abandoned and the scanner will never touch its buffers.
+ *
+ * @return true if the request had already been delivered
+ */
+bool cancel_request(uint32_t ticket) {
+    xSemaphoreTake(g_delivery_mutex, portMAX_DELAY);
+    uint32_t value = 0;
+    const bool delivered = xTaskNotifyWaitIndexed(REQUEST_DONE_NOTIFY_INDEX, 0, UINT32_MAX,
+                                                  &value, 0) == pdTRUE && value == ticket;
+    if (!delivered) {
+        configASSERT(g_abandoned_count < g_abandoned.size());
+        g_abandoned[g_abandoned_count++] = ticket;
+    }
+    xSemaphoreGive(g_delivery_mutex);
+    return delivered;
+}
+
+/**
+ * @brief Post a request and return its ticket (0 if the queue stayed full).
+ * @param scan_end_us Receives when the serving scan completed, or nullptr
+ */
+uint32_t submit(const ScanRequest& params, ScanResult* result, MessageBufferHandle_t stream,
+                wifi::ScanLease* lease, uint64_t* scan_end_us, TickType_t wait) {
+    const PendingRequest req{next_ticket(), params, result, stream, lease, scan_end_us,
+                             time_us_64(), xTaskGetCurrentTaskHandle()};
+    if (xQueueSend(g_request_queue, &req, wait) != pdTRUE) {
+        DBG_WARN("WiFi", "Scan request queue full");
+        return 0;
+    }
+    return req.ticket;
 }
 
 /**
  * @brief Scanner task - waits for requests and performs scans.
+ *
+ * Every compatible request queued before a scan starts, or while it runs,
+ * is served by that one scan.
  */
 void scanner_task(void* params) {
     static_cast<void>(params);
 
+    RequestBatch batch{};
+    std::size_t carried = 0;
+
     DBG_INFO("WiFi", "Scanner task started, waiting for requests");
     while (true) {
-        if (xSemaphoreTake(g_request_sem, portMAX_DELAY) == pdTRUE) {
-            DBG_INFO("WiFi", "Scan request received");
-            ScanResult* result = g_result_ptr;
-            if (result) {
-                do_scan(result);
+        if (carried == 0) {
+            supervisor::idle(Watched::SCANNER);
+            if (xQueueReceive(g_request_queue, &batch[0], portMAX_DELAY) != pdTRUE) {
+                continue;
+            }
+            carried = 1;
+        }
+        supervisor::check_in(Watched::SCANNER, SCANNER_BUSY_BUDGET_MS);
+        std::size_t live = drain_requests(batch, carried);
+        if (live == 0) {
+            // Every caller gave up while its request was queued
+            carried = 0;
+            continue;
+        }
+        DBG_INFO("WiFi", "Scan request received (%u pending)", static_cast<unsigned>(live));
+
+        const ScanRequest radio = radio_params(batch, live);
+        bool full = wants_full_scan(batch, live);
+        ScanResult* scan = nullptr;
+        ScanTiming timing{};
+        // Results of a scan that outlived its requests must not leak into
+        // this batch, so attach only once the radio is idle
+        if (!wait_radio_idle()) {
+            DBG_ERROR("WiFi", "Previous scan still active after abort");
+            g_scan_failure.error_code = PICO_ERROR_TIMEOUT;
+        } else if ((scan = claim_back_buffer()) == nullptr) {
+            DBG_ERROR("WiFi", "Scan results still leased after %lu ms",
+                      static_cast<unsigned long>(LEASE_WAIT_TIMEOUT_MS));
+            g_scan_failure.error_code = PICO_ERROR_RESOURCE_IN_USE;
+        } else {
+            // Under load keep the strongest APs rather than the first ones heard
+            scan->policy = FullPolicy::KEEP_STRONGEST;
+            live = attach_requests(batch, live);
+            const bool ended_early = do_scan(scan, radio, timing);
+            detach_requests(nullptr);
+            // Every requester was done before the radio: a full batch can only
+            // get here by its streams detaching, and the table is partial
+            if (ended_early) {
+                full = false;
             }
-            xSemaphoreGive(g_complete_sem);
-            DBG_INFO("WiFi", "Scan request completed, signaled caller");
         }
+
+        const bool success = scan && scan->success;
+        record_scan(batch, live, timing, success);
+        if (!success) {
+            timing.end_us = time_us_64();
+        }
+
+        const bool published = success && full;
+        if (published) {
+            publish_results();
+            refresh_known(*scan);
+        }
+
+        // Coalesce requests that arrived while the radio was busy
+        const std::size_t count = drain_requests(batch, live);
+        carried = scan ? deliver(batch, live, count, *scan, full, published, timing.end_us)
+                       : deliver(batch, live, count, g_scan_failure, full, false, timing.end_us);
+        DBG_INFO("WiFi", "Scan request completed, signaled %u callers",
+                 static_cast<unsigned>(count - carried));
     }
 }
 
@@ -121,49 +972,274 @@ namespace wifi {
         DBG_ERROR("WiFi", "cyw43_arch_init failed");
         return false;
     }
+    // Keep the async context (CYW43 poll) and lwIP on the scanner's core
+    pin_driver_task("async_context_task");
+    pin_driver_task("tcpip_thread");
     DBG_INFO("WiFi", "Enabling station mode");
     cyw43_arch_enable_sta_mode();
+    configure_associated_scans();
+    scan_trace::start();
+    if (!install_poll_hook()) {
+        DBG_ERROR("WiFi", "CYW43 poll function not registered");
+        return false;
+    }
     DBG_INFO("WiFi", "CYW43 initialization complete");
     return true;
 }
 
 [[nodiscard]] bool start_scanner_task() {
-    DBG_INFO("WiFi", "Creating scanner semaphores");
-    g_request_sem = xSemaphoreCreateBinary();
-    g_complete_sem = xSemaphoreCreateBinary();
-
-    if (!g_request_sem || !g_complete_sem) {
-        DBG_ERROR("WiFi", "Failed to create semaphores");
+    if (g_scanner_task) {
         return false;
     }
 
+    DBG_INFO("WiFi", "Creating scanner request queue");
+    g_request_queue = xQueueCreateStatic(REQUEST_QUEUE_LENGTH, sizeof(PendingRequest),
+                                         g_request_queue_storage.data(),
+                                         &g_request_queue_control);
+    g_delivery_mutex = xSemaphoreCreateMutexStatic(&g_delivery_mutex_control);
+
     DBG_INFO("WiFi", "Creating scanner task (stack=%lu, priority=%lu)",
              static_cast<unsigned long>(SCANNER_STACK_SIZE),
              static_cast<unsigned long>(SCANNER_PRIORITY));
-    BaseType_t ret = xTaskCreate(
+    g_scanner_task = create_pinned_task(
         scanner_task,
         "wifi_scan",
-        SCANNER_STACK_SIZE,
+        g_scanner_memory,
         nullptr,
         SCANNER_PRIORITY,
-        nullptr
+        NETWORK_CORE
     );
+    return g_scanner_task != nullptr;
+}
 
-    if (ret != pdPASS) {
-        DBG_ERROR("WiFi", "xTaskCreate failed");
+[[nodiscard]] bool request_scan(ScanResult* result, uint32_t timeout_ms) {
+    return request_scan(ScanRequest{}, result, timeout_ms);
+}
+
+[[nodiscard]] bool request_scan(const ScanRequest& request, ScanResult* result,
+                                uint32_t timeout_ms) {
+    if (!result || !g_request_queue || !g_delivery_mutex) {
+        return false;
+    }
+
+    TimeOut_t timeout;
+    TickType_t remaining = pdMS_TO_TICKS(timeout_ms);
+    vTaskSetTimeOutState(&timeout);
+    const uint64_t start_us = time_us_64();
+    uint64_t scan_end_us = 0;
+
+    const uint32_t ticket = submit(request, result, nullptr, nullptr, &scan_end_us, remaining);
+    if (ticket == 0) {
+        return false;
     }
-    return ret == pdPASS;
+    const bool delivered = (xTaskCheckForTimeOut(&timeout, &remaining) == pdFALSE &&
+                            wait_for_ticket(ticket, &timeout, &remaining)) ||
+                           cancel_request(ticket);
+    if (delivered) {
+        record_delivery(start_us, scan_end_us);
+    } else {
+        record_timeout();
+    }
+    return delivered;
 }
 
-[[nodiscard]] bool request_scan(ScanResult* result, uint32_t timeout_ms) {
-    if (!result || !g_request_sem || !g_complete_sem) {
+[[nodiscard]] bool request_scan(ScanLease& lease, uint32_t timeout_ms) {
+    return request_scan(lease, ScanMode::ACTIVE, timeout_ms);
+}
+
+[[nodiscard]] bool request_scan(ScanLease& lease, ScanMode mode, uint32_t timeout_ms) {
+    lease.release();
+    if (!g_request_queue || !g_delivery_mutex) {
+        return false;
+    }
+
+    TimeOut_t timeout;
+    TickType_t remaining = pdMS_TO_TICKS(timeout_ms);
+    vTaskSetTimeOutState(&timeout);
+    const uint64_t start_us = time_us_64();
+    uint64_t scan_end_us = 0;
+
+    ScanRequest request;
+    request.mode = mode;
+    const uint32_t ticket = submit(request, nullptr, nullptr, &lease, &scan_end_us, remaining);
+    if (ticket == 0) {
+        return false;
+    }
+    const bool delivered = (xTaskCheckForTimeOut(&timeout, &remaining) == pdFALSE &&
+                            wait_for_ticket(ticket, &timeout, &remaining)) ||
+                           cancel_request(ticket);
+    if (delivered) {
+        record_delivery(start_us, scan_end_us);
+    } else {
+        record_timeout();
+    }
+    // An empty lease after delivery means the scan failed
+    return delivered && static_cast<bool>(lease);
+}
+
+[[nodiscard]] bool scan_async(APSink sink, void* ctx, uint32_t timeout_ms) {
+    return scan_async(ScanRequest{}, sink, ctx, timeout_ms);
+}
+
+[[nodiscard]] bool scan_async(const ScanRequest& request, APSink sink, void* ctx,
+                              uint32_t timeout_ms) {
+    if (!sink || !g_request_queue || !g_delivery_mutex) {
+        return false;
+    }
+
+    TimeOut_t timeout;
+    TickType_t remaining = pdMS_TO_TICKS(timeout_ms);
+    vTaskSetTimeOutState(&timeout);
+    const uint64_t start_us = time_us_64();
+
+    // On this task's stack: nothing references it once detached below
+    std::array<uint8_t, STREAM_BUFFER_SIZE + 1> stream_storage;
+    StaticMessageBuffer_t stream_control;
+    MessageBufferHandle_t stream = xMessageBufferCreateStatic(
+        STREAM_BUFFER_SIZE, stream_storage.data(), &stream_control);
+
+    const uint32_t ticket = submit(request, nullptr, stream, nullptr, nullptr, remaining);
+    if (ticket == 0) {
+        vMessageBufferDelete(stream);
+        return false;
+    }
+
+    bool finished = false;
+    bool ok = false;
+    StreamMessage msg;
+    while (!finished && xTaskCheckForTimeOut(&timeout, &remaining) == pdFALSE) {
+        const size_t len = xMessageBufferReceive(stream, &msg, sizeof(msg), remaining);
+        if (len == sizeof(APInfo)) {
+            if (!sink(msg.ap, ctx)) {
+                finished = true;
+                ok = true;
+            }
+        } else if (len == sizeof(StreamEnd)) {
+            finished = true;
+            ok = msg.end.success;
+        }
+    }
+
+    // Withdraw from delivery, so the scanner can no longer attach the
+    // stream, then unhook it from the callback, before freeing it
+    cancel_request(ticket);
+    detach_requests(stream);
+    vMessageBufferDelete(stream);
+    if (finished) {
+        record_delivery(start_us, 0);
+    } else {
+        record_timeout();
+    }
+    return ok;
+}
+
+void remember_network(const APInfo& ap) {
+    const uint32_t now = uptime_ms();
+    taskENTER_CRITICAL();
+    g_known.remember(ap, now);
+    taskEXIT_CRITICAL();
+}
+
+[[nodiscard]] bool forget_network(const std::array<uint8_t, BSSID_LEN>& bssid) {
+    taskENTER_CRITICAL();
+    const bool forgotten = g_known.forget(bssid);
+    taskEXIT_CRITICAL();
+    return forgotten;
+}
+
+[[nodiscard]] KnownNetworks known_networks() {
+    taskENTER_CRITICAL();
+    const KnownNetworks known = g_known;
+    taskEXIT_CRITICAL();
+    return known;
+}
+
+void set_known_networks(const KnownNetworks& known) {
+    taskENTER_CRITICAL();
+    g_known = known;
+    taskEXIT_CRITICAL();
+}
+
+[[nodiscard]] bool scan_known(ScanResult* result, uint32_t timeout_ms) {
+    if (!result) {
+        return false;
+    }
+    const KnownNetworks known = known_networks();
+    if (known.empty()) {
+        return false;
+    }
+    if (!request_scan(known.fast_request(), result, timeout_ms) || result->count == 0) {
         return false;
     }
+    refresh_known(*result);
+    return true;
+}
+
+[[nodiscard]] bool set_power_profile(PowerProfile profile) {
+    const PowerSettings settings = power_settings(profile);
+    // The driver takes its own lock for each of these
+    const bool pm_set = cyw43_wifi_pm(&cyw43_state, driver_pm(settings.power_save)) == 0;
+    const bool mpc_set = set_wlc_var_u32("mpc", settings.idle_radio_off ? 1 : 0);
+    const bool dwell_set = set_wlc_u32(WLC_SET_SCAN_PASSIVE_TIME, settings.passive_dwell_ms);
+    if (!pm_set || !mpc_set || !dwell_set) {
+        DBG_WARN("WiFi", "Power profile %s partly applied (pm %d, mpc %d, dwell %d)",
+                 power_profile_name(profile), static_cast<int>(pm_set),
+                 static_cast<int>(mpc_set), static_cast<int>(dwell_set));
+        return false;
+    }
+    DBG_INFO("WiFi", "Power profile %s: passive dwell %lu ms, radio %s when idle",
+             power_profile_name(profile), static_cast<unsigned long>(settings.passive_dwell_ms),
+             settings.idle_radio_off ? "off" : "on");
+    return true;
+}
+
+[[nodiscard]] bool on_battery() {
+    return !cyw43_arch_gpio_get(CYW43_WL_GPIO_VBUS_PIN);
+}
+
+[[nodiscard]] ScanStats get_stats() {
+    taskENTER_CRITICAL();
+    const ScanStats stats = g_stats;
+    taskEXIT_CRITICAL();
+    return stats;
+}
+
+void reset_stats() {
+    taskENTER_CRITICAL();
+    g_stats = ScanStats{};
+    taskEXIT_CRITICAL();
+}
+
+[[nodiscard]] ScanLease latest_scan() {
+    taskENTER_CRITICAL();
+    const uint8_t slot = g_results.acquire();
+    const uint32_t generation = g_results.generation(slot);
+    taskEXIT_CRITICAL();
+    if (slot == PingPong<ScanResult>::NO_SLOT) {
+        return ScanLease{};
+    }
+    return ScanLease{&g_results.get(slot), generation, slot};
+}
 
-    g_result_ptr = result;
-    xSemaphoreGive(g_request_sem);
+void ScanLease::release() {
+    if (!result_) {
+        return;
+    }
+    taskENTER_CRITICAL();
+    const bool freed = g_results.release(slot_);
+    taskEXIT_CRITICAL();
+    // The scanner may be waiting to refill this buffer
+    if (freed && g_scanner_task) {
+        xTaskNotifyIndexed(g_scanner_task, SCAN_EVENT_NOTIFY_INDEX, SCAN_EVENT_RELEASED, eSetBits);
+    }
+    result_ = nullptr;
+}
 
-    return xSemaphoreTake(g_complete_sem, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+[[nodiscard]] bool ScanLease::is_stale() const {
+    taskENTER_CRITICAL();
+    const uint32_t latest = g_results.generation();
+    taskEXIT_CRITICAL();
+    return result_ && latest != generation_;
 }
 
 } // namespace wifi
@@ -2,17 +2,134 @@
  * @file wifi_scanner.hpp
  * @brief WiFi scanning with synchronous request-response pattern.
  *
- * The scanner task waits for scan requests and returns results
- * via a shared pointer. Uses FreeRTOS semaphores for synchronization.
+ * Callers post request descriptors to a FreeRTOS queue and block on a
+ * task notification. The scanner task coalesces every request queued
+ * before or during a scan onto that scan and copies the result to each
+ * caller, so N concurrent requesters cost one radio scan.
+ *
+ * Full scans are also published to a scanner-owned double buffer, which
+ * callers can read in place through a ScanLease instead of providing
+ * their own ScanResult.
+ *
+ * start_scan_scheduler() runs periodic full scans in the background on an
+ * adaptive interval; subscribe_deltas() reports only what changed between
+ * them.
+ *
+ * A small cache of known APs is kept current by every full scan;
+ * scan_known() looks for them with a scan that ends on the first one heard.
  */
 
 #ifndef WIFI_SCANNER_HPP
 #define WIFI_SCANNER_HPP
 
 #include "scan_msg.hpp"
+#include "scan_request.hpp"
+#include "scan_schedule.hpp"
+#include "scan_stats.hpp"
+#include "known_networks.hpp"
+#include "power_profile.hpp"
 
 namespace wifi {
 
+/**
+ * @brief Per-AP callback for scan_async().
+ * @param ap Network just reported by the radio
+ * @param ctx Caller context passed to scan_async()
+ * @return true to keep receiving, false to stop early
+ */
+using APSink = bool (*)(const APInfo& ap, void* ctx);
+
+/**
+ * @brief Callback for every scan completed by the scan scheduler.
+ * @param scan Result, valid only for the duration of the call
+ * @param changed The AP set differed from the previous scan
+ * @param ctx Caller context passed to start_scan_scheduler()
+ *
+ * Runs in the scheduler task, after the DeltaListener calls for the same
+ * scan; a slow listener delays the next scan.
+ */
+using ScanListener = void (*)(const ScanResult& scan, bool changed, void* ctx);
+
+/**
+ * @brief Callback for each change the scan scheduler detects between scans.
+ * @param event Added, removed or RSSI-changed AP
+ * @param ctx Caller context passed to subscribe_deltas()
+ *
+ * Runs in the scheduler task, before the ScanListener for the same scan.
+ */
+using DeltaListener = void (*)(const APEvent& event, void* ctx);
+
+class ScanLease;
+
+/**
+ * @brief Lease the most recently published full scan.
+ * @return Empty lease if no full scan has completed yet
+ */
+[[nodiscard]] ScanLease latest_scan();
+
+/**
+ * @brief Read-only lease on a scan result owned by the scanner task.
+ *
+ * The result stays valid and unchanged until the lease is released or
+ * destroyed, without being copied. Any number of tasks may hold leases on
+ * the same result. Keep leases short: the scanner cannot refill a leased
+ * buffer, so a lease held across the next scan delays it and eventually
+ * makes it fail.
+ */
+class ScanLease {
+public:
+    ScanLease() = default;
+    ~ScanLease() { release(); }
+
+    ScanLease(ScanLease&& other) noexcept
+        : result_(other.result_), generation_(other.generation_), slot_(other.slot_) {
+        other.result_ = nullptr;
+    }
+
+    ScanLease& operator=(ScanLease&& other) noexcept {
+        if (this != &other) {
+            release();
+            result_ = other.result_;
+            generation_ = other.generation_;
+            slot_ = other.slot_;
+            other.result_ = nullptr;
+        }
+        return *this;
+    }
+
+    ScanLease(const ScanLease&) = delete;
+    ScanLease& operator=(const ScanLease&) = delete;
+
+    /**
+     * @brief Give the result back to the scanner (no-op on an empty lease).
+     */
+    void release();
+
+    /**
+     * @brief Check if a newer full scan has been published since this one.
+     */
+    [[nodiscard]] bool is_stale() const;
+
+    /**
+     * @brief Scan generation, increasing with every published full scan.
+     */
+    [[nodiscard]] uint32_t generation() const noexcept { return generation_; }
+
+    [[nodiscard]] explicit operator bool() const noexcept { return result_ != nullptr; }
+    [[nodiscard]] const ScanResult& operator*() const noexcept { return *result_; }
+    [[nodiscard]] const ScanResult* operator->() const noexcept { return result_; }
+
+private:
+    friend ScanLease latest_scan();
+
+    ScanLease(const ScanResult* result, uint32_t generation, uint8_t slot) noexcept
+        : result_(result), generation_(generation), slot_(slot) {}
+
+    const ScanResult* result_{nullptr};
+    uint32_t generation_{0};
+    uint8_t slot_{0};
+};
+
 /**
  * @brief Initialize WiFi hardware (CYW43).
  * @return true on success, false on failure
@@ -35,11 +152,182 @@ namespace wifi {
  * @param timeout_ms Maximum time to wait for scan completion
  * @return true if scan completed within timeout
  *
- * Blocks until scan completes or timeout expires.
+ * Blocks until scan completes or timeout expires. Safe to call from
+ * several tasks at once; concurrent requests share a single scan.
+ * After a timeout the scanner never writes to result.
  * LED blinks during scan, stops when complete.
+ *
+ * Uses task notification index 2 of the calling task.
  */
 [[nodiscard]] bool request_scan(ScanResult* result, uint32_t timeout_ms = 30000);
 
+/**
+ * @brief Request a synchronous targeted WiFi scan.
+ * @param request SSID/BSSID/channel filters, radio mode and stop condition
+ * @param result Pointer to ScanResult to populate with matching APs only
+ * @param timeout_ms Maximum time to wait for scan completion
+ * @return true if scan completed within timeout
+ *
+ * A target SSID makes the radio send directed probes for that network
+ * only. With stop_on_match set, the request completes on the first
+ * matching AP instead of waiting for the full channel sweep (the scan is
+ * ended early only if every coalesced request is satisfied).
+ */
+[[nodiscard]] bool request_scan(const ScanRequest& request, ScanResult* result,
+                                uint32_t timeout_ms = 30000);
+
+/**
+ * @brief Request a full WiFi scan and lease its result.
+ * @param lease Receives the result of the scan (released first if held)
+ * @param timeout_ms Maximum time to wait for scan completion
+ * @return true if a successful scan completed within timeout
+ *
+ * Like request_scan(ScanResult*), but the caller reads the scanner's own
+ * buffer instead of receiving a copy, so no ScanResult is needed on the
+ * calling task's stack.
+ *
+ * Uses task notification index 2 of the calling task.
+ */
+[[nodiscard]] bool request_scan(ScanLease& lease, uint32_t timeout_ms = 30000);
+
+/**
+ * @brief Request a full WiFi scan in the given radio mode and lease its result.
+ *
+ * As request_scan(ScanLease&). A passive scan is used only if every
+ * request it is coalesced with asks for one too.
+ */
+[[nodiscard]] bool request_scan(ScanLease& lease, ScanMode mode, uint32_t timeout_ms = 30000);
+
+/**
+ * @brief Request a scan and stream each AP to sink as it is found.
+ * @param sink Called in the calling task for every AP, in arrival order
+ * @param ctx Passed through to sink
+ * @param timeout_ms Maximum time to wait for scan completion
+ * @return true if the scan completed (or sink stopped it early) within timeout
+ *
+ * APs arrive through a message buffer fed by the CYW43 result callback,
+ * so the first one is typically seen tens of milliseconds after the scan
+ * starts. Unlike request_scan() the stream is not limited to
+ * MAX_SCAN_RESULTS, and duplicates reported by the radio are passed on.
+ * If sink falls behind by more than a few APs, later ones are dropped.
+ *
+ * Returning false from sink stops delivery to this caller. The radio scan
+ * still runs to completion for any other requester; if there is none, it
+ * stops and its partial table is neither published nor used to serve
+ * requests that arrived meanwhile.
+ *
+ * The AP stream lives on the calling task's stack (about 400 bytes).
+ * Uses task notification index 2 of the calling task.
+ */
+[[nodiscard]] bool scan_async(APSink sink, void* ctx, uint32_t timeout_ms = 30000);
+
+/**
+ * @brief Targeted variant of scan_async(); only matching APs reach sink.
+ */
+[[nodiscard]] bool scan_async(const ScanRequest& request, APSink sink, void* ctx,
+                              uint32_t timeout_ms = 30000);
+
+/**
+ * @brief Add ap to the known-network cache, or update it.
+ *
+ * Typically called with the AP just associated with. Safe from any task.
+ */
+void remember_network(const APInfo& ap);
+
+/**
+ * @brief Remove bssid from the known-network cache.
+ * @return false if it was not known
+ */
+[[nodiscard]] bool forget_network(const std::array<uint8_t, BSSID_LEN>& bssid);
+
+/**
+ * @brief Snapshot of the known-network cache.
+ */
+[[nodiscard]] KnownNetworks known_networks();
+
+/**
+ * @brief Replace the known-network cache, e.g. with one restored from flash.
+ */
+void set_known_networks(const KnownNetworks& known);
+
+/**
+ * @brief Fast reconnect scan: look for any known AP.
+ * @param result Receives the known APs heard (at least one on success)
+ * @param timeout_ms Maximum time to wait for scan completion
+ * @return true if a known AP was heard within timeout (false without
+ *         scanning if the cache is empty)
+ *
+ * Targets the most recently heard known BSSIDs (see
+ * KnownNetworks::fast_request()) with stop_on_match, so the request
+ * completes as soon as the radio reaches the first one's channel rather
+ * than after the whole sweep. If none answers there, the rest of the
+ * sweep is the fallback, which also catches an AP that changed channel.
+ * Heard entries are refreshed in the cache.
+ *
+ * CYW43 always sweeps every channel (its driver overwrites the channel
+ * list), so the time saved depends on where the AP sits in the sweep;
+ * the cached channel is what a join can use to skip its own scan.
+ */
+[[nodiscard]] bool scan_known(ScanResult* result, uint32_t timeout_ms = 30000);
+
+/**
+ * @brief Apply a power profile's radio settings (see power_profile.hpp).
+ * @return false if the radio refused any of them (the rest still apply)
+ *
+ * Sets the CYW43 power-save mode, idle power-down and passive dwell. The
+ * scan mode and cadence are the scheduler's: pass
+ * apply_power_settings(config, power_settings(profile)) to
+ * start_scan_scheduler(). Call after init(), from any task.
+ */
+[[nodiscard]] bool set_power_profile(PowerProfile profile);
+
+/**
+ * @brief Check whether the board is running without USB power (VBUS absent).
+ */
+[[nodiscard]] bool on_battery();
+
+/**
+ * @brief Snapshot of the scan pipeline's latency histograms and counters.
+ *
+ * Accumulated since boot or the last reset_stats(). Safe from any task.
+ */
+[[nodiscard]] ScanStats get_stats();
+
+/**
+ * @brief Clear the statistics returned by get_stats().
+ */
+void reset_stats();
+
+/**
+ * @brief Start periodic background full scans.
+ * @param config Interval bounds and back-off (see AdaptiveSchedule)
+ * @param listener Called with each completed scan, or nullptr for deltas only
+ * @param ctx Passed through to listener
+ * @return true if the scheduler task was created
+ *
+ * Scans run on a fixed-rate cadence (measured from scan start to scan
+ * start, so scan duration does not add drift). The interval grows while
+ * the AP set stays the same and drops back to the minimum when it
+ * changes. Requires the scanner task; may only be called once.
+ */
+[[nodiscard]] bool start_scan_scheduler(const ScheduleConfig& config, ScanListener listener,
+                                        void* ctx = nullptr);
+
+/// Maximum delta subscribers
+inline constexpr std::size_t MAX_DELTA_SUBSCRIBERS = 4;
+
+/**
+ * @brief Receive added/removed/RSSI-changed events from the scan scheduler.
+ * @param listener Called once per change
+ * @param ctx Passed through to listener
+ * @return false if MAX_DELTA_SUBSCRIBERS are already registered
+ *
+ * Thresholds come from ScheduleConfig::diff. Only changes are reported:
+ * subscribe before start_scan_scheduler() to also get the initial AP set
+ * as ADDED events.
+ */
+[[nodiscard]] bool subscribe_deltas(DeltaListener listener, void* ctx = nullptr);
+
 } // namespace wifi
 
 #endif // WIFI_SCANNER_HPP
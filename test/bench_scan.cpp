@@ -0,0 +1,342 @@
+/**
+ * @file bench_scan.cpp
+ * @brief Host benchmarks for the scan data structures (scan_msg.hpp, scan_diff.hpp),
+ *        the console formatter (console_format.hpp) and the fingerprint matcher
+ *        (fingerprint.hpp).
+ *
+ * Feeds synthetic AP streams through the code the scanner runs per
+ * callback and per scan, and reports nanoseconds per operation and heap
+ * allocations per operation (the firmware paths should show none).
+ *
+ * A stream models a real sweep: each scan reports SCAN_UNIQUE_APS
+ * distinct BSSIDs (more than ScanResult holds, so the full-table paths
+ * run), each heard DUPLICATES_PER_AP times on average with jittered RSSI,
+ * in shuffled order. Successive scans share most of their APs, as a
+ * stationary device sees.
+ *
+ * Usage: bench_scan [--quick]
+ *   --quick  1k callbacks only (run by ctest as a smoke test)
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "../src/scan_msg.hpp"
+#include "../src/scan_diff.hpp"
+#include "../src/console_format.hpp"
+#include "../src/fingerprint.hpp"
+
+// =============================================================================
+// Allocation counting
+// =============================================================================
+
+namespace {
+uint64_t g_allocations = 0;
+} // anonymous namespace
+
+void* operator new(std::size_t size) {
+    g_allocations++;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+// =============================================================================
+// Synthetic AP streams
+// =============================================================================
+
+constexpr std::size_t SCAN_UNIQUE_APS = 48;
+constexpr std::size_t DUPLICATES_PER_AP = 4;
+constexpr std::size_t SCAN_CALLBACKS = SCAN_UNIQUE_APS * DUPLICATES_PER_AP;
+
+// Share of a scan's APs replaced by new ones in the next scan
+constexpr std::size_t CHURN_PERCENT = 10;
+
+/**
+ * @brief AP callbacks grouped into scans of SCAN_CALLBACKS.
+ */
+struct Stream {
+    std::vector<APInfo> callbacks;
+    std::vector<uint8_t> cyw43_auth;
+
+    [[nodiscard]] std::size_t scans() const { return callbacks.size() / SCAN_CALLBACKS; }
+};
+
+APInfo make_ap(uint32_t id, std::mt19937& rng) {
+    APInfo ap;
+    std::snprintf(ap.ssid.data(), ap.ssid.size(), "Network-%05u", static_cast<unsigned>(id));
+    ap.bssid = {0x02, 0x11, static_cast<uint8_t>(id >> 24), static_cast<uint8_t>(id >> 16),
+                static_cast<uint8_t>(id >> 8), static_cast<uint8_t>(id)};
+    ap.rssi = static_cast<int16_t>(-40 - static_cast<int>(rng() % 50));
+    ap.channel = static_cast<uint8_t>(1 + rng() % 13);
+    ap.auth = static_cast<AuthMode>(rng() % static_cast<uint32_t>(AuthMode::UNKNOWN));
+    return ap;
+}
+
+/**
+ * @brief Stream of about callbacks AP reports (whole scans).
+ */
+Stream make_stream(std::size_t callbacks, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<APInfo> neighbourhood;
+    uint32_t next_id = 0;
+    while (neighbourhood.size() < SCAN_UNIQUE_APS) {
+        neighbourhood.push_back(make_ap(next_id++, rng));
+    }
+
+    Stream stream;
+    const std::size_t scans = std::max<std::size_t>(1, callbacks / SCAN_CALLBACKS);
+    stream.callbacks.reserve(scans * SCAN_CALLBACKS);
+    std::vector<APInfo> scan;
+    for (std::size_t s = 0; s < scans; s++) {
+        for (std::size_t i = 0; i < SCAN_UNIQUE_APS * CHURN_PERCENT / 100; i++) {
+            neighbourhood[rng() % neighbourhood.size()] = make_ap(next_id++, rng);
+        }
+        scan.clear();
+        for (const APInfo& ap : neighbourhood) {
+            for (std::size_t d = 0; d < DUPLICATES_PER_AP; d++) {
+                APInfo heard = ap;
+                heard.rssi = static_cast<int16_t>(ap.rssi + static_cast<int>(rng() % 7) - 3);
+                scan.push_back(heard);
+            }
+        }
+        std::shuffle(scan.begin(), scan.end(), rng);
+        stream.callbacks.insert(stream.callbacks.end(), scan.begin(), scan.end());
+    }
+
+    // CYW43 auth bitmasks as heard: mostly WPA2, some mixed, a few open/WEP
+    constexpr std::array<uint8_t, 8> AUTH_MIX = {4, 4, 4, 6, 6, 0, 1, 2};
+    stream.cyw43_auth.resize(stream.callbacks.size());
+    for (uint8_t& auth : stream.cyw43_auth) {
+        auth = AUTH_MIX[rng() % AUTH_MIX.size()];
+    }
+    return stream;
+}
+
+// =============================================================================
+// Harness
+// =============================================================================
+
+constexpr int REPETITIONS = 5;
+
+// Results are folded in here so the optimizer cannot drop the work
+volatile uint64_t g_sink = 0;
+
+/**
+ * @brief Run body (which performs ops operations) and print the best time.
+ */
+template <typename Body>
+void bench(const char* name, std::size_t ops, Body&& body) {
+    double best_ns = 0;
+    uint64_t allocations = 0;
+    for (int rep = 0; rep < REPETITIONS; rep++) {
+        const uint64_t allocs_before = g_allocations;
+        const auto start = std::chrono::steady_clock::now();
+        body();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        allocations = g_allocations - allocs_before;
+        const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+        if (rep == 0 || ns < best_ns) {
+            best_ns = ns;
+        }
+    }
+    std::printf("%-40s %9zu %10.1f %10.3f\n", name, ops, best_ns / static_cast<double>(ops),
+                static_cast<double>(allocations) / static_cast<double>(ops));
+}
+
+// =============================================================================
+// Benchmarks
+// =============================================================================
+
+/**
+ * @brief ScanResult::add over every callback: dedup, RSSI merge, full-table policy.
+ */
+void bench_add(const Stream& stream, const char* name, RssiMerge merge, FullPolicy policy) {
+    static ScanResult result;
+    result.merge = merge;
+    result.policy = policy;
+    bench(name, stream.callbacks.size(), [&] {
+        uint64_t added = 0;
+        for (std::size_t s = 0; s < stream.scans(); s++) {
+            result.reset();
+            const APInfo* scan = stream.callbacks.data() + s * SCAN_CALLBACKS;
+            for (std::size_t i = 0; i < SCAN_CALLBACKS; i++) {
+                added += result.add(scan[i]);
+            }
+        }
+        g_sink = g_sink + added;
+    });
+}
+
+void bench_auth(const Stream& stream) {
+    bench("auth_mode_from_cyw43", stream.cyw43_auth.size(), [&] {
+        uint64_t sum = 0;
+        for (uint8_t auth : stream.cyw43_auth) {
+            sum += static_cast<uint8_t>(auth_mode_from_cyw43(auth));
+        }
+        g_sink = g_sink + sum;
+    });
+}
+
+void bench_format_bssid(const Stream& stream) {
+    bench("APInfo::format_bssid", stream.callbacks.size(), [&] {
+        char text[18];
+        uint64_t sum = 0;
+        for (const APInfo& ap : stream.callbacks) {
+            ap.format_bssid(text, sizeof(text));
+            sum += static_cast<uint8_t>(text[16]);
+        }
+        g_sink = g_sink + sum;
+    });
+}
+
+/**
+ * @brief Fill one ScanResult per scan, as the scanner does before publishing.
+ */
+std::vector<ScanResult> collect_scans(const Stream& stream) {
+    std::vector<ScanResult> scans(stream.scans());
+    for (std::size_t s = 0; s < scans.size(); s++) {
+        scans[s].policy = FullPolicy::KEEP_STRONGEST;
+        const APInfo* scan = stream.callbacks.data() + s * SCAN_CALLBACKS;
+        for (std::size_t i = 0; i < SCAN_CALLBACKS; i++) {
+            [[maybe_unused]] const bool added = scans[s].add(scan[i]);
+        }
+        scans[s].success = true;
+    }
+    return scans;
+}
+
+void bench_top_k(const std::vector<ScanResult>& scans) {
+    bench("ScanResult::by_rssi (per scan)", scans.size(), [&] {
+        uint64_t sum = 0;
+        for (const ScanResult& scan : scans) {
+            sum += scan.by_rssi()[0];
+        }
+        g_sink = g_sink + sum;
+    });
+}
+
+void bench_diff(const std::vector<ScanResult>& scans) {
+    bench("ScanDiff::update (per scan)", scans.size(), [&] {
+        ScanDiff diff;
+        uint64_t events = 0;
+        for (const ScanResult& scan : scans) {
+            events += diff.update(scan, [](const APEvent&) {});
+        }
+        g_sink = g_sink + events;
+    });
+}
+
+/**
+ * @brief Render each scan as a console table: one snprintf per AP versus ConsoleBuffer.
+ */
+void bench_console(const std::vector<ScanResult>& scans) {
+    static std::array<char, 4096> text;
+    bench("console table, snprintf (per scan)", scans.size(), [&] {
+        uint64_t bytes = 0;
+        for (const ScanResult& scan : scans) {
+            std::size_t len = 0;
+            for (std::size_t i = 0; i < scan.count; i++) {
+                const APInfo ap = scan.networks[i];
+                char bssid[18];
+                ap.format_bssid(bssid, sizeof(bssid));
+                const int n = std::snprintf(text.data() + len, text.size() - len,
+                                            "  %c %-32s  %s  ch%2u  %4ddBm  %-9s %s\n", '+',
+                                            ap.ssid.data(), bssid, ap.channel, ap.rssi,
+                                            auth_mode_to_string(ap.auth), "");
+                len += static_cast<std::size_t>(n);
+            }
+            bytes += len;
+        }
+        g_sink = g_sink + bytes;
+    });
+
+    static ConsoleBuffer<4096> out;
+    bench("console table, ConsoleBuffer (per scan)", scans.size(), [&] {
+        uint64_t bytes = 0;
+        for (const ScanResult& scan : scans) {
+            out.clear();
+            append_scan(out, ConsoleFormat::TABLE, '+', scan);
+            bytes += out.size();
+        }
+        g_sink = g_sink + bytes;
+    });
+    bench("console JSON lines (per scan)", scans.size(), [&] {
+        uint64_t bytes = 0;
+        for (const ScanResult& scan : scans) {
+            out.clear();
+            append_scan(out, ConsoleFormat::JSON_LINES, '+', scan);
+            bytes += out.size();
+        }
+        g_sink = g_sink + bytes;
+    });
+}
+
+/**
+ * @brief Match each scan against a table of references built from the stream's own scans.
+ */
+void bench_fingerprint(const std::vector<ScanResult>& scans) {
+    constexpr std::size_t LOCATIONS = 64;
+    static std::array<FingerprintLocation, LOCATIONS> locations;
+    for (std::size_t i = 0; i < LOCATIONS; i++) {
+        locations[i] = FingerprintLocation{"ref", fingerprint_of(scans[i % scans.size()])};
+    }
+    const FingerprintDb db(locations.data(), locations.size());
+
+    bench("fingerprint_of (per scan)", scans.size(), [&] {
+        uint64_t sum = 0;
+        for (const ScanResult& scan : scans) {
+            sum += fingerprint_of(scan).bssid[0];
+        }
+        g_sink = g_sink + sum;
+    });
+    bench("FingerprintDb::match, 64 locations", scans.size(), [&] {
+        uint64_t sum = 0;
+        for (const ScanResult& scan : scans) {
+            sum += db.match(fingerprint_of(scan)).distance.rms_q8;
+        }
+        g_sink = g_sink + sum;
+    });
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const bool quick = argc > 1 && std::strcmp(argv[1], "--quick") == 0;
+    const std::vector<std::size_t> sizes = quick ? std::vector<std::size_t>{1000}
+                                                 : std::vector<std::size_t>{1000, 10000, 100000};
+
+    std::printf("%zu APs per scan, each heard %zu times, %zu%% churn between scans\n",
+                SCAN_UNIQUE_APS, DUPLICATES_PER_AP, CHURN_PERCENT);
+    for (std::size_t size : sizes) {
+        const Stream stream = make_stream(size, static_cast<uint32_t>(size));
+        const std::vector<ScanResult> scans = collect_scans(stream);
+
+        std::printf("\n%zu callbacks (%zu scans)\n", stream.callbacks.size(), stream.scans());
+        std::printf("%-40s %9s %10s %10s\n", "benchmark", "ops", "ns/op", "allocs/op");
+        bench_add(stream, "ScanResult::add (max, drop new)", RssiMerge::MAX, FullPolicy::DROP_NEW);
+        bench_add(stream, "ScanResult::add (mean, keep strongest)", RssiMerge::MEAN,
+                  FullPolicy::KEEP_STRONGEST);
+        bench_auth(stream);
+        bench_format_bssid(stream);
+        bench_top_k(scans);
+        bench_diff(scans);
+        bench_console(scans);
+        bench_fingerprint(scans);
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host shim of the FreeRTOS kernel types and macros the scanner uses.
+ *
+ * Tasks are std::threads and every kernel object is guarded by one kernel
+ * lock (sim_freertos.cpp). One tick is one millisecond of real time.
+ * Only what wifi_scanner.cpp and the headers it includes need is here.
+ */
+
+#ifndef SIM_FREERTOS_H
+#define SIM_FREERTOS_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+using BaseType_t = long;
+using UBaseType_t = unsigned long;
+using TickType_t = uint32_t;
+using StackType_t = uint32_t;
+using TaskFunction_t = void (*)(void*);
+
+#define pdFALSE                 (static_cast<BaseType_t>(0))
+#define pdTRUE                  (static_cast<BaseType_t>(1))
+#define pdPASS                  pdTRUE
+#define pdFAIL                  pdFALSE
+#define portMAX_DELAY           (static_cast<TickType_t>(0xffffffffUL))
+
+#define configTICK_RATE_HZ      1000
+#define configNUMBER_OF_CORES   2
+#define configUSE_CORE_AFFINITY 1
+#define configMAX_PRIORITIES    32
+#define configMINIMAL_STACK_SIZE 256
+#define tskIDLE_PRIORITY        (static_cast<UBaseType_t>(0))
+#define configASSERT(x)         assert(x)
+
+#define pdMS_TO_TICKS(ms) \
+    (static_cast<TickType_t>((static_cast<uint64_t>(ms) * configTICK_RATE_HZ) / 1000))
+
+/// Static task memory; the shim gives every task a std::thread instead
+struct StaticTask_t {
+    void* unused;
+};
+
+struct tskTaskControlBlock;
+using TaskHandle_t = tskTaskControlBlock*;
+
+struct xTIME_OUT {
+    TickType_t entered;
+};
+using TimeOut_t = xTIME_OUT;
+
+// Critical sections nest and exclude every other task (one recursive lock)
+void sim_enter_critical();
+void sim_exit_critical();
+#define taskENTER_CRITICAL() sim_enter_critical()
+#define taskEXIT_CRITICAL()  sim_exit_critical()
+
+#endif // SIM_FREERTOS_H
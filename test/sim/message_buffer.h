@@ -0,0 +1,29 @@
+/**
+ * @file message_buffer.h
+ * @brief Host shim of the FreeRTOS message buffer API.
+ *
+ * Each message costs its length plus a size_t header, as in FreeRTOS, so
+ * a buffer sized for N messages holds N.
+ */
+
+#ifndef SIM_MESSAGE_BUFFER_H
+#define SIM_MESSAGE_BUFFER_H
+
+#include "FreeRTOS.h"
+
+struct StreamBufferDef_t;
+using MessageBufferHandle_t = StreamBufferDef_t*;
+
+struct StaticMessageBuffer_t {
+    void* unused;
+};
+
+MessageBufferHandle_t xMessageBufferCreateStatic(std::size_t size, uint8_t* storage,
+                                                 StaticMessageBuffer_t* control);
+std::size_t xMessageBufferSend(MessageBufferHandle_t buffer, const void* data, std::size_t len,
+                               TickType_t ticks);
+std::size_t xMessageBufferReceive(MessageBufferHandle_t buffer, void* data, std::size_t len,
+                                  TickType_t ticks);
+void vMessageBufferDelete(MessageBufferHandle_t buffer);
+
+#endif // SIM_MESSAGE_BUFFER_H
@@ -0,0 +1,71 @@
+/**
+ * @file cyw43_arch.h
+ * @brief Host shim of the CYW43 driver API, backed by the trace replayer (sim_cyw43.cpp).
+ *
+ * Structures carry only the fields the scanner reads or writes.
+ */
+
+#ifndef SIM_PICO_CYW43_ARCH_H
+#define SIM_PICO_CYW43_ARCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+// pico/error.h
+enum pico_error_codes {
+    PICO_OK = 0,
+    PICO_ERROR_GENERIC = -1,
+    PICO_ERROR_TIMEOUT = -2,
+    PICO_ERROR_RESOURCE_IN_USE = -13,
+};
+
+#define CYW43_ITF_STA 0
+#define CYW43_WL_GPIO_VBUS_PIN 2
+
+// Power-management values for cyw43_wifi_pm() (packed fields in the driver)
+#define CYW43_NONE_PM 0x10
+#define CYW43_AGGRESSIVE_PM 0xA11142
+#define CYW43_PERFORMANCE_PM 0x111142
+
+struct cyw43_t {
+    int itf_state;
+};
+
+struct cyw43_wifi_scan_options_t {
+    uint32_t version;
+    uint16_t action;
+    uint16_t _;
+    uint32_t ssid_len;
+    uint8_t ssid[32];
+    uint16_t channel_num;
+    uint16_t channel_list[1];
+    int8_t scan_type;
+};
+
+struct cyw43_ev_scan_result_t {
+    uint8_t bssid[6];
+    uint8_t ssid_len;
+    uint8_t ssid[32];
+    uint16_t channel;
+    uint8_t auth_mode;
+    int16_t rssi;
+};
+
+extern cyw43_t cyw43_state;
+
+// Driver poll function, called by the async context after each event
+extern void (*cyw43_poll)();
+
+int cyw43_arch_init();
+void cyw43_arch_enable_sta_mode();
+void cyw43_thread_enter();
+void cyw43_thread_exit();
+
+int cyw43_wifi_scan(cyw43_t* self, cyw43_wifi_scan_options_t* opts, void* env,
+                    int (*result_cb)(void*, const cyw43_ev_scan_result_t*));
+bool cyw43_wifi_scan_active(cyw43_t* self);
+int cyw43_ioctl(cyw43_t* self, uint32_t cmd, std::size_t len, uint8_t* buf, uint32_t iface);
+int cyw43_wifi_pm(cyw43_t* self, uint32_t pm);
+bool cyw43_arch_gpio_get(uint32_t wl_gpio);
+
+#endif // SIM_PICO_CYW43_ARCH_H
@@ -0,0 +1,18 @@
+/**
+ * @file time.h
+ * @brief Host shim of the Pico SDK time functions (microseconds since start).
+ */
+
+#ifndef SIM_PICO_TIME_H
+#define SIM_PICO_TIME_H
+
+#include <cstdint>
+
+using absolute_time_t = uint64_t;
+
+uint64_t time_us_64();
+
+inline absolute_time_t get_absolute_time() { return time_us_64(); }
+inline uint32_t to_ms_since_boot(absolute_time_t t) { return static_cast<uint32_t>(t / 1000); }
+
+#endif // SIM_PICO_TIME_H
@@ -0,0 +1,23 @@
+/**
+ * @file queue.h
+ * @brief Host shim of the FreeRTOS queue API (copy-in, copy-out, FIFO).
+ */
+
+#ifndef SIM_QUEUE_H
+#define SIM_QUEUE_H
+
+#include "FreeRTOS.h"
+
+struct QueueDefinition;
+using QueueHandle_t = QueueDefinition*;
+
+struct StaticQueue_t {
+    void* unused;
+};
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size, uint8_t* storage,
+                                 StaticQueue_t* control);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks);
+
+#endif // SIM_QUEUE_H
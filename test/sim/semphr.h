@@ -0,0 +1,18 @@
+/**
+ * @file semphr.h
+ * @brief Host shim of the FreeRTOS mutex API.
+ */
+
+#ifndef SIM_SEMPHR_H
+#define SIM_SEMPHR_H
+
+#include "queue.h"
+
+using SemaphoreHandle_t = QueueHandle_t;
+using StaticSemaphore_t = StaticQueue_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t* control);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex);
+
+#endif // SIM_SEMPHR_H
@@ -0,0 +1,306 @@
+/**
+ * @file sim_cyw43.cpp
+ * @brief Simulated CYW43 that replays scan traces in real (scaled) time.
+ */
+
+#include "sim_cyw43.hpp"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "pico/time.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+cyw43_t cyw43_state{};
+void (*cyw43_poll)() = nullptr;
+
+namespace {
+
+using ResultCallback = int (*)(void*, const cyw43_ev_scan_result_t*);
+
+/**
+ * @brief Radio state.
+ *
+ * Lock order: driver_lock, then trace_lock. The scanner calls
+ * cyw43_wifi_scan() with the driver lock already held.
+ */
+struct Radio {
+    std::recursive_mutex driver_lock;
+    std::condition_variable_any started;
+
+    // Under driver_lock
+    bool active = false;
+    uint32_t scan_id = 0;
+    uint64_t start_us = 0;
+    void* env = nullptr;
+    ResultCallback callback = nullptr;
+    std::string ssid_filter;
+    sim::ScanTrace current;
+    uint32_t current_speedup = 1;
+    sim::ScanEnd scan_end = sim::ScanEnd::COMPLETE;
+    bool aborted = false;
+    sim::RadioStats stats;
+
+    // Under trace_lock
+    std::mutex trace_lock;
+    std::vector<sim::ScanTrace> traces;
+    std::size_t next_trace = 0;
+    uint32_t speedup = 1;
+};
+
+Radio& radio() {
+    // Never freed: the async context thread outlives main()
+    static Radio* r = new Radio;
+    return *r;
+}
+
+void driver_poll() {}
+
+void sleep_until_us(uint64_t deadline_us) {
+    const uint64_t now = time_us_64();
+    if (deadline_us > now) {
+        std::this_thread::sleep_for(std::chrono::microseconds(deadline_us - now));
+    }
+}
+
+/**
+ * @brief Async context task: plays each started scan's trace.
+ */
+void async_context_task(void* params) {
+    static_cast<void>(params);
+    Radio& r = radio();
+    uint32_t played = 0;
+    while (true) {
+        sim::ScanTrace trace;
+        uint32_t speedup = 1;
+        uint32_t scan_id = 0;
+        uint64_t start_us = 0;
+        {
+            std::unique_lock<std::recursive_mutex> driver(r.driver_lock);
+            r.started.wait(driver, [&] { return r.scan_id != played; });
+            trace = r.current;
+            speedup = r.current_speedup;
+            scan_id = r.scan_id;
+            start_us = r.start_us;
+        }
+        played = scan_id;
+
+        for (const sim::TracedAP& ap : trace.aps) {
+            sleep_until_us(start_us + ap.offset_us / speedup);
+            std::lock_guard<std::recursive_mutex> driver(r.driver_lock);
+            const std::string ssid(reinterpret_cast<const char*>(ap.result.ssid),
+                                   ap.result.ssid_len);
+            if (!r.ssid_filter.empty() && ssid != r.ssid_filter) {
+                continue;
+            }
+            r.stats.callbacks++;
+            r.callback(r.env, &ap.result);
+        }
+
+        sleep_until_us(start_us + trace.duration_us / speedup);
+        std::unique_lock<std::recursive_mutex> driver(r.driver_lock);
+        r.started.wait(driver, [&] {
+            return r.scan_end == sim::ScanEnd::COMPLETE ||
+                   (r.scan_end == sim::ScanEnd::HANG && r.aborted);
+        });
+        r.aborted = false;
+        r.active = false;
+        if (cyw43_poll) {
+            cyw43_poll();
+        }
+    }
+}
+
+bool parse_bssid(const std::string& text, uint8_t* bssid) {
+    unsigned bytes[6];
+    if (std::sscanf(text.c_str(), "%2x:%2x:%2x:%2x:%2x:%2x", &bytes[0], &bytes[1], &bytes[2],
+                    &bytes[3], &bytes[4], &bytes[5]) != 6) {
+        return false;
+    }
+    for (int i = 0; i < 6; i++) {
+        bssid[i] = static_cast<uint8_t>(bytes[i]);
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Driver API
+// =============================================================================
+
+int cyw43_arch_init() {
+    static StaticTask_t tcb;
+    if (!xTaskGetHandle("async_context_task")) {
+        xTaskCreateStatic(async_context_task, "async_context_task", 0, nullptr, 0, nullptr, &tcb);
+    }
+    cyw43_poll = driver_poll;
+    return 0;
+}
+
+void cyw43_arch_enable_sta_mode() {}
+
+void cyw43_thread_enter() {
+    radio().driver_lock.lock();
+}
+
+void cyw43_thread_exit() {
+    radio().driver_lock.unlock();
+}
+
+int cyw43_wifi_scan(cyw43_t* self, cyw43_wifi_scan_options_t* opts, void* env,
+                    ResultCallback result_cb) {
+    static_cast<void>(self);
+    Radio& r = radio();
+    std::lock_guard<std::recursive_mutex> driver(r.driver_lock);
+    if (r.active) {
+        r.stats.scans_refused++;
+        return -1;   // CYW43 returns -EPERM
+    }
+    {
+        std::lock_guard<std::mutex> traces(r.trace_lock);
+        r.current = r.traces.empty() ? sim::ScanTrace{} : r.traces[r.next_trace];
+        if (!r.traces.empty()) {
+            r.next_trace = (r.next_trace + 1) % r.traces.size();
+        }
+        r.current_speedup = r.speedup;
+    }
+    r.ssid_filter.assign(reinterpret_cast<const char*>(opts->ssid),
+                         std::min<uint32_t>(opts->ssid_len, sizeof(opts->ssid)));
+    r.active = true;
+    r.scan_id++;
+    r.start_us = time_us_64();
+    r.env = env;
+    r.callback = result_cb;
+    r.stats.scans_started++;
+    r.stats.directed_scans += r.ssid_filter.empty() ? 0 : 1;
+    r.stats.passive_scans += opts->scan_type == 1 ? 1 : 0;
+    r.started.notify_all();
+    return 0;
+}
+
+bool cyw43_wifi_scan_active(cyw43_t* self) {
+    static_cast<void>(self);
+    std::lock_guard<std::recursive_mutex> driver(radio().driver_lock);
+    return radio().active;
+}
+
+int cyw43_ioctl(cyw43_t* self, uint32_t cmd, std::size_t len, uint8_t* buf, uint32_t iface) {
+    static_cast<void>(self);
+    static_cast<void>(iface);
+    // WLC_SCAN with the single channel -1 aborts the scan in progress
+    constexpr uint32_t WLC_SET_SCAN = (50 << 1) | 1;
+    if (cmd == WLC_SET_SCAN && len >= 66 && buf[60] == 1 && buf[64] == 0xFF && buf[65] == 0xFF) {
+        Radio& r = radio();
+        std::lock_guard<std::recursive_mutex> driver(r.driver_lock);
+        if (r.active) {
+            r.stats.aborts++;
+            r.aborted = true;
+            r.started.notify_all();
+        }
+    }
+    return 0;
+}
+
+int cyw43_wifi_pm(cyw43_t* self, uint32_t pm) {
+    static_cast<void>(self);
+    static_cast<void>(pm);
+    return 0;
+}
+
+bool cyw43_arch_gpio_get(uint32_t wl_gpio) {
+    // Always on USB power
+    return wl_gpio == CYW43_WL_GPIO_VBUS_PIN;
+}
+
+// =============================================================================
+// Simulation control
+// =============================================================================
+
+namespace sim {
+
+bool parse_traces(const std::string& text, std::vector<ScanTrace>& out, std::string* error) {
+    std::istringstream lines(text);
+    std::string line;
+    int number = 0;
+    const auto fail = [&](const char* what) {
+        if (error) {
+            *error = "line " + std::to_string(number) + ": " + what;
+        }
+        return false;
+    };
+    while (std::getline(lines, line)) {
+        number++;
+        std::istringstream fields(line);
+        std::string kind;
+        if (!(fields >> kind) || kind[0] == '#') {
+            continue;
+        }
+        if (kind == "scan") {
+            ScanTrace scan;
+            if (!(fields >> scan.duration_us)) {
+                return fail("bad scan duration");
+            }
+            out.push_back(scan);
+        } else if (kind == "ap") {
+            if (out.empty()) {
+                return fail("ap before scan");
+            }
+            TracedAP ap{};
+            std::string bssid;
+            int rssi = 0;
+            unsigned channel = 0;
+            unsigned auth = 0;
+            if (!(fields >> ap.offset_us >> bssid >> rssi >> channel >> auth) ||
+                !parse_bssid(bssid, ap.result.bssid)) {
+                return fail("bad ap fields");
+            }
+            std::string ssid;
+            std::getline(fields >> std::ws, ssid);
+            ap.result.rssi = static_cast<int16_t>(rssi);
+            ap.result.channel = static_cast<uint16_t>(channel);
+            ap.result.auth_mode = static_cast<uint8_t>(auth);
+            ap.result.ssid_len = static_cast<uint8_t>(std::min(ssid.size(), sizeof(ap.result.ssid)));
+            std::memcpy(ap.result.ssid, ssid.data(), ap.result.ssid_len);
+            out.back().aps.push_back(ap);
+        } else {
+            return fail("unknown record");
+        }
+    }
+    return true;
+}
+
+void set_traces(std::vector<ScanTrace> traces) {
+    std::lock_guard<std::mutex> guard(radio().trace_lock);
+    radio().traces = std::move(traces);
+    radio().next_trace = 0;
+}
+
+void set_speedup(uint32_t speedup) {
+    std::lock_guard<std::mutex> guard(radio().trace_lock);
+    radio().speedup = std::max<uint32_t>(speedup, 1);
+}
+
+void set_scan_end(ScanEnd end) {
+    std::lock_guard<std::recursive_mutex> driver(radio().driver_lock);
+    radio().scan_end = end;
+    radio().started.notify_all();
+}
+
+RadioStats radio_stats() {
+    std::lock_guard<std::recursive_mutex> driver(radio().driver_lock);
+    return radio().stats;
+}
+
+void reset_radio_stats() {
+    std::lock_guard<std::recursive_mutex> driver(radio().driver_lock);
+    radio().stats = RadioStats{};
+}
+
+} // namespace sim
@@ -0,0 +1,94 @@
+/**
+ * @file sim_cyw43.hpp
+ * @brief Control of the simulated CYW43: scan traces, replay speed and radio counters.
+ *
+ * Each cyw43_wifi_scan() replays the next trace in turn (wrapping
+ * around): the async context thread delivers every AP callback at its
+ * recorded offset from the start of the scan, under the driver lock, then
+ * clears the scan-active flag and runs cyw43_poll at the recorded
+ * duration, as the real driver's event processing does. A directed
+ * (SSID) scan only reports that SSID. CYW43 refuses a scan while one is
+ * active, and so does the simulation; scans_refused counts those.
+ *
+ * Trace text format (one scan after another, tools/pico.py trace writes it):
+ *
+ *   # comment
+ *   scan <duration_us>
+ *   ap <offset_us> <bssid aa:bb:cc:dd:ee:ff> <rssi> <channel> <auth bitmask> <ssid...>
+ */
+
+#ifndef SIM_CYW43_HPP
+#define SIM_CYW43_HPP
+
+#include "pico/cyw43_arch.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sim {
+
+/**
+ * @brief One AP callback of a recorded scan.
+ */
+struct TracedAP {
+    uint32_t offset_us;             ///< Since cyw43_wifi_scan()
+    cyw43_ev_scan_result_t result;
+};
+
+/**
+ * @brief One recorded scan.
+ */
+struct ScanTrace {
+    uint32_t duration_us{0};        ///< Until the driver reported the scan complete
+    std::vector<TracedAP> aps;
+};
+
+/**
+ * @brief Counters of the simulated radio.
+ */
+struct RadioStats {
+    uint32_t scans_started{0};
+    uint32_t scans_refused{0};      ///< cyw43_wifi_scan() while a scan was active
+    uint32_t callbacks{0};          ///< AP callbacks delivered
+    uint32_t directed_scans{0};     ///< Scans with an SSID
+    uint32_t passive_scans{0};
+    uint32_t aborts{0};             ///< WLC_SCAN aborts while a scan was active
+};
+
+/**
+ * @brief How the radio ends a scan once its trace has played.
+ */
+enum class ScanEnd {
+    COMPLETE,       ///< Reports the scan complete (a working radio)
+    HANG,           ///< Stays scanning until aborted
+    WEDGE           ///< Stays scanning, ignoring aborts
+};
+
+/**
+ * @brief Parse a trace file.
+ * @return false, with error describing the first bad line, if it does not parse
+ */
+bool parse_traces(const std::string& text, std::vector<ScanTrace>& out, std::string* error);
+
+/**
+ * @brief Replay these scans from now on (takes effect at the next scan).
+ */
+void set_traces(std::vector<ScanTrace> traces);
+
+/**
+ * @brief Replay speed: recorded times are divided by speedup.
+ */
+void set_speedup(uint32_t speedup);
+
+/**
+ * @brief How scans end from now on. Back to COMPLETE also ends a scan left hanging.
+ */
+void set_scan_end(ScanEnd end);
+
+[[nodiscard]] RadioStats radio_stats();
+void reset_radio_stats();
+
+} // namespace sim
+
+#endif // SIM_CYW43_HPP
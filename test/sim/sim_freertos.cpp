@@ -0,0 +1,383 @@
+/**
+ * @file sim_freertos.cpp
+ * @brief FreeRTOS shim: tasks on std::thread, kernel objects under one lock.
+ *
+ * Every blocking call waits on a single condition variable that any state
+ * change broadcasts. That is slow under heavy contention but trivially
+ * free of lost wakeups, which is what a load test needs from its kernel.
+ *
+ * Kernel state is allocated once and never freed: tasks such as the
+ * scanner loop forever and are still blocked in it when the process exits.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "message_buffer.h"
+#include "pico/time.h"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct tskTaskControlBlock {
+    std::string name;
+    std::array<uint32_t, configTASK_NOTIFICATION_ARRAY_ENTRIES> value{};
+    std::array<bool, configTASK_NOTIFICATION_ARRAY_ENTRIES> pending{};
+};
+
+struct QueueDefinition {
+    std::size_t length;
+    std::size_t item_size;
+    std::deque<std::vector<uint8_t>> items;
+    bool is_mutex;
+    bool held;
+};
+
+struct StreamBufferDef_t {
+    std::size_t capacity;
+    std::size_t used;
+    std::deque<std::vector<uint8_t>> messages;
+};
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Kernel {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::recursive_mutex critical;
+    std::vector<TaskHandle_t> tasks;
+    Clock::time_point start = Clock::now();
+};
+
+Kernel& kernel() {
+    static Kernel* k = new Kernel;
+    return *k;
+}
+
+thread_local TaskHandle_t t_current = nullptr;
+
+/**
+ * @brief Handle of the calling thread, registering threads the shim did not start.
+ */
+TaskHandle_t current_locked() {
+    if (!t_current) {
+        t_current = new tskTaskControlBlock{};
+        t_current->name = "host";
+        kernel().tasks.push_back(t_current);
+    }
+    return t_current;
+}
+
+/**
+ * @brief Wait under the kernel lock until ready() holds or ticks pass.
+ * @return ready()
+ */
+template <typename Ready>
+bool wait_for(std::unique_lock<std::mutex>& guard, TickType_t ticks, Ready ready) {
+    if (ticks == portMAX_DELAY) {
+        kernel().changed.wait(guard, ready);
+        return true;
+    }
+    return kernel().changed.wait_for(guard, std::chrono::milliseconds(ticks), ready);
+}
+
+TaskHandle_t create_task(TaskFunction_t fn, const char* name, void* params) {
+    auto* task = new tskTaskControlBlock{};
+    task->name = name;
+    {
+        std::lock_guard<std::mutex> guard(kernel().lock);
+        kernel().tasks.push_back(task);
+    }
+    std::thread([task, fn, params] {
+        t_current = task;
+        fn(params);
+    }).detach();
+    return task;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Time and critical sections
+// =============================================================================
+
+uint64_t time_us_64() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now() - kernel().start).count());
+}
+
+TickType_t xTaskGetTickCount() {
+    return static_cast<TickType_t>(time_us_64() / 1000);
+}
+
+void sim_enter_critical() {
+    kernel().critical.lock();
+}
+
+void sim_exit_critical() {
+    kernel().critical.unlock();
+}
+
+void vTaskSetTimeOutState(TimeOut_t* timeout) {
+    timeout->entered = xTaskGetTickCount();
+}
+
+BaseType_t xTaskCheckForTimeOut(TimeOut_t* timeout, TickType_t* remaining) {
+    if (*remaining == portMAX_DELAY) {
+        return pdFALSE;
+    }
+    const TickType_t now = xTaskGetTickCount();
+    const TickType_t elapsed = now - timeout->entered;
+    if (elapsed >= *remaining) {
+        *remaining = 0;
+        return pdTRUE;
+    }
+    *remaining -= elapsed;
+    timeout->entered = now;
+    return pdFALSE;
+}
+
+// =============================================================================
+// Tasks
+// =============================================================================
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char* name, uint32_t stack_depth,
+                               void* params, UBaseType_t priority, StackType_t* stack,
+                               StaticTask_t* tcb) {
+    static_cast<void>(stack_depth);
+    static_cast<void>(priority);
+    static_cast<void>(stack);
+    static_cast<void>(tcb);
+    return create_task(fn, name, params);
+}
+
+TaskHandle_t xTaskCreateStaticAffinitySet(TaskFunction_t fn, const char* name,
+                                          uint32_t stack_depth, void* params,
+                                          UBaseType_t priority, StackType_t* stack,
+                                          StaticTask_t* tcb, UBaseType_t affinity) {
+    static_cast<void>(affinity);
+    return xTaskCreateStatic(fn, name, stack_depth, params, priority, stack, tcb);
+}
+
+void vTaskCoreAffinitySet(TaskHandle_t task, UBaseType_t affinity) {
+    static_cast<void>(task);
+    static_cast<void>(affinity);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    // Only self-deletion is supported: the thread just stops running
+    if (task == nullptr || task == t_current) {
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::hours(1));
+        }
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TaskHandle_t xTaskGetHandle(const char* name) {
+    std::lock_guard<std::mutex> guard(kernel().lock);
+    for (TaskHandle_t task : kernel().tasks) {
+        if (task->name == name) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    std::lock_guard<std::mutex> guard(kernel().lock);
+    return current_locked();
+}
+
+// =============================================================================
+// Task notifications
+// =============================================================================
+
+BaseType_t xTaskNotifyIndexed(TaskHandle_t task, UBaseType_t index, uint32_t value,
+                              eNotifyAction action) {
+    std::lock_guard<std::mutex> guard(kernel().lock);
+    uint32_t& slot = task->value[index];
+    BaseType_t result = pdPASS;
+    switch (action) {
+        case eSetBits: slot |= value; break;
+        case eIncrement: slot++; break;
+        case eSetValueWithOverwrite: slot = value; break;
+        case eSetValueWithoutOverwrite:
+            if (task->pending[index]) {
+                result = pdFAIL;
+            } else {
+                slot = value;
+            }
+            break;
+        case eNoAction: break;
+    }
+    task->pending[index] = true;
+    kernel().changed.notify_all();
+    return result;
+}
+
+BaseType_t xTaskNotifyWaitIndexed(UBaseType_t index, uint32_t clear_on_entry,
+                                  uint32_t clear_on_exit, uint32_t* value, TickType_t ticks) {
+    std::unique_lock<std::mutex> guard(kernel().lock);
+    TaskHandle_t self = current_locked();
+    if (!self->pending[index]) {
+        self->value[index] &= ~clear_on_entry;
+    }
+    const bool received = wait_for(guard, ticks, [&] { return self->pending[index]; });
+    if (value) {
+        *value = self->value[index];
+    }
+    if (!received) {
+        return pdFALSE;
+    }
+    self->value[index] &= ~clear_on_exit;
+    self->pending[index] = false;
+    return pdTRUE;
+}
+
+BaseType_t xTaskNotifyStateClearIndexed(TaskHandle_t task, UBaseType_t index) {
+    std::lock_guard<std::mutex> guard(kernel().lock);
+    TaskHandle_t target = task ? task : current_locked();
+    const bool was_pending = target->pending[index];
+    target->pending[index] = false;
+    return was_pending ? pdTRUE : pdFALSE;
+}
+
+uint32_t ulTaskNotifyValueClearIndexed(TaskHandle_t task, UBaseType_t index, uint32_t bits) {
+    std::lock_guard<std::mutex> guard(kernel().lock);
+    TaskHandle_t target = task ? task : current_locked();
+    const uint32_t previous = target->value[index];
+    target->value[index] &= ~bits;
+    return previous;
+}
+
+uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear, TickType_t ticks) {
+    std::unique_lock<std::mutex> guard(kernel().lock);
+    TaskHandle_t self = current_locked();
+    wait_for(guard, ticks, [&] { return self->value[index] != 0; });
+    const uint32_t count = self->value[index];
+    if (count != 0) {
+        self->value[index] = clear ? 0 : count - 1;
+    }
+    self->pending[index] = false;
+    return count;
+}
+
+// =============================================================================
+// Queues and mutexes
+// =============================================================================
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size, uint8_t* storage,
+                                 StaticQueue_t* control) {
+    static_cast<void>(storage);
+    static_cast<void>(control);
+    return new QueueDefinition{length, item_size, {}, false, false};
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    std::unique_lock<std::mutex> guard(kernel().lock);
+    if (!wait_for(guard, ticks, [&] { return queue->items.size() < queue->length; })) {
+        return pdFALSE;
+    }
+    const auto* bytes = static_cast<const uint8_t*>(item);
+    queue->items.emplace_back(bytes, bytes + queue->item_size);
+    kernel().changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+    std::unique_lock<std::mutex> guard(kernel().lock);
+    if (!wait_for(guard, ticks, [&] { return !queue->items.empty(); })) {
+        return pdFALSE;
+    }
+    std::memcpy(item, queue->items.front().data(), queue->item_size);
+    queue->items.pop_front();
+    kernel().changed.notify_all();
+    return pdTRUE;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t* control) {
+    static_cast<void>(control);
+    return new QueueDefinition{1, 0, {}, true, false};
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks) {
+    std::unique_lock<std::mutex> guard(kernel().lock);
+    if (!wait_for(guard, ticks, [&] { return !mutex->held; })) {
+        return pdFALSE;
+    }
+    mutex->held = true;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+    std::lock_guard<std::mutex> guard(kernel().lock);
+    if (!mutex->held) {
+        return pdFALSE;
+    }
+    mutex->held = false;
+    kernel().changed.notify_all();
+    return pdTRUE;
+}
+
+// =============================================================================
+// Message buffers
+// =============================================================================
+
+MessageBufferHandle_t xMessageBufferCreateStatic(std::size_t size, uint8_t* storage,
+                                                 StaticMessageBuffer_t* control) {
+    static_cast<void>(storage);
+    static_cast<void>(control);
+    return new StreamBufferDef_t{size, 0, {}};
+}
+
+std::size_t xMessageBufferSend(MessageBufferHandle_t buffer, const void* data, std::size_t len,
+                               TickType_t ticks) {
+    const std::size_t cost = len + sizeof(std::size_t);
+    std::unique_lock<std::mutex> guard(kernel().lock);
+    if (cost > buffer->capacity ||
+        !wait_for(guard, ticks, [&] { return buffer->capacity - buffer->used >= cost; })) {
+        return 0;
+    }
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    buffer->messages.emplace_back(bytes, bytes + len);
+    buffer->used += cost;
+    kernel().changed.notify_all();
+    return len;
+}
+
+std::size_t xMessageBufferReceive(MessageBufferHandle_t buffer, void* data, std::size_t len,
+                                  TickType_t ticks) {
+    std::unique_lock<std::mutex> guard(kernel().lock);
+    if (!wait_for(guard, ticks, [&] { return !buffer->messages.empty(); })) {
+        return 0;
+    }
+    const std::vector<uint8_t>& message = buffer->messages.front();
+    if (message.size() > len) {
+        return 0;
+    }
+    const std::size_t received = message.size();
+    std::memcpy(data, message.data(), received);
+    buffer->used -= received + sizeof(std::size_t);
+    buffer->messages.pop_front();
+    kernel().changed.notify_all();
+    return received;
+}
+
+void vMessageBufferDelete(MessageBufferHandle_t buffer) {
+    std::lock_guard<std::mutex> guard(kernel().lock);
+    delete buffer;
+}
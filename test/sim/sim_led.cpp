@@ -0,0 +1,17 @@
+/**
+ * @file sim_led.cpp
+ * @brief LED stubs for the simulated scanner (the LED only blinks during scans).
+ */
+
+#include "led.hpp"
+
+namespace led {
+
+bool init() { return true; }
+void on() {}
+void off() {}
+void start_blink(uint32_t interval_ms) { static_cast<void>(interval_ms); }
+void stop_blink() {}
+void show_code(uint8_t count) { static_cast<void>(count); }
+
+} // namespace led
@@ -0,0 +1,54 @@
+/**
+ * @file task.h
+ * @brief Host shim of the FreeRTOS task and task-notification API.
+ */
+
+#ifndef SIM_TASK_H
+#define SIM_TASK_H
+
+#include "FreeRTOS.h"
+
+/// Notification slots per task
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES 3
+
+enum eNotifyAction {
+    eNoAction = 0,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite
+};
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char* name, uint32_t stack_depth,
+                               void* params, UBaseType_t priority, StackType_t* stack,
+                               StaticTask_t* tcb);
+TaskHandle_t xTaskCreateStaticAffinitySet(TaskFunction_t fn, const char* name,
+                                          uint32_t stack_depth, void* params,
+                                          UBaseType_t priority, StackType_t* stack,
+                                          StaticTask_t* tcb, UBaseType_t affinity);
+void vTaskCoreAffinitySet(TaskHandle_t task, UBaseType_t affinity);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+
+TaskHandle_t xTaskGetHandle(const char* name);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+TickType_t xTaskGetTickCount();
+
+BaseType_t xTaskNotifyIndexed(TaskHandle_t task, UBaseType_t index, uint32_t value,
+                              eNotifyAction action);
+BaseType_t xTaskNotifyWaitIndexed(UBaseType_t index, uint32_t clear_on_entry,
+                                  uint32_t clear_on_exit, uint32_t* value, TickType_t ticks);
+BaseType_t xTaskNotifyStateClearIndexed(TaskHandle_t task, UBaseType_t index);
+uint32_t ulTaskNotifyValueClearIndexed(TaskHandle_t task, UBaseType_t index, uint32_t bits);
+uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear, TickType_t ticks);
+
+#define xTaskNotify(task, value, action) xTaskNotifyIndexed(task, 0, value, action)
+#define xTaskNotifyWait(entry, exit, value, ticks) \
+    xTaskNotifyWaitIndexed(0, entry, exit, value, ticks)
+#define xTaskNotifyGive(task) xTaskNotifyIndexed(task, 0, 0, eIncrement)
+#define ulTaskNotifyTake(clear, ticks) ulTaskNotifyTakeIndexed(0, clear, ticks)
+
+void vTaskSetTimeOutState(TimeOut_t* timeout);
+BaseType_t xTaskCheckForTimeOut(TimeOut_t* timeout, TickType_t* remaining);
+
+#endif // SIM_TASK_H
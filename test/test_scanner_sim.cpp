@@ -0,0 +1,345 @@
+/**
+ * @file test_scanner_sim.cpp
+ * @brief Load tests of the real scanner (wifi_scanner.cpp) on the simulated CYW43.
+ *
+ * The scanner, its request queue and callback run unmodified on the
+ * FreeRTOS shim (test/sim), while the simulated radio replays
+ * traces/office.trace SPEEDUP times faster than recorded. Many host
+ * threads then request scans at once, as the scheduler, console and
+ * telemetry tasks do on the device.
+ */
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "sim_cyw43.hpp"
+#include "../src/wifi_scanner.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// A 2.4 s recorded scan replays in about 120 ms
+constexpr uint32_t SPEEDUP = 20;
+
+using Bssid = std::array<uint8_t, BSSID_LEN>;
+
+std::vector<sim::ScanTrace> g_traces;
+
+/**
+ * @brief Load the trace and start the scanner, once for the whole run.
+ */
+void start_scanner() {
+    static const bool started = [] {
+        std::ifstream file(SIM_TRACE_DIR "/office.trace");
+        std::stringstream text;
+        text << file.rdbuf();
+        std::string error;
+        REQUIRE_MESSAGE(sim::parse_traces(text.str(), g_traces, &error), error);
+        REQUIRE(g_traces.size() == 3);
+        sim::set_traces(g_traces);
+        sim::set_speedup(SPEEDUP);
+        REQUIRE(wifi::init());
+        REQUIRE(wifi::start_scanner_task());
+        return true;
+    }();
+    CHECK(started);
+}
+
+/**
+ * @brief Named BSSIDs heard in any trace.
+ */
+std::set<Bssid> traced_bssids() {
+    std::set<Bssid> bssids;
+    for (const sim::ScanTrace& trace : g_traces) {
+        for (const sim::TracedAP& ap : trace.aps) {
+            if (ap.result.ssid_len > 0) {
+                Bssid bssid;
+                std::copy(ap.result.bssid, ap.result.bssid + BSSID_LEN, bssid.begin());
+                bssids.insert(bssid);
+            }
+        }
+    }
+    return bssids;
+}
+
+uint32_t max_trace_ms() {
+    uint32_t longest = 0;
+    for (const sim::ScanTrace& trace : g_traces) {
+        longest = std::max(longest, trace.duration_us / SPEEDUP / 1000);
+    }
+    return longest;
+}
+
+/**
+ * @brief Run fn(i) on n threads at once and wait for all of them.
+ */
+template <typename Fn>
+void run_concurrently(int n, Fn fn) {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < n; i++) {
+        threads.emplace_back(fn, i);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief Wait out any scan still running in the radio.
+ */
+void settle() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(2 * max_trace_ms()));
+}
+
+} // anonymous namespace
+
+TEST_CASE("Scanner on simulated CYW43") {
+    start_scanner();
+    const std::set<Bssid> known = traced_bssids();
+    settle();
+    sim::reset_radio_stats();
+    wifi::reset_stats();
+
+    SUBCASE("one request returns the traced APs") {
+        ScanResult result;
+        REQUIRE(wifi::request_scan(&result, 5000));
+        CHECK(result.success);
+        CHECK(result.count > 20);
+        for (std::size_t i = 0; i < result.count; i++) {
+            CHECK(known.count(result.networks.bssid[i]) == 1);
+        }
+        CHECK(sim::radio_stats().scans_started == 1);
+        const ScanStats stats = wifi::get_stats();
+        CHECK(stats.radio_on.count() == 1);
+        CHECK(stats.radio_on.total_us() >= stats.radio.total_us());
+    }
+
+    SUBCASE("concurrent requesters coalesce onto few scans") {
+        constexpr int REQUESTERS = 24;
+        constexpr int REQUESTS_EACH = 4;
+        std::atomic<int> served{0};
+        run_concurrently(REQUESTERS, [&](int) {
+            ScanResult result;
+            for (int r = 0; r < REQUESTS_EACH; r++) {
+                if (wifi::request_scan(&result, 10000) && result.success && result.count > 20) {
+                    served++;
+                }
+            }
+        });
+
+        const sim::RadioStats radio = sim::radio_stats();
+        const ScanStats stats = wifi::get_stats();
+        CHECK(served == REQUESTERS * REQUESTS_EACH);
+        CHECK(stats.requests == REQUESTERS * REQUESTS_EACH);
+        CHECK(stats.timeouts == 0);
+        // Each requester waits for its own scan, so at best all of them share one
+        CHECK(radio.scans_started >= REQUESTS_EACH);
+        CHECK(radio.scans_started * 4 <= REQUESTERS * REQUESTS_EACH);
+        CHECK(radio.scans_refused == 0);
+        std::ostringstream summary;
+        summary << REQUESTERS * REQUESTS_EACH << " requests served by " << radio.scans_started
+                << " scans, p95 end-to-end " << stats.end_to_end.percentile_us(95) << " us";
+        MESSAGE(summary.str());
+    }
+
+    SUBCASE("a targeted request ends at its match, the next scan waits for the radio") {
+        ScanRequest request;
+        request.set_ssid("Office");
+        request.stop_on_match = true;
+
+        const auto start = std::chrono::steady_clock::now();
+        ScanResult result;
+        REQUIRE(wifi::request_scan(request, &result, 5000));
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        CHECK(result.count >= 1);
+        // "Office" is on channel 1, the first swept
+        CHECK(elapsed < std::chrono::milliseconds(max_trace_ms() / 2));
+
+        // The radio is still finishing that sweep; a full scan must not be refused
+        REQUIRE(wifi::request_scan(&result, 5000));
+        CHECK(result.count > 20);
+        CHECK(sim::radio_stats().scans_refused == 0);
+        CHECK(sim::radio_stats().directed_scans == 1);
+    }
+
+    SUBCASE("an SSID request returns only that network") {
+        ScanRequest request;
+        request.set_ssid("Guest");
+        ScanResult result;
+        REQUIRE(wifi::request_scan(request, &result, 5000));
+        REQUIRE(result.count >= 1);
+        for (std::size_t i = 0; i < result.count; i++) {
+            CHECK(std::string(result.networks[i].ssid.data()) == "Guest");
+        }
+    }
+
+    SUBCASE("a request that times out is never written") {
+        ScanResult busy;
+        std::thread other([&] { CHECK(wifi::request_scan(&busy, 5000)); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        ScanResult result;
+        result.count = 0xBEEF;
+        CHECK_FALSE(wifi::request_scan(&result, 10));
+        other.join();
+        settle();
+        CHECK(result.count == 0xBEEF);
+        CHECK(wifi::get_stats().timeouts == 1);
+    }
+
+    SUBCASE("a stream that times out behind a full batch is never attached") {
+        // Hold the scanner in one hung scan while the queue fills up
+        sim::set_scan_end(sim::ScanEnd::HANG);
+        std::vector<std::thread> requesters;
+        requesters.emplace_back([] {
+            ScanResult result;
+            CHECK(wifi::request_scan(&result, 5000));
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        // Drained after the hung scan, filling its batch; the stream stays queued
+        for (int i = 0; i < 7; i++) {
+            requesters.emplace_back([] {
+                ScanResult result;
+                CHECK(wifi::request_scan(&result, 5000));
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        const auto sink = [](const APInfo&, void*) { return true; };
+        CHECK_FALSE(wifi::scan_async(sink, nullptr, 50));
+        sim::set_scan_end(sim::ScanEnd::COMPLETE);
+        for (std::thread& requester : requesters) {
+            requester.join();
+        }
+        settle();
+
+        // No scan was started for the abandoned stream
+        CHECK(sim::radio_stats().scans_started == 1);
+        CHECK(wifi::get_stats().queue_wait.count() == 1);
+        CHECK(wifi::get_stats().timeouts == 1);
+    }
+
+    SUBCASE("a stream stopped by its sink ends the scan without publishing it") {
+        const uint32_t generation = wifi::latest_scan().generation();
+        const auto sink = [](const APInfo&, void*) { return false; };
+        CHECK(wifi::scan_async(sink, nullptr, 5000));
+        settle();
+
+        // The partial table must not replace the latest full scan
+        const wifi::ScanLease latest = wifi::latest_scan();
+        CHECK((latest.generation() == generation || latest->count > 20));
+        CHECK(sim::radio_stats().scans_started == 1);
+    }
+
+    SUBCASE("streams, leases and copies share scans") {
+        constexpr int EACH = 4;
+        std::atomic<int> streamed_aps{0};
+        std::atomic<int> streams_ok{0};
+        std::atomic<int> leases_ok{0};
+        std::atomic<int> copies_ok{0};
+        run_concurrently(3 * EACH, [&](int i) {
+            if (i % 3 == 0) {
+                const auto sink = [](const APInfo&, void* ctx) {
+                    static_cast<std::atomic<int>*>(ctx)->fetch_add(1);
+                    return true;
+                };
+                streams_ok += wifi::scan_async(sink, &streamed_aps, 10000) ? 1 : 0;
+            } else if (i % 3 == 1) {
+                wifi::ScanLease lease;
+                leases_ok += (wifi::request_scan(lease, 10000) && lease->count > 20 &&
+                              lease.generation() > 0) ? 1 : 0;
+            } else {
+                ScanResult result;
+                copies_ok += (wifi::request_scan(&result, 10000) && result.count > 20) ? 1 : 0;
+            }
+        });
+        CHECK(streams_ok == EACH);
+        CHECK(leases_ok == EACH);
+        CHECK(copies_ok == EACH);
+        CHECK(streamed_aps >= EACH * 20);
+        CHECK(sim::radio_stats().scans_refused == 0);
+    }
+}
+
+TEST_CASE("Hung scans on simulated CYW43") {
+    start_scanner();
+    settle();
+    sim::reset_radio_stats();
+    wifi::reset_stats();
+
+    SUBCASE("a hung scan is aborted and the radio scans again") {
+        sim::set_scan_end(sim::ScanEnd::HANG);
+        ScanResult result;
+        // Delivered as a failed scan, well inside the caller's timeout
+        REQUIRE(wifi::request_scan(&result, 5000));
+        CHECK_FALSE(result.success);
+        CHECK(result.error_code == PICO_ERROR_TIMEOUT);
+        CHECK(sim::radio_stats().aborts == 1);
+        CHECK(wifi::get_stats().aborted_scans == 1);
+        CHECK(wifi::get_stats().wedged_scans == 0);
+
+        sim::set_scan_end(sim::ScanEnd::COMPLETE);
+        REQUIRE(wifi::request_scan(&result, 5000));
+        CHECK(result.success);
+        CHECK(result.count > 20);
+        CHECK(sim::radio_stats().scans_refused == 0);
+    }
+
+    SUBCASE("a wedged radio is counted, and retried once it recovers") {
+        sim::set_scan_end(sim::ScanEnd::WEDGE);
+        ScanResult result;
+        REQUIRE(wifi::request_scan(&result, 5000));
+        CHECK_FALSE(result.success);
+        CHECK(wifi::get_stats().wedged_scans == 1);
+        CHECK(wifi::get_stats().aborted_scans == 0);
+
+        // The next request waits out the wedged scan before starting its own
+        std::thread recover([] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            sim::set_scan_end(sim::ScanEnd::COMPLETE);
+        });
+        REQUIRE(wifi::request_scan(&result, 5000));
+        recover.join();
+        CHECK(result.success);
+        CHECK(result.count > 20);
+        CHECK(sim::radio_stats().scans_refused == 0);
+        CHECK(wifi::get_stats().wedged_scans == 1);
+    }
+    sim::set_scan_end(sim::ScanEnd::COMPLETE);
+}
+
+TEST_CASE("Trace parser") {
+    std::vector<sim::ScanTrace> traces;
+    std::string error;
+
+    SUBCASE("records") {
+        REQUIRE(sim::parse_traces("# header\n"
+                                  "scan 2000000\n"
+                                  "ap 1500 02:00:00:00:00:01 -48 6 4 Cafe Free WiFi\n"
+                                  "ap 1700 02:00:00:00:00:02 -80 11 0\n",
+                                  traces, &error));
+        REQUIRE(traces.size() == 1);
+        CHECK(traces[0].duration_us == 2000000);
+        REQUIRE(traces[0].aps.size() == 2);
+        const cyw43_ev_scan_result_t& ap = traces[0].aps[0].result;
+        CHECK(traces[0].aps[0].offset_us == 1500);
+        CHECK(ap.bssid[5] == 1);
+        CHECK(ap.rssi == -48);
+        CHECK(ap.channel == 6);
+        CHECK(ap.auth_mode == 4);
+        CHECK(std::string(reinterpret_cast<const char*>(ap.ssid), ap.ssid_len) == "Cafe Free WiFi");
+        CHECK(traces[0].aps[1].result.ssid_len == 0);
+    }
+
+    SUBCASE("errors name the line") {
+        CHECK_FALSE(sim::parse_traces("ap 1 02:00:00:00:00:01 -48 6 4 x\n", traces, &error));
+        CHECK(error == "line 1: ap before scan");
+        CHECK_FALSE(sim::parse_traces("scan 10\nap 1 02:00 -48 6 4 x\n", traces, &error));
+        CHECK(error == "line 2: bad ap fields");
+    }
+}
@@ -4,8 +4,32 @@
  */
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <algorithm>
+#include <climits>
+#include <string>
+#include <vector>
 #include "doctest.h"
 #include "../src/scan_msg.hpp"
+#include "../src/scan_request.hpp"
+#include "../src/scan_exchange.hpp"
+#include "../src/scan_schedule.hpp"
+#include "../src/scan_diff.hpp"
+#include "../src/log_ring.hpp"
+#include "../src/log_frame.hpp"
+#include "../src/task_stats.hpp"
+#include "../src/scan_stats.hpp"
+#include "../src/led_pattern.hpp"
+#include "../src/scan_log.hpp"
+#include "../src/known_networks.hpp"
+#include "../src/telemetry_frame.hpp"
+#include "../src/iperf_udp.hpp"
+#include "../src/net_stats.hpp"
+#include "../src/trace_frame.hpp"
+#include "../src/console_format.hpp"
+#include "../src/power_profile.hpp"
+#include "../src/boot_timeline.hpp"
+#include "../src/fingerprint.hpp"
+#include "../src/health_monitor.hpp"
 
 // =============================================================================
 // AuthMode conversion tests
@@ -139,6 +163,7 @@ TEST_CASE("ScanResult") {
         for (int i = 0; i < 5; i++) {
             APInfo ap;
             std::snprintf(ap.ssid.data(), ap.ssid.size(), "Network%d", i);
+            ap.bssid[5] = static_cast<uint8_t>(i);
             [[maybe_unused]] const bool added = result.add(ap);
         }
 
@@ -154,6 +179,7 @@ TEST_CASE("ScanResult") {
         for (size_t i = 0; i < MAX_SCAN_RESULTS; i++) {
             APInfo ap;
             std::snprintf(ap.ssid.data(), ap.ssid.size(), "Network%zu", i);
+            ap.bssid[5] = static_cast<uint8_t>(i);
             bool added = result.add(ap);
             CHECK(added);
         }
@@ -164,6 +190,7 @@ TEST_CASE("ScanResult") {
         // Try to add one more
         APInfo extra;
         std::strcpy(extra.ssid.data(), "Overflow");
+        extra.bssid[0] = 0xFF;
         bool added = result.add(extra);
         CHECK_FALSE(added);
         CHECK(result.count == MAX_SCAN_RESULTS);
@@ -175,6 +202,7 @@ TEST_CASE("ScanResult") {
 
         for (size_t i = 0; i < MAX_SCAN_RESULTS; i++) {
             APInfo ap;
+            ap.bssid[5] = static_cast<uint8_t>(i);
             [[maybe_unused]] const bool added = result.add(ap);
         }
 
@@ -182,6 +210,2127 @@ TEST_CASE("ScanResult") {
     }
 }
 
+// =============================================================================
+// ScanResult BSSID deduplication tests
+// =============================================================================
+
+TEST_CASE("ScanResult deduplication") {
+    APInfo ap;
+    std::strcpy(ap.ssid.data(), "Office");
+    ap.bssid = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+    ap.rssi = -70;
+
+    SUBCASE("repeat BSSID merges") {
+        ScanResult result;
+        CHECK(result.add(ap));
+        CHECK(result.add(ap));
+        CHECK(result.add(ap));
+        CHECK(result.count == 1);
+        CHECK(result.samples[0] == 3);
+    }
+
+    SUBCASE("max merge keeps strongest") {
+        ScanResult result;
+        CHECK(result.add(ap));
+        APInfo stronger = ap;
+        stronger.rssi = -50;
+        CHECK(result.add(stronger));
+        APInfo weaker = ap;
+        weaker.rssi = -90;
+        CHECK(result.add(weaker));
+        CHECK(result.networks[0].rssi == -50);
+    }
+
+    SUBCASE("mean merge averages") {
+        ScanResult result;
+        result.merge = RssiMerge::MEAN;
+        CHECK(result.add(ap));
+        APInfo other = ap;
+        other.rssi = -50;
+        CHECK(result.add(other));
+        CHECK(result.networks[0].rssi == -60);
+    }
+
+    SUBCASE("duplicates merge when full") {
+        ScanResult result;
+        for (size_t i = 0; i < MAX_SCAN_RESULTS; i++) {
+            APInfo entry = ap;
+            entry.bssid[5] = static_cast<uint8_t>(i);
+            CHECK(result.add(entry));
+        }
+        CHECK(result.is_full());
+
+        APInfo repeat = ap;
+        repeat.bssid[5] = 7;
+        CHECK(result.add(repeat));
+        CHECK(result.count == MAX_SCAN_RESULTS);
+        CHECK(result.samples[7] == 2);
+    }
+
+    SUBCASE("same SSID different BSSID kept") {
+        ScanResult result;
+        CHECK(result.add(ap));
+        APInfo other = ap;
+        other.bssid[0] = 0xAA;
+        CHECK(result.add(other));
+        CHECK(result.count == 2);
+    }
+
+    SUBCASE("find") {
+        ScanResult result;
+        CHECK_FALSE(result.find(ap.bssid));
+        CHECK(result.add(ap));
+        const auto found = result.find(ap.bssid);
+        REQUIRE(found);
+        CHECK(strcmp(found->ssid.data(), "Office") == 0);
+    }
+
+    SUBCASE("reset clears index") {
+        ScanResult result;
+        CHECK(result.add(ap));
+        result.reset();
+        CHECK_FALSE(result.find(ap.bssid));
+        CHECK(result.add(ap));
+        CHECK(result.count == 1);
+        CHECK(result.samples[0] == 1);
+    }
+}
+
+// =============================================================================
+// ScanResult top-K eviction tests
+// =============================================================================
+
+namespace {
+
+APInfo make_ap(uint8_t id, int16_t rssi) {
+    APInfo ap;
+    std::snprintf(ap.ssid.data(), ap.ssid.size(), "AP%u", id);
+    ap.bssid = {0x02, 0x00, 0x00, 0x00, static_cast<uint8_t>(id >> 8), static_cast<uint8_t>(id)};
+    ap.rssi = rssi;
+    return ap;
+}
+
+APInfo make_named_ap(const char* ssid) {
+    APInfo ap;
+    std::strncpy(ap.ssid.data(), ssid, MAX_SSID_LEN);
+    return ap;
+}
+
+} // anonymous namespace
+
+TEST_CASE("ScanResult top-K") {
+    SUBCASE("drop new by default") {
+        ScanResult result;
+        for (uint8_t i = 0; i < MAX_SCAN_RESULTS; i++) {
+            CHECK(result.add(make_ap(i, -80)));
+        }
+        CHECK_FALSE(result.add(make_ap(200, -20)));
+        CHECK(result.rejected == 1);
+        CHECK_FALSE(result.find(make_ap(200, 0).bssid));
+    }
+
+    SUBCASE("stronger AP replaces weakest") {
+        ScanResult result;
+        result.policy = FullPolicy::KEEP_STRONGEST;
+        for (uint8_t i = 0; i < MAX_SCAN_RESULTS; i++) {
+            CHECK(result.add(make_ap(i, static_cast<int16_t>(-40 - i))));
+        }
+        // Weakest is id 31 at -71
+        CHECK(result.add(make_ap(200, -50)));
+        CHECK(result.count == MAX_SCAN_RESULTS);
+        CHECK(result.rejected == 0);
+        CHECK(result.replaced == 1);
+        CHECK_FALSE(result.find(make_ap(31, 0).bssid));
+        REQUIRE(result.find(make_ap(200, 0).bssid));
+        CHECK(result.find(make_ap(200, 0).bssid)->rssi == -50);
+    }
+
+    SUBCASE("weaker AP rejected") {
+        ScanResult result;
+        result.policy = FullPolicy::KEEP_STRONGEST;
+        for (uint8_t i = 0; i < MAX_SCAN_RESULTS; i++) {
+            CHECK(result.add(make_ap(i, -60)));
+        }
+        CHECK_FALSE(result.add(make_ap(200, -90)));
+        CHECK_FALSE(result.add(make_ap(201, -60)));
+        CHECK(result.rejected == 2);
+        CHECK(result.replaced == 0);
+    }
+
+    SUBCASE("merged RSSI decides the weakest") {
+        ScanResult result;
+        result.policy = FullPolicy::KEEP_STRONGEST;
+        for (uint8_t i = 0; i < MAX_SCAN_RESULTS; i++) {
+            CHECK(result.add(make_ap(i, -60)));
+        }
+        CHECK_FALSE(result.add(make_ap(100, -70)));
+        // id 0 was at -60; make everyone but id 5 stronger
+        for (uint8_t i = 0; i < MAX_SCAN_RESULTS; i++) {
+            if (i != 5) CHECK(result.add(make_ap(i, -30)));
+        }
+        CHECK(result.add(make_ap(101, -50)));
+        CHECK_FALSE(result.find(make_ap(5, 0).bssid));
+    }
+
+    SUBCASE("keeps exactly the strongest K") {
+        ScanResult result;
+        result.policy = FullPolicy::KEEP_STRONGEST;
+
+        // 200 distinct APs with distinct RSSI in shuffled order
+        std::array<uint8_t, 200> order{};
+        for (size_t i = 0; i < order.size(); i++) order[i] = static_cast<uint8_t>(i);
+        uint32_t seed = 12345;
+        for (size_t i = order.size() - 1; i > 0; i--) {
+            seed = seed * 1103515245u + 12345u;
+            std::swap(order[i], order[(seed >> 16) % (i + 1)]);
+        }
+        for (uint8_t id : order) {
+            // id 199 is strongest
+            [[maybe_unused]] const bool added = result.add(make_ap(id, static_cast<int16_t>(-250 + id)));
+        }
+
+        CHECK(result.count == MAX_SCAN_RESULTS);
+        CHECK(result.rejected + result.replaced == 200 - MAX_SCAN_RESULTS);
+        CHECK(result.replaced > 0);
+        for (unsigned id = 0; id < 200; id++) {
+            const bool kept = result.find(make_ap(static_cast<uint8_t>(id), 0).bssid).has_value();
+            CHECK(kept == (id >= 200 - MAX_SCAN_RESULTS));
+        }
+    }
+
+    SUBCASE("every report at a full table counts, repeats included") {
+        ScanResult result;
+        for (uint8_t i = 0; i < MAX_SCAN_RESULTS; i++) {
+            CHECK(result.add(make_ap(i, -60)));
+        }
+        for (int repeat = 0; repeat < 3; repeat++) {
+            CHECK_FALSE(result.add(make_ap(200, -70)));
+        }
+        CHECK(result.rejected == 3);
+        // A BSSID already in the table merges instead
+        CHECK(result.add(make_ap(0, -50)));
+        CHECK(result.rejected == 3);
+    }
+
+    SUBCASE("reset clears eviction state") {
+        ScanResult result;
+        result.policy = FullPolicy::KEEP_STRONGEST;
+        for (uint8_t i = 0; i <= MAX_SCAN_RESULTS; i++) {
+            [[maybe_unused]] const bool added = result.add(make_ap(i, -60));
+        }
+        result.reset();
+        CHECK(result.rejected == 0);
+        CHECK(result.replaced == 0);
+        CHECK(result.policy == FullPolicy::KEEP_STRONGEST);
+    }
+}
+
+// =============================================================================
+// Packed storage and configurable capacity tests
+// =============================================================================
+
+TEST_CASE("Packed AP storage") {
+    SUBCASE("round trip") {
+        APTable<4> table;
+        APInfo ap;
+        std::strcpy(ap.ssid.data(), "Office");
+        ap.bssid = {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF};
+        ap.rssi = -67;
+        ap.channel = 11;
+        ap.auth = AuthMode::WPA_WPA2_PSK;
+
+        table.set(2, ap);
+        const APInfo out = table[2];
+        CHECK(strcmp(out.ssid.data(), "Office") == 0);
+        CHECK(out.bssid == ap.bssid);
+        CHECK(out.rssi == -67);
+        CHECK(out.channel == 11);
+        CHECK(out.auth == AuthMode::WPA_WPA2_PSK);
+        CHECK(table.ssid_len[2] == 6);
+    }
+
+    SUBCASE("full-length SSID") {
+        APTable<1> table;
+        APInfo ap;
+        std::memset(ap.ssid.data(), 'x', MAX_SSID_LEN);
+        table.set(0, ap);
+        CHECK(table.ssid_len[0] == MAX_SSID_LEN);
+        CHECK(std::strlen(table[0].ssid.data()) == MAX_SSID_LEN);
+    }
+
+    SUBCASE("channel and auth share a byte") {
+        APTable<1> table;
+        APInfo ap;
+        ap.channel = 14;
+        ap.auth = AuthMode::UNKNOWN;
+        table.set(0, ap);
+        CHECK(table.channel(0) == 14);
+        CHECK(table.auth(0) == AuthMode::UNKNOWN);
+    }
+
+    SUBCASE("RSSI saturates") {
+        APTable<1> table;
+        APInfo ap;
+        ap.rssi = -300;
+        table.set(0, ap);
+        CHECK(table[0].rssi == INT8_MIN);
+    }
+
+    SUBCASE("shorter SSID reuses its bytes") {
+        APTable<2> table;
+        table.set(0, make_named_ap("Office-5G"));
+        table.set(1, make_named_ap("Lab"));
+        const std::size_t used = table.ssid_pool_used;
+        table.set(0, make_named_ap("Home"));
+        CHECK(table.ssid_pool_used == used);
+        CHECK(table.ssid(0) == "Home");
+        CHECK(table.ssid(1) == "Lab");
+    }
+
+    SUBCASE("longer SSIDs compact the pool") {
+        APTable<2> table;  // 32-byte pool
+        table.set(0, make_named_ap("aaaaaaaaaaaa"));
+        table.set(1, make_named_ap("bbbbbbbbbbbb"));
+        table.set(0, make_named_ap("cccccccccccccccc"));  // Appends, leaving a gap
+        table.set(1, make_named_ap("dddddddddddddddd"));  // Only fits after compaction
+        CHECK(table.ssid(0) == "cccccccccccccccc");
+        CHECK(table.ssid(1) == "dddddddddddddddd");
+        CHECK(table.ssid_pool_used == 32);
+    }
+
+    SUBCASE("full pool truncates") {
+        APTable<2> table;
+        APInfo ap;
+        std::memset(ap.ssid.data(), 'x', MAX_SSID_LEN);
+        table.set(0, ap);
+        table.set(1, make_named_ap("Office"));
+        CHECK(table.ssid_len[0] == MAX_SSID_LEN);
+        CHECK(table.ssid_len[1] == 0);
+        CHECK(table[1].ssid[0] == '\0');
+    }
+
+    SUBCASE("move and clear") {
+        APTable<2> table;
+        table.set(1, make_named_ap("Lab"));
+        table.move_entry(1, 0);
+        CHECK(table.ssid(0) == "Lab");
+        CHECK(table.ssid_len[1] == 0);
+        table.clear();
+        CHECK(table.ssid_len[0] == 0);
+        CHECK(table.ssid_pool_used == 0);
+    }
+
+    SUBCASE("layout") {
+        using Table = APTable<32>;
+        CHECK(Table::SSID_POOL_SIZE == 32 * SSID_POOL_BYTES_PER_AP);
+        CHECK(sizeof(Table) ==
+              32 * (SSID_POOL_BYTES_PER_AP + sizeof(Table::PoolOffset) + 1 + BSSID_LEN + 2) + sizeof(uint16_t));
+        CHECK(sizeof(APTable<8>::PoolOffset) == 1);
+    }
+}
+
+TEST_CASE("BasicScanResult capacity") {
+    SUBCASE("small table") {
+        BasicScanResult<4> result;
+        CHECK(result.CAPACITY == 4u);
+        for (uint8_t i = 0; i < 4; i++) {
+            CHECK(result.add(make_ap(i, -50)));
+        }
+        CHECK(result.is_full());
+        CHECK_FALSE(result.add(make_ap(9, -50)));
+        CHECK(result.rejected == 1);
+    }
+
+    SUBCASE("index sized to a power of two") {
+        CHECK(BasicScanResult<4>::INDEX_SLOTS == 8u);
+        CHECK(BasicScanResult<20>::INDEX_SLOTS == 64u);
+        CHECK(ScanResult::INDEX_SLOTS == 64u);
+    }
+
+    SUBCASE("smaller than default") {
+        CHECK(sizeof(BasicScanResult<8>) < sizeof(ScanResult));
+    }
+
+    SUBCASE("smaller than an array of APInfo") {
+        CHECK(sizeof(ScanResult) < MAX_SCAN_RESULTS * sizeof(APInfo));
+    }
+
+    SUBCASE("reset empties the SSID pool") {
+        ScanResult result;
+        CHECK(result.add(make_named_ap("Office")));
+        result.reset();
+        CHECK(result.networks.ssid_pool_used == 0);
+    }
+
+    SUBCASE("by_rssi") {
+        ScanResult result;
+        CHECK(result.add(make_ap(0, -70)));
+        CHECK(result.add(make_ap(1, -40)));
+        CHECK(result.add(make_ap(2, -55)));
+        const auto order = result.by_rssi();
+        CHECK(order[0] == 1);
+        CHECK(order[1] == 2);
+        CHECK(order[2] == 0);
+    }
+
+    SUBCASE("index_of") {
+        ScanResult result;
+        CHECK(result.index_of(make_ap(3, 0).bssid) == ScanResult::npos);
+        CHECK(result.add(make_ap(2, -60)));
+        CHECK(result.add(make_ap(3, -60)));
+        CHECK(result.index_of(make_ap(3, 0).bssid) == 1u);
+    }
+}
+
+// =============================================================================
+// ScanRequest tests
+// =============================================================================
+
+TEST_CASE("ScanRequest") {
+    APInfo ap;
+    std::strcpy(ap.ssid.data(), "Office");
+    const uint8_t bssid[] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+    std::memcpy(ap.bssid.data(), bssid, BSSID_LEN);
+    ap.channel = 6;
+
+    SUBCASE("default matches everything") {
+        ScanRequest req;
+        CHECK_FALSE(req.is_targeted());
+        CHECK(req.matches(ap));
+        CHECK(req.mode == ScanMode::ACTIVE);
+        CHECK_FALSE(req.stop_on_match);
+    }
+
+    SUBCASE("ssid filter") {
+        ScanRequest req;
+        req.set_ssid("Office");
+        CHECK(req.is_targeted());
+        CHECK(req.matches(ap));
+        req.set_ssid("Guest");
+        CHECK_FALSE(req.matches(ap));
+    }
+
+    SUBCASE("ssid truncated to max length") {
+        ScanRequest req;
+        req.set_ssid("0123456789012345678901234567890123456789");
+        CHECK(std::strlen(req.ssid.data()) == MAX_SSID_LEN);
+    }
+
+    SUBCASE("bssid set") {
+        ScanRequest req;
+        const uint8_t other[] = {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF};
+        CHECK(req.add_bssid(other));
+        CHECK_FALSE(req.matches(ap));
+        CHECK(req.add_bssid(bssid));
+        CHECK(req.matches(ap));
+    }
+
+    SUBCASE("bssid set capacity") {
+        ScanRequest req;
+        for (size_t i = 0; i < MAX_TARGET_BSSIDS; i++) {
+            CHECK(req.add_bssid(bssid));
+        }
+        CHECK_FALSE(req.add_bssid(bssid));
+        CHECK_FALSE(req.add_bssid(nullptr));
+    }
+
+    SUBCASE("channel list") {
+        ScanRequest req;
+        CHECK(req.add_channel(1));
+        CHECK(req.add_channel(11));
+        CHECK_FALSE(req.matches(ap));
+        CHECK(req.add_channel(6));
+        CHECK(req.matches(ap));
+        CHECK_FALSE(req.add_channel(0));
+        CHECK_FALSE(req.add_channel(MAX_WIFI_CHANNEL + 1));
+    }
+
+    SUBCASE("filters combine") {
+        ScanRequest req;
+        req.set_ssid("Office");
+        CHECK(req.add_channel(1));
+        CHECK_FALSE(req.matches(ap));
+    }
+
+    SUBCASE("covers") {
+        ScanRequest all;
+        ScanRequest office;
+        office.set_ssid("Office");
+        ScanRequest guest;
+        guest.set_ssid("Guest");
+
+        CHECK(all.covers(office));
+        CHECK(office.covers(office));
+        CHECK_FALSE(office.covers(all));
+        CHECK_FALSE(office.covers(guest));
+    }
+
+    SUBCASE("copy_matching") {
+        ScanResult in;
+        in.success = true;
+        for (uint8_t ch = 1; ch <= 3; ch++) {
+            APInfo entry = ap;
+            entry.channel = ch;
+            entry.bssid[5] = ch;
+            [[maybe_unused]] const bool added = in.add(entry);
+        }
+
+        ScanRequest req;
+        CHECK(req.add_channel(2));
+        ScanResult out;
+        copy_matching(in, req, out);
+
+        CHECK(out.success);
+        CHECK(out.count == 1);
+        CHECK(out.networks[0].channel == 2);
+    }
+}
+
+// =============================================================================
+// PingPong tests
+// =============================================================================
+
+TEST_CASE("PingPong") {
+    PingPong<ScanResult> exchange;
+
+    SUBCASE("nothing to lease before first publish") {
+        CHECK(exchange.generation() == 0);
+        CHECK(exchange.acquire() == PingPong<ScanResult>::NO_SLOT);
+        CHECK(exchange.back() != nullptr);
+    }
+
+    SUBCASE("publish hands the back buffer to readers") {
+        ScanResult* back = exchange.back();
+        REQUIRE(back != nullptr);
+        back->success = true;
+        back->count = 0;
+        exchange.publish();
+
+        const uint8_t slot = exchange.acquire();
+        REQUIRE(slot != PingPong<ScanResult>::NO_SLOT);
+        CHECK(&exchange.get(slot) == back);
+        CHECK(exchange.get(slot).success);
+        CHECK(exchange.generation(slot) == 1);
+        CHECK(exchange.back() != back);
+    }
+
+    SUBCASE("readers share the front buffer") {
+        exchange.publish();
+        const uint8_t a = exchange.acquire();
+        const uint8_t b = exchange.acquire();
+        CHECK(a == b);
+        CHECK(exchange.readers(a) == 2);
+        CHECK_FALSE(exchange.release(a));   // still front
+        CHECK_FALSE(exchange.release(b));
+        CHECK(exchange.readers(a) == 0);
+    }
+
+    SUBCASE("leased buffer is not handed back to the writer") {
+        exchange.publish();
+        const uint8_t slot = exchange.acquire();
+        exchange.publish();                 // slot is now the back buffer
+        CHECK(exchange.back() == nullptr);
+        CHECK(exchange.generation(slot) == 1);
+        CHECK(exchange.generation() == 2);
+
+        CHECK(exchange.release(slot));      // frees the back buffer
+        CHECK(&exchange.get(slot) == exchange.back());
+    }
+
+    SUBCASE("new leases follow the latest publish") {
+        exchange.publish();
+        const uint8_t old_slot = exchange.acquire();
+        exchange.publish();
+        const uint8_t new_slot = exchange.acquire();
+        CHECK(new_slot != old_slot);
+        CHECK(exchange.generation(new_slot) == 2);
+        CHECK(exchange.release(old_slot));
+        CHECK_FALSE(exchange.release(new_slot));
+    }
+
+    SUBCASE("stray releases are ignored") {
+        CHECK_FALSE(exchange.release(0));
+        CHECK_FALSE(exchange.release(PingPong<ScanResult>::NO_SLOT));
+        CHECK(exchange.readers(0) == 0);
+    }
+}
+
+// =============================================================================
+// AdaptiveSchedule tests
+// =============================================================================
+
+namespace {
+
+ScanResult make_scan(uint8_t first_id, uint8_t count) {
+    ScanResult result;
+    result.success = true;
+    for (uint8_t id = first_id; id < first_id + count; id++) {
+        [[maybe_unused]] const bool added = result.add(make_ap(id, -60));
+    }
+    return result;
+}
+
+} // anonymous namespace
+
+TEST_CASE("AdaptiveSchedule") {
+    const ScheduleConfig config{.min_interval_ms = 1000, .max_interval_ms = 8000,
+                                .backoff_percent = 200, .change_tolerance = 1};
+    AdaptiveSchedule schedule{config};
+
+    SUBCASE("starts at minimum interval") {
+        CHECK(schedule.interval_ms() == 1000);
+    }
+
+    SUBCASE("first scan counts as changed") {
+        CHECK(schedule.update(make_scan(0, 5)));
+        CHECK(schedule.interval_ms() == 1000);
+    }
+
+    SUBCASE("backs off while stable, capped at maximum") {
+        const ScanResult scan = make_scan(0, 5);
+        schedule.update(scan);
+        CHECK_FALSE(schedule.update(scan));
+        CHECK(schedule.interval_ms() == 2000);
+        schedule.update(scan);
+        schedule.update(scan);
+        CHECK(schedule.interval_ms() == 8000);
+        schedule.update(scan);
+        CHECK(schedule.interval_ms() == 8000);
+        CHECK(schedule.stable_scans() == 4);
+    }
+
+    SUBCASE("RSSI and order changes are stable") {
+        schedule.update(make_scan(0, 5));
+        ScanResult reordered;
+        reordered.success = true;
+        for (uint8_t id = 5; id-- > 0;) {
+            [[maybe_unused]] const bool added = reordered.add(make_ap(id, -80));
+        }
+        CHECK_FALSE(schedule.update(reordered));
+    }
+
+    SUBCASE("changes within tolerance are stable") {
+        schedule.update(make_scan(0, 5));
+        CHECK_FALSE(schedule.update(make_scan(0, 6)));    // one AP appeared
+        CHECK_FALSE(schedule.update(make_scan(0, 5)));    // and left again
+        CHECK(schedule.interval_ms() == 4000);
+    }
+
+    SUBCASE("bigger change resets to minimum") {
+        const ScanResult scan = make_scan(0, 5);
+        schedule.update(scan);
+        schedule.update(scan);
+        schedule.update(scan);
+        CHECK(schedule.interval_ms() == 4000);
+        CHECK(schedule.update(make_scan(1, 5)));         // one left, one new
+        CHECK(schedule.interval_ms() == 1000);
+        CHECK(schedule.stable_scans() == 0);
+    }
+
+    SUBCASE("churn at the edge of a full table is stable") {
+        schedule.update(make_scan(0, MAX_SCAN_RESULTS));
+        for (uint8_t first = 2; first <= 8; first += 2) {
+            CHECK_FALSE(schedule.update(make_scan(first, MAX_SCAN_RESULTS)));  // two out, two in
+        }
+        CHECK(schedule.interval_ms() == 8000);
+        CHECK(schedule.stable_scans() == 4);
+    }
+
+    SUBCASE("low overlap in a full table resets to minimum") {
+        schedule.update(make_scan(0, MAX_SCAN_RESULTS));
+        schedule.update(make_scan(0, MAX_SCAN_RESULTS));
+        CHECK(schedule.update(make_scan(8, MAX_SCAN_RESULTS)));                // 24 of 40 kept
+        CHECK(schedule.interval_ms() == 1000);
+    }
+
+    SUBCASE("full overlap requirement leaves only the tolerance") {
+        ScheduleConfig strict = config;
+        strict.min_overlap_percent = 100;
+        AdaptiveSchedule exact{strict};
+        exact.update(make_scan(0, MAX_SCAN_RESULTS));
+        CHECK(exact.update(make_scan(2, MAX_SCAN_RESULTS)));
+    }
+
+    SUBCASE("failed scans are ignored") {
+        const ScanResult scan = make_scan(0, 5);
+        schedule.update(scan);
+        schedule.update(scan);
+        ScanResult failed;
+        CHECK_FALSE(schedule.update(failed));
+        CHECK(schedule.interval_ms() == 2000);
+        CHECK_FALSE(schedule.update(scan));
+        CHECK(schedule.interval_ms() == 4000);
+    }
+
+    SUBCASE("inconsistent config is sanitized") {
+        AdaptiveSchedule odd{ScheduleConfig{.min_interval_ms = 5000, .max_interval_ms = 100,
+                                            .backoff_percent = 50, .change_tolerance = 0}};
+        const ScanResult scan = make_scan(0, 3);
+        odd.update(scan);
+        odd.update(scan);
+        CHECK(odd.interval_ms() == 5000);
+    }
+}
+
+// =============================================================================
+// ScanDiff tests
+// =============================================================================
+
+namespace {
+
+struct EventLog {
+    std::vector<APEvent> events;
+
+    void operator()(const APEvent& event) { events.push_back(event); }
+
+    [[nodiscard]] std::size_t count(APChange change) const {
+        return static_cast<std::size_t>(std::count_if(events.begin(), events.end(),
+            [change](const APEvent& e) { return e.change == change; }));
+    }
+};
+
+} // anonymous namespace
+
+TEST_CASE("ScanDiff") {
+    ScanDiff diff{DiffConfig{.rssi_threshold_db = 6, .missed_scans = 2}};
+    EventLog log;
+
+    SUBCASE("first scan reports every AP as added") {
+        CHECK(diff.update(make_scan(0, 3), log) == 3);
+        CHECK(log.count(APChange::ADDED) == 3);
+        CHECK(diff.tracked() == 3);
+    }
+
+    SUBCASE("identical scan reports nothing") {
+        diff.update(make_scan(0, 3), log);
+        log.events.clear();
+        CHECK(diff.update(make_scan(0, 3), log) == 0);
+        CHECK(log.events.empty());
+    }
+
+    SUBCASE("RSSI hysteresis against last reported value") {
+        ScanResult scan;
+        scan.success = true;
+        CHECK(scan.add(make_ap(1, -60)));
+        diff.update(scan, log);
+        log.events.clear();
+
+        auto rescan = [&](int16_t rssi) {
+            ScanResult next;
+            next.success = true;
+            CHECK(next.add(make_ap(1, rssi)));
+            return diff.update(next, log);
+        };
+
+        CHECK(rescan(-63) == 0);    // noise
+        CHECK(rescan(-57) == 0);
+        CHECK(rescan(-65) == 0);    // 5 dB from -60
+        CHECK(rescan(-66) == 1);    // drift adds up to the threshold
+        REQUIRE(log.events.size() == 1);
+        CHECK(log.events[0].change == APChange::RSSI_CHANGED);
+        CHECK(log.events[0].ap.rssi == -66);
+        CHECK(log.events[0].previous_rssi == -60);
+        CHECK(rescan(-62) == 0);    // 4 dB from the new reference
+    }
+
+    SUBCASE("removal needs consecutive misses") {
+        diff.update(make_scan(0, 3), log);
+        log.events.clear();
+
+        CHECK(diff.update(make_scan(0, 2), log) == 0);   // first miss
+        CHECK(diff.update(make_scan(0, 3), log) == 0);   // back, resets
+        CHECK(diff.update(make_scan(0, 2), log) == 0);
+        CHECK(diff.update(make_scan(0, 2), log) == 1);
+        REQUIRE(log.events.size() == 1);
+        CHECK(log.events[0].change == APChange::REMOVED);
+        CHECK(log.events[0].ap.bssid[5] == 2);
+        CHECK(diff.tracked() == 2);
+    }
+
+    SUBCASE("removed AP is added again when it returns") {
+        diff.update(make_scan(0, 2), log);
+        diff.update(make_scan(0, 1), log);
+        diff.update(make_scan(0, 1), log);
+        log.events.clear();
+        CHECK(diff.update(make_scan(0, 2), log) == 1);
+        CHECK(log.count(APChange::ADDED) == 1);
+    }
+
+    SUBCASE("failed scan is ignored") {
+        diff.update(make_scan(0, 3), log);
+        log.events.clear();
+        ScanResult failed;
+        CHECK(diff.update(failed, log) == 0);
+        CHECK(diff.update(failed, log) == 0);
+        CHECK(diff.tracked() == 3);
+    }
+
+    SUBCASE("full tracker evicts the longest-missing AP") {
+        BasicScanDiff<3> small{DiffConfig{.rssi_threshold_db = 6, .missed_scans = 3}};
+        small.update(make_scan(0, 3), log);
+        small.update(make_scan(1, 2), log);   // id 0 missing once
+        log.events.clear();
+
+        CHECK(small.update(make_scan(1, 3), log) == 2);   // id 3 needs room
+        CHECK(log.count(APChange::REMOVED) == 1);
+        CHECK(log.count(APChange::ADDED) == 1);
+        CHECK(log.events[0].ap.bssid[5] == 0);
+        CHECK(small.tracked() == 3);
+    }
+
+    SUBCASE("change markers") {
+        CHECK(ap_change_marker(APChange::ADDED) == '+');
+        CHECK(ap_change_marker(APChange::REMOVED) == '-');
+        CHECK(ap_change_marker(APChange::RSSI_CHANGED) == '~');
+    }
+}
+
+// =============================================================================
+// LogRing tests
+// =============================================================================
+
+TEST_CASE("LogRing") {
+    LogRing<uint32_t, 4> ring;
+    uint32_t value = 0;
+
+    SUBCASE("starts empty") {
+        CHECK_FALSE(ring.try_pop(value));
+        CHECK(ring.take_dropped() == 0);
+        CHECK(ring.capacity() == 4);
+    }
+
+    SUBCASE("FIFO order") {
+        CHECK(ring.try_push(1));
+        CHECK(ring.try_push(2));
+        CHECK(ring.try_pop(value));
+        CHECK(value == 1);
+        CHECK(ring.try_pop(value));
+        CHECK(value == 2);
+        CHECK_FALSE(ring.try_pop(value));
+    }
+
+    SUBCASE("full ring drops and counts new records") {
+        for (uint32_t i = 0; i < 4; i++) {
+            CHECK(ring.try_push(i));
+        }
+        CHECK_FALSE(ring.try_push(99));
+        CHECK_FALSE(ring.try_push(99));
+        CHECK(ring.take_dropped() == 2);
+        CHECK(ring.take_dropped() == 0);
+
+        CHECK(ring.try_pop(value));
+        CHECK(value == 0);      // oldest kept, not overwritten
+    }
+
+    SUBCASE("reports the empty to non-empty transition") {
+        bool was_empty = false;
+        CHECK(ring.try_push(1, was_empty));
+        CHECK(was_empty);
+        CHECK(ring.try_push(2, was_empty));
+        CHECK_FALSE(was_empty);
+        CHECK(ring.try_pop(value));
+        CHECK(ring.try_push(3, was_empty));
+        CHECK_FALSE(was_empty);   // 2 not taken yet
+        CHECK(ring.try_pop(value));
+        CHECK(ring.try_pop(value));
+        CHECK(ring.try_push(4, was_empty));
+        CHECK(was_empty);
+    }
+
+    SUBCASE("wraps around") {
+        for (uint32_t i = 0; i < 10; i++) {
+            CHECK(ring.try_push(i));
+            CHECK(ring.try_pop(value));
+            CHECK(value == i);
+        }
+        CHECK(ring.take_dropped() == 0);
+    }
+}
+
+// =============================================================================
+// Log frame tests
+// =============================================================================
+
+namespace {
+
+std::vector<uint8_t> cobs_decode(const uint8_t* in, std::size_t len) {
+    std::vector<uint8_t> out;
+    std::size_t i = 0;
+    while (i < len) {
+        const uint8_t code = in[i++];
+        for (uint8_t k = 1; k < code; k++) {
+            out.push_back(in[i++]);
+        }
+        if (code != 0xFF && i < len) {
+            out.push_back(0);
+        }
+    }
+    return out;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Log frame encoding") {
+    std::array<uint8_t, dlog_frame::MAX_FRAME> frame{};
+
+    SUBCASE("varint") {
+        std::array<uint8_t, dlog_frame::MAX_VARINT> buf{};
+        CHECK(dlog_frame::put_varint(buf.data(), 0) == 1);
+        CHECK(buf[0] == 0);
+        CHECK(dlog_frame::put_varint(buf.data(), 300) == 2);
+        CHECK(buf[0] == 0xAC);
+        CHECK(buf[1] == 0x02);
+        CHECK(dlog_frame::put_varint(buf.data(), UINT32_MAX) == dlog_frame::MAX_VARINT);
+    }
+
+    SUBCASE("COBS removes zeros and terminates the frame") {
+        const std::array<uint8_t, 4> in{0x11, 0x00, 0x00, 0x22};
+        const std::size_t n = dlog_frame::cobs_encode(in.data(), in.size(), frame.data());
+        CHECK(n == in.size() + 2);
+        CHECK(std::count(frame.begin(), frame.begin() + n - 1, 0) == 0);
+        CHECK(frame[n - 1] == 0);
+        const auto decoded = cobs_decode(frame.data(), n - 1);
+        CHECK(std::equal(decoded.begin(), decoded.end(), in.begin(), in.end()));
+    }
+
+    SUBCASE("COBS handles long zero-free runs") {
+        std::array<uint8_t, 300> in{};
+        std::fill(in.begin(), in.end(), 0x5A);
+        std::array<uint8_t, 310> out{};
+        const std::size_t n = dlog_frame::cobs_encode(in.data(), in.size(), out.data());
+        CHECK(n == in.size() + 3);
+        const auto decoded = cobs_decode(out.data(), n - 1);
+        CHECK(std::equal(decoded.begin(), decoded.end(), in.begin(), in.end()));
+    }
+
+    SUBCASE("record layout") {
+        const std::array<uint32_t, 2> args{5, 0xFFFFFFFF};
+        const std::size_t n = dlog_frame::encode(42, 1000, 1, args.data(), args.size(),
+                                                 frame.data());
+        CHECK(n <= dlog_frame::MAX_FRAME);
+        const auto payload = cobs_decode(frame.data(), n - 1);
+        REQUIRE(payload.size() == 1 + 1 + 2 + 1 + 5);
+        CHECK((payload[0] & 0x07) == 2);                        // nargs
+        CHECK(((payload[0] >> 3) & 0x03) == 1);                 // core
+        CHECK((payload[0] >> 5) == dlog_frame::VERSION);
+        CHECK(payload[1] == 42);                                // id
+        CHECK(payload[2] == 0xE8);                              // tick 1000
+        CHECK(payload[3] == 0x07);
+        CHECK(payload[4] == 5);
+    }
+
+    SUBCASE("worst case fits MAX_FRAME") {
+        std::array<uint32_t, dlog_frame::MAX_ARGS> args{};
+        args.fill(UINT32_MAX);
+        const std::size_t n = dlog_frame::encode(UINT32_MAX, UINT32_MAX, 3, args.data(),
+                                                 args.size(), frame.data());
+        CHECK(n == dlog_frame::MAX_FRAME);
+    }
+}
+
+// =============================================================================
+// Trace frame tests
+// =============================================================================
+
+TEST_CASE("Trace frame encoding") {
+    std::array<uint8_t, trace_frame::MAX_FRAME> frame{};
+
+    SUBCASE("start") {
+        const std::size_t n = trace_frame::encode_start(7, trace_frame::FLAG_PASSIVE, 300,
+                                                        frame.data());
+        const auto payload = cobs_decode(frame.data(), n - 1);
+        REQUIRE(payload.size() == 2 + 1 + 2);
+        CHECK((payload[0] & 0x0F) == trace_frame::KIND_START);
+        CHECK((payload[0] >> 5) == trace_frame::VERSION);
+        CHECK(payload[1] == 7);
+        CHECK(payload[2] == trace_frame::FLAG_PASSIVE);
+        CHECK(payload[3] == 0xAC);                              // 300
+        CHECK(payload[4] == 0x02);
+    }
+
+    SUBCASE("AP keeps the raw callback") {
+        const uint8_t bssid[6] = {0x02, 0x1A, 0x00, 0x00, 0x00, 0x01};
+        const uint8_t ssid[] = "Cafe";
+        const trace_frame::TracedAp ap{5, bssid, -48, 6, 0x04, ssid, 4};
+        const std::size_t n = trace_frame::encode_ap(200, ap, frame.data());
+        CHECK(frame[n - 1] == 0);
+        const auto payload = cobs_decode(frame.data(), n - 1);
+        REQUIRE(payload.size() == 2 + 1 + 6 + 3 + 1 + 4);
+        CHECK((payload[0] & 0x0F) == trace_frame::KIND_AP);
+        CHECK(payload[1] == 200);
+        CHECK(payload[2] == 5);                                 // offset
+        CHECK(std::equal(bssid, bssid + 6, payload.begin() + 3));
+        CHECK(static_cast<int8_t>(payload[9]) == -48);
+        CHECK(payload[10] == 6);
+        CHECK(payload[11] == 0x04);
+        CHECK(payload[12] == 4);
+        CHECK(std::string(payload.begin() + 13, payload.end()) == "Cafe");
+    }
+
+    SUBCASE("hidden network") {
+        const uint8_t bssid[6] = {};
+        const trace_frame::TracedAp ap{0, bssid, -90, 11, 0, nullptr, 0};
+        const std::size_t n = trace_frame::encode_ap(0, ap, frame.data());
+        const auto payload = cobs_decode(frame.data(), n - 1);
+        REQUIRE(payload.size() == 2 + 1 + 6 + 3 + 1);
+        CHECK(payload.back() == 0);
+    }
+
+    SUBCASE("end") {
+        const std::size_t n = trace_frame::encode_end(1, 1000000, frame.data());
+        const auto payload = cobs_decode(frame.data(), n - 1);
+        REQUIRE(payload.size() == 2 + 3);
+        CHECK((payload[0] & 0x0F) == trace_frame::KIND_END);
+    }
+
+    SUBCASE("worst case fits MAX_FRAME") {
+        const uint8_t bssid[6] = {1, 2, 3, 4, 5, 6};
+        std::array<uint8_t, 40> ssid{};
+        ssid.fill('x');
+        const trace_frame::TracedAp ap{UINT32_MAX, bssid, -1, 14, 0xFF, ssid.data(), ssid.size()};
+        const std::size_t n = trace_frame::encode_ap(255, ap, frame.data());
+        CHECK(n == trace_frame::MAX_FRAME);
+        const auto payload = cobs_decode(frame.data(), n - 1);
+        CHECK(payload[2 + 5 + 6 + 3] == trace_frame::MAX_SSID);
+    }
+}
+
+// =============================================================================
+// Console formatting tests
+// =============================================================================
+
+namespace {
+
+APInfo make_console_ap(const char* ssid, int16_t rssi, uint8_t channel, AuthMode auth) {
+    APInfo ap;
+    std::strncpy(ap.ssid.data(), ssid, MAX_SSID_LEN);
+    ap.bssid = {0x24, 0xC9, 0xA1, 0x5C, 0x27, 0x98};
+    ap.rssi = rssi;
+    ap.channel = channel;
+    ap.auth = auth;
+    return ap;
+}
+
+std::string console_text(const ConsoleBuffer<1024>& out) {
+    return std::string(out.data(), out.size());
+}
+
+} // anonymous namespace
+
+TEST_CASE("Console formatting") {
+    ConsoleBuffer<1024> out;
+
+    SUBCASE("integers") {
+        out.put_uint(0);
+        out.put(' ');
+        out.put_uint(UINT32_MAX);
+        out.put(' ');
+        out.put_int(-45, 5);
+        out.put(' ');
+        out.put_int(INT32_MIN);
+        out.put(' ');
+        out.put_uint(7, 3);
+        CHECK(console_text(out) == "0 4294967295   -45 -2147483648   7");
+    }
+
+    SUBCASE("table rows match the printf layout") {
+        const APInfo aps[] = {
+            make_console_ap("MyNetwork", -45, 6, AuthMode::WPA2_PSK),
+            make_console_ap("Neighbor_WiFi", -100, 11, AuthMode::WPA_WPA2_PSK),
+            make_console_ap("abcdefghijklmnopqrstuvwxyz012345", -7, 1, AuthMode::OPEN),
+            make_console_ap("x", 0, 14, AuthMode::UNKNOWN),
+        };
+        for (const APInfo& ap : aps) {
+            for (int32_t previous : {NO_PREVIOUS_RSSI, -60}) {
+                out.clear();
+                REQUIRE(append_ap(out, ConsoleFormat::TABLE, '~', ap, previous));
+                char bssid[18];
+                ap.format_bssid(bssid, sizeof(bssid));
+                char note[24] = "";
+                if (previous != NO_PREVIOUS_RSSI) {
+                    std::snprintf(note, sizeof(note), "(was %ddBm)", static_cast<int>(previous));
+                }
+                char expected[128];
+                std::snprintf(expected, sizeof(expected), "  %c %-32s  %s  ch%2u  %4ddBm  %-9s %s\n",
+                              '~', ap.ssid.data(), bssid, ap.channel, ap.rssi,
+                              auth_mode_to_string(ap.auth), note);
+                CHECK(console_text(out) == expected);
+            }
+        }
+    }
+
+    SUBCASE("CSV quotes only when needed") {
+        REQUIRE(append_csv_header(out));
+        REQUIRE(append_ap(out, ConsoleFormat::CSV, '+',
+                          make_console_ap("Office", -45, 6, AuthMode::WPA2_PSK)));
+        REQUIRE(append_ap(out, ConsoleFormat::CSV, '~',
+                          make_console_ap("Bob's \"5G\", upstairs", -50, 36, AuthMode::WPA3_PSK), -62));
+        CHECK(console_text(out) ==
+              "type,marker,ssid,bssid,channel,rssi,auth,was\n"
+              "ap,+,Office,24:C9:A1:5C:27:98,6,-45,WPA2,\n"
+              "ap,~,\"Bob's \"\"5G\"\", upstairs\",24:C9:A1:5C:27:98,36,-50,WPA3,-62\n");
+    }
+
+    SUBCASE("JSON lines escape SSIDs") {
+        REQUIRE(append_ap(out, ConsoleFormat::JSON_LINES, '-',
+                          make_console_ap("a\"b\\c\x01", -70, 1, AuthMode::OPEN)));
+        REQUIRE(append_ap(out, ConsoleFormat::JSON_LINES, '~',
+                          make_console_ap("Office", -45, 6, AuthMode::WPA2_PSK), -60));
+        CHECK(console_text(out) ==
+              "{\"type\":\"ap\",\"marker\":\"-\",\"ssid\":\"a\\\"b\\\\c\\u0001\","
+              "\"bssid\":\"24:C9:A1:5C:27:98\",\"channel\":1,\"rssi\":-70,\"auth\":\"OPEN\"}\n"
+              "{\"type\":\"ap\",\"marker\":\"~\",\"ssid\":\"Office\","
+              "\"bssid\":\"24:C9:A1:5C:27:98\",\"channel\":6,\"rssi\":-45,\"auth\":\"WPA2\",\"was\":-60}\n");
+    }
+
+    SUBCASE("scan summaries") {
+        REQUIRE(append_scan_summary(out, ConsoleFormat::TABLE, 12, true));
+        REQUIRE(append_scan_summary(out, ConsoleFormat::TABLE, 3, false));
+        REQUIRE(append_scan_summary(out, ConsoleFormat::CSV, 3, false));
+        REQUIRE(append_scan_summary(out, ConsoleFormat::JSON_LINES, 12, true));
+        CHECK(console_text(out) ==
+              "--- Scan: 12 networks, AP set changed ---\n"
+              "--- Scan: 3 networks ---\n"
+              "scan,3,stable\n"
+              "{\"type\":\"scan\",\"networks\":12,\"changed\":true}\n");
+    }
+
+    SUBCASE("location lines") {
+        // 4.5 dB is 1152/256; 1.96 dB rounds to 2.0
+        REQUIRE(append_location(out, ConsoleFormat::TABLE, "Kitchen", 1152, 7));
+        REQUIRE(append_location(out, ConsoleFormat::TABLE, nullptr, 0, 0));
+        REQUIRE(append_location(out, ConsoleFormat::CSV, "Hall, east", 502, 3));
+        REQUIRE(append_location(out, ConsoleFormat::CSV, nullptr, 0, 0));
+        REQUIRE(append_location(out, ConsoleFormat::JSON_LINES, "Kitchen", 1152, 7));
+        REQUIRE(append_location(out, ConsoleFormat::JSON_LINES, nullptr, 0, 0));
+        CHECK(console_text(out) ==
+              "--- Location: Kitchen (4.5 dB RMS over 7 APs) ---\n"
+              "--- Location: unknown ---\n"
+              "location,\"Hall, east\",2.0,3\n"
+              "location,,,0\n"
+              "{\"type\":\"location\",\"name\":\"Kitchen\",\"rms_db\":4.5,\"common\":7}\n"
+              "{\"type\":\"location\",\"name\":null}\n");
+    }
+
+    SUBCASE("a row that does not fit is not written") {
+        ConsoleBuffer<100> small;
+        const APInfo ap = make_console_ap("MyNetwork", -45, 6, AuthMode::WPA2_PSK);
+        REQUIRE(append_ap(small, ConsoleFormat::TABLE, '+', ap));
+        const std::size_t one_row = small.size();
+        CHECK_FALSE(append_ap(small, ConsoleFormat::TABLE, '+', ap));
+        CHECK(small.size() == one_row);
+        CHECK_FALSE(small.overflowed());
+    }
+
+    SUBCASE("whole scans and headings") {
+        ScanResult scan;
+        for (uint8_t i = 0; i < 3; i++) {
+            APInfo ap = make_console_ap("Net", static_cast<int16_t>(-40 - i), 6, AuthMode::WPA2_PSK);
+            ap.bssid[5] = i;
+            REQUIRE(scan.add(ap));
+        }
+        CHECK(append_scan(out, ConsoleFormat::CSV, '*', scan) == 3);
+        REQUIRE(out.prepend("head\n", 5));
+        const std::string text = console_text(out);
+        CHECK(text.substr(0, 27) == "head\nap,*,Net,24:C9:A1:5C:2");
+        CHECK(std::count(text.begin(), text.end(), '\n') == 4);
+
+        ConsoleBuffer<100> small;
+        CHECK(append_scan(small, ConsoleFormat::CSV, '*', scan) == 2);
+        CHECK_FALSE(small.prepend(text.data(), text.size()));
+    }
+}
+
+// =============================================================================
+// Task run-time accounting tests
+// =============================================================================
+
+TEST_CASE("RunTimeDelta") {
+    RunTimeDelta<2> run_time;
+
+    SUBCASE("per_mille") {
+        CHECK(per_mille(0, 0) == 0);
+        CHECK(per_mille(1, 3) == 333);
+        CHECK(per_mille(5, 5) == 1000);
+        CHECK(per_mille(7, 5) == 1000);
+    }
+
+    SUBCASE("reports the counter's growth between reports") {
+        run_time.begin();
+        CHECK(run_time.sample(1, 100) == 100);
+        run_time.begin();
+        CHECK(run_time.sample(1, 150) == 50);
+        run_time.begin();
+        CHECK(run_time.sample(1, 150) == 0);
+    }
+
+    SUBCASE("deleted tasks free their slot after one missed report") {
+        run_time.begin();
+        CHECK(run_time.sample(1, 10) == 10);
+        CHECK(run_time.sample(2, 20) == 20);
+        run_time.begin();
+        CHECK(run_time.sample(1, 15) == 5);
+        // Task 2 missed only this report, so its slot is still held
+        CHECK(run_time.sample(3, 30) == 30);
+        run_time.begin();
+        CHECK(run_time.sample(1, 16) == 1);
+        CHECK(run_time.sample(3, 40) == 40);
+        run_time.begin();
+        CHECK(run_time.sample(3, 45) == 5);
+    }
+}
+
+// =============================================================================
+// Scan latency histogram tests
+// =============================================================================
+
+TEST_CASE("LatencyHistogram") {
+    LatencyHistogram hist;
+
+    SUBCASE("power-of-two buckets") {
+        CHECK(LatencyHistogram::bucket_of(0) == 0);
+        CHECK(LatencyHistogram::bucket_of(1023) == 0);
+        CHECK(LatencyHistogram::bucket_of(1024) == 1);
+        CHECK(LatencyHistogram::bucket_of(2047) == 1);
+        CHECK(LatencyHistogram::bucket_of(2048) == 2);
+        CHECK(LatencyHistogram::bucket_of(UINT32_MAX) == LatencyHistogram::BUCKETS - 1);
+        for (std::size_t i = 0; i + 1 < LatencyHistogram::BUCKETS; i++) {
+            const uint32_t limit = LatencyHistogram::bucket_limit_us(i);
+            CHECK(LatencyHistogram::bucket_of(limit - 1) == i);
+            CHECK(LatencyHistogram::bucket_of(limit) == i + 1);
+        }
+        // A request at the 30 s default timeout still lands in a bucket of its own
+        CHECK(LatencyHistogram::bucket_of(30000000) == LatencyHistogram::BUCKETS - 1);
+        CHECK(LatencyHistogram::bucket_of(10000000) < LatencyHistogram::BUCKETS - 1);
+    }
+
+    SUBCASE("empty") {
+        CHECK(hist.count() == 0);
+        CHECK(hist.mean_us() == 0);
+        CHECK(hist.percentile_us(50) == 0);
+    }
+
+    SUBCASE("summary") {
+        hist.record(500);
+        hist.record(1500);
+        hist.record(3000);
+        hist.record(3500);
+        CHECK(hist.count() == 4);
+        CHECK(hist.min_us() == 500);
+        CHECK(hist.max_us() == 3500);
+        CHECK(hist.mean_us() == 2125);
+        CHECK(hist.total_us() == 8500);
+        CHECK(hist.bucket_count(0) == 1);
+        CHECK(hist.bucket_count(1) == 1);
+        CHECK(hist.bucket_count(2) == 2);
+    }
+
+    SUBCASE("percentiles are bucket edges capped at the maximum") {
+        for (int i = 0; i < 90; i++) {
+            hist.record(100);
+        }
+        for (int i = 0; i < 10; i++) {
+            hist.record(5000);
+        }
+        CHECK(hist.percentile_us(50) == 1024);
+        CHECK(hist.percentile_us(90) == 1024);
+        CHECK(hist.percentile_us(95) == 5000);
+        CHECK(hist.percentile_us(100) == 5000);
+    }
+
+    SUBCASE("elapsed_us saturates") {
+        CHECK(elapsed_us(10, 25) == 15);
+        CHECK(elapsed_us(25, 10) == 0);
+        CHECK(elapsed_us(0, uint64_t{1} << 40) == UINT32_MAX);
+    }
+}
+
+// =============================================================================
+// LED pattern tests
+// =============================================================================
+
+namespace {
+
+/**
+ * @brief Number of off-to-on transitions in one pattern cycle.
+ */
+int flashes(uint32_t bits) {
+    int count = 0;
+    bool previous = pattern_level(bits, (PATTERN_SLOTS - 1) * PATTERN_SLOT_MS);
+    for (uint32_t slot = 0; slot < PATTERN_SLOTS; slot++) {
+        const bool level = pattern_level(bits, slot * PATTERN_SLOT_MS);
+        count += level && !previous;
+        previous = level;
+    }
+    return count;
+}
+
+} // anonymous namespace
+
+TEST_CASE("LED patterns") {
+    SUBCASE("blink is even and wraps cleanly") {
+        CHECK(blink_bits(50) == 0x55555555u);
+        CHECK(blink_bits(100) == 0x33333333u);
+        CHECK(blink_bits(800) == 0x0000FFFFu);
+        // Rounded down to a power of two slots, clamped to the cycle
+        CHECK(blink_bits(150) == blink_bits(100));
+        CHECK(blink_bits(10) == blink_bits(50));
+        CHECK(blink_bits(5000) == blink_bits(800));
+        CHECK(std::popcount(blink_bits(200)) == PATTERN_SLOTS / 2);
+    }
+
+    SUBCASE("heartbeat is a double pulse") {
+        CHECK(flashes(heartbeat_bits()) == 2);
+        CHECK(pattern_level(heartbeat_bits(), 0));
+        CHECK_FALSE(pattern_level(heartbeat_bits(), 150));
+        CHECK(pattern_level(heartbeat_bits(), 250));
+        CHECK_FALSE(pattern_level(heartbeat_bits(), 1000));
+    }
+
+    SUBCASE("flash codes count and pause") {
+        for (uint8_t n = 1; n <= MAX_FLASH_CODE; n++) {
+            CHECK(flashes(flash_code_bits(n)) == n);
+            // Dark for the last 400 ms before repeating
+            CHECK((flash_code_bits(n) >> (PATTERN_SLOTS - 8)) == 0);
+        }
+        CHECK(flash_code_bits(0) == flash_code_bits(1));
+        CHECK(flash_code_bits(MAX_FLASH_CODE + 1) == flash_code_bits(MAX_FLASH_CODE));
+    }
+
+    SUBCASE("pattern_level repeats every cycle") {
+        const uint32_t cycle = PATTERN_SLOTS * PATTERN_SLOT_MS;
+        CHECK(pattern_level(heartbeat_bits(), cycle) == pattern_level(heartbeat_bits(), 0));
+        CHECK(pattern_level(0xFFFFFFFFu, 12345));
+        CHECK_FALSE(pattern_level(0, 12345));
+    }
+}
+
+// =============================================================================
+// Scan flash log tests
+// =============================================================================
+
+namespace {
+
+/**
+ * @brief NOR flash in RAM: programming can only clear bits, erase sets a sector to 0xFF.
+ */
+struct RamFlash {
+    static constexpr std::size_t SECTOR_SIZE = 4096;
+    static constexpr std::size_t PAGE_SIZE = 256;
+
+    explicit RamFlash(std::size_t sector_count)
+        : data(sector_count * SECTOR_SIZE, 0xFF), erase_counts(sector_count, 0) {}
+
+    std::size_t sectors() const { return erase_counts.size(); }
+
+    void read(std::size_t offset, uint8_t* out, std::size_t len) {
+        std::copy_n(data.begin() + static_cast<std::ptrdiff_t>(offset), len, out);
+    }
+
+    bool erase_sector(std::size_t sector) {
+        std::fill_n(data.begin() + static_cast<std::ptrdiff_t>(sector * SECTOR_SIZE),
+                    SECTOR_SIZE, 0xFF);
+        erase_counts[sector]++;
+        return true;
+    }
+
+    bool program(std::size_t offset, const uint8_t* in, std::size_t len) {
+        REQUIRE(offset % PAGE_SIZE == 0);
+        REQUIRE(len == PAGE_SIZE);
+        if (pages_left == 0) {
+            return false;
+        }
+        pages_left--;
+        for (std::size_t i = 0; i < len; i++) {
+            data[offset + i] &= in[i];
+        }
+        return true;
+    }
+
+    std::vector<uint8_t> data;
+    std::vector<uint32_t> erase_counts;
+    std::size_t pages_left = SIZE_MAX;   ///< Fail (power loss) after this many page writes
+};
+
+ScanResult make_logged_scan(uint8_t tag, std::size_t aps) {
+    ScanResult scan;
+    scan.success = true;
+    for (std::size_t i = 0; i < aps; i++) {
+        APInfo ap;
+        std::snprintf(ap.ssid.data(), ap.ssid.size(), "net-%u-%zu", tag, i);
+        ap.bssid = {0x02, tag, 0, 0, 0, static_cast<uint8_t>(i)};
+        ap.rssi = static_cast<int16_t>(-40 - static_cast<int>(i));
+        ap.channel = static_cast<uint8_t>(1 + i % 13);
+        ap.auth = AuthMode::WPA2_PSK;
+        REQUIRE(scan.add(ap));
+    }
+    return scan;
+}
+
+} // anonymous namespace
+
+TEST_CASE("ScanLog") {
+    RamFlash flash(4);
+    ScanLog<RamFlash> log(flash);
+    log.mount();
+    ScanResult out;
+
+    SUBCASE("crc32 check value") {
+        const char* check = "123456789";
+        CHECK(crc32(reinterpret_cast<const uint8_t*>(check), 9) == 0xCBF43926u);
+    }
+
+    SUBCASE("empty flash") {
+        CHECK(log.empty());
+        CHECK_FALSE(log.load_latest(out));
+    }
+
+    SUBCASE("round trip through a remount") {
+        REQUIRE(log.append(make_logged_scan(1, 5)));
+        REQUIRE(log.append(make_logged_scan(2, MAX_SCAN_RESULTS)));
+
+        ScanLog<RamFlash> rebooted(flash);
+        rebooted.mount();
+        CHECK(rebooted.latest_sequence() == 2);
+        REQUIRE(rebooted.load_latest(out));
+        const ScanResult expected = make_logged_scan(2, MAX_SCAN_RESULTS);
+        CHECK(out.success);
+        REQUIRE(out.count == expected.count);
+        for (std::size_t i = 0; i < out.count; i++) {
+            const APInfo a = out.networks[i];
+            const APInfo b = expected.networks[i];
+            CHECK(std::strcmp(a.ssid.data(), b.ssid.data()) == 0);
+            CHECK(a.bssid == b.bssid);
+            CHECK(a.rssi == b.rssi);
+            CHECK(a.channel == b.channel);
+            CHECK(a.auth == b.auth);
+        }
+
+        // Appending continues the sequence after the remount
+        REQUIRE(rebooted.append(make_logged_scan(3, 1)));
+        CHECK(rebooted.latest_sequence() == 3);
+    }
+
+    SUBCASE("failed scans are not logged") {
+        ScanResult failed;
+        CHECK_FALSE(log.append(failed));
+        CHECK(log.empty());
+    }
+
+    SUBCASE("ring wraps with even wear and keeps recent history") {
+        for (uint32_t i = 0; i < 100; i++) {
+            REQUIRE(log.append(make_logged_scan(static_cast<uint8_t>(i), 20)));
+        }
+        const auto [lo, hi] = std::minmax_element(flash.erase_counts.begin(),
+                                                  flash.erase_counts.end());
+        CHECK(*hi - *lo <= 1);
+
+        ScanLog<RamFlash> rebooted(flash);
+        rebooted.mount();
+        CHECK(rebooted.latest_sequence() == 100);
+
+        std::vector<uint32_t> sequences;
+        const std::size_t visited = rebooted.for_each_recent(
+            8, out, [&](const ScanResult& scan, uint32_t sequence) {
+                CHECK(scan.count == 20);
+                sequences.push_back(sequence);
+                return true;
+            });
+        CHECK(visited == 8);
+        for (std::size_t i = 0; i < sequences.size(); i++) {
+            CHECK(sequences[i] == 100 - i);
+        }
+        // Everything but the sector being refilled survives
+        const std::size_t all = rebooted.for_each_recent(
+            SIZE_MAX, out, [](const ScanResult&, uint32_t) { return true; });
+        CHECK(all >= 3 * (RamFlash::SECTOR_SIZE / 1024));
+        CHECK(all < 100);
+    }
+
+    SUBCASE("torn write falls back to the previous record") {
+        REQUIRE(log.append(make_logged_scan(1, 10)));
+        flash.pages_left = 1;
+        CHECK_FALSE(log.append(make_logged_scan(2, MAX_SCAN_RESULTS)));
+        flash.pages_left = SIZE_MAX;
+
+        ScanLog<RamFlash> rebooted(flash);
+        rebooted.mount();
+        CHECK(rebooted.latest_sequence() == 1);
+        REQUIRE(rebooted.load_latest(out));
+        CHECK(out.count == 10);
+
+        // New records go to a fresh sector, never after the torn one
+        REQUIRE(rebooted.append(make_logged_scan(3, 10)));
+        CHECK(flash.erase_counts[1] == 1);
+        ScanLog<RamFlash> again(flash);
+        again.mount();
+        CHECK(again.latest_sequence() == 2);
+        REQUIRE(again.load_latest(out));
+        CHECK(out.networks.bssid[0][1] == 3);
+    }
+}
+
+// =============================================================================
+// Known network cache tests
+// =============================================================================
+
+namespace {
+
+APInfo make_known_ap(uint8_t id, uint8_t channel, int16_t rssi = -50) {
+    APInfo ap;
+    std::snprintf(ap.ssid.data(), ap.ssid.size(), "known-%u", id);
+    ap.bssid = {0x02, 0x4B, 0, 0, 0, id};
+    ap.channel = channel;
+    ap.rssi = rssi;
+    ap.auth = AuthMode::WPA2_PSK;
+    return ap;
+}
+
+} // anonymous namespace
+
+TEST_CASE("KnownNetworks") {
+    KnownNetworks known;
+    CHECK(known.empty());
+
+    SUBCASE("remember and forget") {
+        known.remember(make_known_ap(1, 6), 100);
+        known.remember(make_known_ap(2, 11), 200);
+        REQUIRE(known.size() == 2);
+        const KnownNetwork* entry = known.find(make_known_ap(2, 11).bssid);
+        REQUIRE(entry != nullptr);
+        CHECK(entry->ap.channel == 11);
+        CHECK(entry->last_seen_ms == 200);
+
+        CHECK(known.forget(make_known_ap(1, 6).bssid));
+        CHECK_FALSE(known.forget(make_known_ap(1, 6).bssid));
+        CHECK(known.size() == 1);
+        CHECK(known.find(make_known_ap(1, 6).bssid) == nullptr);
+    }
+
+    SUBCASE("full cache evicts the least recently seen") {
+        for (uint8_t i = 0; i < MAX_KNOWN_NETWORKS; i++) {
+            known.remember(make_known_ap(i, 1), 1000u + i);
+        }
+        known.remember(make_known_ap(0, 1), 5000);
+        known.remember(make_known_ap(100, 1), 6000);
+        CHECK(known.size() == MAX_KNOWN_NETWORKS);
+        CHECK(known.find(make_known_ap(0, 1).bssid) != nullptr);
+        CHECK(known.find(make_known_ap(1, 1).bssid) == nullptr);
+        CHECK(known.find(make_known_ap(100, 1).bssid) != nullptr);
+    }
+
+    SUBCASE("refresh updates entries heard in a scan") {
+        known.remember(make_known_ap(1, 6, -70), 100);
+        known.remember(make_known_ap(2, 11, -70), 100);
+        ScanResult scan;
+        scan.success = true;
+        REQUIRE(scan.add(make_known_ap(1, 6, -45)));
+        REQUIRE(scan.add(make_known_ap(9, 3)));
+
+        CHECK(known.refresh(scan, 900) == 1);
+        const KnownNetwork* heard = known.find(make_known_ap(1, 6).bssid);
+        CHECK(heard->ap.rssi == -45);
+        CHECK(heard->last_seen_ms == 900);
+        CHECK(known.find(make_known_ap(2, 11).bssid)->last_seen_ms == 100);
+        CHECK(known.find(make_known_ap(9, 3).bssid) == nullptr);
+    }
+
+    SUBCASE("revision tracks persisted fields only") {
+        known.remember(make_known_ap(1, 6), 100);
+        const uint32_t added = known.revision();
+
+        ScanResult scan;
+        scan.success = true;
+        REQUIRE(scan.add(make_known_ap(1, 6, -80)));
+        known.refresh(scan, 200);
+        known.remember(make_known_ap(1, 6, -30), 300);
+        CHECK(known.revision() == added);
+
+        scan.reset();
+        REQUIRE(scan.add(make_known_ap(1, 11)));
+        known.refresh(scan, 400);
+        CHECK(known.revision() != added);
+    }
+
+    SUBCASE("fast request targets the most recently heard") {
+        known.remember(make_known_ap(1, 1, -40), 100);
+        known.remember(make_known_ap(2, 6, -60), 500);
+        known.remember(make_known_ap(3, 11, -80), 0);
+        known.remember(make_known_ap(4, 3, -50), 0);
+        known.remember(make_known_ap(5, 9, -45), 300);
+
+        const ScanRequest request = known.fast_request();
+        CHECK(request.stop_on_match);
+        CHECK(request.channel_mask == 0);
+        REQUIRE(request.bssid_count == MAX_TARGET_BSSIDS);
+        CHECK(request.bssids[0] == make_known_ap(2, 6).bssid);
+        CHECK(request.bssids[1] == make_known_ap(5, 9).bssid);
+        CHECK(request.bssids[2] == make_known_ap(1, 1).bssid);
+        // Not seen since boot: ranked by stored RSSI
+        CHECK(request.bssids[3] == make_known_ap(4, 3).bssid);
+        // An AP on another channel still matches
+        CHECK(request.matches(make_known_ap(2, 13)));
+        CHECK_FALSE(request.matches(make_known_ap(3, 11)));
+    }
+
+    SUBCASE("best entry for an SSID") {
+        APInfo office_a = make_known_ap(1, 1, -70);
+        APInfo office_b = make_known_ap(2, 6, -50);
+        APInfo office_c = make_known_ap(3, 11, -40);
+        for (APInfo* ap : {&office_a, &office_b, &office_c}) {
+            std::strcpy(ap->ssid.data(), "Office");
+        }
+        known.remember(make_known_ap(4, 3, -30), 900);
+        known.remember(office_a, 500);
+        known.remember(office_b, 500);
+        known.remember(office_c, 100);
+
+        const KnownNetwork* best = known.best_for("Office");
+        REQUIRE(best != nullptr);
+        CHECK(best->ap.bssid == office_b.bssid);
+        CHECK(known.best_for("Guest") == nullptr);
+    }
+
+    SUBCASE("round trip through a scan result") {
+        known.remember(make_known_ap(1, 6, -55), 100);
+        known.remember(make_known_ap(2, 11, -65), 200);
+        BasicScanResult<MAX_KNOWN_NETWORKS> saved;
+        known.export_to(saved);
+        CHECK(saved.success);
+        CHECK(saved.count == 2);
+
+        KnownNetworks restored;
+        restored.import_from(saved);
+        REQUIRE(restored.size() == 2);
+        const KnownNetwork* entry = restored.find(make_known_ap(2, 11).bssid);
+        REQUIRE(entry != nullptr);
+        CHECK(entry->ap.channel == 11);
+        CHECK(entry->ap.rssi == -65);
+        CHECK(std::strcmp(entry->ap.ssid.data(), "known-2") == 0);
+        CHECK(entry->last_seen_ms == 0);
+    }
+}
+
+// =============================================================================
+// Telemetry frame tests
+// =============================================================================
+
+namespace {
+
+uint32_t read_test_varint(const uint8_t* data, std::size_t& pos) {
+    uint32_t value = 0;
+    for (int shift = 0; ; shift += 7) {
+        const uint8_t byte = data[pos++];
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+}
+
+/**
+ * @brief Decoded scan from a telemetry datagram.
+ */
+struct DecodedScan {
+    uint32_t generation;
+    uint32_t uptime_s;
+    std::vector<APInfo> aps;
+};
+
+/**
+ * @brief Reference decoder following the layout in telemetry_frame.hpp.
+ */
+std::vector<DecodedScan> decode_datagram(const uint8_t* data, std::size_t len,
+                                         uint32_t& sequence) {
+    REQUIRE(len >= 1 + BSSID_LEN);
+    CHECK(data[0] == TELEMETRY_VERSION);
+    std::size_t pos = 1 + BSSID_LEN;
+    sequence = read_test_varint(data, pos);
+
+    std::vector<std::array<uint8_t, BSSID_LEN>> seen;
+    std::vector<std::string> ssids;
+    std::vector<DecodedScan> scans;
+    while (pos < len) {
+        DecodedScan scan;
+        scan.generation = read_test_varint(data, pos);
+        scan.uptime_s = read_test_varint(data, pos);
+        const uint8_t count = data[pos++];
+        for (uint8_t i = 0; i < count; i++) {
+            APInfo ap;
+            std::memcpy(ap.bssid.data(), data + pos, BSSID_LEN);
+            pos += BSSID_LEN;
+            ap.rssi = static_cast<int8_t>(data[pos++]);
+            ap.channel = data[pos] & 0x0F;
+            ap.auth = static_cast<AuthMode>(data[pos++] >> 4);
+            const auto known = std::find(seen.begin(), seen.end(), ap.bssid);
+            std::string ssid;
+            if (known == seen.end()) {
+                const uint8_t ssid_len = data[pos++];
+                ssid.assign(reinterpret_cast<const char*>(data + pos), ssid_len);
+                pos += ssid_len;
+                seen.push_back(ap.bssid);
+                ssids.push_back(ssid);
+            } else {
+                ssid = ssids[static_cast<std::size_t>(known - seen.begin())];
+            }
+            std::memcpy(ap.ssid.data(), ssid.data(), ssid.size());
+            scan.aps.push_back(ap);
+        }
+        scans.push_back(scan);
+    }
+    CHECK(pos == len);
+    return scans;
+}
+
+} // anonymous namespace
+
+TEST_CASE("TelemetryWriter") {
+    std::vector<uint8_t> buffer(1472);
+    const std::array<uint8_t, BSSID_LEN> device = {0x28, 0xCD, 0xC1, 0x00, 0x00, 0x01};
+    TelemetryWriter writer;
+    writer.begin(buffer.data(), buffer.size(), device, 300);
+
+    SUBCASE("header only") {
+        CHECK(writer.scans() == 0);
+        CHECK(writer.size() == 1 + BSSID_LEN + 2);
+        CHECK(std::equal(device.begin(), device.end(), buffer.begin() + 1));
+    }
+
+    SUBCASE("scans round trip") {
+        const ScanResult first = make_logged_scan(1, 5);
+        const ScanResult second = make_logged_scan(1, 6);
+        REQUIRE(writer.add(first, 41, 20));
+        REQUIRE(writer.add(second, 42, 40));
+        CHECK(writer.scans() == 2);
+
+        uint32_t sequence = 0;
+        const auto scans = decode_datagram(buffer.data(), writer.size(), sequence);
+        CHECK(sequence == 300);
+        REQUIRE(scans.size() == 2);
+        CHECK(scans[0].generation == 41);
+        CHECK(scans[1].uptime_s == 40);
+        REQUIRE(scans[1].aps.size() == 6);
+        for (std::size_t i = 0; i < scans[1].aps.size(); i++) {
+            const APInfo expected = second.networks[i];
+            const APInfo& ap = scans[1].aps[i];
+            CHECK(ap.bssid == expected.bssid);
+            CHECK(ap.rssi == expected.rssi);
+            CHECK(ap.channel == expected.channel);
+            CHECK(ap.auth == expected.auth);
+            CHECK(std::strcmp(ap.ssid.data(), expected.ssid.data()) == 0);
+        }
+    }
+
+    SUBCASE("repeated BSSIDs cost fixed bytes only") {
+        const ScanResult scan = make_logged_scan(2, 10);
+        REQUIRE(writer.add(scan, 1, 0));
+        const std::size_t first = writer.size();
+        REQUIRE(writer.add(scan, 2, 0));
+        CHECK(writer.size() - first == 3 + scan.count * TELEMETRY_AP_FIXED);
+    }
+
+    SUBCASE("scan that does not fit leaves the datagram unchanged") {
+        const ScanResult scan = make_logged_scan(3, MAX_SCAN_RESULTS);
+        uint32_t generation = 0;
+        while (writer.add(scan, ++generation, 0)) {
+        }
+        CHECK(writer.scans() >= 2);
+        const std::size_t size = writer.size();
+        CHECK_FALSE(writer.add(scan, ++generation, 0));
+        CHECK(writer.size() == size);
+        CHECK(size <= buffer.size());
+
+        uint32_t sequence = 0;
+        const auto scans = decode_datagram(buffer.data(), size, sequence);
+        CHECK(scans.size() == writer.scans());
+    }
+
+    SUBCASE("BSSID table limit") {
+        std::vector<uint8_t> large(8192);
+        writer.begin(large.data(), large.size(), device, 0);
+        std::size_t distinct = 0;
+        for (uint8_t tag = 0; distinct + 8 <= TELEMETRY_MAX_BSSIDS; tag++) {
+            REQUIRE(writer.add(make_logged_scan(tag, 8), tag, 0));
+            distinct += 8;
+        }
+        // Known BSSIDs still fit, new ones would overflow the SSID table
+        CHECK(writer.add(make_logged_scan(0, 8), 100, 0));
+        CHECK_FALSE(writer.add(make_logged_scan(200, 8), 101, 0));
+    }
+}
+
+// =============================================================================
+// IperfUdpTracker tests
+// =============================================================================
+
+TEST_CASE("IperfUdpTracker") {
+    IperfUdpTracker tracker;
+
+    SUBCASE("clean test") {
+        for (int32_t id = 0; id < 100; id++) {
+            CHECK_FALSE(tracker.on_datagram(id, 1470, 1000 + static_cast<uint64_t>(id) * 1000));
+        }
+        CHECK(tracker.active());
+        CHECK(tracker.on_datagram(-100, 1470, 100000));
+        CHECK_FALSE(tracker.active());
+
+        const IperfUdpReport& report = tracker.report();
+        CHECK(report.datagrams == 100);
+        CHECK(report.bytes == 147000);
+        CHECK(report.lost == 0);
+        CHECK(report.duration_us == 99000);
+        CHECK(report.kbit_per_s() == 147000u * 8000 / 99000);
+        // Repeated end markers are ignored
+        CHECK_FALSE(tracker.on_datagram(-100, 1470, 101000));
+    }
+
+    SUBCASE("loss and reordering") {
+        for (int32_t id : {0, 1, 4, 3, 5}) {
+            CHECK_FALSE(tracker.on_datagram(id, 100, 1000));
+        }
+        CHECK(tracker.on_datagram(-6, 100, 2000));
+        const IperfUdpReport& report = tracker.report();
+        CHECK(report.datagrams == 5);
+        CHECK(report.lost == 1);
+        CHECK(report.out_of_order == 1);
+        CHECK(report.loss_per_mille() == 166);
+    }
+
+    SUBCASE("idle gap starts a new test") {
+        CHECK_FALSE(tracker.on_datagram(0, 100, 0));
+        CHECK_FALSE(tracker.on_datagram(1, 100, 1000));
+        CHECK_FALSE(tracker.on_datagram(0, 100, 1000 + IPERF_UDP_IDLE_US + 1));
+        CHECK(tracker.report().datagrams == 1);
+        CHECK(tracker.report().out_of_order == 0);
+    }
+
+    SUBCASE("empty report") {
+        CHECK(IperfUdpReport{}.kbit_per_s() == 0);
+        CHECK(IperfUdpReport{}.loss_per_mille() == 0);
+    }
+}
+
+TEST_CASE("NetCounters") {
+    NetCounters earlier;
+    earlier.pbuf_pool_err = 3;
+    earlier.pbuf_pool_max = 10;
+    earlier.link_recv = 1000;
+    NetCounters now = earlier;
+    now.pbuf_pool_err = 5;
+    now.pbuf_pool_max = 24;
+    now.link_recv = 1500;
+
+    const NetCounters delta = now.since(earlier);
+    CHECK(delta.pbuf_pool_err == 2);
+    CHECK(delta.link_recv == 500);
+    CHECK(delta.pbuf_pool_max == 24);
+    CHECK(delta.link_drop == 0);
+}
+
+// =============================================================================
+// Fingerprint tests
+// =============================================================================
+
+namespace {
+
+/**
+ * @brief Fingerprint from (BSSID id, RSSI) pairs, via a scan as the device builds it.
+ */
+Fingerprint make_print(std::initializer_list<std::pair<uint8_t, int16_t>> aps) {
+    ScanResult scan;
+    for (const auto& [id, rssi] : aps) {
+        REQUIRE(scan.add(make_ap(id, rssi)));
+    }
+    return fingerprint_of(scan);
+}
+
+} // anonymous namespace
+
+TEST_CASE("Fingerprint matching") {
+    SUBCASE("integer square root") {
+        CHECK(isqrt(0) == 0);
+        CHECK(isqrt(1) == 1);
+        CHECK(isqrt(15) == 3);
+        CHECK(isqrt(16) == 4);
+        CHECK(isqrt(UINT32_MAX) == 65535);
+        for (uint32_t v = 0; v < 5000; v++) {
+            const uint32_t r = isqrt(v);
+            CHECK((r * r <= v && (r + 1) * (r + 1) > v));
+        }
+    }
+
+    SUBCASE("BSSID keys keep byte order") {
+        const std::array<uint8_t, BSSID_LEN> a{0x24, 0xC9, 0xA1, 0x5C, 0x27, 0x98};
+        std::array<uint8_t, BSSID_LEN> b = a;
+        b[0] = 0x25;
+        CHECK(bssid_key(a) == 0x24C9A15C2798ull);
+        CHECK(bssid_key(a) < bssid_key(b));
+    }
+
+    SUBCASE("a scan keeps its strongest APs, sorted by BSSID") {
+        ScanResult scan;
+        for (uint8_t i = 0; i < 24; i++) {
+            REQUIRE(scan.add(make_ap(static_cast<uint8_t>(100 - i), static_cast<int16_t>(-40 - i))));
+        }
+        const Fingerprint print = fingerprint_of(scan);
+        REQUIRE(print.count == MAX_FINGERPRINT_APS);
+        CHECK(print.valid());
+        // Ids 100..85 are the 16 strongest; the weakest of them, id 85, sorts first
+        CHECK(print.bssid[0] == bssid_key(make_ap(85, 0).bssid));
+        CHECK(print.rssi[0] == -55);
+        CHECK(print.rssi[MAX_FINGERPRINT_APS - 1] == -40);
+    }
+
+    SUBCASE("distances") {
+        const Fingerprint a = make_print({{1, -50}, {2, -60}, {3, -70}});
+        CHECK(fingerprint_distance(a, a).rms_q8 == 0);
+        CHECK(fingerprint_distance(a, a).common == 3);
+
+        // Every AP 3 dB off: RMS exactly 3 dB
+        const Fingerprint shifted = make_print({{1, -53}, {2, -63}, {3, -73}});
+        CHECK(fingerprint_distance(a, shifted).rms_q8 == 3 * 256);
+
+        // A strong AP missing costs more than a weak one
+        const Fingerprint no_strong = make_print({{2, -60}, {3, -70}});
+        const Fingerprint no_weak = make_print({{1, -50}, {2, -60}});
+        CHECK(fingerprint_distance(a, no_strong).rms_q8 > fingerprint_distance(a, no_weak).rms_q8);
+        CHECK(fingerprint_distance(a, no_weak).common == 2);
+        // sqrt(30^2 / 3) = 17.32 dB
+        CHECK(fingerprint_distance(a, no_weak).rms_q8 == 4434);
+
+        CHECK(fingerprint_distance(Fingerprint{}, Fingerprint{}).rms_q8 == NO_FINGERPRINT_DISTANCE);
+    }
+
+    SUBCASE("nearest location") {
+        static const FingerprintLocation locations[] = {
+            {"Kitchen", make_print({{1, -45}, {2, -60}, {3, -75}, {4, -80}})},
+            {"Office", make_print({{1, -75}, {2, -50}, {3, -55}, {5, -70}})},
+            {"Garage", make_print({{6, -40}, {7, -50}})},
+        };
+        const FingerprintDb db(locations, 3);
+        REQUIRE(db.size() == 3);
+        CHECK(db.valid());
+
+        const FingerprintMatch kitchen = db.match(make_print({{1, -48}, {2, -62}, {3, -70}}));
+        REQUIRE(kitchen.found());
+        CHECK(std::string(db[kitchen.location].name) == "Kitchen");
+        CHECK(kitchen.distance.common == 3);
+        CHECK(kitchen.distance.rms_q8 < kitchen.runner_up_q8);
+
+        const FingerprintMatch office = db.match(make_print({{2, -52}, {3, -57}, {5, -68}}));
+        REQUIRE(office.found());
+        CHECK(std::string(db[office.location].name) == "Office");
+
+        // One shared AP is not enough to place a scan
+        CHECK_FALSE(db.match(make_print({{6, -40}, {9, -50}})).found());
+        CHECK(db.match(make_print({{6, -40}, {9, -50}}), 1).found());
+        CHECK_FALSE(db.match(Fingerprint{}).found());
+        CHECK_FALSE(FingerprintDb{}.match(make_print({{1, -45}, {2, -60}})).found());
+    }
+
+    SUBCASE("unsorted tables are rejected") {
+        FingerprintLocation location{"Bad", make_print({{1, -45}, {2, -60}})};
+        std::swap(location.print.bssid[0], location.print.bssid[1]);
+        CHECK_FALSE(FingerprintDb(&location, 1).valid());
+    }
+}
+
+// =============================================================================
+// Power profile tests
+// =============================================================================
+
+TEST_CASE("Power profiles") {
+    SUBCASE("settings order from most responsive to most frugal") {
+        const PowerSettings performance = power_settings(PowerProfile::PERFORMANCE);
+        const PowerSettings balanced = power_settings(PowerProfile::BALANCED);
+        const PowerSettings low = power_settings(PowerProfile::ULTRA_LOW_POWER);
+        CHECK(performance.power_save == RadioPowerSave::NONE);
+        CHECK_FALSE(performance.idle_radio_off);
+        CHECK(balanced.power_save == RadioPowerSave::PERFORMANCE);
+        CHECK(balanced.idle_radio_off);
+        CHECK(balanced.interval_percent == 100);
+        CHECK(low.power_save == RadioPowerSave::AGGRESSIVE);
+        CHECK(low.scan_mode == ScanMode::PASSIVE);
+        // Long enough to hear a beacon sent every 102.4 ms
+        CHECK(low.passive_dwell_ms > 103);
+        CHECK(performance.interval_percent < balanced.interval_percent);
+        CHECK(balanced.interval_percent < low.interval_percent);
+    }
+
+    SUBCASE("names") {
+        CHECK(std::string(power_profile_name(PowerProfile::PERFORMANCE)) == "performance");
+        CHECK(std::string(power_profile_name(PowerProfile::BALANCED)) == "balanced");
+        CHECK(std::string(power_profile_name(PowerProfile::ULTRA_LOW_POWER)) == "ultra-low-power");
+    }
+
+    SUBCASE("auto picks by power source") {
+        CHECK(auto_power_profile(true) == PowerProfile::ULTRA_LOW_POWER);
+        CHECK(auto_power_profile(false) == PowerProfile::BALANCED);
+    }
+
+    SUBCASE("schedule scaling") {
+        ScheduleConfig config;
+        config.min_interval_ms = 20000;
+        config.max_interval_ms = 300000;
+        config.change_tolerance = 3;
+
+        const ScheduleConfig balanced =
+            apply_power_settings(config, power_settings(PowerProfile::BALANCED));
+        CHECK(balanced.min_interval_ms == 20000);
+        CHECK(balanced.max_interval_ms == 300000);
+        CHECK(balanced.mode == ScanMode::ACTIVE);
+
+        const ScheduleConfig low =
+            apply_power_settings(config, power_settings(PowerProfile::ULTRA_LOW_POWER));
+        CHECK(low.min_interval_ms == 60000);
+        CHECK(low.max_interval_ms == 900000);
+        CHECK(low.mode == ScanMode::PASSIVE);
+        CHECK(low.change_tolerance == 3);
+
+        const ScheduleConfig performance =
+            apply_power_settings(config, power_settings(PowerProfile::PERFORMANCE));
+        CHECK(performance.min_interval_ms == 10000);
+        CHECK(performance.max_interval_ms == 150000);
+
+        config.max_interval_ms = UINT32_MAX;
+        CHECK(apply_power_settings(config, power_settings(PowerProfile::ULTRA_LOW_POWER))
+                  .max_interval_ms == UINT32_MAX);
+    }
+
+    SUBCASE("radio duty cycle") {
+        CHECK(radio_duty_per_mille(0, 0) == 0);
+        CHECK(radio_duty_per_mille(2400000, 20000000) == 120);
+        CHECK(radio_duty_per_mille(5, 1) == 1000);
+    }
+}
+
+// =============================================================================
+// Boot timeline tests
+// =============================================================================
+
+TEST_CASE("BootTimeline") {
+    BootTimeline boot;
+
+    SUBCASE("first mark wins") {
+        CHECK_FALSE(boot.reached(BootPhase::RADIO_READY));
+        CHECK(boot.mark(BootPhase::RADIO_READY, 450000));
+        CHECK_FALSE(boot.mark(BootPhase::RADIO_READY, 900000));
+        CHECK(boot.reached(BootPhase::RADIO_READY));
+        CHECK(boot.at_us(BootPhase::RADIO_READY) == 450000);
+    }
+
+    SUBCASE("time zero still counts as reached") {
+        CHECK(boot.mark(BootPhase::MAIN, 0));
+        CHECK(boot.reached(BootPhase::MAIN));
+        CHECK(boot.at_us(BootPhase::MAIN) == 1);
+    }
+
+    SUBCASE("between phases") {
+        boot.mark(BootPhase::RADIO_START, 20000);
+        boot.mark(BootPhase::STORE_RESTORED, 60000);
+        boot.mark(BootPhase::RADIO_READY, 470000);
+        CHECK(boot.between_us(BootPhase::RADIO_START, BootPhase::RADIO_READY) == 450000);
+        // Not reached, or reached in the other order
+        CHECK(boot.between_us(BootPhase::RADIO_START, BootPhase::FIRST_SCAN) == 0);
+        CHECK(boot.between_us(BootPhase::FIRST_SCAN, BootPhase::RADIO_READY) == 0);
+        CHECK(boot.between_us(BootPhase::RADIO_READY, BootPhase::STORE_RESTORED) == 0);
+    }
+
+    SUBCASE("out of range phases are ignored") {
+        CHECK_FALSE(boot.mark(BootPhase::COUNT, 5));
+        CHECK(boot.at_us(BootPhase::COUNT) == 0);
+        CHECK_FALSE(boot.reached(BootPhase::FIRST_SCAN));
+    }
+
+    SUBCASE("every phase has a name") {
+        for (std::size_t i = 0; i < BOOT_PHASES; i++) {
+            CHECK(std::string(boot_phase_name(static_cast<BootPhase>(i))) != "???");
+        }
+    }
+}
+
+// =============================================================================
+// Health monitor tests
+// =============================================================================
+
+TEST_CASE("HealthMonitor") {
+    HealthMonitor monitor;
+
+    SUBCASE("tasks that never checked in are healthy") {
+        CHECK(monitor.healthy(UINT64_MAX));
+        CHECK(monitor.unhealthy(0) == Watched::COUNT);
+    }
+
+    SUBCASE("a check-in holds until its budget runs out") {
+        monitor.check_in(Watched::SCANNER, 1000000, 500);
+        CHECK(monitor.healthy(1500000));
+        CHECK(monitor.unhealthy(1500001) == Watched::SCANNER);
+        // Checking in again moves the deadline
+        monitor.check_in(Watched::SCANNER, 1400000, 500);
+        CHECK(monitor.healthy(1500001));
+    }
+
+    SUBCASE("an idle task has no deadline") {
+        monitor.check_in(Watched::SCHEDULER, 0, 10);
+        monitor.idle(Watched::SCHEDULER);
+        CHECK(monitor.healthy(60000000));
+    }
+
+    SUBCASE("failure is sticky") {
+        monitor.fail(Watched::SCANNER);
+        CHECK(monitor.failed(Watched::SCANNER));
+        monitor.check_in(Watched::SCANNER, 0, 1000);
+        monitor.idle(Watched::SCANNER);
+        CHECK(monitor.unhealthy(0) == Watched::SCANNER);
+        CHECK_FALSE(monitor.failed(Watched::SCHEDULER));
+    }
+
+    SUBCASE("the first unhealthy task is reported") {
+        monitor.check_in(Watched::SCANNER, 0, 5000);
+        monitor.check_in(Watched::SCHEDULER, 0, 1);
+        CHECK(monitor.unhealthy(2000) == Watched::SCHEDULER);
+        CHECK(monitor.unhealthy(6000000) == Watched::SCANNER);
+    }
+
+    SUBCASE("out of range tasks are ignored") {
+        monitor.fail(Watched::COUNT);
+        monitor.check_in(Watched::COUNT, 0, 0);
+        CHECK(monitor.healthy(1));
+        CHECK_FALSE(monitor.failed(Watched::COUNT));
+    }
+
+    SUBCASE("every task has a name") {
+        for (std::size_t i = 0; i < WATCHED_TASKS; i++) {
+            CHECK(std::string(watched_name(static_cast<Watched>(i))) != "???");
+        }
+    }
+}
+
+TEST_CASE("RebootRecord") {
+    SUBCASE("round trip") {
+        const RebootRecord record{RebootCause::FAILED, Watched::SCANNER};
+        const RebootRecord decoded = RebootRecord::decode(record.encode());
+        CHECK(decoded.supervised());
+        CHECK(decoded.cause == RebootCause::FAILED);
+        CHECK(decoded.task == Watched::SCANNER);
+        CHECK((record.encode() >> 16) == RebootRecord::MAGIC);
+    }
+
+    SUBCASE("anything else in the register is not a supervised reboot") {
+        CHECK_FALSE(RebootRecord::decode(0).supervised());
+        CHECK_FALSE(RebootRecord::decode(0xFFFFFFFF).supervised());
+        // Right magic, but an unknown cause or task
+        CHECK_FALSE(RebootRecord::decode(RebootRecord::MAGIC << 16 | 0x0700).supervised());
+        CHECK_FALSE(RebootRecord::decode(RebootRecord::MAGIC << 16 | 0x0109).supervised());
+        CHECK_FALSE(RebootRecord::decode(RebootRecord::MAGIC << 16).supervised());
+    }
+
+    SUBCASE("every cause has a name") {
+        CHECK(std::string(reboot_cause_name(RebootCause::STALLED)) == "stalled");
+        CHECK(std::string(reboot_cause_name(RebootCause::FAILED)) == "failed");
+    }
+}
+
 // =============================================================================
 // Constants tests
 // =============================================================================
@@ -5,14 +5,18 @@ Consolidates all Pico development operations into a single tool.
 """
 
 import argparse
+import csv
+import json
 import os
+import re
 import signal
 import socket
+import struct
 import subprocess
 import sys
 import time
 from pathlib import Path
-from typing import Optional
+from typing import Callable, Optional
 
 from common import get_project_dir, get_local_dir
 
@@ -25,6 +29,13 @@ GDB_PORT = 3333
 TELNET_PORT = 4444
 TCL_PORT = 6666
 RTT_PORT = 9090
+RTT_LOG_PORT = 9091
+RTT_LOG_CHANNEL = 1  # Binary debug log frames (DEBUG_LOG_BINARY builds)
+RTT_TRACE_PORT = 9092
+RTT_TRACE_CHANNEL = 2  # Raw scan callback frames (SCAN_TRACE builds)
+TELEMETRY_PORT = 5530  # UDP scan telemetry (TELEMETRY_HOST builds)
+FINGERPRINT_MAX_APS = 16  # MAX_FINGERPRINT_APS in src/fingerprint.hpp
+FINGERPRINT_MIN_PRESENCE = 0.5  # Share of a survey's scans an AP must be in
 
 # RTT memory search range (covers all SRAM on RP2350)
 RTT_START_ADDR = 0x20000000
@@ -662,18 +673,20 @@ def openocd_rtt_setup() -> tuple[bool, str]:
             if "error" in out.lower() and "already" not in out.lower():
                 return False, f"RTT start failed: {out}"
 
-            # Check if RTT server is already running
-            if is_port_open(RTT_PORT):
-                return True, "RTT already configured"
-
-            # Start RTT server on TCP port
-            out = send_cmd(f"rtt server start {RTT_PORT} 0")
-            if "error" in out.lower():
-                return False, f"RTT server start failed: {out}"
-
-            # Wait for server to be ready
+            # Start a TCP server per channel (text stdio, binary log, scan
+            # trace) unless a previous run already did
+            servers = ((0, RTT_PORT), (RTT_LOG_CHANNEL, RTT_LOG_PORT),
+                       (RTT_TRACE_CHANNEL, RTT_TRACE_PORT))
+            for channel, port in servers:
+                if is_port_open(port):
+                    continue
+                out = send_cmd(f"rtt server start {port} {channel}")
+                if "error" in out.lower():
+                    return False, f"RTT server start failed: {out}"
+
+            # Wait for servers to be ready
             for _ in range(20):
-                if is_port_open(RTT_PORT):
+                if all(is_port_open(port) for _, port in servers):
                     return True, "RTT configured"
                 time.sleep(0.1)
 
@@ -683,12 +696,10 @@ def openocd_rtt_setup() -> tuple[bool, str]:
         return False, f"Failed to configure RTT: {e}"
 
 
-def cmd_rtt_read(duration: Optional[int] = None) -> int:
-    """Read RTT output from the target via the debug probe.
+def read_rtt(port: int, duration: Optional[int], on_data: Callable[[bytes], None]) -> int:
+    """Set up RTT and pass everything received on port to on_data.
 
-    RTT (Real-Time Transfer) provides fast bidirectional communication through
-    the debug probe without requiring a USB serial connection. It's especially
-    useful when debugging as output continues even when the target is halted.
+    Starts OpenOCD if needed. Reads forever, or for duration seconds.
     """
     # Ensure OpenOCD is running
     if not is_port_open(TELNET_PORT):
@@ -717,7 +728,7 @@ def cmd_rtt_read(duration: Optional[int] = None) -> int:
     try:
         sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
         sock.settimeout(0.5)
-        sock.connect(("localhost", RTT_PORT))
+        sock.connect(("localhost", port))
 
         end_time = time.time() + duration if duration else None
         while True:
@@ -727,15 +738,14 @@ def cmd_rtt_read(duration: Optional[int] = None) -> int:
                 data = sock.recv(4096)
                 if data:
                     captured += len(data)
-                    sys.stdout.buffer.write(data)
-                    sys.stdout.buffer.flush()
+                    on_data(data)
             except socket.timeout:
                 continue
 
     except KeyboardInterrupt:
         pass
     except ConnectionRefusedError:
-        print(f"Error: Cannot connect to RTT server on port {RTT_PORT}", file=sys.stderr)
+        print(f"Error: Cannot connect to RTT server on port {port}", file=sys.stderr)
         return 1
     except Exception as e:
         print(f"\nError: {e}", file=sys.stderr)
@@ -748,6 +758,576 @@ def cmd_rtt_read(duration: Optional[int] = None) -> int:
     return 0
 
 
+def cmd_rtt_read(duration: Optional[int] = None) -> int:
+    """Read RTT output from the target via the debug probe.
+
+    RTT (Real-Time Transfer) provides fast bidirectional communication through
+    the debug probe without requiring a USB serial connection. It's especially
+    useful when debugging as output continues even when the target is halted.
+    """
+    def write(data: bytes) -> None:
+        sys.stdout.buffer.write(data)
+        sys.stdout.buffer.flush()
+
+    return read_rtt(RTT_PORT, duration, write)
+
+
+# =============================================================================
+# Binary Log Decoding
+# =============================================================================
+
+# Must match src/log_frame.hpp and src/debug_log.hpp
+DLOG_SECTION = ".dlog"
+DLOG_VERSION = 1
+DLOG_DROPPED_ID = 0
+DLOG_LEVEL_PREFIX = {"I": "", "W": "WARN: ", "E": "ERROR: "}
+
+PRINTF_SPEC = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|j|z|t|L)?([diouxXcsp%])")
+
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+
+
+class ElfImage:
+    """Minimal 32-bit little-endian ELF reader (sections and loaded data)."""
+
+    def __init__(self, path: Path):
+        data = path.read_bytes()
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise ValueError(f"{path} is not a 32-bit little-endian ELF")
+
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+        headers = [struct.unpack_from("<IIIIII", data, shoff + i * shentsize)
+                   for i in range(shnum)]
+        names_offset = headers[shstrndx][4]
+
+        self.sections: dict[str, bytes] = {}
+        self.loaded: list[tuple[int, bytes]] = []
+        for name, stype, flags, addr, offset, size in headers:
+            end = data.index(b"\0", names_offset + name)
+            section_name = data[names_offset + name:end].decode()
+            body = b"" if stype == SHT_NOBITS else data[offset:offset + size]
+            self.sections[section_name] = body
+            if flags & SHF_ALLOC and stype != SHT_NOBITS:
+                self.loaded.append((addr, body))
+
+    def read_cstring(self, addr: int, limit: int = 256) -> Optional[str]:
+        """Read a NUL-terminated string from the loaded image (flash/rodata)."""
+        for base, body in self.loaded:
+            if base <= addr < base + len(body):
+                start = addr - base
+                end = body.find(b"\0", start, start + limit)
+                return body[start:end if end >= 0 else start + limit].decode("utf-8", "replace")
+        return None
+
+
+def cobs_decode(data: bytes) -> bytes:
+    """Decode one COBS frame (without its zero delimiter)."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        end = i + code - 1
+        if code == 0 or end > len(data):
+            raise ValueError("corrupt COBS block")
+        out += data[i:end]
+        i = end
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def read_varint(data: bytes, pos: int) -> tuple[int, int]:
+    """Read an unsigned LEB128 value, returning (value, next position)."""
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(data) or shift > 28:
+            raise ValueError("truncated varint")
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+class DlogDecoder:
+    """Rebuild log lines from binary frames using the .dlog section of the ELF."""
+
+    def __init__(self, elf: ElfImage):
+        dictionary = elf.sections.get(DLOG_SECTION)
+        if dictionary is None:
+            raise ValueError(f"ELF has no {DLOG_SECTION} section (built without DEBUG_LOG_BINARY?)")
+        self.elf = elf
+        self.dictionary = dictionary
+        self.pending = bytearray()
+
+    def feed(self, data: bytes) -> list[str]:
+        """Add received bytes, returning the lines of every completed frame."""
+        self.pending += data
+        lines = []
+        while (end := self.pending.find(0)) >= 0:
+            frame = bytes(self.pending[:end])
+            del self.pending[:end + 1]
+            if frame:
+                lines.append(self.decode_frame(frame))
+        return lines
+
+    def decode_frame(self, frame: bytes) -> str:
+        try:
+            payload = cobs_decode(frame)
+            if not payload or payload[0] >> 5 != DLOG_VERSION:
+                raise ValueError("unknown frame version")
+            nargs = payload[0] & 0x07
+            core = (payload[0] >> 3) & 0x03
+            site_id, pos = read_varint(payload, 1)
+            tick, pos = read_varint(payload, pos)
+            args = []
+            for _ in range(nargs):
+                value, pos = read_varint(payload, pos)
+                args.append(value)
+        except ValueError as e:
+            return f"<bad log frame: {e}>"
+
+        core_tag = f" [c{core}]" if core else ""
+        if site_id == DLOG_DROPPED_ID:
+            dropped = args[0] if args else 0
+            return f"[{tick:8d}]{core_tag} [Log] WARN: {dropped} messages dropped on core {core}"
+
+        offset = site_id - 1
+        end = self.dictionary.find(b"\0", offset)
+        if offset >= len(self.dictionary) or end < 0:
+            return f"[{tick:8d}]{core_tag} <unknown log site {site_id} (ELF does not match firmware?)>"
+        site = self.dictionary[offset:end].decode("utf-8", "replace")
+        level, rest = site[:1], site[1:]
+        tag, _, fmt = rest.partition("\x1f")
+        prefix = DLOG_LEVEL_PREFIX.get(level, "")
+        return f"[{tick:8d}]{core_tag} [{tag}] {prefix}{self.format(fmt, args)}"
+
+    def format(self, fmt: str, args: list[int]) -> str:
+        """Apply a C printf format to raw 32-bit argument words."""
+        words = iter(args)
+
+        def signed(value: int) -> int:
+            return value - (1 << 32) if value & 0x80000000 else value
+
+        def convert(m: re.Match) -> str:
+            flags, width, precision, _, conv = m.groups()
+            if conv == "%":
+                return "%"
+            if width == "*":
+                width = str(signed(next(words, 0)))
+            if precision == "*":
+                precision = str(next(words, 0))
+            spec = "%" + flags + (width or "") + (f".{precision}" if precision is not None else "")
+            value = next(words, 0)
+            if conv in "diu":
+                return (spec + "d") % (signed(value) if conv != "u" else value)
+            if conv in "oxX":
+                return (spec + conv) % value
+            if conv == "c":
+                return (spec + "c") % chr(value & 0xFF)
+            if conv == "p":
+                return (spec + "s") % f"0x{value:08x}"
+            text = self.elf.read_cstring(value)
+            return (spec + "s") % (text if text is not None else f"<str@0x{value:08x}>")
+
+        return PRINTF_SPEC.sub(convert, fmt)
+
+
+def cmd_rtt_log(duration: Optional[int] = None, elf_file: Optional[Path] = None) -> int:
+    """Read binary debug log frames from RTT channel 1 and print them as text.
+
+    Format strings are not in the firmware image; they are looked up in the
+    .dlog section of the ELF, which must be the one that was flashed.
+    """
+    elf_path = elf_file or get_default_elf()
+    try:
+        decoder = DlogDecoder(ElfImage(elf_path))
+    except (OSError, ValueError) as e:
+        print(f"Error: {e}", file=sys.stderr)
+        return 1
+
+    def decode(data: bytes) -> None:
+        for line in decoder.feed(data):
+            print(line, flush=True)
+
+    return read_rtt(RTT_LOG_PORT, duration, decode)
+
+
+# =============================================================================
+# Scan Telemetry
+# =============================================================================
+
+# Must match src/telemetry_frame.hpp and AuthMode in src/scan_msg.hpp
+TELEMETRY_VERSION = 1
+AUTH_NAMES = ["OPEN", "WEP", "WPA", "WPA2", "WPA/WPA2", "WPA3"]
+
+
+def format_mac(data: bytes) -> str:
+    return ":".join(f"{b:02X}" for b in data)
+
+
+def decode_telemetry(datagram: bytes) -> tuple[str, int, list[dict]]:
+    """Decode one telemetry datagram into (device, sequence, scans)."""
+    if len(datagram) < 8 or datagram[0] != TELEMETRY_VERSION:
+        raise ValueError("unknown datagram version")
+    device = format_mac(datagram[1:7])
+    sequence, pos = read_varint(datagram, 7)
+
+    ssids: dict[bytes, str] = {}
+    scans = []
+    while pos < len(datagram):
+        generation, pos = read_varint(datagram, pos)
+        uptime, pos = read_varint(datagram, pos)
+        if pos >= len(datagram):
+            raise ValueError("truncated scan")
+        count = datagram[pos]
+        pos += 1
+        aps = []
+        for _ in range(count):
+            if pos + 8 > len(datagram):
+                raise ValueError("truncated AP")
+            bssid = datagram[pos:pos + 6]
+            rssi = struct.unpack_from("b", datagram, pos + 6)[0]
+            chan_auth = datagram[pos + 7]
+            pos += 8
+            if bssid not in ssids:
+                length = datagram[pos]
+                ssids[bssid] = datagram[pos + 1:pos + 1 + length].decode("utf-8", "replace")
+                pos += 1 + length
+            auth = chan_auth >> 4
+            aps.append({
+                "bssid": format_mac(bssid),
+                "ssid": ssids[bssid],
+                "rssi": rssi,
+                "channel": chan_auth & 0x0F,
+                "auth": AUTH_NAMES[auth] if auth < len(AUTH_NAMES) else "UNKNOWN",
+            })
+        scans.append({"generation": generation, "uptime": uptime, "aps": aps})
+    return device, sequence, scans
+
+
+def cmd_telemetry(port: int = TELEMETRY_PORT, duration: Optional[int] = None) -> int:
+    """Receive scan telemetry datagrams on a UDP port and print them.
+
+    Reports lost datagrams per device from gaps in the sequence number, and
+    the bytes per scan actually received.
+    """
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    try:
+        sock.bind(("", port))
+    except OSError as e:
+        print(f"Error: cannot bind UDP port {port}: {e}", file=sys.stderr)
+        return 1
+    print(f"Listening for scan telemetry on UDP port {port}...", file=sys.stderr)
+
+    next_sequence: dict[str, int] = {}
+    total_bytes = 0
+    total_scans = 0
+    deadline = time.monotonic() + duration if duration else None
+    try:
+        while deadline is None or time.monotonic() < deadline:
+            sock.settimeout(max(0.1, deadline - time.monotonic()) if deadline else None)
+            try:
+                datagram, (host, _) = sock.recvfrom(2048)
+            except socket.timeout:
+                continue
+            try:
+                device, sequence, scans = decode_telemetry(datagram)
+            except (ValueError, IndexError) as e:
+                print(f"<bad datagram from {host}: {e}>")
+                continue
+
+            expected = next_sequence.get(device)
+            if expected is not None and sequence != expected:
+                print(f"{device}: {(sequence - expected) & 0xFFFFFFFF} datagrams lost")
+            next_sequence[device] = (sequence + 1) & 0xFFFFFFFF
+            total_bytes += len(datagram)
+            total_scans += len(scans)
+
+            for scan in scans:
+                print(f"{device} #{sequence} scan {scan['generation']} at {scan['uptime']}s: "
+                      f"{len(scan['aps'])} APs")
+                for ap in scan["aps"]:
+                    print(f"    {ap['ssid']:<32}  {ap['bssid']}  ch{ap['channel']:2d}  "
+                          f"{ap['rssi']:4d}dBm  {ap['auth']}")
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        sock.close()
+
+    if total_scans:
+        print(f"{total_scans} scans, {total_bytes / total_scans:.0f} bytes per scan",
+              file=sys.stderr)
+    return 0
+
+
+# =============================================================================
+# Scan Trace Capture
+# =============================================================================
+
+# Must match src/trace_frame.hpp
+TRACE_VERSION = 1
+TRACE_START, TRACE_AP, TRACE_END = 1, 2, 3
+TRACE_FLAG_PASSIVE = 0x01
+TRACE_FLAG_DIRECTED = 0x02
+
+
+class TraceDecoder:
+    """Rebuild scans from trace frames, keeping only those captured whole.
+
+    A scan is dropped if any of its frames was skipped (a gap in the frame
+    sequence) or it never completed. Directed scans are dropped too: they
+    only hold one SSID, and the simulator filters full scans for that.
+    """
+
+    def __init__(self):
+        self.pending = bytearray()
+        self.sequence: Optional[int] = None
+        self.scan: Optional[dict] = None
+        self.complete: list[dict] = []
+        self.incomplete = 0
+        self.directed = 0
+        self.bad_frames = 0
+
+    def feed(self, data: bytes) -> None:
+        self.pending += data
+        while (end := self.pending.find(0)) >= 0:
+            frame = bytes(self.pending[:end])
+            del self.pending[:end + 1]
+            if frame:
+                self.decode_frame(frame)
+
+    def drop_scan(self) -> None:
+        if self.scan is not None:
+            self.incomplete += 1
+            self.scan = None
+
+    def decode_frame(self, frame: bytes) -> None:
+        try:
+            payload = cobs_decode(frame)
+            if len(payload) < 2 or payload[0] >> 5 != TRACE_VERSION:
+                raise ValueError("unknown frame version")
+            kind = payload[0] & 0x0F
+            sequence = payload[1]
+            if self.sequence is not None and sequence != (self.sequence + 1) & 0xFF:
+                self.drop_scan()
+            self.sequence = sequence
+
+            if kind == TRACE_START:
+                self.drop_scan()
+                flags = payload[2]
+                uptime, _ = read_varint(payload, 3)
+                self.scan = {"uptime": uptime, "flags": flags, "aps": []}
+            elif kind == TRACE_AP:
+                offset, pos = read_varint(payload, 2)
+                if pos + 10 > len(payload):
+                    raise ValueError("truncated AP")
+                bssid = payload[pos:pos + 6]
+                rssi = struct.unpack_from("b", payload, pos + 6)[0]
+                channel, auth, length = payload[pos + 7], payload[pos + 8], payload[pos + 9]
+                ssid = payload[pos + 10:pos + 10 + length]
+                if self.scan is not None:
+                    self.scan["aps"].append((offset, bssid, rssi, channel, auth, ssid))
+            elif kind == TRACE_END:
+                duration, _ = read_varint(payload, 2)
+                if self.scan is None:
+                    return
+                self.scan["duration"] = duration
+                if self.scan["flags"] & TRACE_FLAG_DIRECTED:
+                    self.directed += 1
+                else:
+                    self.complete.append(self.scan)
+                self.scan = None
+            else:
+                raise ValueError(f"unknown frame kind {kind}")
+        except (ValueError, IndexError):
+            self.bad_frames += 1
+            self.drop_scan()
+
+
+def format_trace_ssid(ssid: bytes) -> str:
+    """SSID as the simulator reads it: the rest of the line, so no control characters."""
+    text = ssid.decode("utf-8", "replace")
+    return "".join(c if c.isprintable() else "?" for c in text).strip()
+
+
+def write_trace(scans: list[dict], out) -> None:
+    """Write scans in the simulator's text format (test/sim/sim_cyw43.hpp)."""
+    out.write(f"# Captured by tools/pico.py trace, {time.strftime('%Y-%m-%d %H:%M:%S')}\n")
+    out.write(f"# {len(scans)} scans\n")
+    for scan in scans:
+        mode = "passive" if scan["flags"] & TRACE_FLAG_PASSIVE else "active"
+        out.write(f"\n# {mode} scan at {scan['uptime'] / 1e6:.6f} s (uptime, wraps at 2^32 us)\n")
+        out.write(f"scan {scan['duration']}\n")
+        for offset, bssid, rssi, channel, auth, ssid in scan["aps"]:
+            bssid_text = ":".join(f"{b:02x}" for b in bssid)
+            line = f"ap {offset} {bssid_text} {rssi} {channel} {auth} {format_trace_ssid(ssid)}"
+            out.write(line.rstrip() + "\n")
+
+
+def cmd_trace(output: Path, duration: Optional[int] = None,
+              capture: Optional[Path] = None) -> int:
+    """Capture raw scan callbacks (SCAN_TRACE builds) into a simulator trace.
+
+    Reads trace frames from RTT channel 2, or from a raw capture file, and
+    writes the scans captured whole to output when done.
+    """
+    decoder = TraceDecoder()
+    if capture:
+        try:
+            decoder.feed(capture.read_bytes())
+        except OSError as e:
+            print(f"Error: {e}", file=sys.stderr)
+            return 1
+    else:
+        def progress(data: bytes) -> None:
+            before = len(decoder.complete)
+            decoder.feed(data)
+            if len(decoder.complete) != before:
+                scan = decoder.complete[-1]
+                print(f"scan {len(decoder.complete)}: {len(scan['aps'])} callbacks "
+                      f"in {scan['duration'] / 1000:.0f} ms", file=sys.stderr)
+
+        ret = read_rtt(RTT_TRACE_PORT, duration, progress)
+        if ret != 0:
+            return ret
+
+    if decoder.incomplete or decoder.bad_frames:
+        print(f"Warning: {decoder.incomplete} incomplete scans dropped "
+              f"({decoder.bad_frames} bad frames); is the host keeping up?", file=sys.stderr)
+    if decoder.directed:
+        print(f"{decoder.directed} directed scans left out", file=sys.stderr)
+    if not decoder.complete:
+        print("Error: no complete scans captured (built with -DSCAN_TRACE=ON?)", file=sys.stderr)
+        return 1
+
+    with open(output, "w", encoding="utf-8") as out:
+        write_trace(decoder.complete, out)
+    print(f"Wrote {len(decoder.complete)} scans to {output}", file=sys.stderr)
+    return 0
+
+
+# =============================================================================
+# Fingerprint table
+# =============================================================================
+
+TABLE_ROW_RE = re.compile(r"^\s+(\S) .*?\s([0-9A-Fa-f]{2}(?::[0-9A-Fa-f]{2}){5})\s+ch\s*\d+\s+(-?\d+)dBm")
+
+
+def parse_console_line(line: str) -> Optional[tuple]:
+    """A console record as ("scan",) or ("ap", marker, bssid, rssi), in any CONSOLE_FORMAT."""
+    line = line.strip("\r\n")
+    if line.startswith("{"):
+        try:
+            record = json.loads(line)
+        except ValueError:
+            return None
+        if record.get("type") == "scan":
+            return ("scan",)
+        if record.get("type") == "ap":
+            return ("ap", record["marker"], record["bssid"].upper(), int(record["rssi"]))
+        return None
+    if line.startswith("scan,") or line.startswith("--- Scan:"):
+        return ("scan",)
+    if line.startswith("ap,"):
+        fields = next(csv.reader([line]))
+        if len(fields) >= 6:
+            return ("ap", fields[1], fields[3].upper(), int(fields[5]))
+        return None
+    match = TABLE_ROW_RE.match(line)
+    if match:
+        return ("ap", match.group(1), match.group(2).upper(), int(match.group(3)))
+    return None
+
+
+def survey_scans(lines) -> list[dict]:
+    """Rebuild the AP set after each scheduled scan from the console's change rows.
+
+    The console prints each scan's summary, then what changed since the
+    previous one: + added, - removed, ~ RSSI moved. Restored (*) and
+    known-network (=) rows are from before the survey and are skipped.
+    """
+    scans = []
+    current: dict[str, int] = {}
+    in_scan = False
+    for line in lines:
+        record = parse_console_line(line)
+        if record is None:
+            continue
+        if record[0] == "scan":
+            if in_scan:
+                scans.append(dict(current))
+            in_scan = True
+            continue
+        _, marker, bssid, rssi = record
+        if not in_scan:
+            continue
+        if marker in "+~":
+            current[bssid] = rssi
+        elif marker == "-":
+            current.pop(bssid, None)
+    if in_scan:
+        scans.append(dict(current))
+    return scans
+
+
+def fingerprint_from(scans: list[dict]) -> list[tuple[int, int]]:
+    """(BSSID key, mean RSSI) of the strongest APs in most scans, sorted by key."""
+    heard: dict[str, list[int]] = {}
+    for scan in scans:
+        for bssid, rssi in scan.items():
+            heard.setdefault(bssid, []).append(rssi)
+    steady = [(bssid, round(sum(r) / len(r))) for bssid, r in heard.items()
+              if len(r) >= FINGERPRINT_MIN_PRESENCE * len(scans)]
+    steady.sort(key=lambda entry: entry[1], reverse=True)
+    return sorted((int(bssid.replace(":", ""), 16), rssi)
+                  for bssid, rssi in steady[:FINGERPRINT_MAX_APS])
+
+
+def cmd_fingerprints(output: Path, surveys: list[str]) -> int:
+    """Build the reference location table (FINGERPRINT_DB) from console captures.
+
+    Each survey is NAME=FILE: the console output (any CONSOLE_FORMAT, e.g.
+    from `just serial-read`) of a device left at that spot for a few scans.
+    """
+    entries = []
+    for survey in surveys:
+        name, sep, path = survey.partition("=")
+        if not sep or not name or not path:
+            print(f"Error: survey '{survey}' is not NAME=FILE", file=sys.stderr)
+            return 1
+        try:
+            with open(path, encoding="utf-8", errors="replace") as f:
+                scans = survey_scans(f)
+        except OSError as e:
+            print(f"Error: {e}", file=sys.stderr)
+            return 1
+        aps = fingerprint_from(scans)
+        if not aps:
+            print(f"Error: no scans in {path} (captured after the scheduler started?)",
+                  file=sys.stderr)
+            return 1
+        print(f"{name}: {len(aps)} APs from {len(scans)} scans", file=sys.stderr)
+        entries.append((name, path, len(scans), aps))
+
+    with open(output, "w", encoding="utf-8") as out:
+        out.write(f"// Generated by tools/pico.py fingerprints, {time.strftime('%Y-%m-%d %H:%M:%S')}\n")
+        out.write("// FingerprintLocation initializers (src/fingerprint.hpp), keys ascending\n")
+        for name, path, scan_count, aps in entries:
+            keys = ", ".join(f"0x{key:012X}ull" for key, _ in aps)
+            rssi = ", ".join(str(r) for _, r in aps)
+            out.write(f"\n// {name}: {scan_count} scans from {Path(path).name}\n")
+            out.write(f"{{{json.dumps(name)}, {{{{{{{keys}}}}}, {{{{{rssi}}}}}, {len(aps)}}}}},\n")
+    print(f"Wrote {len(entries)} locations to {output}", file=sys.stderr)
+    return 0
+
+
 # =============================================================================
 # Main
 # =============================================================================
@@ -782,6 +1362,33 @@ def main() -> None:
     rtt_p.add_argument("duration", nargs="?", type=int, default=None,
                        help="Duration in seconds (omit to read forever)")
 
+    # rtt-log (decodes binary debug log frames via debug probe)
+    log_p = subparsers.add_parser("rtt-log", help="Decode binary debug logs via debug probe")
+    log_p.add_argument("duration", nargs="?", type=int, default=None,
+                       help="Duration in seconds (omit to read forever)")
+    log_p.add_argument("--elf", help="ELF file with the .dlog section (default: build output)")
+
+    # telemetry (receives UDP scan telemetry)
+    tel_p = subparsers.add_parser("telemetry", help="Receive and decode UDP scan telemetry")
+    tel_p.add_argument("duration", nargs="?", type=int, default=None,
+                       help="Duration in seconds (omit to receive forever)")
+    tel_p.add_argument("-p", "--port", type=int, default=TELEMETRY_PORT,
+                       help=f"UDP port (default: {TELEMETRY_PORT})")
+
+    # trace (captures raw scan callbacks via debug probe)
+    trace_p = subparsers.add_parser("trace", help="Capture scan callbacks as a simulator trace")
+    trace_p.add_argument("output", help="Trace file to write")
+    trace_p.add_argument("duration", nargs="?", type=int, default=None,
+                         help="Duration in seconds (omit to capture until Ctrl+C)")
+    trace_p.add_argument("--input", help="Decode a raw RTT channel 2 capture instead")
+
+    # fingerprints (builds the reference location table from console captures)
+    fp_p = subparsers.add_parser("fingerprints",
+                                 help="Build a fingerprint table from console captures")
+    fp_p.add_argument("output", help="Table to write (pass to -DFINGERPRINT_DB)")
+    fp_p.add_argument("surveys", nargs="+", metavar="NAME=FILE",
+                      help="Console output captured at each reference location")
+
     args = parser.parse_args()
 
     if not args.command:
@@ -804,6 +1411,20 @@ def main() -> None:
     elif args.command == "rtt-read":
         sys.exit(cmd_rtt_read(args.duration))
 
+    elif args.command == "rtt-log":
+        elf = Path(args.elf) if args.elf else None
+        sys.exit(cmd_rtt_log(args.duration, elf))
+
+    elif args.command == "telemetry":
+        sys.exit(cmd_telemetry(args.port, args.duration))
+
+    elif args.command == "trace":
+        capture = Path(args.input) if args.input else None
+        sys.exit(cmd_trace(Path(args.output), args.duration, capture))
+
+    elif args.command == "fingerprints":
+        sys.exit(cmd_fingerprints(Path(args.output), args.surveys))
+
 
 if __name__ == "__main__":
     main()